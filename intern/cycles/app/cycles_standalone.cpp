@@ -373,6 +373,8 @@ static void options_parse(int argc, const char **argv)
 		"--height %d", &options.height, "Window height in pixel",
 		"--tile-width %d", &options.session_params.tile_size.x, "Tile width in pixels",
 		"--tile-height %d", &options.session_params.tile_size.y, "Tile height in pixels",
+		"--texture-cache", &options.scene_params.use_texture_cache, "Stream image textures from disk through a tiled texture cache",
+		"--texture-cache-size %d", &options.scene_params.texture_cache_size, "Texture cache size in megabytes",
 		"--list-devices", &list, "List information about all available devices",
 #ifdef WITH_CYCLES_LOGGING
 		"--debug", &debug, "Enable debug logging",
@@ -283,6 +283,28 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
                 description="Sample all lights (for indirect samples), rather than randomly picking one",
                 default=True,
                 )
+        cls.use_adaptive_sampling = BoolProperty(
+                name="Adaptive Sampling",
+                description="Automatically stop sampling pixels and tiles once they are noise free enough, "
+                            "only for final renders on the CPU",
+                default=False,
+                )
+        cls.adaptive_threshold = FloatProperty(
+                name="Adaptive Threshold",
+                description="Noise level at which pixels stop being sampled, lower values give less noise. "
+                            "Zero picks a value based on the number of samples",
+                min=0.0, max=1.0,
+                default=0.0,
+                precision=4,
+                )
+        cls.adaptive_min_samples = IntProperty(
+                name="Adaptive Min Samples",
+                description="Minimum number of samples of a pixel before it may stop, "
+                            "zero picks a value based on the number of samples",
+                min=0, max=4096,
+                default=0,
+                )
+
         cls.light_sampling_threshold = FloatProperty(
                 name="Light Sampling Threshold",
                 description="Probabilistically terminate light samples when the light contribution is below this threshold (more noise but faster rendering). "
@@ -290,6 +312,12 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
                 min=0.0, max=1.0,
                 default=0.01,
                 )
+        cls.use_light_tree = BoolProperty(
+                name="Light Tree",
+                description="Pick lamps and mesh lights based on their estimated contribution to the shaded point, "
+                            "reduces noise in scenes with many lights",
+                default=False,
+                )
 
         cls.caustics_reflective = BoolProperty(
                 name="Reflective Caustics",
@@ -518,6 +546,13 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
                 items=enum_bvh_types,
                 default='DYNAMIC_BVH',
                 )
+        cls.use_persistent_dynamic_bvh = BoolProperty(
+                name="Dynamic BVH",
+                description="With persistent data, keep a separate BVH per mesh, so only changed meshes "
+                            "and the top level are rebuilt between frames: faster updates of animations, "
+                            "but slower render than a single static BVH, also for still frames",
+                default=False,
+                )
         cls.debug_use_spatial_splits = BoolProperty(
                 name="Use Spatial Splits",
                 description="Use BVH spatial splits: longer builder time, faster render",
@@ -534,6 +569,18 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
                 default=0,
                 min=0, max=16,
                 )
+        cls.debug_use_compressed_bvh = BoolProperty(
+                name="Compress BVH",
+                description="Store BVH node bounds quantized relative to their parent (CPU only): "
+                            "uses less memory but renders slightly slower",
+                default=False,
+                )
+        cls.debug_use_indexed_triangles = BoolProperty(
+                name="Indexed Triangles",
+                description="Don't store a copy of the vertices of every triangle in the BVH: "
+                            "uses less memory but renders slightly slower",
+                default=False,
+                )
         cls.tile_order = EnumProperty(
                 name="Tile Order",
                 description="Tile order for rendering",
@@ -638,6 +685,27 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
             items=enum_texture_limit
             )
 
+        cls.use_texture_cache = BoolProperty(
+            name="Use Texture Cache",
+            description="Stream image textures from disk in tiles, at the resolution needed for rendering, "
+                        "instead of loading them into memory up front (CPU and SVM only)",
+            default=False,
+            )
+
+        cls.texture_cache_size = IntProperty(
+            name="Cache Size",
+            description="Memory in megabytes the texture cache keeps image tiles in",
+            default=1024,
+            min=16, max=1048576,
+            )
+
+        cls.texture_auto_convert = BoolProperty(
+            name="Auto Convert",
+            description="Write a tiled and mipmapped .tx file next to image textures which don't have one yet, "
+                        "so later renders can load them faster",
+            default=False,
+            )
+
         cls.ao_bounces = IntProperty(
             name="AO Bounces",
             default=0,
@@ -666,6 +734,7 @@ class CyclesRenderSettings(bpy.types.PropertyGroup):
         cls.debug_use_cpu_sse2 = BoolProperty(name="SSE2", default=True)
         cls.debug_use_qbvh = BoolProperty(name="QBVH", default=True)
         cls.debug_use_cpu_split_kernel = BoolProperty(name="Split Kernel", default=False)
+        cls.debug_use_cpu_ray_stream = BoolProperty(name="Ray Streams", default=False)
 
         cls.debug_use_cuda_adaptive_compile = BoolProperty(name="Adaptive Compile", default=False)
         cls.debug_use_cuda_split_kernel = BoolProperty(name="Split Kernel", default=False)
@@ -172,6 +172,7 @@ class CyclesRender_PT_sampling(CyclesButtonsPanel, Panel):
         sub.prop(cscene, "sample_clamp_direct")
         sub.prop(cscene, "sample_clamp_indirect")
         sub.prop(cscene, "light_sampling_threshold")
+        sub.prop(cscene, "use_light_tree")
 
         if cscene.progressive == 'PATH' or use_branched_path(context) is False:
             col = split.column()
@@ -205,6 +206,13 @@ class CyclesRender_PT_sampling(CyclesButtonsPanel, Panel):
 
         layout.row().prop(cscene, "sampling_pattern", text="Pattern")
 
+        row = layout.row()
+        row.prop(cscene, "use_adaptive_sampling")
+        sub = row.row(align=True)
+        sub.active = cscene.use_adaptive_sampling
+        sub.prop(cscene, "adaptive_threshold", text="Threshold")
+        sub.prop(cscene, "adaptive_min_samples", text="Min Samples")
+
         for rl in scene.render.layers:
             if rl.samples > 0:
                 layout.separator()
@@ -411,6 +419,14 @@ class CyclesRender_PT_performance(CyclesButtonsPanel, Panel):
         subsub = sub.column(align=True)
         subsub.prop(rd, "use_save_buffers")
 
+        sub = col.column(align=True)
+        sub.label(text="Texture Cache:")
+        sub.prop(cscene, "use_texture_cache", text="Use Cache")
+        subsub = sub.column(align=True)
+        subsub.active = cscene.use_texture_cache
+        subsub.prop(cscene, "texture_cache_size")
+        subsub.prop(cscene, "texture_auto_convert")
+
         col = split.column(align=True)
 
         col.label(text="Viewport:")
@@ -421,7 +437,10 @@ class CyclesRender_PT_performance(CyclesButtonsPanel, Panel):
         col.separator()
 
         col.label(text="Final Render:")
-        col.prop(rd, "use_persistent_data", text="Persistent Images")
+        col.prop(rd, "use_persistent_data", text="Persistent Data")
+        sub = col.column(align=True)
+        sub.active = rd.use_persistent_data
+        sub.prop(cscene, "use_persistent_dynamic_bvh")
 
         col.separator()
 
@@ -433,6 +452,9 @@ class CyclesRender_PT_performance(CyclesButtonsPanel, Panel):
         row.active = not cscene.debug_use_spatial_splits
         row.prop(cscene, "debug_bvh_time_steps")
 
+        col.prop(cscene, "debug_use_compressed_bvh")
+        col.prop(cscene, "debug_use_indexed_triangles")
+
 
 class CyclesRender_PT_layer_options(CyclesButtonsPanel, Panel):
     bl_label = "Layer"
@@ -1596,6 +1618,9 @@ class CyclesRender_PT_debug(CyclesButtonsPanel, Panel):
         row.prop(cscene, "debug_use_cpu_avx2", toggle=True)
         col.prop(cscene, "debug_use_qbvh")
         col.prop(cscene, "debug_use_cpu_split_kernel")
+        sub = col.column()
+        sub.active = cscene.debug_use_cpu_split_kernel
+        sub.prop(cscene, "debug_use_cpu_ray_stream")
 
         col = layout.column()
         col.label('CUDA Flags:')
@@ -30,9 +30,15 @@
 #include "util/util_foreach.h"
 #include "util/util_logging.h"
 #include "util/util_math.h"
+#include "util/util_string.h"
+#include "util/util_time.h"
 
 #include "mikktspace.h"
 
+#include "DNA_customdata_types.h"
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+
 CCL_NAMESPACE_BEGIN
 
 /* Per-face bit flags. */
@@ -329,6 +335,17 @@ static void create_mesh_volume_attributes(Scene *scene,
 		create_mesh_volume_attribute(b_ob, mesh, scene->image_manager, ATTR_STD_VOLUME_VELOCITY, frame);
 }
 
+/* Data of the n-th layer of a type, in the same order as the RNA collections. */
+static const void *customdata_layer_n(const CustomData *data, int type, int n)
+{
+	for(int i = 0; i < data->totlayer; i++) {
+		if(data->layers[i].type == type && n-- == 0) {
+			return data->layers[i].data;
+		}
+	}
+	return NULL;
+}
+
 /* Create vertex color attributes. */
 static void attr_create_vertex_color(Scene *scene,
                                      Mesh *mesh,
@@ -361,8 +378,11 @@ static void attr_create_vertex_color(Scene *scene,
 		}
 	}
 	else {
+		const ::Mesh *me = (const ::Mesh*)b_mesh.ptr.data;
 		BL::Mesh::tessface_vertex_colors_iterator l;
-		for(b_mesh.tessface_vertex_colors.begin(l); l != b_mesh.tessface_vertex_colors.end(); ++l) {
+		int n = 0;
+
+		for(b_mesh.tessface_vertex_colors.begin(l); l != b_mesh.tessface_vertex_colors.end(); ++l, ++n) {
 			if(!mesh->need_attribute(scene, ustring(l->name().c_str())))
 				continue;
 
@@ -370,20 +390,19 @@ static void attr_create_vertex_color(Scene *scene,
 			                                       TypeDesc::TypeColor,
 			                                       ATTR_ELEMENT_CORNER_BYTE);
 
-			BL::MeshColorLayer::data_iterator c;
+			/* read the colors directly, four per tessellated face */
+			const MCol *mcol = (const MCol*)customdata_layer_n(&me->fdata, CD_MCOL, n);
 			uchar4 *cdata = attr->data_uchar4();
-			size_t i = 0;
 
-			for(l->data.begin(c); c != l->data.end(); ++c, ++i) {
+			for(size_t i = 0; i < nverts.size(); i++, mcol += 4) {
 				int tri_a[3], tri_b[3];
 				face_split_tri_indices(nverts[i], face_flags[i], tri_a, tri_b);
 
+				/* stored as BGR, see rna_MeshColor_color1_get() */
 				uchar4 colors[4];
-				colors[0] = color_float_to_byte(color_srgb_to_scene_linear_v3(get_float3(c->color1())));
-				colors[1] = color_float_to_byte(color_srgb_to_scene_linear_v3(get_float3(c->color2())));
-				colors[2] = color_float_to_byte(color_srgb_to_scene_linear_v3(get_float3(c->color3())));
-				if(nverts[i] == 4) {
-					colors[3] = color_float_to_byte(color_srgb_to_scene_linear_v3(get_float3(c->color4())));
+				for(int j = 0; j < nverts[i]; j++) {
+					float3 color = make_float3(mcol[j].b, mcol[j].g, mcol[j].r) * (1.0f/255.0f);
+					colors[j] = color_float_to_byte(color_srgb_to_scene_linear_v3(color));
 				}
 
 				cdata[0] = colors[tri_a[0]];
@@ -447,9 +466,11 @@ static void attr_create_uv_map(Scene *scene,
 		}
 	}
 	else if(b_mesh.tessface_uv_textures.length() != 0) {
+		const ::Mesh *me = (const ::Mesh*)b_mesh.ptr.data;
 		BL::Mesh::tessface_uv_textures_iterator l;
+		int n = 0;
 
-		for(b_mesh.tessface_uv_textures.begin(l); l != b_mesh.tessface_uv_textures.end(); ++l) {
+		for(b_mesh.tessface_uv_textures.begin(l); l != b_mesh.tessface_uv_textures.end(); ++l, ++n) {
 			bool active_render = l->active_render();
 			AttributeStandard std = (active_render)? ATTR_STD_UV: ATTR_STD_NONE;
 			ustring name = ustring(l->name().c_str());
@@ -463,20 +484,17 @@ static void attr_create_uv_map(Scene *scene,
 				else
 					attr = mesh->attributes.add(name, TypeDesc::TypePoint, ATTR_ELEMENT_CORNER);
 
-				BL::MeshTextureFaceLayer::data_iterator t;
+				/* read the UVs directly, one MTFace per tessellated face */
+				const MTFace *tf = (const MTFace*)customdata_layer_n(&me->fdata, CD_MTFACE, n);
 				float3 *fdata = attr->data_float3();
-				size_t i = 0;
 
-				for(l->data.begin(t); t != l->data.end(); ++t, ++i) {
+				for(size_t i = 0; i < nverts.size(); i++, tf++) {
 					int tri_a[3], tri_b[3];
 					face_split_tri_indices(nverts[i], face_flags[i], tri_a, tri_b);
 
 					float3 uvs[4];
-					uvs[0] = get_float3(t->uv1());
-					uvs[1] = get_float3(t->uv2());
-					uvs[2] = get_float3(t->uv3());
-					if(nverts[i] == 4) {
-						uvs[3] = get_float3(t->uv4());
+					for(int j = 0; j < nverts[i]; j++) {
+						uvs[j] = make_float3(tf->uv[j][0], tf->uv[j][1], 0.0f);
 					}
 
 					fdata[0] = uvs[tri_a[0]];
@@ -711,22 +729,28 @@ static void create_mesh(Scene *scene,
                         bool subdivision = false,
                         bool subdivide_uvs = true)
 {
+	/* Vertices and tessellated faces are read from the Blender arrays
+	 * directly, going through RNA for each element is too slow for meshes
+	 * with millions of faces. */
+	const ::Mesh *me = (const ::Mesh*)b_mesh.ptr.data;
+	const MVert *mvert = me->mvert;
+	const MFace *mface = me->mface;
+	const short (*loop_normals)[4][3] = (const short (*)[4][3])customdata_layer_n(&me->fdata, CD_TESSLOOPNORMAL, 0);
+
 	/* count vertices and faces */
-	int numverts = b_mesh.vertices.length();
-	int numfaces = (!subdivision) ? b_mesh.tessfaces.length() : b_mesh.polygons.length();
+	int numverts = me->totvert;
+	int numfaces = (!subdivision) ? me->totface : b_mesh.polygons.length();
 	int numtris = 0;
 	int numcorners = 0;
 	int numngons = 0;
 	bool use_loop_normals = b_mesh.use_auto_smooth() && (mesh->subdivision_type != Mesh::SUBDIVISION_CATMULL_CLARK);
 
 	BL::Mesh::vertices_iterator v;
-	BL::Mesh::tessfaces_iterator f;
 	BL::Mesh::polygons_iterator p;
 
 	if(!subdivision) {
-		for(b_mesh.tessfaces.begin(f); f != b_mesh.tessfaces.end(); ++f) {
-			int4 vi = get_int4(f->vertices_raw());
-			numtris += (vi[3] == 0)? 1: 2;
+		for(int i = 0; i < numfaces; i++) {
+			numtris += (mface[i].v4 == 0)? 1: 2;
 		}
 	}
 	else {
@@ -741,16 +765,16 @@ static void create_mesh(Scene *scene,
 	mesh->reserve_subd_faces(numfaces, numngons, numcorners);
 
 	/* create vertex coordinates and normals */
-	for(b_mesh.vertices.begin(v); v != b_mesh.vertices.end(); ++v)
-		mesh->add_vertex(get_float3(v->co()));
+	for(int i = 0; i < numverts; i++)
+		mesh->add_vertex(make_float3(mvert[i].co[0], mvert[i].co[1], mvert[i].co[2]));
 
 	AttributeSet& attributes = (subdivision)? mesh->subd_attributes: mesh->attributes;
 	Attribute *attr_N = attributes.add(ATTR_STD_VERTEX_NORMAL);
 	float3 *N = attr_N->data_float3();
 
-	for(b_mesh.vertices.begin(v); v != b_mesh.vertices.end(); ++v, ++N)
-		*N = get_float3(v->normal());
-	N = attr_N->data_float3();
+	for(int i = 0; i < numverts; i++) {
+		N[i] = make_float3(mvert[i].no[0], mvert[i].no[1], mvert[i].no[2]) * (1.0f/32767.0f);
+	}
 
 	/* create generated coordinates from undeformed coordinates */
 	if(mesh->need_attribute(scene, ATTR_STD_GENERATED)) {
@@ -770,21 +794,23 @@ static void create_mesh(Scene *scene,
 	/* create faces */
 	vector<int> nverts(numfaces);
 	vector<int> face_flags(numfaces, FACE_FLAG_NONE);
-	int fi = 0;
 
 	if(!subdivision) {
-		for(b_mesh.tessfaces.begin(f); f != b_mesh.tessfaces.end(); ++f, ++fi) {
-			int4 vi = get_int4(f->vertices_raw());
+		for(int fi = 0; fi < numfaces; fi++) {
+			const MFace& face = mface[fi];
+			int4 vi = make_int4(face.v1, face.v2, face.v3, face.v4);
 			int n = (vi[3] == 0)? 3: 4;
-			int shader = clamp(f->material_index(), 0, used_shaders.size()-1);
-			bool smooth = f->use_smooth() || use_loop_normals;
+			int shader = clamp(face.mat_nr, 0, used_shaders.size()-1);
+			bool smooth = (face.flag & ME_SMOOTH) || use_loop_normals;
 
+			/* split normals are zero when they were not computed, as in RNA */
 			if(use_loop_normals) {
-				BL::Array<float, 12> loop_normals = f->split_normals();
 				for(int i = 0; i < n; i++) {
-					N[vi[i]] = make_float3(loop_normals[i * 3],
-					                       loop_normals[i * 3 + 1],
-					                       loop_normals[i * 3 + 2]);
+					N[vi[i]] = (loop_normals)
+					        ? make_float3(loop_normals[fi][i][0],
+					                      loop_normals[fi][i][1],
+					                      loop_normals[fi][i][2]) * (1.0f/32767.0f)
+					        : make_float3(0.0f, 0.0f, 0.0f);
 				}
 			}
 
@@ -905,6 +931,100 @@ static void create_subd_mesh(Scene *scene,
 	sdparams.objecttoworld = get_transform(b_ob.matrix_world());
 }
 
+/* Mesh Hash
+ *
+ * Hash of the exported Blender data that create_mesh() reads, to detect meshes
+ * which are tagged for an update without having changed, as happens for any
+ * object with modifiers on frame changes. */
+
+static uint64_t mesh_hash_data(uint64_t hash, const void *data, size_t size)
+{
+	/* MurmurHash64A, seeded with the hash of the previous data. Every word
+	 * is mixed before it is combined, so changes in any bit of the input
+	 * spread over the whole hash. */
+	const uint64_t m = 0xc6a4a7935bd1e995ULL;
+	const int r = 47;
+	const unsigned char *bytes = (const unsigned char*)data;
+	size_t i = 0;
+
+	hash ^= size * m;
+
+	for(; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+		uint64_t k;
+		memcpy(&k, bytes + i, sizeof(k));
+
+		k *= m;
+		k ^= k >> r;
+		k *= m;
+
+		hash ^= k;
+		hash *= m;
+	}
+
+	if(i < size) {
+		uint64_t k = 0;
+		memcpy(&k, bytes + i, size - i);
+
+		hash ^= k;
+		hash *= m;
+	}
+
+	hash ^= hash >> r;
+	hash *= m;
+	hash ^= hash >> r;
+
+	return hash;
+}
+
+static uint64_t mesh_hash_layers(uint64_t hash, const CustomData *data, int num_elements)
+{
+	for(int i = 0; i < data->totlayer; i++) {
+		const CustomDataLayer& layer = data->layers[i];
+
+		switch(layer.type) {
+			case CD_MVERT:
+			case CD_MEDGE:
+			case CD_MFACE:
+			case CD_MTFACE:
+			case CD_MCOL:
+			case CD_ORCO:
+			case CD_TESSLOOPNORMAL:
+				break;
+			default:
+				continue;
+		}
+
+		hash = mesh_hash_data(hash, &layer.type, sizeof(layer.type));
+		hash = mesh_hash_data(hash, layer.name, strlen(layer.name));
+		if(layer.data) {
+			hash = mesh_hash_data(hash, layer.data, (size_t)num_elements*CustomData_sizeof(layer.type));
+		}
+	}
+
+	return hash;
+}
+
+static uint64_t mesh_hash(BL::Mesh& b_mesh, bool hide_tris)
+{
+	const ::Mesh *me = (const ::Mesh*)b_mesh.ptr.data;
+	uint64_t hash = 0;
+
+	int flags[2] = {hide_tris, me->flag & ME_AUTOSMOOTH};
+	hash = mesh_hash_data(hash, flags, sizeof(flags));
+	hash = mesh_hash_data(hash, &me->smoothresh, sizeof(me->smoothresh));
+
+	float3 loc, size;
+	mesh_texture_space(b_mesh, loc, size);
+	float texspace[6] = {loc.x, loc.y, loc.z, size.x, size.y, size.z};
+	hash = mesh_hash_data(hash, texspace, sizeof(texspace));
+
+	hash = mesh_hash_layers(hash, &me->vdata, me->totvert);
+	hash = mesh_hash_layers(hash, &me->edata, me->totedge);
+	hash = mesh_hash_layers(hash, &me->fdata, me->totface);
+
+	return hash;
+}
+
 /* Sync */
 
 static void sync_mesh_fluid_motion(BL::Object& b_ob, Scene *scene, Mesh *mesh)
@@ -944,18 +1064,34 @@ static void sync_mesh_fluid_motion(BL::Object& b_ob, Scene *scene, Mesh *mesh)
 	}
 }
 
+static bool mesh_need_attribute_recalc(Mesh *mesh)
+{
+	foreach(Shader *shader, mesh->used_shaders)
+		if(shader->need_update_attributes)
+			return true;
+
+	return false;
+}
+
+void BlenderSync::sync_mesh_clear(MeshExport *mesh_export)
+{
+	Mesh *mesh = mesh_export->mesh;
+
+	mesh_export->oldtriangle = mesh->triangles;
+
+	/* compares curve_keys rather than strands in order to handle quick hair
+	 * adjustments in dynamic BVH - other methods could probably do this better*/
+	mesh_export->oldcurve_keys = mesh->curve_keys;
+	mesh_export->oldcurve_radius = mesh->curve_radius;
+
+	mesh->clear();
+	mesh->used_shaders = mesh_export->used_shaders;
+}
+
 Mesh *BlenderSync::sync_mesh(BL::Object& b_ob,
                              bool object_updated,
                              bool hide_tris)
 {
-	/* When viewport display is not needed during render we can force some
-	 * caches to be releases from blender side in order to reduce peak memory
-	 * footprint during synchronization process.
-	 */
-	const bool is_interface_locked = b_engine.render() &&
-	                                 b_engine.render().use_lock_interface();
-	const bool can_free_caches = BlenderSession::headless || is_interface_locked;
-
 	/* test if we can instance or if the object is modified */
 	BL::ID b_ob_data = b_ob.data();
 	BL::ID key = (BKE_object_is_modified(b_ob))? b_ob: b_ob_data;
@@ -1002,13 +1138,7 @@ Mesh *BlenderSync::sync_mesh(BL::Object& b_ob,
 		else {
 			/* even if not tagged for recalc, we may need to sync anyway
 			 * because the shader needs different mesh attributes */
-			bool attribute_recalc = false;
-
-			foreach(Shader *shader, mesh->used_shaders)
-				if(shader->need_update_attributes)
-					attribute_recalc = true;
-
-			if(!attribute_recalc)
+			if(!mesh_need_attribute_recalc(mesh))
 				return mesh;
 		}
 	}
@@ -1019,17 +1149,48 @@ Mesh *BlenderSync::sync_mesh(BL::Object& b_ob,
 
 	mesh_synced.insert(mesh);
 
-	/* create derived mesh */
-	array<int> oldtriangle = mesh->triangles;
+	Mesh::SubdivisionType subdivision_type = Mesh::SUBDIVISION_NONE;
+	if(requested_geometry_flags != Mesh::GEOMETRY_NONE) {
+		subdivision_type = object_subdivision_type(b_ob, preview, experimental);
 
-	/* compares curve_keys rather than strands in order to handle quick hair
-	 * adjustments in dynamic BVH - other methods could probably do this better*/
-	array<float3> oldcurve_keys = mesh->curve_keys;
-	array<float> oldcurve_radius = mesh->curve_radius;
+		/* Disable adaptive subdivision while baking as the baking system
+		 * currently doesnt support the topology and will crash.
+		 */
+		if(scene->bake_manager->get_baking()) {
+			subdivision_type = Mesh::SUBDIVISION_NONE;
+		}
+	}
 
-	mesh->clear();
-	mesh->used_shaders = used_shaders;
-	mesh->name = ustring(b_ob_data.name().c_str());
+	/* test if the existing mesh may be kept, in case the exported data turns
+	 * out to be the same. hair, smoke and fluid are generated outside of the
+	 * mesh data, and motion data is exported separately. */
+	bool can_skip = mesh_hashes.find(mesh) != mesh_hashes.end() &&
+	                mesh->triangles.size() != 0 &&
+	                !mesh->transform_applied &&
+	                mesh->used_shaders == used_shaders &&
+	                mesh->geometry_flags == requested_geometry_flags &&
+	                mesh->subdivision_type == Mesh::SUBDIVISION_NONE &&
+	                subdivision_type == Mesh::SUBDIVISION_NONE &&
+	                !mesh->attributes.find(ATTR_STD_MOTION_VERTEX_POSITION) &&
+	                !mesh_need_attribute_recalc(mesh) &&
+	                b_ob.particle_systems.length() == 0 &&
+	                !object_smoke_domain_find(b_ob) &&
+	                !object_fluid_domain_find(b_ob);
+
+	BL::Mesh b_mesh(PointerRNA_NULL);
+	MeshExport *mesh_export = new MeshExport(b_ob, b_mesh, mesh);
+	mesh_export->used_shaders = used_shaders;
+	mesh_export->hide_tris = hide_tris;
+	mesh_export->can_skip = can_skip;
+	mesh_export->geometry_flags = requested_geometry_flags;
+
+	if(!can_skip) {
+		sync_mesh_clear(mesh_export);
+		mesh->name = ustring(b_ob_data.name().c_str());
+
+		/* objects using the mesh test this right after it is synced */
+		mesh->need_update = true;
+	}
 
 	if(requested_geometry_flags != Mesh::GEOMETRY_NONE) {
 		/* mesh objects does have special handle in the dependency graph,
@@ -1043,51 +1204,117 @@ Mesh *BlenderSync::sync_mesh(BL::Object& b_ob,
 
 		bool need_undeformed = mesh->need_attribute(scene, ATTR_STD_GENERATED);
 
-		mesh->subdivision_type = object_subdivision_type(b_ob, preview, experimental);
+		mesh->subdivision_type = subdivision_type;
 
-		/* Disable adaptive subdivision while baking as the baking system
-		 * currently doesnt support the topology and will crash.
-		 */
-		if(scene->bake_manager->get_baking()) {
-			mesh->subdivision_type = Mesh::SUBDIVISION_NONE;
+		mesh_export->b_mesh = object_to_mesh(b_data,
+		                                     b_ob,
+		                                     b_scene,
+		                                     true,
+		                                     !preview,
+		                                     need_undeformed,
+		                                     mesh->subdivision_type);
+	}
+
+	mesh_exports.push_back(mesh_export);
+
+	if(!mesh_export->b_mesh) {
+		if(can_skip) {
+			mesh_export->can_skip = false;
+			sync_mesh_clear(mesh_export);
+			mesh->need_update = true;
 		}
+	}
+	else if(mesh->subdivision_type != Mesh::SUBDIVISION_NONE) {
+		/* subdivision setup updates the shared camera, so it stays on this thread */
+		sync_mesh_convert(mesh_export);
+	}
 
-		BL::Mesh b_mesh = object_to_mesh(b_data,
-		                                 b_ob,
-		                                 b_scene,
-		                                 true,
-		                                 !preview,
-		                                 need_undeformed,
-		                                 mesh->subdivision_type);
-
-		if(b_mesh) {
-			if(render_layer.use_surfaces && !hide_tris) {
-				if(mesh->subdivision_type != Mesh::SUBDIVISION_NONE)
-					create_subd_mesh(scene, mesh, b_ob, b_mesh, used_shaders,
-					                 dicing_rate, max_subdivisions);
-				else
-					create_mesh(scene, mesh, b_mesh, used_shaders, false);
+	/* the exported Blender meshes stay in memory until converted, so convert
+	 * them in batches */
+	if(mesh_exports.size() >= 4*(size_t)TaskScheduler::num_threads()) {
+		sync_meshes_finish();
+	}
+
+	return mesh;
+}
+
+void BlenderSync::sync_mesh_hash(MeshExport *mesh_export)
+{
+	mesh_export->hash = mesh_hash(mesh_export->b_mesh, mesh_export->hide_tris);
+}
+
+void BlenderSync::sync_mesh_convert(MeshExport *mesh_export)
+{
+	Mesh *mesh = mesh_export->mesh;
+	BL::Object& b_ob = mesh_export->b_ob;
+	BL::Mesh& b_mesh = mesh_export->b_mesh;
+
+	/* only triangle meshes are hashed, meshes which could be skipped are
+	 * hashed already */
+	if(mesh->subdivision_type == Mesh::SUBDIVISION_NONE && !mesh_export->can_skip)
+		sync_mesh_hash(mesh_export);
 
+	if(!render_layer.use_surfaces || mesh_export->hide_tris)
+		return;
+
+	if(mesh->subdivision_type != Mesh::SUBDIVISION_NONE)
+		create_subd_mesh(scene, mesh, b_ob, b_mesh, mesh_export->used_shaders,
+		                 dicing_rate, max_subdivisions);
+	else
+		create_mesh(scene, mesh, b_mesh, mesh_export->used_shaders, false);
+}
+
+void BlenderSync::sync_mesh_finish(MeshExport *mesh_export)
+{
+	/* When viewport display is not needed during render we can force some
+	 * caches to be releases from blender side in order to reduce peak memory
+	 * footprint during synchronization process.
+	 */
+	const bool is_interface_locked = b_engine.render() &&
+	                                 b_engine.render().use_lock_interface();
+	const bool can_free_caches = BlenderSession::headless || is_interface_locked;
+
+	Mesh *mesh = mesh_export->mesh;
+	BL::Object& b_ob = mesh_export->b_ob;
+	BL::Mesh& b_mesh = mesh_export->b_mesh;
+
+	if(b_mesh) {
+		if(!mesh_export->skipped) {
+			if(render_layer.use_surfaces && !mesh_export->hide_tris)
 				create_mesh_volume_attributes(scene, b_ob, mesh, b_scene.frame_current());
-			}
 
 			if(render_layer.use_hair && mesh->subdivision_type == Mesh::SUBDIVISION_NONE)
 				sync_curves(mesh, b_mesh, b_ob, false);
+		}
 
-			if(can_free_caches) {
-				b_ob.cache_release();
-			}
-
-			/* free derived mesh */
-			b_data.meshes.remove(b_mesh, false);
+		if(can_free_caches) {
+			b_ob.cache_release();
 		}
+
+		/* free derived mesh */
+		b_data.meshes.remove(b_mesh, false);
+	}
+
+	if(mesh_export->skipped) {
+		num_meshes_skipped++;
+		return;
 	}
-	mesh->geometry_flags = requested_geometry_flags;
+
+	/* remember the data for the next sync, only triangle meshes are hashed */
+	if(mesh_export->hash != 0)
+		mesh_hashes[mesh] = mesh_export->hash;
+	else
+		mesh_hashes.erase(mesh);
+
+	mesh->geometry_flags = mesh_export->geometry_flags;
 
 	/* fluid motion */
 	sync_mesh_fluid_motion(b_ob, scene, mesh);
 
 	/* tag update */
+	const array<int>& oldtriangle = mesh_export->oldtriangle;
+	const array<float3>& oldcurve_keys = mesh_export->oldcurve_keys;
+	const array<float>& oldcurve_radius = mesh_export->oldcurve_radius;
 	bool rebuild = false;
 
 	if(oldtriangle.size() != mesh->triangles.size())
@@ -1112,8 +1339,89 @@ Mesh *BlenderSync::sync_mesh(BL::Object& b_ob,
 	}
 
 	mesh->tag_update(scene, rebuild);
+}
 
-	return mesh;
+/* Show the stage and the time spent in each stage so far, meshes are
+ * converted in batches so the totals grow during the sync. */
+void BlenderSync::sync_meshes_status(const char *stage)
+{
+	progress.set_sync_status(string_printf("Synchronizing meshes | %s", stage),
+	                         string_printf("Hash %.2fs, convert %.2fs, finish %.2fs",
+	                                       time_mesh_hash,
+	                                       time_mesh_convert,
+	                                       time_mesh_finish));
+}
+
+void BlenderSync::sync_meshes_finish()
+{
+	if(mesh_exports.size() == 0)
+		return;
+
+	/* Tasks only run while this thread waits for them, so they never overlap
+	 * with object_to_mesh() changing Blender data, or with objects reading
+	 * the meshes while they are synced. Each task only writes its own mesh,
+	 * all clearing happens on this thread. */
+
+	/* objects were synced before these meshes turned out to be modified */
+	set<Mesh*> changed_meshes;
+
+	/* hash meshes which might be unchanged first, to know which to keep */
+	sync_meshes_status("Hashing");
+	double time_start = time_dt();
+
+	foreach(MeshExport *mesh_export, mesh_exports) {
+		if(mesh_export->can_skip && mesh_export->b_mesh)
+			mesh_pool.push(function_bind(&BlenderSync::sync_mesh_hash, this, mesh_export));
+	}
+	mesh_pool.wait_work();
+
+	foreach(MeshExport *mesh_export, mesh_exports) {
+		if(!mesh_export->can_skip || !mesh_export->b_mesh)
+			continue;
+
+		if(mesh_export->hash == mesh_hashes[mesh_export->mesh]) {
+			mesh_export->skipped = true;
+		}
+		else {
+			sync_mesh_clear(mesh_export);
+			changed_meshes.insert(mesh_export->mesh);
+		}
+	}
+
+	time_mesh_hash += time_dt() - time_start;
+
+	sync_meshes_status("Converting");
+	time_start = time_dt();
+
+	foreach(MeshExport *mesh_export, mesh_exports) {
+		if(mesh_export->b_mesh && !mesh_export->skipped &&
+		   mesh_export->mesh->subdivision_type == Mesh::SUBDIVISION_NONE)
+		{
+			mesh_pool.push(function_bind(&BlenderSync::sync_mesh_convert, this, mesh_export));
+		}
+	}
+	mesh_pool.wait_work();
+
+	time_mesh_convert += time_dt() - time_start;
+
+	sync_meshes_status("Finishing");
+	time_start = time_dt();
+
+	foreach(MeshExport *mesh_export, mesh_exports) {
+		sync_mesh_finish(mesh_export);
+		delete mesh_export;
+	}
+
+	time_mesh_finish += time_dt() - time_start;
+
+	mesh_exports.clear();
+
+	if(changed_meshes.size()) {
+		foreach(Object *object, scene->objects) {
+			if(changed_meshes.find(object->mesh) != changed_meshes.end())
+				object->tag_update(scene);
+		}
+	}
 }
 
 void BlenderSync::sync_mesh_motion(BL::Object& b_ob,
@@ -1294,6 +1602,11 @@ void BlenderSync::sync_mesh_motion(BL::Object& b_ob,
 		}
 	}
 
+	/* meshes kept unchanged by the sync were not tagged for update, but
+	 * may just have received motion data */
+	if(!mesh->need_update && mesh->attributes.find(ATTR_STD_MOTION_VERTEX_POSITION))
+		mesh->tag_update(scene, false);
+
 	/* hair motion */
 	if(numkeys)
 		sync_curves(mesh, b_mesh, b_ob, true, time_index);
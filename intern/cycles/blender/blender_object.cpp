@@ -596,6 +596,10 @@ void BlenderSync::sync_objects(float motion_time)
 		}
 	}
 
+	/* meshes still being converted, also when canceled as the exported
+	 * Blender meshes must be freed */
+	sync_meshes_finish();
+
 	progress.set_sync_status("");
 
 	if(!cancel && !motion) {
@@ -604,8 +608,20 @@ void BlenderSync::sync_objects(float motion_time)
 		/* handle removed data and modified pointers */
 		if(light_map.post_sync())
 			scene->light_manager->tag_update(scene);
-		if(mesh_map.post_sync())
+		if(mesh_map.post_sync()) {
 			scene->mesh_manager->tag_update(scene);
+
+			/* forget hashes of removed meshes, their pointers may be reused */
+			set<Mesh*> meshes(scene->meshes.begin(), scene->meshes.end());
+			map<Mesh*, uint64_t>::iterator it = mesh_hashes.begin();
+
+			while(it != mesh_hashes.end()) {
+				if(meshes.find(it->first) == meshes.end())
+					mesh_hashes.erase(it++);
+				else
+					++it;
+			}
+		}
 		if(object_map.post_sync())
 			scene->object_manager->tag_update(scene);
 		if(particle_system_map.post_sync())
@@ -116,7 +116,7 @@ void BlenderSession::create_session()
 {
 	SessionParams session_params = BlenderSync::get_session_params(b_engine, b_userpref, b_scene, background);
 	bool is_cpu = session_params.device.type == DEVICE_CPU;
-	SceneParams scene_params = BlenderSync::get_scene_params(b_scene, background, is_cpu);
+	SceneParams scene_params = BlenderSync::get_scene_params(b_scene, background, session_params.device);
 	bool session_pause = BlenderSync::get_session_pause(b_scene, background);
 
 	/* reset status/progress */
@@ -180,7 +180,7 @@ void BlenderSession::reset_session(BL::BlendData& b_data_, BL::Scene& b_scene_)
 
 	SessionParams session_params = BlenderSync::get_session_params(b_engine, b_userpref, b_scene, background);
 	const bool is_cpu = session_params.device.type == DEVICE_CPU;
-	SceneParams scene_params = BlenderSync::get_scene_params(b_scene, background, is_cpu);
+	SceneParams scene_params = BlenderSync::get_scene_params(b_scene, background, session_params.device);
 
 	width = render_resolution_x(b_render);
 	height = render_resolution_y(b_render);
@@ -195,13 +195,17 @@ void BlenderSession::reset_session(BL::BlendData& b_data_, BL::Scene& b_scene_)
 
 		delete session;
 
+		/* with persistent data the sync object of the previous render was
+		 * kept, it is re-created along with the session */
+		delete sync;
+		sync = NULL;
+
 		create_session();
 
 		return;
 	}
 
 	session->progress.reset();
-	scene->reset();
 
 	session->tile_manager.set_tile_order(session_params.tile_order);
 
@@ -210,8 +214,16 @@ void BlenderSession::reset_session(BL::BlendData& b_data_, BL::Scene& b_scene_)
 	 */
 	session->stats.mem_peak = session->stats.mem_used;
 
-	/* sync object should be re-created */
-	sync = new BlenderSync(b_engine, b_data, b_scene, scene, !background, session->progress, is_cpu);
+	if(sync) {
+		/* scene data of the previous frame was kept, only sync changes */
+		sync->reset(b_data, b_scene);
+	}
+	else {
+		scene->reset();
+
+		/* sync object should be re-created */
+		sync = new BlenderSync(b_engine, b_data, b_scene, scene, !background, session->progress, is_cpu);
+	}
 
 	/* for final render we will do full data sync per render layer, only
 	 * do some basic syncing here, no objects or materials for speed */
@@ -376,6 +388,7 @@ void BlenderSession::render()
 	/* get buffer parameters */
 	SessionParams session_params = BlenderSync::get_session_params(b_engine, b_userpref, b_scene, background);
 	BufferParams buffer_params = BlenderSync::get_buffer_params(b_render, b_v3d, b_rv3d, scene->camera, width, height);
+	PointerRNA cscene = RNA_pointer_get(&b_scene.ptr, "cycles");
 
 	/* render each layer */
 	BL::RenderSettings r = b_scene.render();
@@ -424,6 +437,13 @@ void BlenderSession::render()
 		session->params.denoising_feature_strength = get_float(crl, "denoising_feature_strength");
 		session->params.denoising_relative_pca = get_boolean(crl, "denoising_relative_pca");
 
+		/* Adaptive sampling is only supported by the CPU path tracing loop. */
+		bool use_adaptive_sampling = !session_params.progressive_refine &&
+		                             session_params.device.type == DEVICE_CPU &&
+		                             get_boolean(cscene, "use_adaptive_sampling");
+		buffer_params.adaptive_sampling_pass = use_adaptive_sampling;
+		scene->film->use_adaptive_sampling = use_adaptive_sampling;
+
 		scene->film->pass_alpha_threshold = b_layer_iter->pass_alpha_threshold();
 		scene->film->tag_passes_update(scene, passes);
 		scene->film->tag_update(scene);
@@ -493,13 +513,16 @@ void BlenderSession::render()
 	session->update_render_tile_cb = function_null;
 
 	/* free all memory used (host and device), so we wouldn't leave render
-	 * engine with extra memory allocated
+	 * engine with extra memory allocated, unless it is kept for the next
+	 * frame with persistent data
 	 */
 
 	session->device_free();
 
-	delete sync;
-	sync = NULL;
+	if(!scene->params.persistent_data) {
+		delete sync;
+		sync = NULL;
+	}
 }
 
 static void populate_bake_data(BakeData *data, const
@@ -641,13 +664,16 @@ void BlenderSession::bake(BL::Object& b_object,
 	}
 
 	/* free all memory used (host and device), so we wouldn't leave render
-	 * engine with extra memory allocated
+	 * engine with extra memory allocated, unless it is kept for the next
+	 * frame with persistent data
 	 */
 
 	session->device_free();
 
-	delete sync;
-	sync = NULL;
+	if(!scene->params.persistent_data) {
+		delete sync;
+		sync = NULL;
+	}
 }
 
 void BlenderSession::do_write_update_render_result(BL::RenderResult& b_rr,
@@ -736,8 +762,7 @@ void BlenderSession::synchronize()
 
 	/* on session/scene parameter changes, we recreate session entirely */
 	SessionParams session_params = BlenderSync::get_session_params(b_engine, b_userpref, b_scene, background);
-	const bool is_cpu = session_params.device.type == DEVICE_CPU;
-	SceneParams scene_params = BlenderSync::get_scene_params(b_scene, background, is_cpu);
+	SceneParams scene_params = BlenderSync::get_scene_params(b_scene, background, session_params.device);
 	bool session_pause = BlenderSync::get_session_pause(b_scene, background);
 
 	if(session->params.modified(session_params) ||
@@ -37,6 +37,8 @@
 #include "util/util_foreach.h"
 #include "util/util_opengl.h"
 #include "util/util_hash.h"
+#include "util/util_logging.h"
+#include "util/util_time.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -65,6 +67,10 @@ BlenderSync::BlenderSync(BL::RenderEngine& b_engine,
   is_cpu(is_cpu),
   dicing_rate(1.0f),
   max_subdivisions(12),
+  num_meshes_skipped(0),
+  time_mesh_hash(0.0),
+  time_mesh_convert(0.0),
+  time_mesh_finish(0.0),
   progress(progress)
 {
 	PointerRNA cscene = RNA_pointer_get(&b_scene.ptr, "cycles");
@@ -76,6 +82,25 @@ BlenderSync::~BlenderSync()
 {
 }
 
+void BlenderSync::reset(BL::BlendData& b_data, BL::Scene& b_scene)
+{
+	/* Update data and scene pointers in case they change in session reset,
+	 * for example during bake where the original scene is used. */
+	this->b_data = b_data;
+	this->b_scene = b_scene;
+
+	/* With persistent data the scene of the previous frame is kept, but
+	 * Blender doesn't tell what changed between frames of a final render, so
+	 * all data is synced again. Meshes which didn't change are detected by
+	 * their hash, and keep their BVH and device data. */
+	shader_map.set_recalc_all();
+	object_map.set_recalc_all();
+	mesh_map.set_recalc_all();
+	light_map.set_recalc_all();
+	particle_system_map.set_recalc_all();
+	world_recalc = true;
+}
+
 /* Sync */
 
 bool BlenderSync::sync_recalc()
@@ -197,25 +222,45 @@ void BlenderSync::sync_data(BL::RenderSettings& b_render,
                             void **python_thread_state,
                             const char *layer)
 {
+	double time_shaders = 0.0, time_objects = 0.0, time_motion = 0.0;
+
 	sync_render_layers(b_v3d, layer);
 	sync_integrator();
 	sync_film();
-	sync_shaders();
-	sync_images();
+	{
+		scoped_timer timer(&time_shaders);
+		sync_shaders();
+		sync_images();
+	}
 	sync_curve_settings();
 
 	mesh_synced.clear(); /* use for objects and motion sync */
+	num_meshes_skipped = 0;
+	time_mesh_hash = time_mesh_convert = time_mesh_finish = 0.0;
 
 	if(scene->need_motion() == Scene::MOTION_PASS ||
 	   scene->need_motion() == Scene::MOTION_NONE ||
 	   scene->camera->motion_position == Camera::MOTION_POSITION_CENTER)
 	{
+		scoped_timer timer(&time_objects);
 		sync_objects();
 	}
-	sync_motion(b_render,
-	            b_override,
-	            width, height,
-	            python_thread_state);
+	{
+		scoped_timer timer(&time_motion);
+		sync_motion(b_render,
+		            b_override,
+		            width, height,
+		            python_thread_state);
+	}
+
+	VLOG(1) << "Synchronized " << mesh_synced.size() << " meshes, "
+	        << num_meshes_skipped << " of them unchanged.";
+	VLOG(1) << "Synchronization time: shaders " << time_shaders
+	        << "s, objects " << time_objects
+	        << "s, motion " << time_motion << "s.";
+	VLOG(1) << "Mesh conversion time: hash " << time_mesh_hash
+	        << "s, convert " << time_mesh_convert
+	        << "s, finish " << time_mesh_finish << "s.";
 
 	mesh_synced.clear();
 }
@@ -293,6 +338,10 @@ void BlenderSync::sync_integrator()
 	integrator->sample_all_lights_direct = get_boolean(cscene, "sample_all_lights_direct");
 	integrator->sample_all_lights_indirect = get_boolean(cscene, "sample_all_lights_indirect");
 	integrator->light_sampling_threshold = get_float(cscene, "light_sampling_threshold");
+	integrator->use_light_tree = get_boolean(cscene, "use_light_tree");
+
+	integrator->adaptive_threshold = get_float(cscene, "adaptive_threshold");
+	integrator->adaptive_min_samples = get_int(cscene, "adaptive_min_samples");
 
 	int diffuse_samples = get_int(cscene, "diffuse_samples");
 	int glossy_samples = get_int(cscene, "glossy_samples");
@@ -335,6 +384,10 @@ void BlenderSync::sync_integrator()
 
 	if(integrator->modified(previntegrator))
 		integrator->tag_update(scene);
+
+	/* The light distribution depends on whether the light tree is used. */
+	if(integrator->use_light_tree != previntegrator.use_light_tree)
+		scene->light_manager->tag_update(scene);
 }
 
 /* Film */
@@ -617,7 +670,7 @@ array<Pass> BlenderSync::sync_render_passes(BL::RenderLayer& b_rlay,
 
 SceneParams BlenderSync::get_scene_params(BL::Scene& b_scene,
                                           bool background,
-                                          bool is_cpu)
+                                          const DeviceInfo& device)
 {
 	BL::RenderSettings r = b_scene.render();
 	SceneParams params;
@@ -641,12 +694,20 @@ SceneParams BlenderSync::get_scene_params(BL::Scene& b_scene,
 	params.use_bvh_spatial_split = RNA_boolean_get(&cscene, "debug_use_spatial_splits");
 	params.use_bvh_unaligned_nodes = RNA_boolean_get(&cscene, "debug_use_hair_bvh");
 	params.num_bvh_time_steps = RNA_int_get(&cscene, "debug_bvh_time_steps");
+	params.use_bvh_compressed_nodes = RNA_boolean_get(&cscene, "debug_use_compressed_bvh");
+	params.use_bvh_indexed_triangles = RNA_boolean_get(&cscene, "debug_use_indexed_triangles");
 
 	if(background && params.shadingsystem != SHADINGSYSTEM_OSL)
 		params.persistent_data = r.use_persistent_data();
 	else
 		params.persistent_data = false;
 
+	/* Optionally keep mesh BVHs separate, so they can be reused or refitted in
+	 * the next frame instead of rebuilding the whole scene, at the cost of a
+	 * slower render than with a static BVH. */
+	if(params.persistent_data && RNA_boolean_get(&cscene, "use_persistent_dynamic_bvh"))
+		params.bvh_type = SceneParams::BVH_DYNAMIC;
+
 	int texture_limit;
 	if(background) {
 		texture_limit = RNA_enum_get(&cscene, "texture_limit_render");
@@ -661,14 +722,24 @@ SceneParams BlenderSync::get_scene_params(BL::Scene& b_scene,
 		params.texture_limit = 0;
 	}
 
+	params.use_texture_cache = RNA_boolean_get(&cscene, "use_texture_cache");
+	params.texture_cache_size = RNA_int_get(&cscene, "texture_cache_size");
+	params.texture_auto_convert = RNA_boolean_get(&cscene, "texture_auto_convert");
+
 #if !(defined(__GNUC__) && (defined(i386) || defined(_M_IX86)))
-	if(is_cpu) {
+	if(device.type == DEVICE_CPU) {
 		params.use_qbvh = DebugFlags().cpu.qbvh && system_cpu_support_sse2();
+		/* Octo nodes are only traversed by the AVX2 kernel, and have no
+		 * compressed layout. */
+		params.use_bvh8 = params.use_qbvh &&
+		                  device.has_bvh8 &&
+		                  !params.use_bvh_compressed_nodes;
 	}
 	else
 #endif
 	{
 		params.use_qbvh = false;
+		params.use_bvh8 = false;
 	}
 
 	return params;
@@ -29,6 +29,7 @@
 
 #include "util/util_map.h"
 #include "util/util_set.h"
+#include "util/util_task.h"
 #include "util/util_transform.h"
 #include "util/util_vector.h"
 
@@ -58,6 +59,8 @@ public:
 	            bool is_cpu);
 	~BlenderSync();
 
+	void reset(BL::BlendData& b_data, BL::Scene& b_scene);
+
 	/* sync */
 	bool sync_recalc();
 	void sync_data(BL::RenderSettings& b_render,
@@ -84,7 +87,7 @@ public:
 	/* get parameters */
 	static SceneParams get_scene_params(BL::Scene& b_scene,
 	                                    bool background,
-	                                    bool is_cpu);
+	                                    const DeviceInfo& device);
 	static SessionParams get_session_params(BL::RenderEngine& b_engine,
 	                                        BL::UserPreferences& b_userpref,
 	                                        BL::Scene& b_scene,
@@ -116,6 +119,8 @@ private:
 
 	void sync_nodes(Shader *shader, BL::ShaderNodeTree& b_ntree);
 	Mesh *sync_mesh(BL::Object& b_ob, bool object_updated, bool hide_tris);
+	void sync_meshes_finish();
+	void sync_meshes_status(const char *stage);
 	void sync_curves(Mesh *mesh,
 	                 BL::Mesh& b_mesh,
 	                 BL::Object& b_ob,
@@ -152,6 +157,39 @@ private:
 	/* Images. */
 	void sync_images();
 
+	/* Meshes are exported from Blender on the main thread, as that evaluates
+	 * modifiers. They are then converted into Cycles meshes in batches by a
+	 * task pool, while the main thread waits. The Blender side cleanup happens
+	 * once all conversions of a batch are done. */
+	struct MeshExport {
+		MeshExport(BL::Object& b_ob, BL::Mesh& b_mesh, Mesh *mesh)
+		: b_ob(b_ob), b_mesh(b_mesh), mesh(mesh),
+		  geometry_flags(0), hide_tris(false),
+		  can_skip(false), skipped(false), hash(0) {}
+
+		BL::Object b_ob;
+		BL::Mesh b_mesh;
+		Mesh *mesh;
+		vector<Shader*> used_shaders;
+		int geometry_flags;
+		bool hide_tris;
+
+		/* Mesh is kept as it is if its data hash did not change, the hash
+		 * of the previous sync is in mesh_hashes. */
+		bool can_skip;
+		bool skipped;
+		uint64_t hash;
+
+		array<int> oldtriangle;
+		array<float3> oldcurve_keys;
+		array<float> oldcurve_radius;
+	};
+
+	void sync_mesh_clear(MeshExport *mesh_export);
+	void sync_mesh_hash(MeshExport *mesh_export);
+	void sync_mesh_convert(MeshExport *mesh_export);
+	void sync_mesh_finish(MeshExport *mesh_export);
+
 	/* util */
 	void find_shader(BL::ID& id, vector<Shader*>& used_shaders, Shader *default_shader);
 	bool BKE_object_is_modified(BL::Object& b_ob);
@@ -170,6 +208,7 @@ private:
 	id_map<ParticleSystemKey, ParticleSystem> particle_system_map;
 	set<Mesh*> mesh_synced;
 	set<Mesh*> mesh_motion_synced;
+	map<Mesh*, uint64_t> mesh_hashes;
 	set<float> motion_times;
 	void *world_map;
 	bool world_recalc;
@@ -182,6 +221,12 @@ private:
 	float dicing_rate;
 	int max_subdivisions;
 
+	TaskPool mesh_pool;
+	vector<MeshExport*> mesh_exports;
+	int num_meshes_skipped;
+	/* time spent in each stage of the mesh conversion, for the whole sync */
+	double time_mesh_hash, time_mesh_convert, time_mesh_finish;
+
 	struct RenderLayerInfo {
 		RenderLayerInfo()
 		: scene_layer(0), layer(0),
@@ -36,6 +36,7 @@ void BKE_image_user_frame_calc(void *iuser, int cfra, int fieldnr);
 void BKE_image_user_file_path(void *iuser, void *ima, char *path);
 unsigned char *BKE_image_get_pixels_for_frame(void *image, int frame);
 float *BKE_image_get_float_pixels_for_frame(void *image, int frame);
+int CustomData_sizeof(int type);
 }
 
 CCL_NAMESPACE_BEGIN
@@ -599,6 +600,7 @@ public:
 	id_map(vector<T*> *scene_data_)
 	{
 		scene_data = scene_data_;
+		recalc_all = false;
 	}
 
 	T *find(const BL::ID& id)
@@ -621,9 +623,14 @@ public:
 		b_recalc.insert(id.ptr.data);
 	}
 
+	void set_recalc_all()
+	{
+		recalc_all = true;
+	}
+
 	bool has_recalc()
 	{
-		return !(b_recalc.empty());
+		return recalc_all || !(b_recalc.empty());
 	}
 
 	void pre_sync()
@@ -649,7 +656,7 @@ public:
 			recalc = true;
 		}
 		else {
-			recalc = (b_recalc.find(id.ptr.data) != b_recalc.end());
+			recalc = recalc_all || (b_recalc.find(id.ptr.data) != b_recalc.end());
 			if(parent.ptr.data)
 				recalc = recalc || (b_recalc.find(parent.ptr.data) != b_recalc.end());
 		}
@@ -711,6 +718,7 @@ public:
 
 		used_set.clear();
 		b_recalc.clear();
+		recalc_all = false;
 		b_map = new_map;
 
 		return deleted;
@@ -721,6 +729,7 @@ protected:
 	map<K, T*> b_map;
 	set<T*> used_set;
 	set<void*> b_recalc;
+	bool recalc_all;
 };
 
 /* Object Key */
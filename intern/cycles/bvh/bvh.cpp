@@ -22,6 +22,7 @@
 
 #include "bvh/bvh2.h"
 #include "bvh/bvh4.h"
+#include "bvh/bvh8.h"
 #include "bvh/bvh_build.h"
 #include "bvh/bvh_node.h"
 
@@ -51,7 +52,9 @@ BVH::BVH(const BVHParams& params_, const vector<Object*>& objects_)
 
 BVH *BVH::create(const BVHParams& params, const vector<Object*>& objects)
 {
-	if(params.use_qbvh)
+	if(params.use_bvh8)
+		return new BVH8(params, objects);
+	else if(params.use_qbvh)
 		return new BVH4(params, objects);
 	else
 		return new BVH2(params, objects);
@@ -108,6 +111,16 @@ void BVH::refit(Progress& progress)
 	refit_nodes();
 }
 
+void BVH::refit_top_level(Progress& progress)
+{
+	assert(params.top_level);
+
+	/* Leaves of the top level only reference its own primitives and the
+	 * instances, the nodes of the instance BVHs are not touched. */
+	progress.set_substatus("Refitting BVH nodes");
+	refit_nodes();
+}
+
 /* Triangles */
 
 void BVH::pack_triangle(int idx, float4 tri_verts[3])
@@ -140,11 +153,13 @@ void BVH::pack_primitives()
 			}
 		}
 	}
-	/* Reserve size for arrays. */
+	/* Reserve size for arrays. With indexed triangles the kernel reads the
+	 * mesh vertices directly, so no copy of them is packed. */
+	const bool use_tri_verts = !params.use_indexed_triangles;
 	pack.prim_tri_index.clear();
 	pack.prim_tri_index.resize(tidx_size);
 	pack.prim_tri_verts.clear();
-	pack.prim_tri_verts.resize(num_prim_triangles * 3);
+	pack.prim_tri_verts.resize((use_tri_verts)? num_prim_triangles * 3: 0);
 	pack.prim_visibility.clear();
 	pack.prim_visibility.resize(tidx_size);
 	/* Fill in all the arrays. */
@@ -154,7 +169,7 @@ void BVH::pack_primitives()
 			int tob = pack.prim_object[i];
 			Object *ob = objects[tob];
 
-			if((pack.prim_type[i] & PRIMITIVE_ALL_TRIANGLE) != 0) {
+			if(use_tri_verts && (pack.prim_type[i] & PRIMITIVE_ALL_TRIANGLE) != 0) {
 				pack_triangle(i, (float4*)&pack.prim_tri_verts[3 * prim_triangle_index]);
 				pack.prim_tri_index[i] = 3 * prim_triangle_index;
 				++prim_triangle_index;
@@ -184,6 +199,8 @@ void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
 	 * top level BVH, adjusting indexes and offsets where appropriate.
 	 */
 	const bool use_qbvh = params.use_qbvh;
+	const bool use_bvh8 = params.use_bvh8;
+	const bool use_compressed_nodes = use_qbvh && !use_bvh8 && params.use_compressed_nodes;
 
 	/* Adjust primitive index to point to the triangle in the global array, for
 	 * meshes with transform applied and already in the top level BVH.
@@ -312,7 +329,9 @@ void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
 				else {
 					pack_prim_index[pack_prim_index_offset] = bvh_prim_index[i] + mesh_tri_offset;
 					pack_prim_tri_index[pack_prim_index_offset] =
-					        bvh_prim_tri_index[i] + pack_prim_tri_verts_offset;
+					        (bvh_prim_tri_index[i] != -1)
+					                ? bvh_prim_tri_index[i] + pack_prim_tri_verts_offset
+					                : -1;
 				}
 
 				pack_prim_type[pack_prim_index_offset] = bvh_prim_type[i];
@@ -360,14 +379,30 @@ void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
 			for(size_t i = 0, j = 0; i < bvh_nodes_size; j++) {
 				size_t nsize, nsize_bbox;
 				if(bvh_nodes[i].x & PATH_RAY_NODE_UNALIGNED) {
-					nsize = use_qbvh
-					            ? BVH_UNALIGNED_QNODE_SIZE
-					            : BVH_UNALIGNED_NODE_SIZE;
-					nsize_bbox = (use_qbvh)? 13: 0;
+					if(use_bvh8) {
+						nsize = BVH_UNALIGNED_ONODE_SIZE;
+						nsize_bbox = 25;
+					}
+					else {
+						nsize = use_qbvh
+						            ? BVH_UNALIGNED_QNODE_SIZE
+						            : BVH_UNALIGNED_NODE_SIZE;
+						nsize_bbox = (use_qbvh)? 13: 0;
+					}
 				}
 				else {
-					nsize = (use_qbvh)? BVH_QNODE_SIZE: BVH_NODE_SIZE;
-					nsize_bbox = (use_qbvh)? 7: 0;
+					if(use_bvh8) {
+						nsize = BVH_ONODE_SIZE;
+						nsize_bbox = 13;
+					}
+					else if(use_compressed_nodes) {
+						nsize = BVH_COMPRESSED_QNODE_SIZE;
+						nsize_bbox = 4;
+					}
+					else {
+						nsize = (use_qbvh)? BVH_QNODE_SIZE: BVH_NODE_SIZE;
+						nsize_bbox = (use_qbvh)? 7: 0;
+					}
 				}
 
 				memcpy(pack_nodes + pack_nodes_offset,
@@ -380,19 +415,31 @@ void BVH::pack_instances(size_t nodes_size, size_t leaf_nodes_size)
 				data.z += (data.z < 0)? -noffset_leaf: noffset;
 				data.w += (data.w < 0)? -noffset_leaf: noffset;
 
-				if(use_qbvh) {
+				if(use_qbvh || use_bvh8) {
 					data.x += (data.x < 0)? -noffset_leaf: noffset;
 					data.y += (data.y < 0)? -noffset_leaf: noffset;
 				}
 
 				pack_nodes[pack_nodes_offset + nsize_bbox] = data;
 
+				/* Octo nodes store the second half of the children in the next row. */
+				size_t nsize_children = 1;
+				if(use_bvh8) {
+					data = bvh_nodes[i + nsize_bbox + 1];
+					data.x += (data.x < 0)? -noffset_leaf: noffset;
+					data.y += (data.y < 0)? -noffset_leaf: noffset;
+					data.z += (data.z < 0)? -noffset_leaf: noffset;
+					data.w += (data.w < 0)? -noffset_leaf: noffset;
+					pack_nodes[pack_nodes_offset + nsize_bbox + 1] = data;
+					nsize_children = 2;
+				}
+
 				/* Usually this copies nothing, but we better
 				 * be prepared for possible node size extension.
 				 */
-				memcpy(&pack_nodes[pack_nodes_offset + nsize_bbox+1],
-				       &bvh_nodes[i + nsize_bbox+1],
-				       sizeof(int4) * (nsize - (nsize_bbox+1)));
+				memcpy(&pack_nodes[pack_nodes_offset + nsize_bbox + nsize_children],
+				       &bvh_nodes[i + nsize_bbox + nsize_children],
+				       sizeof(int4) * (nsize - (nsize_bbox + nsize_children)));
 
 				pack_nodes_offset += nsize;
 				i += nsize;
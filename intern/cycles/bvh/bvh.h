@@ -88,6 +88,11 @@ public:
 	void build(Progress& progress);
 	void refit(Progress& progress);
 
+	/* Update the top level nodes for changed object bounds and visibility,
+	 * keeping the merged instance BVHs as they are. Only valid as long as
+	 * the meshes and the objects using them did not change. */
+	void refit_top_level(Progress& progress);
+
 protected:
 	BVH(const BVHParams& params, const vector<Object*>& objects);
 
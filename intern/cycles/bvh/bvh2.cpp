@@ -237,8 +237,6 @@ void BVH2::pack_nodes(const BVHNode *root)
 
 void BVH2::refit_nodes()
 {
-	assert(!params.top_level);
-
 	BoundBox bbox = BoundBox::empty;
 	uint visibility = 0;
 	refit_node(0, (pack.root_index == -1)? true: false, bbox, visibility);
@@ -251,8 +249,11 @@ void BVH2::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility)
 		const int4 *data = &pack.leaf_nodes[idx];
 		const int c0 = data[0].x;
 		const int c1 = data[0].y;
-		/* refit leaf node */
-		for(int prim = c0; prim < c1; prim++) {
+		/* refit leaf node, instances in the top level are packed as
+		 * ~prim with an empty range */
+		const int prim_start = (c0 < 0)? ~c0: c0;
+		const int prim_end = (c0 < 0)? prim_start + 1: c1;
+		for(int prim = prim_start; prim < prim_end; prim++) {
 			int pidx = pack.prim_index[prim];
 			int tob = pack.prim_object[prim];
 			Object *ob = objects[tob];
@@ -314,6 +315,13 @@ void BVH2::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility)
 			}
 
 			visibility |= ob->visibility;
+
+			if(params.top_level && pidx != -1) {
+				/* Visibility of the object may have changed since packing. */
+				pack.prim_visibility[prim] = ob->visibility;
+				if(pack.prim_type[prim] & PRIMITIVE_ALL_CURVE)
+					pack.prim_visibility[prim] |= PATH_RAY_CURVE;
+			}
 		}
 
 		/* TODO(sergey): De-duplicate with pack_leaf(). */
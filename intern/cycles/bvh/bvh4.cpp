@@ -135,6 +135,17 @@ void BVH4::pack_aligned_node(int idx,
                              const float time_to,
                              const int num)
 {
+	if(params.use_compressed_nodes) {
+		pack_compressed_node(idx,
+		                     bounds,
+		                     child,
+		                     visibility,
+		                     time_from,
+		                     time_to,
+		                     num);
+		return;
+	}
+
 	float4 data[BVH_QNODE_SIZE];
 	memset(data, 0, sizeof(data));
 
@@ -175,6 +186,105 @@ void BVH4::pack_aligned_node(int idx,
 	memcpy(&pack.nodes[idx], data, sizeof(float4)*BVH_QNODE_SIZE);
 }
 
+/* Biased exponent of the smallest power of two scale which quantizes the
+ * range from origin to max into 8 bits. */
+static uint compressed_node_exponent(float origin, float max)
+{
+	int exponent = 0;
+	frexpf((max - origin)/255.0f, &exponent);
+	uint biased = clamp(exponent + 127, 1, 254);
+	/* Guard against rounding in the division. */
+	while(biased < 254 && origin + 255.0f*__uint_as_float(biased << 23) < max) {
+		biased++;
+	}
+	return biased;
+}
+
+/* Quantize bounds conservatively, so that dequantizing them the same way
+ * as the kernel does never gives a tighter box. Empty child bounds end up
+ * with min above max, and are never intersected. */
+static uint compressed_node_quantize_min(float value, float origin, float scale)
+{
+	const float q = floorf((value - origin)/scale);
+	int qi = (q <= 0.0f)? 0: (q >= 255.0f)? 255: (int)q;
+	while(qi > 0 && origin + qi*scale > value) {
+		qi--;
+	}
+	return qi;
+}
+
+static uint compressed_node_quantize_max(float value, float origin, float scale)
+{
+	const float q = ceilf((value - origin)/scale);
+	int qi = (q <= 0.0f)? 0: (q >= 255.0f)? 255: (int)q;
+	while(qi < 255 && origin + qi*scale < value) {
+		qi++;
+	}
+	return qi;
+}
+
+void BVH4::pack_compressed_node(int idx,
+                                const BoundBox *bounds,
+                                const int *child,
+                                const uint visibility,
+                                const float time_from,
+                                const float time_to,
+                                const int num)
+{
+	float4 data[BVH_COMPRESSED_QNODE_SIZE];
+	memset(data, 0, sizeof(data));
+
+	data[0].x = __uint_as_float(visibility & ~PATH_RAY_NODE_UNALIGNED);
+	data[0].y = time_from;
+	data[0].z = time_to;
+
+	BoundBox node_bounds = BoundBox::empty;
+	for(int i = 0; i < num; i++) {
+		node_bounds.grow(bounds[i]);
+	}
+	if(!node_bounds.valid()) {
+		node_bounds = BoundBox(make_float3(0.0f, 0.0f, 0.0f));
+	}
+
+	const float3 origin = node_bounds.min;
+	uint exponent[3];
+	float scale[3];
+	for(int axis = 0; axis < 3; axis++) {
+		exponent[axis] = compressed_node_exponent(origin[axis], node_bounds.max[axis]);
+		scale[axis] = __uint_as_float(exponent[axis] << 23);
+	}
+
+	data[1].x = origin.x;
+	data[1].y = origin.y;
+	data[1].z = origin.z;
+	data[1].w = __uint_as_float(exponent[0] | (exponent[1] << 8) | (exponent[2] << 16));
+
+	/* Child bounds, one byte per child for each of the six planes. Children
+	 * past num get inverted bounds, same as for regular nodes. */
+	uint planes[6] = {0, 0, 0, 0, 0, 0};
+	for(int i = 0; i < 4; i++) {
+		for(int axis = 0; axis < 3; axis++) {
+			uint qmin = 255, qmax = 0;
+			if(i < num) {
+				qmin = compressed_node_quantize_min(bounds[i].min[axis], origin[axis], scale[axis]);
+				qmax = compressed_node_quantize_max(bounds[i].max[axis], origin[axis], scale[axis]);
+			}
+			planes[axis*2 + 0] |= qmin << (i*8);
+			planes[axis*2 + 1] |= qmax << (i*8);
+		}
+		data[4][i] = __int_as_float((i < num)? child[i]: 0);
+	}
+
+	data[2].x = __uint_as_float(planes[0]);
+	data[2].y = __uint_as_float(planes[1]);
+	data[2].z = __uint_as_float(planes[2]);
+	data[2].w = __uint_as_float(planes[3]);
+	data[3].x = __uint_as_float(planes[4]);
+	data[3].y = __uint_as_float(planes[5]);
+
+	memcpy(&pack.nodes[idx], data, sizeof(float4)*BVH_COMPRESSED_QNODE_SIZE);
+}
+
 void BVH4::pack_unaligned_inner(const BVHStackEntry& e,
                                 const BVHStackEntry *en,
                                 int num)
@@ -266,6 +376,11 @@ void BVH4::pack_unaligned_node(int idx,
 
 /* Quad SIMD Nodes */
 
+int BVH4::aligned_node_size() const
+{
+	return (params.use_compressed_nodes)? BVH_COMPRESSED_QNODE_SIZE: BVH_QNODE_SIZE;
+}
+
 void BVH4::pack_nodes(const BVHNode *root)
 {
 	/* Calculate size of the arrays required. */
@@ -278,10 +393,10 @@ void BVH4::pack_nodes(const BVHNode *root)
 		const size_t num_unaligned_nodes =
 		        root->getSubtreeSize(BVH_STAT_UNALIGNED_INNER_QNODE_COUNT);
 		node_size = (num_unaligned_nodes * BVH_UNALIGNED_QNODE_SIZE) +
-		            (num_inner_nodes - num_unaligned_nodes) * BVH_QNODE_SIZE;
+		            (num_inner_nodes - num_unaligned_nodes) * aligned_node_size();
 	}
 	else {
-		node_size = num_inner_nodes * BVH_QNODE_SIZE;
+		node_size = num_inner_nodes * aligned_node_size();
 	}
 	/* Resize arrays. */
 	pack.nodes.clear();
@@ -306,7 +421,7 @@ void BVH4::pack_nodes(const BVHNode *root)
 		stack.push_back(BVHStackEntry(root, nextNodeIdx));
 		nextNodeIdx += node_qbvh_is_unaligned(root)
 		                       ? BVH_UNALIGNED_QNODE_SIZE
-		                       : BVH_QNODE_SIZE;
+		                       : aligned_node_size();
 	}
 
 	while(stack.size()) {
@@ -350,7 +465,7 @@ void BVH4::pack_nodes(const BVHNode *root)
 					idx = nextNodeIdx;
 					nextNodeIdx += node_qbvh_is_unaligned(nodes[i])
 					                       ? BVH_UNALIGNED_QNODE_SIZE
-					                       : BVH_QNODE_SIZE;
+					                       : aligned_node_size();
 				}
 				stack.push_back(BVHStackEntry(nodes[i], idx));
 			}
@@ -365,8 +480,6 @@ void BVH4::pack_nodes(const BVHNode *root)
 
 void BVH4::refit_nodes()
 {
-	assert(!params.top_level);
-
 	BoundBox bbox = BoundBox::empty;
 	uint visibility = 0;
 	refit_node(0, (pack.root_index == -1)? true: false, bbox, visibility);
@@ -377,8 +490,11 @@ void BVH4::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility)
 	if(leaf) {
 		int4 *data = &pack.leaf_nodes[idx];
 		int4 c = data[0];
-		/* Refit leaf node. */
-		for(int prim = c.x; prim < c.y; prim++) {
+		/* Refit leaf node, instances in the top level are packed as
+		 * ~prim with an empty range. */
+		const int prim_start = (c.x < 0)? ~c.x: c.x;
+		const int prim_end = (c.x < 0)? prim_start + 1: c.y;
+		for(int prim = prim_start; prim < prim_end; prim++) {
 			int pidx = pack.prim_index[prim];
 			int tob = pack.prim_object[prim];
 			Object *ob = objects[tob];
@@ -440,6 +556,13 @@ void BVH4::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility)
 			}
 
 			visibility |= ob->visibility;
+
+			if(params.top_level && pidx != -1) {
+				/* Visibility of the object may have changed since packing. */
+				pack.prim_visibility[prim] = ob->visibility;
+				if(pack.prim_type[prim] & PRIMITIVE_ALL_CURVE)
+					pack.prim_visibility[prim] |= PATH_RAY_CURVE;
+			}
 		}
 
 		/* TODO(sergey): This is actually a copy of pack_leaf(),
@@ -466,6 +589,9 @@ void BVH4::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility)
 		if(is_unaligned) {
 			c = data[13];
 		}
+		else if(params.use_compressed_nodes) {
+			c = data[4];
+		}
 		else {
 			c = data[7];
 		}
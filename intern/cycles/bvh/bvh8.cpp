@@ -0,0 +1,548 @@
+/*
+ * Copyright 2011-2017, Blender Foundation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "bvh/bvh8.h"
+
+#include "render/mesh.h"
+#include "render/object.h"
+
+#include "bvh/bvh_node.h"
+#include "bvh/bvh_unaligned.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Collect the children of an octo node from the binary tree, by opening the
+ * inner child with the largest surface area until all eight slots are used
+ * or only leaves are left.
+ */
+static int node_obvh_collect_children(const BVHNode *node,
+                                      const BVHNode *children[8])
+{
+	int num = 0;
+	children[num++] = node->get_child(0);
+	children[num++] = node->get_child(1);
+
+	while(num < 8) {
+		int best = -1;
+		float best_area = 0.0f;
+		for(int i = 0; i < num; i++) {
+			if(!children[i]->is_leaf()) {
+				float area = children[i]->bounds.safe_area();
+				if(best == -1 || area > best_area) {
+					best = i;
+					best_area = area;
+				}
+			}
+		}
+		if(best == -1) {
+			break;
+		}
+		const BVHNode *inner = children[best];
+		children[best] = inner->get_child(0);
+		children[num++] = inner->get_child(1);
+	}
+
+	return num;
+}
+
+static bool node_obvh_is_unaligned(const BVHNode *const *children, int num)
+{
+	for(int i = 0; i < num; i++) {
+		if(children[i]->is_unaligned) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/* Count the nodes of the collapsed tree, to know the size of the arrays. */
+static void node_obvh_count(const BVHNode *node,
+                            bool use_unaligned_nodes,
+                            size_t *num_aligned_inner,
+                            size_t *num_unaligned_inner,
+                            size_t *num_leaves)
+{
+	if(node->is_leaf()) {
+		++(*num_leaves);
+		return;
+	}
+
+	const BVHNode *children[8];
+	int num = node_obvh_collect_children(node, children);
+	if(use_unaligned_nodes && node_obvh_is_unaligned(children, num)) {
+		++(*num_unaligned_inner);
+	}
+	else {
+		++(*num_aligned_inner);
+	}
+
+	for(int i = 0; i < num; i++) {
+		node_obvh_count(children[i],
+		                use_unaligned_nodes,
+		                num_aligned_inner,
+		                num_unaligned_inner,
+		                num_leaves);
+	}
+}
+
+/* Row of per child values, spread over two float4. */
+static inline float *obvh_row(float4 *data, int row)
+{
+	return (float*)&data[1 + row*2];
+}
+
+BVH8::BVH8(const BVHParams& params_, const vector<Object*>& objects_)
+: BVH(params_, objects_)
+{
+	params.use_bvh8 = true;
+}
+
+void BVH8::pack_leaf(const BVHStackEntry& e, const LeafNode *leaf)
+{
+	float4 data[BVH_ONODE_LEAF_SIZE];
+	memset(data, 0, sizeof(data));
+	if(leaf->num_triangles() == 1 && pack.prim_index[leaf->lo] == -1) {
+		/* object */
+		data[0].x = __int_as_float(~(leaf->lo));
+		data[0].y = __int_as_float(0);
+	}
+	else {
+		/* triangle */
+		data[0].x = __int_as_float(leaf->lo);
+		data[0].y = __int_as_float(leaf->hi);
+	}
+	data[0].z = __uint_as_float(leaf->visibility);
+	if(leaf->num_triangles() != 0) {
+		data[0].w = __uint_as_float(pack.prim_type[leaf->lo]);
+	}
+
+	memcpy(&pack.leaf_nodes[e.idx], data, sizeof(float4)*BVH_ONODE_LEAF_SIZE);
+}
+
+void BVH8::pack_inner(const BVHStackEntry& e,
+                      const BVHStackEntry *en,
+                      int num)
+{
+	bool has_unaligned = false;
+	/* Check whether we have to create unaligned node or all nodes are aligned
+	 * and we can cut some corner here.
+	 */
+	if(params.use_unaligned_nodes) {
+		for(int i = 0; i < num; i++) {
+			if(en[i].node->is_unaligned) {
+				has_unaligned = true;
+				break;
+			}
+		}
+	}
+	if(has_unaligned) {
+		pack_unaligned_inner(e, en, num);
+	}
+	else {
+		pack_aligned_inner(e, en, num);
+	}
+}
+
+void BVH8::pack_aligned_inner(const BVHStackEntry& e,
+                              const BVHStackEntry *en,
+                              int num)
+{
+	BoundBox bounds[8];
+	int child[8];
+	for(int i = 0; i < num; ++i) {
+		bounds[i] = en[i].node->bounds;
+		child[i] = en[i].encodeIdx();
+	}
+	pack_aligned_node(e.idx,
+	                  bounds,
+	                  child,
+	                  e.node->visibility,
+	                  e.node->time_from,
+	                  e.node->time_to,
+	                  num);
+}
+
+void BVH8::pack_aligned_node(int idx,
+                             const BoundBox *bounds,
+                             const int *child,
+                             const uint visibility,
+                             const float time_from,
+                             const float time_to,
+                             const int num)
+{
+	float4 data[BVH_ONODE_SIZE];
+	memset(data, 0, sizeof(data));
+
+	data[0].x = __uint_as_float(visibility & ~PATH_RAY_NODE_UNALIGNED);
+	data[0].y = time_from;
+	data[0].z = time_to;
+
+	float *children = (float*)&data[13];
+
+	for(int i = 0; i < num; i++) {
+		float3 bb_min = bounds[i].min;
+		float3 bb_max = bounds[i].max;
+
+		obvh_row(data, 0)[i] = bb_min.x;
+		obvh_row(data, 1)[i] = bb_max.x;
+		obvh_row(data, 2)[i] = bb_min.y;
+		obvh_row(data, 3)[i] = bb_max.y;
+		obvh_row(data, 4)[i] = bb_min.z;
+		obvh_row(data, 5)[i] = bb_max.z;
+
+		children[i] = __int_as_float(child[i]);
+	}
+
+	for(int i = num; i < 8; i++) {
+		/* We store BB which would never be recorded as intersection
+		 * so kernel might safely assume there are always 8 child nodes.
+		 */
+		obvh_row(data, 0)[i] = FLT_MAX;
+		obvh_row(data, 1)[i] = -FLT_MAX;
+
+		obvh_row(data, 2)[i] = FLT_MAX;
+		obvh_row(data, 3)[i] = -FLT_MAX;
+
+		obvh_row(data, 4)[i] = FLT_MAX;
+		obvh_row(data, 5)[i] = -FLT_MAX;
+
+		children[i] = __int_as_float(0);
+	}
+
+	memcpy(&pack.nodes[idx], data, sizeof(float4)*BVH_ONODE_SIZE);
+}
+
+void BVH8::pack_unaligned_inner(const BVHStackEntry& e,
+                                const BVHStackEntry *en,
+                                int num)
+{
+	Transform aligned_space[8];
+	BoundBox bounds[8];
+	int child[8];
+	for(int i = 0; i < num; ++i) {
+		aligned_space[i] = en[i].node->get_aligned_space();
+		bounds[i] = en[i].node->bounds;
+		child[i] = en[i].encodeIdx();
+	}
+	pack_unaligned_node(e.idx,
+	                    aligned_space,
+	                    bounds,
+	                    child,
+	                    e.node->visibility,
+	                    e.node->time_from,
+	                    e.node->time_to,
+	                    num);
+}
+
+void BVH8::pack_unaligned_node(int idx,
+                               const Transform *aligned_space,
+                               const BoundBox *bounds,
+                               const int *child,
+                               const uint visibility,
+                               const float time_from,
+                               const float time_to,
+                               const int num)
+{
+	float4 data[BVH_UNALIGNED_ONODE_SIZE];
+	memset(data, 0, sizeof(data));
+
+	data[0].x = __uint_as_float(visibility | PATH_RAY_NODE_UNALIGNED);
+	data[0].y = time_from;
+	data[0].z = time_to;
+
+	float *children = (float*)&data[25];
+
+	for(int i = 0; i < num; i++) {
+		Transform space = BVHUnaligned::compute_node_transform(
+		        bounds[i],
+		        aligned_space[i]);
+
+		obvh_row(data, 0)[i] = space.x.x;
+		obvh_row(data, 1)[i] = space.x.y;
+		obvh_row(data, 2)[i] = space.x.z;
+
+		obvh_row(data, 3)[i] = space.y.x;
+		obvh_row(data, 4)[i] = space.y.y;
+		obvh_row(data, 5)[i] = space.y.z;
+
+		obvh_row(data, 6)[i] = space.z.x;
+		obvh_row(data, 7)[i] = space.z.y;
+		obvh_row(data, 8)[i] = space.z.z;
+
+		obvh_row(data, 9)[i] = space.x.w;
+		obvh_row(data, 10)[i] = space.y.w;
+		obvh_row(data, 11)[i] = space.z.w;
+
+		children[i] = __int_as_float(child[i]);
+	}
+
+	for(int i = num; i < 8; i++) {
+		/* We store BB which would never be recorded as intersection
+		 * so kernel might safely assume there are always 8 child nodes.
+		 */
+		obvh_row(data, 0)[i] = 1.0f;
+		obvh_row(data, 1)[i] = 0.0f;
+		obvh_row(data, 2)[i] = 0.0f;
+
+		obvh_row(data, 3)[i] = 0.0f;
+		obvh_row(data, 4)[i] = 0.0f;
+		obvh_row(data, 5)[i] = 0.0f;
+
+		obvh_row(data, 6)[i] = 0.0f;
+		obvh_row(data, 7)[i] = 0.0f;
+		obvh_row(data, 8)[i] = 0.0f;
+
+		obvh_row(data, 9)[i] = -FLT_MAX;
+		obvh_row(data, 10)[i] = -FLT_MAX;
+		obvh_row(data, 11)[i] = -FLT_MAX;
+
+		children[i] = __int_as_float(0);
+	}
+
+	memcpy(&pack.nodes[idx], data, sizeof(float4)*BVH_UNALIGNED_ONODE_SIZE);
+}
+
+/* Octo SIMD Nodes */
+
+void BVH8::pack_nodes(const BVHNode *root)
+{
+	/* Calculate size of the arrays required. */
+	size_t num_aligned_inner = 0, num_unaligned_inner = 0, num_leaf_nodes = 0;
+	node_obvh_count(root,
+	                params.use_unaligned_nodes,
+	                &num_aligned_inner,
+	                &num_unaligned_inner,
+	                &num_leaf_nodes);
+	const size_t node_size = num_aligned_inner * BVH_ONODE_SIZE +
+	                         num_unaligned_inner * BVH_UNALIGNED_ONODE_SIZE;
+	/* Resize arrays. */
+	pack.nodes.clear();
+	pack.leaf_nodes.clear();
+	/* For top level BVH, first merge existing BVH's so we know the offsets. */
+	if(params.top_level) {
+		pack_instances(node_size, num_leaf_nodes*BVH_ONODE_LEAF_SIZE);
+	}
+	else {
+		pack.nodes.resize(node_size);
+		pack.leaf_nodes.resize(num_leaf_nodes*BVH_ONODE_LEAF_SIZE);
+	}
+
+	int nextNodeIdx = 0, nextLeafNodeIdx = 0;
+
+	vector<BVHStackEntry> stack;
+	stack.reserve(BVHParams::MAX_DEPTH*8);
+	if(root->is_leaf()) {
+		stack.push_back(BVHStackEntry(root, nextLeafNodeIdx++));
+	}
+	else {
+		const BVHNode *nodes[8];
+		int numnodes = node_obvh_collect_children(root, nodes);
+		stack.push_back(BVHStackEntry(root, nextNodeIdx));
+		nextNodeIdx += (params.use_unaligned_nodes &&
+		                node_obvh_is_unaligned(nodes, numnodes))
+		                       ? BVH_UNALIGNED_ONODE_SIZE
+		                       : BVH_ONODE_SIZE;
+	}
+
+	while(stack.size()) {
+		BVHStackEntry e = stack.back();
+		stack.pop_back();
+
+		if(e.node->is_leaf()) {
+			/* leaf node */
+			const LeafNode *leaf = reinterpret_cast<const LeafNode*>(e.node);
+			pack_leaf(e, leaf);
+		}
+		else {
+			/* Inner node. */
+			const BVHNode *nodes[8];
+			int numnodes = node_obvh_collect_children(e.node, nodes);
+			/* Push entries on the stack. */
+			for(int i = 0; i < numnodes; ++i) {
+				int idx;
+				if(nodes[i]->is_leaf()) {
+					idx = nextLeafNodeIdx++;
+				}
+				else {
+					const BVHNode *grand_children[8];
+					int num_grand_children =
+					        node_obvh_collect_children(nodes[i], grand_children);
+					idx = nextNodeIdx;
+					nextNodeIdx += (params.use_unaligned_nodes &&
+					                node_obvh_is_unaligned(grand_children,
+					                                       num_grand_children))
+					                       ? BVH_UNALIGNED_ONODE_SIZE
+					                       : BVH_ONODE_SIZE;
+				}
+				stack.push_back(BVHStackEntry(nodes[i], idx));
+			}
+			/* Set node. */
+			pack_inner(e, &stack[stack.size()-numnodes], numnodes);
+		}
+	}
+	assert(node_size == nextNodeIdx);
+	/* Root index to start traversal at, to handle case of single leaf node. */
+	pack.root_index = (root->is_leaf())? -1: 0;
+}
+
+void BVH8::refit_nodes()
+{
+	BoundBox bbox = BoundBox::empty;
+	uint visibility = 0;
+	refit_node(0, (pack.root_index == -1)? true: false, bbox, visibility);
+}
+
+void BVH8::refit_node(int idx, bool leaf, BoundBox& bbox, uint& visibility)
+{
+	if(leaf) {
+		int4 *data = &pack.leaf_nodes[idx];
+		int4 c = data[0];
+		/* Refit leaf node, instances in the top level are packed as
+		 * ~prim with an empty range. */
+		const int prim_start = (c.x < 0)? ~c.x: c.x;
+		const int prim_end = (c.x < 0)? prim_start + 1: c.y;
+		for(int prim = prim_start; prim < prim_end; prim++) {
+			int pidx = pack.prim_index[prim];
+			int tob = pack.prim_object[prim];
+			Object *ob = objects[tob];
+
+			if(pidx == -1) {
+				/* Object instance. */
+				bbox.grow(ob->bounds);
+			}
+			else {
+				/* Primitives. */
+				const Mesh *mesh = ob->mesh;
+
+				if(pack.prim_type[prim] & PRIMITIVE_ALL_CURVE) {
+					/* Curves. */
+					int str_offset = (params.top_level)? mesh->curve_offset: 0;
+					Mesh::Curve curve = mesh->get_curve(pidx - str_offset);
+					int k = PRIMITIVE_UNPACK_SEGMENT(pack.prim_type[prim]);
+
+					curve.bounds_grow(k, &mesh->curve_keys[0], &mesh->curve_radius[0], bbox);
+
+					visibility |= PATH_RAY_CURVE;
+
+					/* Motion curves. */
+					if(mesh->use_motion_blur) {
+						Attribute *attr = mesh->curve_attributes.find(ATTR_STD_MOTION_VERTEX_POSITION);
+
+						if(attr) {
+							size_t mesh_size = mesh->curve_keys.size();
+							size_t steps = mesh->motion_steps - 1;
+							float3 *key_steps = attr->data_float3();
+
+							for(size_t i = 0; i < steps; i++)
+								curve.bounds_grow(k, key_steps + i*mesh_size, &mesh->curve_radius[0], bbox);
+						}
+					}
+				}
+				else {
+					/* Triangles. */
+					int tri_offset = (params.top_level)? mesh->tri_offset: 0;
+					Mesh::Triangle triangle = mesh->get_triangle(pidx - tri_offset);
+					const float3 *vpos = &mesh->verts[0];
+
+					triangle.bounds_grow(vpos, bbox);
+
+					/* Motion triangles. */
+					if(mesh->use_motion_blur) {
+						Attribute *attr = mesh->attributes.find(ATTR_STD_MOTION_VERTEX_POSITION);
+
+						if(attr) {
+							size_t mesh_size = mesh->verts.size();
+							size_t steps = mesh->motion_steps - 1;
+							float3 *vert_steps = attr->data_float3();
+
+							for(size_t i = 0; i < steps; i++)
+								triangle.bounds_grow(vert_steps + i*mesh_size, bbox);
+						}
+					}
+				}
+			}
+
+			visibility |= ob->visibility;
+
+			if(params.top_level && pidx != -1) {
+				/* Visibility of the object may have changed since packing. */
+				pack.prim_visibility[prim] = ob->visibility;
+				if(pack.prim_type[prim] & PRIMITIVE_ALL_CURVE)
+					pack.prim_visibility[prim] |= PATH_RAY_CURVE;
+			}
+		}
+
+		float4 leaf_data[BVH_ONODE_LEAF_SIZE];
+		leaf_data[0].x = __int_as_float(c.x);
+		leaf_data[0].y = __int_as_float(c.y);
+		leaf_data[0].z = __uint_as_float(visibility);
+		leaf_data[0].w = __uint_as_float(c.w);
+		memcpy(&pack.leaf_nodes[idx], leaf_data, sizeof(float4)*BVH_ONODE_LEAF_SIZE);
+	}
+	else {
+		int4 *data = &pack.nodes[idx];
+		bool is_unaligned = (data[0].x & PATH_RAY_NODE_UNALIGNED) != 0;
+		int c[8];
+		memcpy(c,
+		       &data[is_unaligned? 25: 13],
+		       sizeof(c));
+		/* Refit inner node, set bbox from children. */
+		BoundBox child_bbox[8] = {BoundBox::empty,
+		                          BoundBox::empty,
+		                          BoundBox::empty,
+		                          BoundBox::empty,
+		                          BoundBox::empty,
+		                          BoundBox::empty,
+		                          BoundBox::empty,
+		                          BoundBox::empty};
+		uint child_visibility[8] = {0};
+
+		for(int i = 0; i < 8; ++i) {
+			if(c[i] != 0) {
+				refit_node((c[i] < 0)? -c[i]-1: c[i], (c[i] < 0),
+				           child_bbox[i], child_visibility[i]);
+				bbox.grow(child_bbox[i]);
+				visibility |= child_visibility[i];
+			}
+		}
+
+		if(is_unaligned) {
+			Transform aligned_space[8];
+			for(int i = 0; i < 8; ++i) {
+				aligned_space[i] = transform_identity();
+			}
+			pack_unaligned_node(idx,
+			                    aligned_space,
+			                    child_bbox,
+			                    c,
+			                    visibility,
+			                    0.0f,
+			                    1.0f,
+			                    8);
+		}
+		else {
+			pack_aligned_node(idx,
+			                  child_bbox,
+			                  c,
+			                  visibility,
+			                  0.0f,
+			                  1.0f,
+			                  8);
+		}
+	}
+}
+
+CCL_NAMESPACE_END
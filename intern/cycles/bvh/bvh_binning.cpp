@@ -23,7 +23,10 @@
 
 #include "util/util_algorithm.h"
 #include "util/util_boundbox.h"
+#include "util/util_foreach.h"
+#include "util/util_task.h"
 #include "util/util_types.h"
+#include "util/util_vector.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -82,57 +85,45 @@ BVHObjectBinning::BVHObjectBinning(const BVHRange& job,
 	num_bins = min(size_t(MAX_BINS), size_t(4.0f + 0.05f*size()));
 	scale = rcp(cent_bounds_.size()) * make_float3((float)num_bins);
 
-	/* initialize binning counter and bounds */
-	BoundBox bin_bounds[MAX_BINS][4];	/* bounds for every bin in every dimension */
-	int4 bin_count[MAX_BINS];			/* number of primitives mapped to bin */
+	/* map geometry to bins, large ranges are binned by multiple threads into
+	 * bins of their own, which are merged afterwards */
+	Bins bins;
 
-	for(size_t i = 0; i < num_bins; i++) {
-		bin_count[i] = make_int4(0);
-		bin_bounds[i][0] = bin_bounds[i][1] = bin_bounds[i][2] = BoundBox::empty;
+	if(size() < BVHParams::PARALLEL_SPLIT_SIZE) {
+		bin_primitives(prims, start(), end(), &bins);
 	}
-
-	/* map geometry to bins, unrolled once */
-	{
-		ssize_t i;
-
-		for(i = 0; i < ssize_t(size()) - 1; i += 2) {
-			prefetch_L2(&prims[start() + i + 8]);
-
-			/* map even and odd primitive to bin */
-			const BVHReference& prim0 = prims[start() + i + 0];
-			const BVHReference& prim1 = prims[start() + i + 1];
-
-			BoundBox bounds0 = get_prim_bounds(prim0);
-			BoundBox bounds1 = get_prim_bounds(prim1);
-
-			int4 bin0 = get_bin(bounds0);
-			int4 bin1 = get_bin(bounds1);
-
-			/* increase bounds for bins for even primitive */
-			int b00 = (int)extract<0>(bin0); bin_count[b00][0]++; bin_bounds[b00][0].grow(bounds0);
-			int b01 = (int)extract<1>(bin0); bin_count[b01][1]++; bin_bounds[b01][1].grow(bounds0);
-			int b02 = (int)extract<2>(bin0); bin_count[b02][2]++; bin_bounds[b02][2].grow(bounds0);
-
-			/* increase bounds of bins for odd primitive */
-			int b10 = (int)extract<0>(bin1); bin_count[b10][0]++; bin_bounds[b10][0].grow(bounds1);
-			int b11 = (int)extract<1>(bin1); bin_count[b11][1]++; bin_bounds[b11][1].grow(bounds1);
-			int b12 = (int)extract<2>(bin1); bin_count[b12][2]++; bin_bounds[b12][2].grow(bounds1);
+	else {
+		const size_t block_size = BVHParams::PARALLEL_BLOCK_SIZE;
+		const size_t num_blocks = divide_up(size(), block_size);
+		vector<Bins> block_bins(num_blocks);
+		TaskPool pool;
+
+		for(size_t block = 0; block < num_blocks; block++) {
+			int first = start() + block*block_size;
+			int last = min(first + (int)block_size, end());
+			pool.push(function_bind(&BVHObjectBinning::bin_primitives,
+			                        this,
+			                        prims,
+			                        first,
+			                        last,
+			                        &block_bins[block]));
 		}
-
-		/* for uneven number of primitives */
-		if(i < ssize_t(size())) {
-			/* map primitive to bin */
-			const BVHReference& prim0 = prims[start() + i];
-			BoundBox bounds0 = get_prim_bounds(prim0);
-			int4 bin0 = get_bin(bounds0);
-
-			/* increase bounds of bins */
-			int b00 = (int)extract<0>(bin0); bin_count[b00][0]++; bin_bounds[b00][0].grow(bounds0);
-			int b01 = (int)extract<1>(bin0); bin_count[b01][1]++; bin_bounds[b01][1].grow(bounds0);
-			int b02 = (int)extract<2>(bin0); bin_count[b02][2]++; bin_bounds[b02][2].grow(bounds0);
+		pool.wait_work();
+
+		bins = block_bins[0];
+		for(size_t block = 1; block < num_blocks; block++) {
+			for(size_t i = 0; i < num_bins; i++) {
+				bins.count[i] = bins.count[i] + block_bins[block].count[i];
+				bins.bounds[i][0].grow(block_bins[block].bounds[i][0]);
+				bins.bounds[i][1].grow(block_bins[block].bounds[i][1]);
+				bins.bounds[i][2].grow(block_bins[block].bounds[i][2]);
+			}
 		}
 	}
 
+	int4 *bin_count = bins.count;
+	BoundBox (*bin_bounds)[4] = bins.bounds;
+
 	/* sweep from right to left and compute parallel prefix of merged bounds */
 	float4 r_area[MAX_BINS];	/* area of bounds of primitives on the right */
 	float4 r_count[MAX_BINS];	/* number of primitives on the right */
@@ -188,6 +179,185 @@ BVHObjectBinning::BVHObjectBinning(const BVHRange& job,
 	leafSAH = bounds_.half_area() * blocks(size());
 }
 
+void BVHObjectBinning::bin_primitives(const BVHReference *prims,
+                                      int first,
+                                      int last,
+                                      Bins *bins) const
+{
+	/* initialize binning counter and bounds */
+	int4 *bin_count = bins->count;				/* number of primitives mapped to bin */
+	BoundBox (*bin_bounds)[4] = bins->bounds;	/* bounds for every bin in every dimension */
+
+	for(size_t i = 0; i < num_bins; i++) {
+		bin_count[i] = make_int4(0);
+		bin_bounds[i][0] = bin_bounds[i][1] = bin_bounds[i][2] = BoundBox::empty;
+	}
+
+	/* map geometry to bins, unrolled once */
+	ssize_t i;
+
+	for(i = first; i < ssize_t(last) - 1; i += 2) {
+		prefetch_L2(&prims[i + 8]);
+
+		/* map even and odd primitive to bin */
+		const BVHReference& prim0 = prims[i + 0];
+		const BVHReference& prim1 = prims[i + 1];
+
+		BoundBox bounds0 = get_prim_bounds(prim0);
+		BoundBox bounds1 = get_prim_bounds(prim1);
+
+		int4 bin0 = get_bin(bounds0);
+		int4 bin1 = get_bin(bounds1);
+
+		/* increase bounds for bins for even primitive */
+		int b00 = (int)extract<0>(bin0); bin_count[b00][0]++; bin_bounds[b00][0].grow(bounds0);
+		int b01 = (int)extract<1>(bin0); bin_count[b01][1]++; bin_bounds[b01][1].grow(bounds0);
+		int b02 = (int)extract<2>(bin0); bin_count[b02][2]++; bin_bounds[b02][2].grow(bounds0);
+
+		/* increase bounds of bins for odd primitive */
+		int b10 = (int)extract<0>(bin1); bin_count[b10][0]++; bin_bounds[b10][0].grow(bounds1);
+		int b11 = (int)extract<1>(bin1); bin_count[b11][1]++; bin_bounds[b11][1].grow(bounds1);
+		int b12 = (int)extract<2>(bin1); bin_count[b12][2]++; bin_bounds[b12][2].grow(bounds1);
+	}
+
+	/* for uneven number of primitives */
+	if(i < ssize_t(last)) {
+		/* map primitive to bin */
+		const BVHReference& prim0 = prims[i];
+		BoundBox bounds0 = get_prim_bounds(prim0);
+		int4 bin0 = get_bin(bounds0);
+
+		/* increase bounds of bins */
+		int b00 = (int)extract<0>(bin0); bin_count[b00][0]++; bin_bounds[b00][0].grow(bounds0);
+		int b01 = (int)extract<1>(bin0); bin_count[b01][1]++; bin_bounds[b01][1].grow(bounds0);
+		int b02 = (int)extract<2>(bin0); bin_count[b02][2]++; bin_bounds[b02][2].grow(bounds0);
+	}
+}
+
+void BVHObjectBinning::split_classify(const BVHReference *prims,
+                                      int first,
+                                      int last,
+                                      uchar *is_left,
+                                      SplitBlock *block) const
+{
+	block->num_left = 0;
+	block->lgeom_bounds = block->rgeom_bounds = BoundBox::empty;
+	block->lcent_bounds = block->rcent_bounds = BoundBox::empty;
+
+	for(int i = first; i < last; i++) {
+		const BVHReference& prim = prims[i];
+		BoundBox unaligned_bounds = get_prim_bounds(prim);
+		float3 unaligned_center = unaligned_bounds.center2();
+		float3 center = prim.bounds().center2();
+
+		if(get_bin(unaligned_center)[dim] < pos) {
+			block->lgeom_bounds.grow(prim.bounds());
+			block->lcent_bounds.grow(center);
+			block->num_left++;
+			is_left[i - start()] = 1;
+		}
+		else {
+			block->rgeom_bounds.grow(prim.bounds());
+			block->rcent_bounds.grow(center);
+			is_left[i - start()] = 0;
+		}
+	}
+}
+
+void BVHObjectBinning::split_scatter(const BVHReference *prims,
+                                     int first,
+                                     int last,
+                                     const uchar *is_left,
+                                     size_t left_offset,
+                                     size_t right_offset,
+                                     BVHReference *dest) const
+{
+	for(int i = first; i < last; i++) {
+		if(is_left[i - start()]) {
+			dest[left_offset++] = prims[i];
+		}
+		else {
+			dest[right_offset++] = prims[i];
+		}
+	}
+}
+
+static void copy_references(const BVHReference *src, BVHReference *dest, size_t num)
+{
+	std::copy(src, src + num, dest);
+}
+
+/* Stable partition of the range in three parallel passes: classify every
+ * block of primitives, scatter them to their offsets in a temporary array
+ * computed from the per block counts, and copy them back. Returns the number
+ * of primitives on the left. */
+size_t BVHObjectBinning::split_parallel(BVHReference *prims,
+                                        BoundBox *lgeom_bounds,
+                                        BoundBox *rgeom_bounds,
+                                        BoundBox *lcent_bounds,
+                                        BoundBox *rcent_bounds) const
+{
+	const size_t N = size();
+	const size_t block_size = BVHParams::PARALLEL_BLOCK_SIZE;
+	const size_t num_blocks = divide_up(N, block_size);
+
+	vector<uchar> is_left(N);
+	vector<SplitBlock> blocks(num_blocks);
+	TaskPool pool;
+
+	for(size_t block = 0; block < num_blocks; block++) {
+		int first = start() + block*block_size;
+		int last = min(first + (int)block_size, end());
+		pool.push(function_bind(&BVHObjectBinning::split_classify,
+		                        this,
+		                        prims,
+		                        first,
+		                        last,
+		                        &is_left[0],
+		                        &blocks[block]));
+	}
+	pool.wait_work();
+
+	size_t num_left = 0;
+	foreach(const SplitBlock& block, blocks) {
+		lgeom_bounds->grow(block.lgeom_bounds);
+		rgeom_bounds->grow(block.rgeom_bounds);
+		lcent_bounds->grow(block.lcent_bounds);
+		rcent_bounds->grow(block.rcent_bounds);
+		num_left += block.num_left;
+	}
+
+	vector<BVHReference> sorted(N);
+	size_t left_offset = 0, right_offset = num_left;
+
+	for(size_t block = 0; block < num_blocks; block++) {
+		int first = start() + block*block_size;
+		int last = min(first + (int)block_size, end());
+		pool.push(function_bind(&BVHObjectBinning::split_scatter,
+		                        this,
+		                        prims,
+		                        first,
+		                        last,
+		                        &is_left[0],
+		                        left_offset,
+		                        right_offset,
+		                        &sorted[0]));
+		left_offset += blocks[block].num_left;
+		right_offset += (last - first) - blocks[block].num_left;
+	}
+	pool.wait_work();
+
+	for(size_t offset = 0; offset < N; offset += block_size) {
+		pool.push(function_bind(&copy_references,
+		                        &sorted[offset],
+		                        &prims[start() + offset],
+		                        min(block_size, N - offset)));
+	}
+	pool.wait_work();
+
+	return num_left;
+}
+
 void BVHObjectBinning::split(BVHReference* prims,
                              BVHObjectBinning& left_o,
                              BVHObjectBinning& right_o) const
@@ -201,6 +371,15 @@ void BVHObjectBinning::split(BVHReference* prims,
 
 	ssize_t l = 0, r = N-1;
 
+	if(N >= BVHParams::PARALLEL_SPLIT_SIZE) {
+		l = split_parallel(prims,
+		                   &lgeom_bounds,
+		                   &rgeom_bounds,
+		                   &lcent_bounds,
+		                   &rcent_bounds);
+		r = l - 1;
+	}
+
 	while(l <= r) {
 		prefetch_L2(&prims[start() + l + 8]);
 		prefetch_L2(&prims[start() + r - 8]);
@@ -27,12 +27,16 @@ CCL_NAMESPACE_BEGIN
 
 class BVHBuild;
 
-/* Single threaded object binner. Finds the split with the best SAH heuristic
- * by testing for each dimension multiple partitionings for regular spaced
- * partition locations. A partitioning for a partition location is computed,
- * by putting primitives whose centroid is on the left and right of the split
- * location to different sets. The SAH is evaluated by computing the number of
- * blocks occupied by the primitives in the partitions. */
+/* Object binner. Finds the split with the best SAH heuristic by testing for
+ * each dimension multiple partitionings for regular spaced partition
+ * locations. A partitioning for a partition location is computed, by putting
+ * primitives whose centroid is on the left and right of the split location to
+ * different sets. The SAH is evaluated by computing the number of blocks
+ * occupied by the primitives in the partitions.
+ *
+ * Ranges of at least BVHParams::PARALLEL_SPLIT_SIZE primitives, which are the
+ * top levels of the tree where there is not enough subtrees yet to keep all
+ * threads busy, are binned and partitioned by multiple threads. */
 
 class BVHObjectBinning : public BVHRange
 {
@@ -69,6 +73,42 @@ protected:
 	enum { MAX_BINS = 32 };
 	enum { LOG_BLOCK_SIZE = 2 };
 
+	/* Bounds and number of primitives of every bin in every dimension. */
+	struct Bins {
+		BoundBox bounds[MAX_BINS][4];
+		int4 count[MAX_BINS];
+	};
+
+	/* Primitives of one block of a parallel split, classified to either side. */
+	struct SplitBlock {
+		size_t num_left;
+		BoundBox lgeom_bounds, rgeom_bounds;
+		BoundBox lcent_bounds, rcent_bounds;
+	};
+
+	void bin_primitives(const BVHReference *prims,
+	                    int first,
+	                    int last,
+	                    Bins *bins) const;
+
+	void split_classify(const BVHReference *prims,
+	                    int first,
+	                    int last,
+	                    uchar *is_left,
+	                    SplitBlock *block) const;
+	void split_scatter(const BVHReference *prims,
+	                   int first,
+	                   int last,
+	                   const uchar *is_left,
+	                   size_t left_offset,
+	                   size_t right_offset,
+	                   BVHReference *dest) const;
+	size_t split_parallel(BVHReference *prims,
+	                      BoundBox *lgeom_bounds,
+	                      BoundBox *rgeom_bounds,
+	                      BoundBox *lcent_bounds,
+	                      BoundBox *rcent_bounds) const;
+
 	/* computes the bin numbers for each dimension for a box. */
 	__forceinline int4 get_bin(const BoundBox& box) const
 	{
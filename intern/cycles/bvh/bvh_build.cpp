@@ -88,6 +88,55 @@ private:
 	vector<BVHReference> references_;
 };
 
+/* BVH Reference Chunk
+ *
+ * Range of triangles or curves of one mesh, or a single instanced object, for
+ * which the references are created by one task. Chunks are processed twice,
+ * first only counting their references, then writing them to their range of
+ * the preallocated references array, so the references are identical to the
+ * serial ones without keeping a second copy of them. */
+
+struct BVHReferenceChunk {
+	BVHReferenceChunk(Object *object_,
+	                  Mesh *mesh_,
+	                  int object_index_,
+	                  bool curves_,
+	                  size_t start_,
+	                  size_t end_)
+	: object(object_),
+	  mesh(mesh_),
+	  object_index(object_index_),
+	  curves(curves_),
+	  start(start_),
+	  end(end_),
+	  references(NULL),
+	  num_references(0),
+	  bounds(BoundBox::empty),
+	  center(BoundBox::empty)
+	{
+	}
+
+	__forceinline void add_reference(const BVHReference& ref)
+	{
+		if(references != NULL) {
+			references[num_references] = ref;
+		}
+		num_references++;
+		bounds.grow(ref.bounds());
+		center.grow(ref.bounds().center2());
+	}
+
+	Object *object;
+	Mesh *mesh;  /* NULL for instanced objects. */
+	int object_index;
+	bool curves;
+	size_t start, end;
+
+	BVHReference *references;  /* NULL while counting. */
+	size_t num_references;
+	BoundBox bounds, center;
+};
+
 /* Constructor / Destructor */
 
 BVHBuild::BVHBuild(const vector<Object*>& objects_,
@@ -116,26 +165,25 @@ BVHBuild::~BVHBuild()
 
 /* Adding References */
 
-void BVHBuild::add_reference_triangles(BoundBox& root, BoundBox& center, Mesh *mesh, int i)
+void BVHBuild::add_reference_triangles(BVHReferenceChunk *chunk)
 {
+	Mesh *mesh = chunk->mesh;
+	const int i = chunk->object_index;
 	const Attribute *attr_mP = NULL;
 	if(mesh->has_motion_blur()) {
 		attr_mP = mesh->attributes.find(ATTR_STD_MOTION_VERTEX_POSITION);
 	}
-	const size_t num_triangles = mesh->num_triangles();
-	for(uint j = 0; j < num_triangles; j++) {
+	for(uint j = chunk->start; j < chunk->end; j++) {
 		Mesh::Triangle t = mesh->get_triangle(j);
 		const float3 *verts = &mesh->verts[0];
 		if(attr_mP == NULL) {
 			BoundBox bounds = BoundBox::empty;
 			t.bounds_grow(verts, bounds);
 			if(bounds.valid()) {
-				references.push_back(BVHReference(bounds,
+				chunk->add_reference(BVHReference(bounds,
 				                                  j,
 				                                  i,
 				                                  PRIMITIVE_TRIANGLE));
-				root.grow(bounds);
-				center.grow(bounds.center2());
 			}
 		}
 		else if(params.num_motion_triangle_steps == 0 || params.use_spatial_split) {
@@ -153,13 +201,11 @@ void BVHBuild::add_reference_triangles(BoundBox& root, BoundBox& center, Mesh *m
 				t.bounds_grow(vert_steps + step*num_verts, bounds);
 			}
 			if(bounds.valid()) {
-				references.push_back(
+				chunk->add_reference(
 				        BVHReference(bounds,
 				                     j,
 				                     i,
 				                     PRIMITIVE_MOTION_TRIANGLE));
-				root.grow(bounds);
-				center.grow(bounds.center2());
 			}
 		}
 		else {
@@ -205,15 +251,13 @@ void BVHBuild::add_reference_triangles(BoundBox& root, BoundBox& center, Mesh *m
 				bounds.grow(curr_bounds);
 				if(bounds.valid()) {
 					const float prev_time = (float)(bvh_step - 1) * num_bvh_steps_inv_1;
-					references.push_back(
+					chunk->add_reference(
 					        BVHReference(bounds,
 					                     j,
 					                     i,
 					                     PRIMITIVE_MOTION_TRIANGLE,
 					                     prev_time,
 					                     curr_time));
-					root.grow(bounds);
-					center.grow(bounds.center2());
 				}
 				/* Current time boundbox becomes previous one for the
 				 * next time step.
@@ -224,14 +268,15 @@ void BVHBuild::add_reference_triangles(BoundBox& root, BoundBox& center, Mesh *m
 	}
 }
 
-void BVHBuild::add_reference_curves(BoundBox& root, BoundBox& center, Mesh *mesh, int i)
+void BVHBuild::add_reference_curves(BVHReferenceChunk *chunk)
 {
+	Mesh *mesh = chunk->mesh;
+	const int i = chunk->object_index;
 	const Attribute *curve_attr_mP = NULL;
 	if(mesh->has_motion_blur()) {
 		curve_attr_mP = mesh->curve_attributes.find(ATTR_STD_MOTION_VERTEX_POSITION);
 	}
-	const size_t num_curves = mesh->num_curves();
-	for(uint j = 0; j < num_curves; j++) {
+	for(uint j = chunk->start; j < chunk->end; j++) {
 		const Mesh::Curve curve = mesh->get_curve(j);
 		const float *curve_radius = &mesh->curve_radius[0];
 		for(int k = 0; k < curve.num_keys - 1; k++) {
@@ -241,9 +286,7 @@ void BVHBuild::add_reference_curves(BoundBox& root, BoundBox& center, Mesh *mesh
 				curve.bounds_grow(k, &mesh->curve_keys[0], curve_radius, bounds);
 				if(bounds.valid()) {
 					int packed_type = PRIMITIVE_PACK_SEGMENT(PRIMITIVE_CURVE, k);
-					references.push_back(BVHReference(bounds, j, i, packed_type));
-					root.grow(bounds);
-					center.grow(bounds.center2());
+					chunk->add_reference(BVHReference(bounds, j, i, packed_type));
 				}
 			}
 			else if(params.num_motion_curve_steps == 0 || params.use_spatial_split) {
@@ -265,12 +308,10 @@ void BVHBuild::add_reference_curves(BoundBox& root, BoundBox& center, Mesh *mesh
 				}
 				if(bounds.valid()) {
 					int packed_type = PRIMITIVE_PACK_SEGMENT(PRIMITIVE_MOTION_CURVE, k);
-					references.push_back(BVHReference(bounds,
+					chunk->add_reference(BVHReference(bounds,
 					                                  j,
 					                                  i,
 					                                  packed_type));
-					root.grow(bounds);
-					center.grow(bounds.center2());
 				}
 			}
 			else {
@@ -318,14 +359,12 @@ void BVHBuild::add_reference_curves(BoundBox& root, BoundBox& center, Mesh *mesh
 					if(bounds.valid()) {
 						const float prev_time = (float)(bvh_step - 1) * num_bvh_steps_inv_1;
 						int packed_type = PRIMITIVE_PACK_SEGMENT(PRIMITIVE_MOTION_CURVE, k);
-						references.push_back(BVHReference(bounds,
+						chunk->add_reference(BVHReference(bounds,
 						                                  j,
 						                                  i,
 						                                  packed_type,
 						                                  prev_time,
 						                                  curr_time));
-						root.grow(bounds);
-						center.grow(bounds.center2());
 					}
 					/* Current time boundbox becomes previous one for the
 					 * next time step.
@@ -337,68 +376,52 @@ void BVHBuild::add_reference_curves(BoundBox& root, BoundBox& center, Mesh *mesh
 	}
 }
 
-void BVHBuild::add_reference_mesh(BoundBox& root, BoundBox& center, Mesh *mesh, int i)
-{
-	if(params.primitive_mask & PRIMITIVE_ALL_TRIANGLE) {
-		add_reference_triangles(root, center, mesh, i);
-	}
-	if(params.primitive_mask & PRIMITIVE_ALL_CURVE) {
-		add_reference_curves(root, center, mesh, i);
-	}
-}
-
-void BVHBuild::add_reference_object(BoundBox& root, BoundBox& center, Object *ob, int i)
+void BVHBuild::add_reference_object(BVHReferenceChunk *chunk)
 {
-	references.push_back(BVHReference(ob->bounds, -1, i, 0));
-	root.grow(ob->bounds);
-	center.grow(ob->bounds.center2());
+	Object *ob = chunk->object;
+	chunk->add_reference(BVHReference(ob->bounds, -1, chunk->object_index, 0));
 }
 
-static size_t count_curve_segments(Mesh *mesh)
+void BVHBuild::thread_add_references(BVHReferenceChunk *chunk)
 {
-	size_t num = 0, num_curves = mesh->num_curves();
+	if(progress.get_cancel())
+		return;
 
-	for(size_t i = 0; i < num_curves; i++)
-		num += mesh->get_curve(i).num_keys - 1;
+	chunk->num_references = 0;
+	chunk->bounds = BoundBox::empty;
+	chunk->center = BoundBox::empty;
 
-	return num;
+	if(chunk->curves)
+		add_reference_curves(chunk);
+	else
+		add_reference_triangles(chunk);
 }
 
-void BVHBuild::add_references(BVHRange& root)
+void BVHBuild::add_reference_chunks(vector<BVHReferenceChunk>& chunks, Object *ob, int i)
 {
-	/* reserve space for references */
-	size_t num_alloc_references = 0;
+	Mesh *mesh = ob->mesh;
 
-	foreach(Object *ob, objects) {
-		if(params.top_level) {
-			if(!ob->is_traceable()) {
-				continue;
-			}
-			if(!ob->mesh->is_instanced()) {
-				if(params.primitive_mask & PRIMITIVE_ALL_TRIANGLE) {
-					num_alloc_references += ob->mesh->num_triangles();
-				}
-				if(params.primitive_mask & PRIMITIVE_ALL_CURVE) {
-					num_alloc_references += count_curve_segments(ob->mesh);
-				}
-			}
-			else
-				num_alloc_references++;
+	if(params.primitive_mask & PRIMITIVE_ALL_TRIANGLE) {
+		const size_t num_triangles = mesh->num_triangles();
+		for(size_t start = 0; start < num_triangles; start += REFERENCE_CHUNK_SIZE) {
+			size_t end = min(start + REFERENCE_CHUNK_SIZE, num_triangles);
+			chunks.push_back(BVHReferenceChunk(ob, mesh, i, false, start, end));
 		}
-		else {
-			if(params.primitive_mask & PRIMITIVE_ALL_TRIANGLE) {
-				num_alloc_references += ob->mesh->num_triangles();
-			}
-			if(params.primitive_mask & PRIMITIVE_ALL_CURVE) {
-				num_alloc_references += count_curve_segments(ob->mesh);
-			}
+	}
+	if(params.primitive_mask & PRIMITIVE_ALL_CURVE) {
+		const size_t num_curves = mesh->num_curves();
+		for(size_t start = 0; start < num_curves; start += REFERENCE_CHUNK_SIZE) {
+			size_t end = min(start + REFERENCE_CHUNK_SIZE, num_curves);
+			chunks.push_back(BVHReferenceChunk(ob, mesh, i, true, start, end));
 		}
 	}
+}
 
-	references.reserve(num_alloc_references);
-
-	/* add references from objects */
-	BoundBox bounds = BoundBox::empty, center = BoundBox::empty;
+void BVHBuild::add_references(BVHRange& root)
+{
+	/* split objects into chunks of primitives, so that the references of
+	 * large meshes are created by multiple threads */
+	vector<BVHReferenceChunk> chunks;
 	int i = 0;
 
 	foreach(Object *ob, objects) {
@@ -408,18 +431,56 @@ void BVHBuild::add_references(BVHRange& root)
 				continue;
 			}
 			if(!ob->mesh->is_instanced())
-				add_reference_mesh(bounds, center, ob->mesh, i);
+				add_reference_chunks(chunks, ob, i);
 			else
-				add_reference_object(bounds, center, ob, i);
+				chunks.push_back(BVHReferenceChunk(ob, NULL, i, false, 0, 1));
 		}
 		else
-			add_reference_mesh(bounds, center, ob->mesh, i);
+			add_reference_chunks(chunks, ob, i);
 
 		i++;
+	}
+
+	/* count references of every chunk, then add them to their range of the
+	 * references array */
+	for(int pass = 0; pass < 2; pass++) {
+		if(pass == 1) {
+			size_t num_references = 0;
+			foreach(BVHReferenceChunk& chunk, chunks) {
+				num_references += chunk.num_references;
+			}
+			references.resize(num_references);
+
+			size_t offset = 0;
+			foreach(BVHReferenceChunk& chunk, chunks) {
+				chunk.references = (chunk.num_references)? &references[offset]: NULL;
+				offset += chunk.num_references;
+			}
+		}
+
+		/* instances are cheap enough to not be worth a task of their own */
+		foreach(BVHReferenceChunk& chunk, chunks) {
+			if(chunk.mesh == NULL) {
+				thread_add_references(&chunk);
+			}
+			else if(pass == 0 || chunk.num_references) {
+				task_pool.push(function_bind(&BVHBuild::thread_add_references,
+				                             this,
+				                             &chunk));
+			}
+		}
+		task_pool.wait_work();
 
 		if(progress.get_cancel()) return;
 	}
 
+	BoundBox bounds = BoundBox::empty, center = BoundBox::empty;
+
+	foreach(BVHReferenceChunk& chunk, chunks) {
+		bounds.grow(chunk.bounds);
+		center.grow(chunk.center);
+	}
+
 	/* happens mostly on empty meshes */
 	if(!bounds.valid())
 		bounds.grow(make_float3(0.0f, 0.0f, 0.0f));
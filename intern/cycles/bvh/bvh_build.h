@@ -31,6 +31,7 @@ CCL_NAMESPACE_BEGIN
 class Boundbox;
 class BVHBuildTask;
 class BVHNode;
+struct BVHReferenceChunk;
 class BVHSpatialSplitBuildTask;
 class BVHParams;
 class InnerNode;
@@ -64,10 +65,11 @@ protected:
 	friend class BVHObjectBinning;
 
 	/* Adding references. */
-	void add_reference_triangles(BoundBox& root, BoundBox& center, Mesh *mesh, int i);
-	void add_reference_curves(BoundBox& root, BoundBox& center, Mesh *mesh, int i);
-	void add_reference_mesh(BoundBox& root, BoundBox& center, Mesh *mesh, int i);
-	void add_reference_object(BoundBox& root, BoundBox& center, Object *ob, int i);
+	void add_reference_triangles(BVHReferenceChunk *chunk);
+	void add_reference_curves(BVHReferenceChunk *chunk);
+	void add_reference_object(BVHReferenceChunk *chunk);
+	void add_reference_chunks(vector<BVHReferenceChunk>& chunks, Object *ob, int i);
+	void thread_add_references(BVHReferenceChunk *chunk);
 	void add_references(BVHRange& root);
 
 	/* Building. */
@@ -84,7 +86,11 @@ protected:
 	                                const vector<BVHReference>& references) const;
 
 	/* Threads. */
-	enum { THREAD_TASK_SIZE = 4096 };
+	enum {
+		THREAD_TASK_SIZE = 4096,
+		/* Number of triangles or curves of a mesh per reference task. */
+		REFERENCE_CHUNK_SIZE = 16384
+	};
 	void thread_build_node(InnerNode *node,
 	                       int child,
 	                       BVHObjectBinning *range,
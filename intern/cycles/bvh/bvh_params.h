@@ -53,6 +53,19 @@ public:
 	/* QBVH */
 	bool use_qbvh;
 
+	/* Octo BVH, traversed with AVX2 on the CPU. Takes precedence over QBVH. */
+	bool use_bvh8;
+
+	/* Quantize child bounds of aligned QBVH nodes relative to their parent,
+	 * nearly halving the size of the nodes.
+	 */
+	bool use_compressed_nodes;
+
+	/* Don't store a copy of the vertices of every triangle, the kernel looks
+	 * them up through the mesh vertex indices instead.
+	 */
+	bool use_indexed_triangles;
+
 	/* Mask of primitives to be included into the BVH. */
 	int primitive_mask;
 
@@ -76,7 +89,12 @@ public:
 	enum {
 		MAX_DEPTH = 64,
 		MAX_SPATIAL_DEPTH = 48,
-		NUM_SPATIAL_BINS = 32
+		NUM_SPATIAL_BINS = 32,
+		/* Ranges of at least this many references are binned and partitioned
+		 * by multiple threads, in blocks of PARALLEL_BLOCK_SIZE references.
+		 */
+		PARALLEL_SPLIT_SIZE = 65536,
+		PARALLEL_BLOCK_SIZE = 16384
 	};
 
 	BVHParams()
@@ -99,6 +117,9 @@ public:
 
 		top_level = false;
 		use_qbvh = false;
+		use_bvh8 = false;
+		use_compressed_nodes = false;
+		use_indexed_triangles = false;
 		use_unaligned_nodes = false;
 
 		primitive_mask = PRIMITIVE_ALL;
@@ -119,6 +140,18 @@ public:
 
 	__forceinline bool small_enough_for_leaf(int size, int level)
 	{ return (size <= min_leaf_size || level >= MAX_DEPTH); }
+
+	bool modified(const BVHParams& params) const
+	{ return !(use_spatial_split == params.use_spatial_split
+		&& top_level == params.top_level
+		&& use_qbvh == params.use_qbvh
+		&& use_bvh8 == params.use_bvh8
+		&& use_compressed_nodes == params.use_compressed_nodes
+		&& use_indexed_triangles == params.use_indexed_triangles
+		&& primitive_mask == params.primitive_mask
+		&& use_unaligned_nodes == params.use_unaligned_nodes
+		&& num_motion_curve_steps == params.num_motion_curve_steps
+		&& num_motion_triangle_steps == params.num_motion_triangle_steps); }
 };
 
 /* BVH Reference
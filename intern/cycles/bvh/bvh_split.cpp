@@ -159,52 +159,53 @@ BVHSpatialSplit::BVHSpatialSplit(const BVHBuild& builder,
 		        *aligned_space);
 	}
 
-	float3 origin = range_bounds.min;
-	float3 binSize = (range_bounds.max - origin) * (1.0f / (float)BVHParams::NUM_SPATIAL_BINS);
-	float3 invBinSize = 1.0f / binSize;
-
-	for(int dim = 0; dim < 3; dim++) {
-		for(int i = 0; i < BVHParams::NUM_SPATIAL_BINS; i++) {
-			BVHSpatialBin& bin = storage_->bins[dim][i];
-
-			bin.bounds = BoundBox::empty;
-			bin.enter = 0;
-			bin.exit = 0;
-		}
+	/* chop references into bins, large ranges are binned by multiple threads
+	 * into bins of their own, which are merged afterwards. */
+	if(range.size() < BVHParams::PARALLEL_SPLIT_SIZE) {
+		bin_references(&builder,
+		               range.start(),
+		               range.end(),
+		               &range_bounds,
+		               storage_->bins);
 	}
-
-	/* chop references into bins. */
-	for(unsigned int refIdx = range.start(); refIdx < range.end(); refIdx++) {
-		const BVHReference& ref = references_->at(refIdx);
-		BoundBox prim_bounds = get_prim_bounds(ref);
-		float3 firstBinf = (prim_bounds.min - origin) * invBinSize;
-		float3 lastBinf = (prim_bounds.max - origin) * invBinSize;
-		int3 firstBin = make_int3((int)firstBinf.x, (int)firstBinf.y, (int)firstBinf.z);
-		int3 lastBin = make_int3((int)lastBinf.x, (int)lastBinf.y, (int)lastBinf.z);
-
-		firstBin = clamp(firstBin, 0, BVHParams::NUM_SPATIAL_BINS - 1);
-		lastBin = clamp(lastBin, firstBin, BVHParams::NUM_SPATIAL_BINS - 1);
+	else {
+		const int block_size = BVHParams::PARALLEL_BLOCK_SIZE;
+		const int num_blocks = divide_up(range.size(), block_size);
+		vector<Bins> block_bins(num_blocks);
+		TaskPool pool;
+
+		for(int block = 0; block < num_blocks; block++) {
+			int first = range.start() + block*block_size;
+			int last = min(first + block_size, range.end());
+			pool.push(function_bind(&BVHSpatialSplit::bin_references,
+			                        this,
+			                        &builder,
+			                        first,
+			                        last,
+			                        &range_bounds,
+			                        block_bins[block].bins));
+		}
+		pool.wait_work();
 
 		for(int dim = 0; dim < 3; dim++) {
-			BVHReference currRef(get_prim_bounds(ref),
-			                     ref.prim_index(),
-			                     ref.prim_object(),
-			                     ref.prim_type());
+			for(int i = 0; i < BVHParams::NUM_SPATIAL_BINS; i++) {
+				BVHSpatialBin& bin = storage_->bins[dim][i];
 
-			for(int i = firstBin[dim]; i < lastBin[dim]; i++) {
-				BVHReference leftRef, rightRef;
+				bin = block_bins[0].bins[dim][i];
+				for(int block = 1; block < num_blocks; block++) {
+					const BVHSpatialBin& block_bin = block_bins[block].bins[dim][i];
 
-				split_reference(builder, leftRef, rightRef, currRef, dim, origin[dim] + binSize[dim] * (float)(i + 1));
-				storage_->bins[dim][i].bounds.grow(leftRef.bounds());
-				currRef = rightRef;
+					bin.bounds.grow(block_bin.bounds);
+					bin.enter += block_bin.enter;
+					bin.exit += block_bin.exit;
+				}
 			}
-
-			storage_->bins[dim][lastBin[dim]].bounds.grow(currRef.bounds());
-			storage_->bins[dim][firstBin[dim]].enter++;
-			storage_->bins[dim][lastBin[dim]].exit++;
 		}
 	}
 
+	float3 origin = range_bounds.min;
+	float3 binSize = (range_bounds.max - origin) * (1.0f / (float)BVHParams::NUM_SPATIAL_BINS);
+
 	/* select best split plane. */
 	storage_->right_bounds.resize(BVHParams::NUM_SPATIAL_BINS);
 	for(int dim = 0; dim < 3; dim++) {
@@ -238,6 +239,58 @@ BVHSpatialSplit::BVHSpatialSplit(const BVHBuild& builder,
 	}
 }
 
+void BVHSpatialSplit::bin_references(const BVHBuild *builder,
+                                     int first,
+                                     int last,
+                                     const BoundBox *range_bounds,
+                                     BVHSpatialBin (*bins)[BVHParams::NUM_SPATIAL_BINS])
+{
+	float3 origin = range_bounds->min;
+	float3 binSize = (range_bounds->max - origin) * (1.0f / (float)BVHParams::NUM_SPATIAL_BINS);
+	float3 invBinSize = 1.0f / binSize;
+
+	for(int dim = 0; dim < 3; dim++) {
+		for(int i = 0; i < BVHParams::NUM_SPATIAL_BINS; i++) {
+			BVHSpatialBin& bin = bins[dim][i];
+
+			bin.bounds = BoundBox::empty;
+			bin.enter = 0;
+			bin.exit = 0;
+		}
+	}
+
+	for(int refIdx = first; refIdx < last; refIdx++) {
+		const BVHReference& ref = references_->at(refIdx);
+		BoundBox prim_bounds = get_prim_bounds(ref);
+		float3 firstBinf = (prim_bounds.min - origin) * invBinSize;
+		float3 lastBinf = (prim_bounds.max - origin) * invBinSize;
+		int3 firstBin = make_int3((int)firstBinf.x, (int)firstBinf.y, (int)firstBinf.z);
+		int3 lastBin = make_int3((int)lastBinf.x, (int)lastBinf.y, (int)lastBinf.z);
+
+		firstBin = clamp(firstBin, 0, BVHParams::NUM_SPATIAL_BINS - 1);
+		lastBin = clamp(lastBin, firstBin, BVHParams::NUM_SPATIAL_BINS - 1);
+
+		for(int dim = 0; dim < 3; dim++) {
+			BVHReference currRef(get_prim_bounds(ref),
+			                     ref.prim_index(),
+			                     ref.prim_object(),
+			                     ref.prim_type());
+
+			for(int i = firstBin[dim]; i < lastBin[dim]; i++) {
+				BVHReference leftRef, rightRef;
+
+				split_reference(*builder, leftRef, rightRef, currRef, dim, origin[dim] + binSize[dim] * (float)(i + 1));
+				bins[dim][i].bounds.grow(leftRef.bounds());
+				currRef = rightRef;
+			}
+
+			bins[dim][lastBin[dim]].bounds.grow(currRef.bounds());
+			bins[dim][firstBin[dim]].enter++;
+			bins[dim][lastBin[dim]].exit++;
+		}
+	}
+}
+
 void BVHSpatialSplit::split(BVHBuild *builder,
                             BVHRange& left,
                             BVHRange& right,
@@ -108,6 +108,20 @@ protected:
 	const BVHUnaligned *unaligned_heuristic_;
 	const Transform *aligned_space_;
 
+	/* Bins of one block of references when binning in parallel. */
+	struct Bins {
+		BVHSpatialBin bins[3][BVHParams::NUM_SPATIAL_BINS];
+	};
+
+	/* Chops the references in [first, last) into the spatial bins of the
+	 * given range bounds.
+	 */
+	void bin_references(const BVHBuild *builder,
+	                    int first,
+	                    int last,
+	                    const BoundBox *range_bounds,
+	                    BVHSpatialBin (*bins)[BVHParams::NUM_SPATIAL_BINS]);
+
 	/* Lower-level functions which calculates boundaries of left and right nodes
 	 * needed for spatial split.
 	 *
@@ -55,6 +55,7 @@ public:
 	bool advanced_shading;
 	bool pack_images;
 	bool has_bindless_textures; /* flag for GPU and Multi device */
+	bool has_bvh8; /* Device can traverse 8-wide BVH nodes. */
 	bool use_split_kernel; /* Denotes if the device is going to run cycles using split-kernel */
 	vector<DeviceInfo> multi_devices;
 
@@ -67,6 +68,7 @@ public:
 		advanced_shading = true;
 		pack_images = false;
 		has_bindless_textures = false;
+		has_bvh8 = false;
 		use_split_kernel = false;
 	}
 
@@ -307,6 +309,9 @@ public:
 	/* open shading language, only for CPU device */
 	virtual void *osl_memory() { return NULL; }
 
+	/* image textures streamed from disk, only for CPU device */
+	virtual void *oiio_memory() { return NULL; }
+
 	/* load/compile kernels, must be called before adding tasks */ 
 	virtual bool load_kernels(
 	        const DeviceRequestedFeatures& /*requested_features*/)
@@ -34,6 +34,7 @@
 #include "kernel/kernel_types.h"
 #include "kernel/split/kernel_split_data.h"
 #include "kernel/kernel_globals.h"
+#include "kernel/kernel_oiio_globals.h"
 
 #include "kernel/filter/filter.h"
 
@@ -164,12 +165,18 @@ public:
 #ifdef WITH_OSL
 	OSLGlobals osl_globals;
 #endif
+	OIIOGlobals oiio_globals;
 
 	bool use_split_kernel;
+	bool use_ray_stream;
 
 	DeviceRequestedFeatures requested_features;
 
 	KernelFunctions<void(*)(KernelGlobals *, float *, unsigned int *, int, int, int, int, int)>   path_trace_kernel;
+	KernelFunctions<void(*)(KernelGlobals *, float *, int, int, int, int, int)>                   adaptive_stopping_kernel;
+	KernelFunctions<bool(*)(KernelGlobals *, float *, int, int, int, int, int, int)>              adaptive_filter_x_kernel;
+	KernelFunctions<bool(*)(KernelGlobals *, float *, int, int, int, int, int, int)>              adaptive_filter_y_kernel;
+	KernelFunctions<void(*)(KernelGlobals *, float *, int, int, int, int, int)>                   adaptive_adjust_samples_kernel;
 	KernelFunctions<void(*)(KernelGlobals *, uchar4 *, float *, float, int, int, int, int)>       convert_to_half_float_kernel;
 	KernelFunctions<void(*)(KernelGlobals *, uchar4 *, float *, float, int, int, int, int)>       convert_to_byte_kernel;
 	KernelFunctions<void(*)(KernelGlobals *, uint4 *, float4 *, float*, int, int, int, int, int)> shader_kernel;
@@ -206,6 +213,10 @@ public:
 	: Device(info, stats, background),
 #define REGISTER_KERNEL(name) name ## _kernel(KERNEL_FUNCTIONS(name))
 	  REGISTER_KERNEL(path_trace),
+	  REGISTER_KERNEL(adaptive_stopping),
+	  REGISTER_KERNEL(adaptive_filter_x),
+	  REGISTER_KERNEL(adaptive_filter_y),
+	  REGISTER_KERNEL(adaptive_adjust_samples),
 	  REGISTER_KERNEL(convert_to_half_float),
 	  REGISTER_KERNEL(convert_to_byte),
 	  REGISTER_KERNEL(shader),
@@ -228,14 +239,20 @@ public:
 #ifdef WITH_OSL
 		kernel_globals.osl = &osl_globals;
 #endif
+		kernel_globals.oiio = NULL;
 		use_split_kernel = DebugFlags().cpu.split_kernel;
 		if(use_split_kernel) {
 			VLOG(1) << "Will be using split kernel.";
 		}
+		use_ray_stream = use_split_kernel && DebugFlags().cpu.ray_stream;
+		if(use_ray_stream) {
+			VLOG(1) << "Will be using ray streams.";
+		}
 
 #define REGISTER_SPLIT_KERNEL(name) split_kernels[#name] = KernelFunctions<void(*)(KernelGlobals*, KernelData*)>(KERNEL_FUNCTIONS(name))
 		REGISTER_SPLIT_KERNEL(path_init);
 		REGISTER_SPLIT_KERNEL(scene_intersect);
+		REGISTER_SPLIT_KERNEL(scene_intersect_stream);
 		REGISTER_SPLIT_KERNEL(lamp_emission);
 		REGISTER_SPLIT_KERNEL(do_volume);
 		REGISTER_SPLIT_KERNEL(queue_enqueue);
@@ -361,6 +378,11 @@ public:
 #endif
 	}
 
+	void *oiio_memory()
+	{
+		return &oiio_globals;
+	}
+
 	void thread_run(DeviceTask *task)
 	{
 		if(task->type == DeviceTask::RENDER) {
@@ -611,6 +633,33 @@ public:
 		return true;
 	}
 
+	/* Dilate unconverged pixels over the tile, returns true when all pixels converged. */
+	bool adaptive_sampling_filter(KernelGlobals *kg, RenderTile &tile, int sample)
+	{
+		float *render_buffer = (float*)tile.buffer;
+		bool any = false;
+
+		for(int y = tile.y; y < tile.y + tile.h; y++) {
+			any |= adaptive_filter_x_kernel()(kg, render_buffer, sample, y, tile.x, tile.w, tile.offset, tile.stride);
+		}
+		for(int x = tile.x; x < tile.x + tile.w; x++) {
+			any |= adaptive_filter_y_kernel()(kg, render_buffer, sample, x, tile.y, tile.h, tile.offset, tile.stride);
+		}
+
+		return !any;
+	}
+
+	void adaptive_sampling_adjust_samples(KernelGlobals *kg, RenderTile &tile)
+	{
+		float *render_buffer = (float*)tile.buffer;
+
+		for(int y = tile.y; y < tile.y + tile.h; y++) {
+			for(int x = tile.x; x < tile.x + tile.w; x++) {
+				adaptive_adjust_samples_kernel()(kg, render_buffer, tile.sample, x, y, tile.offset, tile.stride);
+			}
+		}
+	}
+
 	void path_trace(DeviceTask &task, RenderTile &tile, KernelGlobals *kg)
 	{
 		float *render_buffer = (float*)tile.buffer;
@@ -618,23 +667,55 @@ public:
 		int start_sample = tile.start_sample;
 		int end_sample = tile.start_sample + tile.num_samples;
 
+		const KernelData *data = &kg->__data;
+		const bool use_adaptive_sampling = (data->film.pass_adaptive_aux_buffer != 0);
+		const int pass_stride = data->film.pass_stride;
+		const int aux_converged = data->film.pass_adaptive_aux_buffer + 3;
+
 		for(int sample = start_sample; sample < end_sample; sample++) {
 			if(task.get_cancel() || task_pool.canceled()) {
 				if(task.need_finish_queue == false)
 					break;
 			}
 
+			/* Test convergence every few samples once the minimum is reached. */
+			const bool adaptive_check = use_adaptive_sampling &&
+			                            (sample + 1 >= data->integrator.adaptive_min_samples) &&
+			                            ((sample + 1) % data->integrator.adaptive_step == 0);
+
 			for(int y = tile.y; y < tile.y + tile.h; y++) {
 				for(int x = tile.x; x < tile.x + tile.w; x++) {
+					if(use_adaptive_sampling) {
+						const float *pixel = render_buffer + (tile.offset + x + y*tile.stride)*pass_stride;
+						if(pixel[aux_converged] != 0.0f) {
+							continue;
+						}
+					}
+
 					path_trace_kernel()(kg, render_buffer, rng_state,
 					                    sample, x, y, tile.offset, tile.stride);
+
+					if(adaptive_check) {
+						adaptive_stopping_kernel()(kg, render_buffer, sample + 1, x, y, tile.offset, tile.stride);
+					}
 				}
 			}
 
 			tile.sample = sample + 1;
 
+			if(adaptive_check && adaptive_sampling_filter(kg, tile, tile.sample)) {
+				/* All pixels converged, the remaining samples are accounted as done. */
+				task.update_progress(&tile, tile.w*tile.h*(end_sample - sample));
+				tile.sample = end_sample;
+				break;
+			}
+
 			task.update_progress(&tile, tile.w*tile.h);
 		}
+
+		if(use_adaptive_sampling) {
+			adaptive_sampling_adjust_samples(kg, tile);
+		}
 	}
 
 	void denoise(DeviceTask &task, RenderTile &tile)
@@ -747,6 +828,7 @@ public:
 	void thread_shader(DeviceTask& task)
 	{
 		KernelGlobals kg = kernel_globals;
+		kg.oiio = (oiio_globals.texture_system != NULL)? &oiio_globals: NULL;
 
 #ifdef WITH_OSL
 		OSLShader::thread_init(&kg, &kernel_globals, &osl_globals);
@@ -818,6 +900,7 @@ protected:
 			kg.decoupled_volume_steps[i] = NULL;
 		}
 		kg.decoupled_volume_steps_index = 0;
+		kg.oiio = (oiio_globals.texture_system != NULL)? &oiio_globals: NULL;
 #ifdef WITH_OSL
 		OSLShader::thread_init(&kg, &kernel_globals, &osl_globals);
 #endif
@@ -858,8 +941,10 @@ class CPUSplitKernelFunction : public SplitKernelFunction {
 public:
 	CPUDevice* device;
 	void (*func)(KernelGlobals *kg, KernelData *data);
+	/* Kernel processes all rays in one invocation. */
+	bool is_stream;
 
-	CPUSplitKernelFunction(CPUDevice* device) : device(device), func(NULL) {}
+	CPUSplitKernelFunction(CPUDevice* device) : device(device), func(NULL), is_stream(false) {}
 	~CPUSplitKernelFunction() {}
 
 	virtual bool enqueue(const KernelDimensions& dim, device_memory& kernel_globals, device_memory& data)
@@ -871,6 +956,14 @@ public:
 		KernelGlobals *kg = (KernelGlobals*)kernel_globals.device_pointer;
 		kg->global_size = make_int2(dim.global_size[0], dim.global_size[1]);
 
+		if(is_stream) {
+			kg->global_id = make_int2(0, 0);
+
+			func(kg, (KernelData*)data.device_pointer);
+
+			return true;
+		}
+
 		for(int y = 0; y < dim.global_size[1]; y++) {
 			for(int x = 0; x < dim.global_size[0]; x++) {
 				kg->global_id = make_int2(x, y);
@@ -935,6 +1028,12 @@ SplitKernelFunction* CPUSplitKernel::get_split_kernel_function(string kernel_nam
 {
 	CPUSplitKernelFunction *kernel = new CPUSplitKernelFunction(device);
 
+	/* Gather rays into streams to traverse the BVH with coherent rays together. */
+	if(device->use_ray_stream && kernel_name == "scene_intersect") {
+		kernel_name = "scene_intersect_stream";
+		kernel->is_stream = true;
+	}
+
 	kernel->func = device->split_kernels[kernel_name]();
 	if(!kernel->func) {
 		delete kernel;
@@ -974,6 +1073,11 @@ void device_cpu_info(vector<DeviceInfo>& devices)
 	info.num = 0;
 	info.advanced_shading = true;
 	info.pack_images = false;
+#ifdef WITH_CYCLES_OPTIMIZED_KERNEL_AVX2
+	/* Ray streams traverse 4-wide nodes only. */
+	info.has_bvh8 = system_cpu_support_avx2() &&
+	                !(DebugFlags().cpu.split_kernel && DebugFlags().cpu.ray_stream);
+#endif
 
 	devices.insert(devices.begin(), info);
 }
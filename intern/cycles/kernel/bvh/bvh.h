@@ -34,6 +34,11 @@ CCL_NAMESPACE_BEGIN
 #  include "kernel/bvh/qbvh_nodes.h"
 #endif
 
+/* Common OBVH functions. */
+#ifdef __OBVH__
+#  include "kernel/bvh/obvh_nodes.h"
+#endif
+
 /* Regular BVH traversal */
 
 #include "kernel/bvh/bvh_nodes.h"
@@ -152,6 +157,12 @@ CCL_NAMESPACE_BEGIN
 #  endif
 #endif  /* __VOLUME_RECORD_ALL__ */
 
+/* Ray stream traversal, for the CPU split kernel */
+
+#ifdef __BVH_STREAM__
+#  include "kernel/bvh/bvh_stream.h"
+#endif
+
 #undef BVH_FEATURE
 #undef BVH_NAME_JOIN
 #undef BVH_NAME_EVAL
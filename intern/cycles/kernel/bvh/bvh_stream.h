@@ -0,0 +1,348 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* Ray stream traversal
+ *
+ * Intersects a stream of rays with the QBVH at once, for coherent rays like
+ * the camera rays of a tile. Every node is fetched and tested once for all
+ * rays of the stream which reach it, and the rays are partitioned over the
+ * children they hit, rather than having each ray walk the tree on its own.
+ * Only closest hit queries of triangle scenes are supported, with or without
+ * instancing and motion blur. */
+
+/* Maximum number of rays traversed together. */
+#define BVH_STREAM_SIZE 64
+
+/* Stream ray in the space of the instance currently being traversed. */
+struct BVHStreamRay {
+	float3 P;
+	float3 dir;
+	float3 idir;
+	int near_x, near_y, near_z;
+	int far_x, far_y, far_z;
+#ifdef __OBJECT_MOTION__
+	Transform ob_itfm;
+#endif
+};
+
+/* Node to traverse with the rays in ray_ids[offset .. offset + num]. Instance
+ * exits are marked with an ENTRYPOINT_SENTINEL node address. */
+struct BVHStreamStackItem {
+	int addr;
+	int object;
+	int offset;
+	int num;
+};
+
+ccl_device_inline bool scene_intersect_stream_supported(KernelGlobals *kg)
+{
+	return kernel_data.bvh.use_qbvh &&
+	       !kernel_data.bvh.use_bvh8 &&
+	       !kernel_data.bvh.have_curves;
+}
+
+ccl_device_inline void bvh_stream_ray_setup(BVHStreamRay *sray,
+                                            const float3 P,
+                                            const float3 dir,
+                                            const float3 idir)
+{
+	sray->P = P;
+	sray->dir = dir;
+	sray->idir = idir;
+	qbvh_near_far_idx_calc(idir,
+	                       &sray->near_x, &sray->near_y, &sray->near_z,
+	                       &sray->far_x, &sray->far_y, &sray->far_z);
+}
+
+ccl_device_inline int bvh_stream_node_intersect(KernelGlobals *kg,
+                                                const BVHStreamRay *sray,
+                                                const float t,
+                                                const int node_addr,
+                                                ssef *dist)
+{
+	const ssef tnear(0.0f), tfar(t);
+	const sse3f idir4(ssef(sray->idir.x), ssef(sray->idir.y), ssef(sray->idir.z));
+#ifdef __KERNEL_AVX2__
+	const float3 P_idir = sray->P*sray->idir;
+	const sse3f P_idir4(P_idir.x, P_idir.y, P_idir.z);
+#else
+	const sse3f org4(ssef(sray->P.x), ssef(sray->P.y), ssef(sray->P.z));
+#endif
+
+	return qbvh_aligned_node_intersect(kg,
+	                                   tnear,
+	                                   tfar,
+#ifdef __KERNEL_AVX2__
+	                                   P_idir4,
+#else
+	                                   org4,
+#endif
+	                                   idir4,
+	                                   sray->near_x, sray->near_y, sray->near_z,
+	                                   sray->far_x, sray->far_y, sray->far_z,
+	                                   node_addr,
+	                                   dist);
+}
+
+/* Finds the closest hit of every ray, same as calling scene_intersect() for
+ * each of them. Rays must not exceed BVH_STREAM_SIZE. */
+ccl_device void scene_intersect_stream(KernelGlobals *kg,
+                                       const Ray *rays,
+                                       const uint *visibility,
+                                       Intersection *isects,
+                                       const int num_rays)
+{
+	kernel_assert(num_rays <= BVH_STREAM_SIZE);
+
+	BVHStreamRay srays[BVH_STREAM_SIZE];
+	/* Ray indices of all stack items, stored in the same order as the items. */
+	uchar ray_ids[BVH_QSTACK_SIZE*BVH_STREAM_SIZE];
+	BVHStreamStackItem traversal_stack[BVH_QSTACK_SIZE];
+	int stack_ptr = 0;
+	int num_active = 0;
+
+	for(int i = 0; i < num_rays; i++) {
+		Intersection *isect = &isects[i];
+		isect->t = rays[i].t;
+		isect->u = 0.0f;
+		isect->v = 0.0f;
+		isect->prim = PRIM_NONE;
+		isect->object = OBJECT_NONE;
+#ifdef __KERNEL_DEBUG__
+		isect->num_traversed_nodes = 0;
+		isect->num_traversed_instances = 0;
+		isect->num_intersections = 0;
+#endif
+
+		if(!isfinite(rays[i].P.x)) {
+			continue;
+		}
+
+		float3 dir = bvh_clamp_direction(rays[i].D);
+		bvh_stream_ray_setup(&srays[i], rays[i].P, dir, bvh_inverse_direction(dir));
+		ray_ids[num_active++] = i;
+	}
+
+	if(num_active == 0) {
+		return;
+	}
+
+	traversal_stack[0].addr = kernel_data.bvh.root;
+	traversal_stack[0].object = OBJECT_NONE;
+	traversal_stack[0].offset = 0;
+	traversal_stack[0].num = num_active;
+
+	while(stack_ptr >= 0) {
+		const BVHStreamStackItem item = traversal_stack[stack_ptr--];
+		const uchar *ids = &ray_ids[item.offset];
+
+		if(item.addr == ENTRYPOINT_SENTINEL) {
+			/* Instance pop. */
+			for(int i = 0; i < item.num; i++) {
+				const int id = ids[i];
+				const Ray *ray = &rays[id];
+				BVHStreamRay *sray = &srays[id];
+				float3 P, dir, idir;
+#ifdef __OBJECT_MOTION__
+				if(kernel_data.bvh.have_motion) {
+					isects[id].t = bvh_instance_motion_pop(kg, item.object, ray, &P, &dir, &idir, isects[id].t, &sray->ob_itfm);
+				}
+				else
+#endif
+				{
+					isects[id].t = bvh_instance_pop(kg, item.object, ray, &P, &dir, &idir, isects[id].t);
+				}
+				bvh_stream_ray_setup(sray, P, dir, idir);
+			}
+			continue;
+		}
+
+		if(item.addr >= 0) {
+			/* Inner node, partition the rays over the children they hit. */
+			const float4 inodes = kernel_tex_fetch(__bvh_nodes, item.addr+0);
+			uchar child_ids[4][BVH_STREAM_SIZE];
+			int child_num[4] = {0, 0, 0, 0};
+			float child_dist[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+
+			for(int i = 0; i < item.num; i++) {
+				const int id = ids[i];
+
+#ifdef __VISIBILITY_FLAG__
+				if((__float_as_uint(inodes.x) & visibility[id]) == 0) {
+					continue;
+				}
+#endif
+#ifdef __OBJECT_MOTION__
+				if(kernel_data.bvh.have_motion &&
+				   (rays[id].time < inodes.y || rays[id].time > inodes.z))
+				{
+					continue;
+				}
+#endif
+
+				ssef dist;
+				int child_mask = bvh_stream_node_intersect(kg,
+				                                           &srays[id],
+				                                           isects[id].t,
+				                                           item.addr,
+				                                           &dist);
+				while(child_mask != 0) {
+					int c = __bscf(child_mask);
+					child_ids[c][child_num[c]++] = id;
+					child_dist[c] += ((float*)&dist)[c];
+				}
+			}
+
+			/* Push the children farthest first, so the children which are
+			 * closest on average for the stream are traversed first. Their
+			 * ray indices replace the ones of the popped item. */
+			const float4 cnodes = qbvh_aligned_node_children(kg, item.addr);
+			int order[4], num_children = 0;
+			for(int c = 0; c < 4; c++) {
+				if(child_num[c] == 0) {
+					continue;
+				}
+				child_dist[c] /= child_num[c];
+				int j = num_children++;
+				for(; j > 0 && child_dist[order[j - 1]] < child_dist[c]; j--) {
+					order[j] = order[j - 1];
+				}
+				order[j] = c;
+			}
+
+			int offset = item.offset;
+			for(int j = 0; j < num_children; j++) {
+				const int c = order[j];
+				++stack_ptr;
+				kernel_assert(stack_ptr < BVH_QSTACK_SIZE);
+				traversal_stack[stack_ptr].addr = __float_as_int(cnodes[c]);
+				traversal_stack[stack_ptr].object = item.object;
+				traversal_stack[stack_ptr].offset = offset;
+				traversal_stack[stack_ptr].num = child_num[c];
+				memcpy(&ray_ids[offset], child_ids[c], child_num[c]*sizeof(uchar));
+				offset += child_num[c];
+			}
+			continue;
+		}
+
+		/* Leaf node. */
+		const float4 leaf = kernel_tex_fetch(__bvh_leaf_nodes, (-item.addr-1));
+		int prim_addr = __float_as_int(leaf.x);
+
+		if(prim_addr >= 0) {
+			const int prim_addr2 = __float_as_int(leaf.y);
+			const uint type = __float_as_int(leaf.w);
+
+			for(int i = 0; i < item.num; i++) {
+				const int id = ids[i];
+				const BVHStreamRay *sray = &srays[id];
+				Intersection *isect = &isects[id];
+
+#ifdef __VISIBILITY_FLAG__
+				if((__float_as_uint(leaf.z) & visibility[id]) == 0) {
+					continue;
+				}
+#endif
+
+				switch(type & PRIMITIVE_ALL) {
+					case PRIMITIVE_TRIANGLE: {
+						for(int prim = prim_addr; prim < prim_addr2; prim++) {
+							kernel_assert(kernel_tex_fetch(__prim_type, prim) == type);
+							triangle_intersect(kg,
+							                   isect,
+							                   sray->P,
+							                   sray->dir,
+							                   visibility[id],
+							                   item.object,
+							                   prim);
+						}
+						break;
+					}
+#ifdef __OBJECT_MOTION__
+					case PRIMITIVE_MOTION_TRIANGLE: {
+						for(int prim = prim_addr; prim < prim_addr2; prim++) {
+							kernel_assert(kernel_tex_fetch(__prim_type, prim) == type);
+							motion_triangle_intersect(kg,
+							                          isect,
+							                          sray->P,
+							                          sray->dir,
+							                          rays[id].time,
+							                          visibility[id],
+							                          item.object,
+							                          prim);
+						}
+						break;
+					}
+#endif
+				}
+			}
+		}
+#ifdef __INSTANCING__
+		else {
+			/* Instance push, the rays get transformed into object space until
+			 * the sentinel item below the object root is popped again. */
+			const int object = kernel_tex_fetch(__prim_object, -prim_addr-1);
+			int num = 0;
+
+			for(int i = 0; i < item.num; i++) {
+				const int id = ids[i];
+				const Ray *ray = &rays[id];
+				BVHStreamRay *sray = &srays[id];
+
+#ifdef __VISIBILITY_FLAG__
+				if((__float_as_uint(leaf.z) & visibility[id]) == 0) {
+					continue;
+				}
+#endif
+
+				float3 P, dir, idir;
+				float unused_dist = -FLT_MAX;
+#  ifdef __OBJECT_MOTION__
+				if(kernel_data.bvh.have_motion) {
+					qbvh_instance_motion_push(kg, object, ray, &P, &dir, &idir, &isects[id].t, &unused_dist, &sray->ob_itfm);
+				}
+				else
+#  endif
+				{
+					qbvh_instance_push(kg, object, ray, &P, &dir, &idir, &isects[id].t, &unused_dist);
+				}
+				bvh_stream_ray_setup(sray, P, dir, idir);
+				ray_ids[item.offset + num++] = id;
+			}
+
+			if(num == 0) {
+				continue;
+			}
+
+			/* The object root gets its own copy of the indices, since its
+			 * children overwrite them. */
+			++stack_ptr;
+			kernel_assert(stack_ptr + 1 < BVH_QSTACK_SIZE);
+			traversal_stack[stack_ptr].addr = ENTRYPOINT_SENTINEL;
+			traversal_stack[stack_ptr].object = object;
+			traversal_stack[stack_ptr].offset = item.offset;
+			traversal_stack[stack_ptr].num = num;
+
+			++stack_ptr;
+			traversal_stack[stack_ptr].addr = kernel_tex_fetch(__object_node, object);
+			traversal_stack[stack_ptr].object = object;
+			traversal_stack[stack_ptr].offset = item.offset + num;
+			traversal_stack[stack_ptr].num = num;
+			memcpy(&ray_ids[item.offset + num], &ray_ids[item.offset], num*sizeof(uchar));
+		}
+#endif  /* __INSTANCING__ */
+	}
+}
@@ -0,0 +1,351 @@
+/*
+ * Copyright 2011-2017, Blender Foundation.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Octo BVH nodes, the 8-wide counterpart of the QBVH nodes, intersecting all
+ * children of a node at once with AVX instructions. Each row of child data
+ * is stored in two consecutive float4.
+ */
+
+struct OBVHStackItem {
+	int addr;
+	float dist;
+};
+
+ccl_device_inline void obvh_near_far_idx_calc(const float3& idir,
+                                              int *ccl_restrict near_x,
+                                              int *ccl_restrict near_y,
+                                              int *ccl_restrict near_z,
+                                              int *ccl_restrict far_x,
+                                              int *ccl_restrict far_y,
+                                              int *ccl_restrict far_z)
+
+{
+	*near_x = 0; *far_x = 2;
+	*near_y = 4; *far_y = 6;
+	*near_z = 8; *far_z = 10;
+
+	const size_t mask = movemask(ssef(idir.m128));
+
+	const int mask_x = (mask & 1) << 1;
+	const int mask_y = mask & 2;
+	const int mask_z = (mask & 4) >> 1;
+
+	*near_x += mask_x; *far_x -= mask_x;
+	*near_y += mask_y; *far_y -= mask_y;
+	*near_z += mask_z; *far_z -= mask_z;
+}
+
+ccl_device_inline void obvh_item_swap(OBVHStackItem *ccl_restrict a,
+                                      OBVHStackItem *ccl_restrict b)
+{
+	OBVHStackItem tmp = *a;
+	*a = *b;
+	*b = tmp;
+}
+
+/* Sort the topmost num stack items, so that the closest one ends up on top
+ * of the stack. At most eight items are sorted, so insertion sort is fine.
+ */
+ccl_device_inline void obvh_stack_sort(OBVHStackItem *ccl_restrict top, int num)
+{
+	for(int i = 1; i < num; i++) {
+		for(int j = i; j > 0 && (top - j)->dist < (top - j + 1)->dist; j--) {
+			obvh_item_swap(top - j, top - j + 1);
+		}
+	}
+}
+
+/* Axis-aligned nodes intersection */
+
+ccl_device_inline int obvh_aligned_node_intersect(KernelGlobals *ccl_restrict kg,
+                                                  const avxf& isect_near,
+                                                  const avxf& isect_far,
+                                                  const avx3f& org_idir,
+                                                  const avx3f& idir,
+                                                  const int near_x,
+                                                  const int near_y,
+                                                  const int near_z,
+                                                  const int far_x,
+                                                  const int far_y,
+                                                  const int far_z,
+                                                  const int node_addr,
+                                                  avxf *ccl_restrict dist)
+{
+	const int offset = node_addr + 1;
+	const avxf tnear_x = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+near_x), idir.x, org_idir.x);
+	const avxf tnear_y = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+near_y), idir.y, org_idir.y);
+	const avxf tnear_z = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+near_z), idir.z, org_idir.z);
+	const avxf tfar_x = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+far_x), idir.x, org_idir.x);
+	const avxf tfar_y = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+far_y), idir.y, org_idir.y);
+	const avxf tfar_z = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+far_z), idir.z, org_idir.z);
+
+	const avxf tnear = max(max(tnear_x, tnear_y), max(tnear_z, isect_near));
+	const avxf tfar = min(min(tfar_x, tfar_y), min(tfar_z, isect_far));
+	*dist = tnear;
+	return movemask(tnear <= tfar);
+}
+
+ccl_device_inline int obvh_aligned_node_intersect_robust(
+        KernelGlobals *ccl_restrict kg,
+        const avxf& isect_near,
+        const avxf& isect_far,
+        const avx3f& P_idir,
+        const avx3f& idir,
+        const int near_x,
+        const int near_y,
+        const int near_z,
+        const int far_x,
+        const int far_y,
+        const int far_z,
+        const int node_addr,
+        const float difl,
+        avxf *ccl_restrict dist)
+{
+	const int offset = node_addr + 1;
+	const avxf tnear_x = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+near_x), idir.x, P_idir.x);
+	const avxf tnear_y = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+near_y), idir.y, P_idir.y);
+	const avxf tnear_z = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+near_z), idir.z, P_idir.z);
+	const avxf tfar_x = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+far_x), idir.x, P_idir.x);
+	const avxf tfar_y = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+far_y), idir.y, P_idir.y);
+	const avxf tfar_z = msub(kernel_tex_fetch_avxf(__bvh_nodes, offset+far_z), idir.z, P_idir.z);
+
+	const float round_down = 1.0f - difl;
+	const float round_up = 1.0f + difl;
+	const avxf tnear = max(max(tnear_x, tnear_y), max(tnear_z, isect_near));
+	const avxf tfar = min(min(tfar_x, tfar_y), min(tfar_z, isect_far));
+	*dist = tnear;
+	return movemask(round_down*tnear <= round_up*tfar);
+}
+
+/* Unaligned nodes intersection */
+
+ccl_device_inline void obvh_unaligned_node_tnear_tfar(KernelGlobals *ccl_restrict kg,
+                                                      const avx3f& org,
+                                                      const avx3f& dir,
+                                                      const int node_addr,
+                                                      avxf *ccl_restrict tnear,
+                                                      avxf *ccl_restrict tfar)
+{
+	const int offset = node_addr + 1;
+	const avxf tfm_x_x = kernel_tex_fetch_avxf(__bvh_nodes, offset+0);
+	const avxf tfm_x_y = kernel_tex_fetch_avxf(__bvh_nodes, offset+2);
+	const avxf tfm_x_z = kernel_tex_fetch_avxf(__bvh_nodes, offset+4);
+
+	const avxf tfm_y_x = kernel_tex_fetch_avxf(__bvh_nodes, offset+6);
+	const avxf tfm_y_y = kernel_tex_fetch_avxf(__bvh_nodes, offset+8);
+	const avxf tfm_y_z = kernel_tex_fetch_avxf(__bvh_nodes, offset+10);
+
+	const avxf tfm_z_x = kernel_tex_fetch_avxf(__bvh_nodes, offset+12);
+	const avxf tfm_z_y = kernel_tex_fetch_avxf(__bvh_nodes, offset+14);
+	const avxf tfm_z_z = kernel_tex_fetch_avxf(__bvh_nodes, offset+16);
+
+	const avxf tfm_t_x = kernel_tex_fetch_avxf(__bvh_nodes, offset+18);
+	const avxf tfm_t_y = kernel_tex_fetch_avxf(__bvh_nodes, offset+20);
+	const avxf tfm_t_z = kernel_tex_fetch_avxf(__bvh_nodes, offset+22);
+
+	const avxf aligned_dir_x = dir.x*tfm_x_x + dir.y*tfm_x_y + dir.z*tfm_x_z,
+	           aligned_dir_y = dir.x*tfm_y_x + dir.y*tfm_y_y + dir.z*tfm_y_z,
+	           aligned_dir_z = dir.x*tfm_z_x + dir.y*tfm_z_y + dir.z*tfm_z_z;
+
+	const avxf aligned_P_x = org.x*tfm_x_x + org.y*tfm_x_y + org.z*tfm_x_z + tfm_t_x,
+	           aligned_P_y = org.x*tfm_y_x + org.y*tfm_y_y + org.z*tfm_y_z + tfm_t_y,
+	           aligned_P_z = org.x*tfm_z_x + org.y*tfm_z_y + org.z*tfm_z_z + tfm_t_z;
+
+	const avxf neg_one(-1.0f);
+	const avxf nrdir_x = neg_one / aligned_dir_x,
+	           nrdir_y = neg_one / aligned_dir_y,
+	           nrdir_z = neg_one / aligned_dir_z;
+
+	const avxf tlower_x = aligned_P_x * nrdir_x,
+	           tlower_y = aligned_P_y * nrdir_y,
+	           tlower_z = aligned_P_z * nrdir_z;
+
+	const avxf tupper_x = tlower_x - nrdir_x,
+	           tupper_y = tlower_y - nrdir_y,
+	           tupper_z = tlower_z - nrdir_z;
+
+	const avxf tnear_x = min(tlower_x, tupper_x);
+	const avxf tnear_y = min(tlower_y, tupper_y);
+	const avxf tnear_z = min(tlower_z, tupper_z);
+	const avxf tfar_x = max(tlower_x, tupper_x);
+	const avxf tfar_y = max(tlower_y, tupper_y);
+	const avxf tfar_z = max(tlower_z, tupper_z);
+
+	*tnear = max(max(tnear_x, tnear_y), tnear_z);
+	*tfar = min(min(tfar_x, tfar_y), tfar_z);
+}
+
+ccl_device_inline int obvh_unaligned_node_intersect(
+        KernelGlobals *ccl_restrict kg,
+        const avxf& isect_near,
+        const avxf& isect_far,
+        const avx3f& org,
+        const avx3f& dir,
+        const int node_addr,
+        avxf *ccl_restrict dist)
+{
+	avxf tnear, tfar;
+	obvh_unaligned_node_tnear_tfar(kg, org, dir, node_addr, &tnear, &tfar);
+	tnear = max(tnear, isect_near);
+	tfar = min(tfar, isect_far);
+	*dist = tnear;
+	return movemask(tnear <= tfar);
+}
+
+ccl_device_inline int obvh_unaligned_node_intersect_robust(
+        KernelGlobals *ccl_restrict kg,
+        const avxf& isect_near,
+        const avxf& isect_far,
+        const avx3f& P,
+        const avx3f& dir,
+        const int node_addr,
+        const float difl,
+        avxf *ccl_restrict dist)
+{
+	avxf tnear, tfar;
+	obvh_unaligned_node_tnear_tfar(kg, P, dir, node_addr, &tnear, &tfar);
+	tnear = max(tnear, isect_near);
+	tfar = min(tfar, isect_far);
+
+	const float round_down = 1.0f - difl;
+	const float round_up = 1.0f + difl;
+	*dist = tnear;
+	return movemask(round_down*tnear <= round_up*tfar);
+}
+
+/* Intersectors wrappers.
+ *
+ * They'll check node type and call appropriate intersection code.
+ */
+
+ccl_device_inline int obvh_node_intersect(
+        KernelGlobals *ccl_restrict kg,
+        const avxf& isect_near,
+        const avxf& isect_far,
+        const avx3f& org_idir,
+        const avx3f& org,
+        const avx3f& dir,
+        const avx3f& idir,
+        const int near_x,
+        const int near_y,
+        const int near_z,
+        const int far_x,
+        const int far_y,
+        const int far_z,
+        const int node_addr,
+        avxf *ccl_restrict dist)
+{
+	const int offset = node_addr;
+	const float4 node = kernel_tex_fetch(__bvh_nodes, offset);
+	if(__float_as_uint(node.x) & PATH_RAY_NODE_UNALIGNED) {
+		return obvh_unaligned_node_intersect(kg,
+		                                     isect_near,
+		                                     isect_far,
+		                                     org,
+		                                     dir,
+		                                     node_addr,
+		                                     dist);
+	}
+	else {
+		return obvh_aligned_node_intersect(kg,
+		                                   isect_near,
+		                                   isect_far,
+		                                   org_idir,
+		                                   idir,
+		                                   near_x, near_y, near_z,
+		                                   far_x, far_y, far_z,
+		                                   node_addr,
+		                                   dist);
+	}
+}
+
+ccl_device_inline int obvh_node_intersect_robust(
+        KernelGlobals *ccl_restrict kg,
+        const avxf& isect_near,
+        const avxf& isect_far,
+        const avx3f& P_idir,
+        const avx3f& P,
+        const avx3f& dir,
+        const avx3f& idir,
+        const int near_x,
+        const int near_y,
+        const int near_z,
+        const int far_x,
+        const int far_y,
+        const int far_z,
+        const int node_addr,
+        const float difl,
+        avxf *ccl_restrict dist)
+{
+	const int offset = node_addr;
+	const float4 node = kernel_tex_fetch(__bvh_nodes, offset);
+	if(__float_as_uint(node.x) & PATH_RAY_NODE_UNALIGNED) {
+		return obvh_unaligned_node_intersect_robust(kg,
+		                                            isect_near,
+		                                            isect_far,
+		                                            P,
+		                                            dir,
+		                                            node_addr,
+		                                            difl,
+		                                            dist);
+	}
+	else {
+		return obvh_aligned_node_intersect_robust(kg,
+		                                          isect_near,
+		                                          isect_far,
+		                                          P_idir,
+		                                          idir,
+		                                          near_x, near_y, near_z,
+		                                          far_x, far_y, far_z,
+		                                          node_addr,
+		                                          difl,
+		                                          dist);
+	}
+}
+
+/* Children of a node, as stored after its bounds. */
+
+ccl_device_inline int obvh_node_child(KernelGlobals *ccl_restrict kg,
+                                      const int node_addr,
+                                      const bool unaligned,
+                                      const int child)
+{
+	const int offset = node_addr + (unaligned ? 25 : 13) + (child >> 2);
+	const float4 cnodes = kernel_tex_fetch(__bvh_nodes, offset);
+	return __float_as_int(cnodes[child & 3]);
+}
+
+/* Push the remaining hit children of a node onto the traversal stack,
+ * returning how many were pushed.
+ */
+ccl_device_inline int obvh_stack_push_children(KernelGlobals *ccl_restrict kg,
+                                               OBVHStackItem *ccl_restrict traversal_stack,
+                                               int *ccl_restrict stack_ptr,
+                                               const int node_addr,
+                                               const bool unaligned,
+                                               int child_mask,
+                                               const avxf& dist)
+{
+	int num = 0;
+	while(child_mask != 0) {
+		const int r = __bscf(child_mask);
+		++(*stack_ptr);
+		kernel_assert(*stack_ptr < BVH_OSTACK_SIZE);
+		traversal_stack[*stack_ptr].addr = obvh_node_child(kg, node_addr, unaligned, r);
+		traversal_stack[*stack_ptr].dist = dist.f[r];
+		++num;
+	}
+	return num;
+}
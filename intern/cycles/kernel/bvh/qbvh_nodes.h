@@ -83,6 +83,96 @@ ccl_device_inline void qbvh_stack_sort(QBVHStackItem *ccl_restrict s1,
 	if(s3->dist < s2->dist) { qbvh_item_swap(s3, s2); }
 }
 
+/* Compressed aligned nodes
+ *
+ * Child bounds are quantized to 8 bits, relative to the bounds of the node
+ * itself. The node stores their minimum as origin and a power of two scale
+ * per axis, so dequantization is exact and the bounds remain conservative.
+ * Node layout:
+ *
+ *   data[0]: visibility, time_from, time_to
+ *   data[1]: origin x, y, z and the biased exponents of the scales
+ *   data[2]: quantized min x, max x, min y, max y, a byte per child
+ *   data[3]: quantized min z, max z
+ *   data[4]: child indices
+ */
+
+ccl_device_inline ssef qbvh_compressed_node_dequantize(const float q,
+                                                       const float origin,
+                                                       const float scale)
+{
+	const __m128i bytes = _mm_cvtsi32_si128(__float_as_int(q));
+#ifdef __KERNEL_SSE41__
+	const ssei qi(_mm_cvtepu8_epi32(bytes));
+#else
+	const __m128i zero = _mm_setzero_si128();
+	const ssei qi(_mm_unpacklo_epi16(_mm_unpacklo_epi8(bytes, zero), zero));
+#endif
+	return madd(ssef(scale), ssef(_mm_cvtepi32_ps(qi)), ssef(origin));
+}
+
+/* Fetch the child bounds in the order used for near and far plane indices:
+ * min x, max x, min y, max y, min z, max z. */
+ccl_device_inline void qbvh_compressed_node_bounds(KernelGlobals *ccl_restrict kg,
+                                                   const int node_addr,
+                                                   ssef bounds[6])
+{
+	const float4 origin = kernel_tex_fetch(__bvh_nodes, node_addr+1);
+	const float4 qxy = kernel_tex_fetch(__bvh_nodes, node_addr+2);
+	const float4 qz = kernel_tex_fetch(__bvh_nodes, node_addr+3);
+	const uint exponents = __float_as_uint(origin.w);
+	const float scale_x = __uint_as_float((exponents & 0xff) << 23);
+	const float scale_y = __uint_as_float(((exponents >> 8) & 0xff) << 23);
+	const float scale_z = __uint_as_float(((exponents >> 16) & 0xff) << 23);
+
+	bounds[0] = qbvh_compressed_node_dequantize(qxy.x, origin.x, scale_x);
+	bounds[1] = qbvh_compressed_node_dequantize(qxy.y, origin.x, scale_x);
+	bounds[2] = qbvh_compressed_node_dequantize(qxy.z, origin.y, scale_y);
+	bounds[3] = qbvh_compressed_node_dequantize(qxy.w, origin.y, scale_y);
+	bounds[4] = qbvh_compressed_node_dequantize(qz.x, origin.z, scale_z);
+	bounds[5] = qbvh_compressed_node_dequantize(qz.y, origin.z, scale_z);
+}
+
+/* Child indices of an aligned node, which come after the bounds. */
+ccl_device_inline float4 qbvh_aligned_node_children(KernelGlobals *ccl_restrict kg,
+                                                    const int node_addr)
+{
+	const int offset = (kernel_data.bvh.use_compressed_nodes)? 4: 7;
+	return kernel_tex_fetch(__bvh_nodes, node_addr+offset);
+}
+
+/* Near and far planes of the children of an aligned node. */
+ccl_device_inline void qbvh_aligned_node_planes(KernelGlobals *ccl_restrict kg,
+                                                const int near_x,
+                                                const int near_y,
+                                                const int near_z,
+                                                const int far_x,
+                                                const int far_y,
+                                                const int far_z,
+                                                const int node_addr,
+                                                ssef planes[6])
+{
+	if(kernel_data.bvh.use_compressed_nodes) {
+		ssef bounds[6];
+		qbvh_compressed_node_bounds(kg, node_addr, bounds);
+		planes[0] = bounds[near_x];
+		planes[1] = bounds[near_y];
+		planes[2] = bounds[near_z];
+		planes[3] = bounds[far_x];
+		planes[4] = bounds[far_y];
+		planes[5] = bounds[far_z];
+	}
+	else {
+		const int offset = node_addr + 1;
+		planes[0] = kernel_tex_fetch_ssef(__bvh_nodes, offset+near_x);
+		planes[1] = kernel_tex_fetch_ssef(__bvh_nodes, offset+near_y);
+		planes[2] = kernel_tex_fetch_ssef(__bvh_nodes, offset+near_z);
+		planes[3] = kernel_tex_fetch_ssef(__bvh_nodes, offset+far_x);
+		planes[4] = kernel_tex_fetch_ssef(__bvh_nodes, offset+far_y);
+		planes[5] = kernel_tex_fetch_ssef(__bvh_nodes, offset+far_z);
+	}
+}
+
 /* Axis-aligned nodes intersection */
 
 ccl_device_inline int qbvh_aligned_node_intersect(KernelGlobals *ccl_restrict kg,
@@ -103,21 +193,26 @@ ccl_device_inline int qbvh_aligned_node_intersect(KernelGlobals *ccl_restrict kg
                                                   const int node_addr,
                                                   ssef *ccl_restrict dist)
 {
-	const int offset = node_addr + 1;
+	ssef planes[6];
+	qbvh_aligned_node_planes(kg,
+	                         near_x, near_y, near_z,
+	                         far_x, far_y, far_z,
+	                         node_addr,
+	                         planes);
 #ifdef __KERNEL_AVX2__
-	const ssef tnear_x = msub(kernel_tex_fetch_ssef(__bvh_nodes, offset+near_x), idir.x, org_idir.x);
-	const ssef tnear_y = msub(kernel_tex_fetch_ssef(__bvh_nodes, offset+near_y), idir.y, org_idir.y);
-	const ssef tnear_z = msub(kernel_tex_fetch_ssef(__bvh_nodes, offset+near_z), idir.z, org_idir.z);
-	const ssef tfar_x = msub(kernel_tex_fetch_ssef(__bvh_nodes, offset+far_x), idir.x, org_idir.x);
-	const ssef tfar_y = msub(kernel_tex_fetch_ssef(__bvh_nodes, offset+far_y), idir.y, org_idir.y);
-	const ssef tfar_z = msub(kernel_tex_fetch_ssef(__bvh_nodes, offset+far_z), idir.z, org_idir.z);
+	const ssef tnear_x = msub(planes[0], idir.x, org_idir.x);
+	const ssef tnear_y = msub(planes[1], idir.y, org_idir.y);
+	const ssef tnear_z = msub(planes[2], idir.z, org_idir.z);
+	const ssef tfar_x = msub(planes[3], idir.x, org_idir.x);
+	const ssef tfar_y = msub(planes[4], idir.y, org_idir.y);
+	const ssef tfar_z = msub(planes[5], idir.z, org_idir.z);
 #else
-	const ssef tnear_x = (kernel_tex_fetch_ssef(__bvh_nodes, offset+near_x) - org.x) * idir.x;
-	const ssef tnear_y = (kernel_tex_fetch_ssef(__bvh_nodes, offset+near_y) - org.y) * idir.y;
-	const ssef tnear_z = (kernel_tex_fetch_ssef(__bvh_nodes, offset+near_z) - org.z) * idir.z;
-	const ssef tfar_x = (kernel_tex_fetch_ssef(__bvh_nodes, offset+far_x) - org.x) * idir.x;
-	const ssef tfar_y = (kernel_tex_fetch_ssef(__bvh_nodes, offset+far_y) - org.y) * idir.y;
-	const ssef tfar_z = (kernel_tex_fetch_ssef(__bvh_nodes, offset+far_z) - org.z) * idir.z;
+	const ssef tnear_x = (planes[0] - org.x) * idir.x;
+	const ssef tnear_y = (planes[1] - org.y) * idir.y;
+	const ssef tnear_z = (planes[2] - org.z) * idir.z;
+	const ssef tfar_x = (planes[3] - org.x) * idir.x;
+	const ssef tfar_y = (planes[4] - org.y) * idir.y;
+	const ssef tfar_z = (planes[5] - org.z) * idir.z;
 #endif
 
 #ifdef __KERNEL_SSE41__
@@ -155,21 +250,26 @@ ccl_device_inline int qbvh_aligned_node_intersect_robust(
         const float difl,
         ssef *ccl_restrict dist)
 {
-	const int offset = node_addr + 1;
+	ssef planes[6];
+	qbvh_aligned_node_planes(kg,
+	                         near_x, near_y, near_z,
+	                         far_x, far_y, far_z,
+	                         node_addr,
+	                         planes);
 #ifdef __KERNEL_AVX2__
-	const ssef tnear_x = msub(kernel_tex_fetch_ssef(__bvh_nodes, offset+near_x), idir.x, P_idir.x);
-	const ssef tnear_y = msub(kernel_tex_fetch_ssef(__bvh_nodes, offset+near_y), idir.y, P_idir.y);
-	const ssef tnear_z = msub(kernel_tex_fetch_ssef(__bvh_nodes, offset+near_z), idir.z, P_idir.z);
-	const ssef tfar_x = msub(kernel_tex_fetch_ssef(__bvh_nodes, offset+far_x), idir.x, P_idir.x);
-	const ssef tfar_y = msub(kernel_tex_fetch_ssef(__bvh_nodes, offset+far_y), idir.y, P_idir.y);
-	const ssef tfar_z = msub(kernel_tex_fetch_ssef(__bvh_nodes, offset+far_z), idir.z, P_idir.z);
+	const ssef tnear_x = msub(planes[0], idir.x, P_idir.x);
+	const ssef tnear_y = msub(planes[1], idir.y, P_idir.y);
+	const ssef tnear_z = msub(planes[2], idir.z, P_idir.z);
+	const ssef tfar_x = msub(planes[3], idir.x, P_idir.x);
+	const ssef tfar_y = msub(planes[4], idir.y, P_idir.y);
+	const ssef tfar_z = msub(planes[5], idir.z, P_idir.z);
 #else
-	const ssef tnear_x = (kernel_tex_fetch_ssef(__bvh_nodes, offset+near_x) - P.x) * idir.x;
-	const ssef tnear_y = (kernel_tex_fetch_ssef(__bvh_nodes, offset+near_y) - P.y) * idir.y;
-	const ssef tnear_z = (kernel_tex_fetch_ssef(__bvh_nodes, offset+near_z) - P.z) * idir.z;
-	const ssef tfar_x = (kernel_tex_fetch_ssef(__bvh_nodes, offset+far_x) - P.x) * idir.x;
-	const ssef tfar_y = (kernel_tex_fetch_ssef(__bvh_nodes, offset+far_y) - P.y) * idir.y;
-	const ssef tfar_z = (kernel_tex_fetch_ssef(__bvh_nodes, offset+far_z) - P.z) * idir.z;
+	const ssef tnear_x = (planes[0] - P.x) * idir.x;
+	const ssef tnear_y = (planes[1] - P.y) * idir.y;
+	const ssef tnear_z = (planes[2] - P.z) * idir.z;
+	const ssef tfar_x = (planes[3] - P.x) * idir.x;
+	const ssef tfar_y = (planes[4] - P.y) * idir.y;
+	const ssef tfar_z = (planes[5] - P.z) * idir.z;
 #endif
 
 	const float round_down = 1.0f - difl;
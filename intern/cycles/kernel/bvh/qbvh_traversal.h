@@ -197,7 +197,7 @@ ccl_device bool BVH_FUNCTION_FULL_NAME(QBVH)(KernelGlobals *kg,
 					else
 #endif
 					{
-						cnodes = kernel_tex_fetch(__bvh_nodes, node_addr+7);
+						cnodes = qbvh_aligned_node_children(kg, node_addr);
 					}
 
 					/* One child is hit, continue with that child. */
@@ -50,9 +50,7 @@ ccl_device_inline void motion_triangle_verts_for_step(KernelGlobals *kg, uint4 t
 {
 	if(step == numsteps) {
 		/* center step: regular vertex location */
-		verts[0] = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+0));
-		verts[1] = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+1));
-		verts[2] = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+2));
+		triangle_vertices_from_vindex(kg, tri_vindex, verts);
 	}
 	else {
 		/* center step not store in this array */
@@ -22,14 +22,34 @@
 
 CCL_NAMESPACE_BEGIN
 
+/* Triangle vertex locations, either stored per triangle or shared between
+ * triangles and looked up through their vertex indices, when the BVH was
+ * built with indexed triangle storage to save memory. */
+
+ccl_device_inline void triangle_vertices_from_vindex(KernelGlobals *kg, const uint4 tri_vindex, float3 P[3])
+{
+	if(kernel_data.bvh.use_indexed_triangles) {
+		P[0] = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.x));
+		P[1] = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.y));
+		P[2] = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.z));
+	}
+	else {
+		P[0] = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+0));
+		P[1] = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+1));
+		P[2] = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+2));
+	}
+}
+
 /* normal on triangle  */
 ccl_device_inline float3 triangle_normal(KernelGlobals *kg, ShaderData *sd)
 {
 	/* load triangle vertices */
 	const uint4 tri_vindex = kernel_tex_fetch(__tri_vindex, sd->prim);
-	const float3 v0 = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+0));
-	const float3 v1 = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+1));
-	const float3 v2 = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+2));
+	float3 verts[3];
+	triangle_vertices_from_vindex(kg, tri_vindex, verts);
+	const float3 v0 = verts[0];
+	const float3 v1 = verts[1];
+	const float3 v2 = verts[2];
 
 	/* return normal */
 	if(sd->object_flag & SD_OBJECT_NEGATIVE_SCALE_APPLIED) {
@@ -45,9 +65,11 @@ ccl_device_inline void triangle_point_normal(KernelGlobals *kg, int object, int
 {
 	/* load triangle vertices */
 	const uint4 tri_vindex = kernel_tex_fetch(__tri_vindex, prim);
-	float3 v0 = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+0));
-	float3 v1 = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+1));
-	float3 v2 = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+2));
+	float3 verts[3];
+	triangle_vertices_from_vindex(kg, tri_vindex, verts);
+	float3 v0 = verts[0];
+	float3 v1 = verts[1];
+	float3 v2 = verts[2];
 	/* compute point */
 	float t = 1.0f - u - v;
 	*P = (u*v0 + v*v1 + t*v2);
@@ -69,9 +91,7 @@ ccl_device_inline void triangle_point_normal(KernelGlobals *kg, int object, int
 ccl_device_inline void triangle_vertices(KernelGlobals *kg, int prim, float3 P[3])
 {
 	const uint4 tri_vindex = kernel_tex_fetch(__tri_vindex, prim);
-	P[0] = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+0));
-	P[1] = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+1));
-	P[2] = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+2));
+	triangle_vertices_from_vindex(kg, tri_vindex, P);
 }
 
 /* Interpolate smooth vertex normal from vertices */
@@ -94,14 +114,12 @@ ccl_device_inline float3 triangle_smooth_normal(KernelGlobals *kg, float3 Ng, in
 ccl_device_inline void triangle_dPdudv(KernelGlobals *kg, int prim, ccl_addr_space float3 *dPdu, ccl_addr_space float3 *dPdv)
 {
 	/* fetch triangle vertex coordinates */
-	const uint4 tri_vindex = kernel_tex_fetch(__tri_vindex, prim);
-	const float3 p0 = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+0));
-	const float3 p1 = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+1));
-	const float3 p2 = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex.w+2));
+	float3 p[3];
+	triangle_vertices(kg, prim, p);
 
 	/* compute derivatives of P w.r.t. uv */
-	*dPdu = (p0 - p2);
-	*dPdv = (p1 - p2);
+	*dPdu = (p[0] - p[2]);
+	*dPdv = (p[1] - p[2]);
 }
 
 /* Reading attributes on various triangle elements */
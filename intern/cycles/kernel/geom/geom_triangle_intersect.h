@@ -22,6 +22,42 @@
 
 CCL_NAMESPACE_BEGIN
 
+/* Vertices of the triangle referenced by the BVH at prim_addr. With indexed
+ * triangle storage there is no per-triangle copy, and they are gathered from
+ * the shared vertices instead. */
+
+ccl_device_inline void triangle_prim_vertices(KernelGlobals *kg, int prim_addr, float3 P[3])
+{
+	if(kernel_data.bvh.use_indexed_triangles) {
+		const int prim = kernel_tex_fetch(__prim_index, prim_addr);
+		triangle_vertices(kg, prim, P);
+	}
+	else {
+		const uint tri_vindex = kernel_tex_fetch(__prim_tri_index, prim_addr);
+		P[0] = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex+0));
+		P[1] = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex+1));
+		P[2] = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex+2));
+	}
+}
+
+#if defined(__KERNEL_SSE2__) && defined(__KERNEL_SSE__)
+ccl_device_inline const ssef *triangle_prim_vertices_ssef(KernelGlobals *kg,
+                                                          int prim_addr,
+                                                          ssef verts[3])
+{
+	if(kernel_data.bvh.use_indexed_triangles) {
+		const int prim = kernel_tex_fetch(__prim_index, prim_addr);
+		const uint4 tri_vindex = kernel_tex_fetch(__tri_vindex, prim);
+		verts[0] = kernel_tex_fetch_ssef(__prim_tri_verts, tri_vindex.x);
+		verts[1] = kernel_tex_fetch_ssef(__prim_tri_verts, tri_vindex.y);
+		verts[2] = kernel_tex_fetch_ssef(__prim_tri_verts, tri_vindex.z);
+		return verts;
+	}
+	const uint tri_vindex = kernel_tex_fetch(__prim_tri_index, prim_addr);
+	return (ssef*)&kg->__prim_tri_verts.data[tri_vindex];
+}
+#endif
+
 ccl_device_inline bool triangle_intersect(KernelGlobals *kg,
                                           Intersection *isect,
                                           float3 P,
@@ -30,13 +66,12 @@ ccl_device_inline bool triangle_intersect(KernelGlobals *kg,
                                           int object,
                                           int prim_addr)
 {
-	const uint tri_vindex = kernel_tex_fetch(__prim_tri_index, prim_addr);
 #if defined(__KERNEL_SSE2__) && defined(__KERNEL_SSE__)
-	const ssef *ssef_verts = (ssef*)&kg->__prim_tri_verts.data[tri_vindex];
+	ssef verts[3];
+	const ssef *ssef_verts = triangle_prim_vertices_ssef(kg, prim_addr, verts);
 #else
-	const float4 tri_a = kernel_tex_fetch(__prim_tri_verts, tri_vindex+0),
-	             tri_b = kernel_tex_fetch(__prim_tri_verts, tri_vindex+1),
-	             tri_c = kernel_tex_fetch(__prim_tri_verts, tri_vindex+2);
+	float3 verts[3];
+	triangle_prim_vertices(kg, prim_addr, verts);
 #endif
 	float t, u, v;
 	if(ray_triangle_intersect(P,
@@ -45,9 +80,7 @@ ccl_device_inline bool triangle_intersect(KernelGlobals *kg,
 #if defined(__KERNEL_SSE2__) && defined(__KERNEL_SSE__)
 	                          ssef_verts,
 #else
-	                          float4_to_float3(tri_a),
-	                          float4_to_float3(tri_b),
-	                          float4_to_float3(tri_c),
+	                          verts[0], verts[1], verts[2],
 #endif
 	                          &u, &v, &t))
 	{
@@ -87,13 +120,12 @@ ccl_device_inline void triangle_intersect_subsurface(
         uint *lcg_state,
         int max_hits)
 {
-	const uint tri_vindex = kernel_tex_fetch(__prim_tri_index, prim_addr);
 #if defined(__KERNEL_SSE2__) && defined(__KERNEL_SSE__)
-	const ssef *ssef_verts = (ssef*)&kg->__prim_tri_verts.data[tri_vindex];
+	ssef verts[3];
+	const ssef *ssef_verts = triangle_prim_vertices_ssef(kg, prim_addr, verts);
 #else
-	const float3 tri_a = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex+0)),
-	             tri_b = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex+1)),
-	             tri_c = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex+2));
+	float3 verts[3];
+	triangle_prim_vertices(kg, prim_addr, verts);
 #endif
 	float t, u, v;
 	if(!ray_triangle_intersect(P,
@@ -102,7 +134,7 @@ ccl_device_inline void triangle_intersect_subsurface(
 #if defined(__KERNEL_SSE2__) && defined(__KERNEL_SSE__)
 	                           ssef_verts,
 #else
-	                           tri_a, tri_b, tri_c,
+	                           verts[0], verts[1], verts[2],
 #endif
 	                           &u, &v, &t))
 	{
@@ -141,9 +173,13 @@ ccl_device_inline void triangle_intersect_subsurface(
 
 	/* Record geometric normal. */
 #if defined(__KERNEL_SSE2__) && defined(__KERNEL_SSE__)
-	const float3 tri_a = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex+0)),
-	             tri_b = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex+1)),
-	             tri_c = float4_to_float3(kernel_tex_fetch(__prim_tri_verts, tri_vindex+2));
+	const float3 tri_a = float4_to_float3(float4(ssef_verts[0].m128)),
+	             tri_b = float4_to_float3(float4(ssef_verts[1].m128)),
+	             tri_c = float4_to_float3(float4(ssef_verts[2].m128));
+#else
+	const float3 tri_a = verts[0],
+	             tri_b = verts[1],
+	             tri_c = verts[2];
 #endif
 	ss_isect->Ng[hit] = normalize(cross(tri_b - tri_a, tri_c - tri_a));
 }
@@ -187,13 +223,11 @@ ccl_device_inline float3 triangle_refine(KernelGlobals *kg,
 
 	P = P + D*t;
 
-	const uint tri_vindex = kernel_tex_fetch(__prim_tri_index, isect->prim);
-	const float4 tri_a = kernel_tex_fetch(__prim_tri_verts, tri_vindex+0),
-	             tri_b = kernel_tex_fetch(__prim_tri_verts, tri_vindex+1),
-	             tri_c = kernel_tex_fetch(__prim_tri_verts, tri_vindex+2);
-	float3 edge1 = make_float3(tri_a.x - tri_c.x, tri_a.y - tri_c.y, tri_a.z - tri_c.z);
-	float3 edge2 = make_float3(tri_b.x - tri_c.x, tri_b.y - tri_c.y, tri_b.z - tri_c.z);
-	float3 tvec = make_float3(P.x - tri_c.x, P.y - tri_c.y, P.z - tri_c.z);
+	float3 verts[3];
+	triangle_prim_vertices(kg, isect->prim, verts);
+	float3 edge1 = verts[0] - verts[2];
+	float3 edge2 = verts[1] - verts[2];
+	float3 tvec = P - verts[2];
 	float3 qvec = cross(tvec, edge1);
 	float3 pvec = cross(D, edge2);
 	float det = dot(edge1, pvec);
@@ -252,13 +286,11 @@ ccl_device_inline float3 triangle_refine_subsurface(KernelGlobals *kg,
 	P = P + D*t;
 
 #ifdef __INTERSECTION_REFINE__
-	const uint tri_vindex = kernel_tex_fetch(__prim_tri_index, isect->prim);
-	const float4 tri_a = kernel_tex_fetch(__prim_tri_verts, tri_vindex+0),
-	             tri_b = kernel_tex_fetch(__prim_tri_verts, tri_vindex+1),
-	             tri_c = kernel_tex_fetch(__prim_tri_verts, tri_vindex+2);
-	float3 edge1 = make_float3(tri_a.x - tri_c.x, tri_a.y - tri_c.y, tri_a.z - tri_c.z);
-	float3 edge2 = make_float3(tri_b.x - tri_c.x, tri_b.y - tri_c.y, tri_b.z - tri_c.z);
-	float3 tvec = make_float3(P.x - tri_c.x, P.y - tri_c.y, P.z - tri_c.z);
+	float3 verts[3];
+	triangle_prim_vertices(kg, isect->prim, verts);
+	float3 edge1 = verts[0] - verts[2];
+	float3 edge2 = verts[1] - verts[2];
+	float3 tvec = P - verts[2];
 	float3 qvec = cross(tvec, edge1);
 	float3 pvec = cross(D, edge2);
 	float det = dot(edge1, pvec);
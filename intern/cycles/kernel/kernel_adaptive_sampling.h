@@ -0,0 +1,170 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+CCL_NAMESPACE_BEGIN
+
+/* Adaptive sampling
+ *
+ * The fourth component of the auxiliary buffer holds the number of samples
+ * a pixel had when it converged, zero while it still needs sampling. */
+
+ccl_device_inline ccl_global float *kernel_adaptive_pixel(KernelGlobals *kg,
+	ccl_global float *buffer, int x, int y, int offset, int stride)
+{
+	return buffer + (offset + x + y*stride)*kernel_data.film.pass_stride;
+}
+
+ccl_device_inline bool kernel_adaptive_is_converged(KernelGlobals *kg, ccl_global float *buffer)
+{
+	return buffer[kernel_data.film.pass_adaptive_aux_buffer + 3] != 0.0f;
+}
+
+/* Neighbors of pixels still being sampled must be sampled too, but only pixels
+ * which converged at this very sample are reverted, earlier ones have stopped
+ * accumulating and can't be resumed. */
+ccl_device_inline void kernel_adaptive_unconverge(KernelGlobals *kg, ccl_global float *buffer, int sample)
+{
+	ccl_global float *converged = buffer + kernel_data.film.pass_adaptive_aux_buffer + 3;
+
+	if(*converged == (float)sample) {
+		*converged = 0.0f;
+	}
+}
+
+/* Determines whether a pixel has sufficiently converged after the given number of samples,
+ * using the per pixel error of section 2.1 of "A hierarchical automatic stopping condition
+ * for Monte Carlo global illumination" (Dammertz et al.). */
+ccl_device void kernel_do_adaptive_stopping(KernelGlobals *kg, ccl_global float *buffer, int sample)
+{
+	if(kernel_adaptive_is_converged(kg, buffer)) {
+		return;
+	}
+
+	float4 I = *((ccl_global float4*)buffer);
+	float4 A = *((ccl_global float4*)(buffer + kernel_data.film.pass_adaptive_aux_buffer));
+
+	/* A small epsilon is added to the divisor to prevent division by zero. */
+	float error = (fabsf(I.x - A.x) + fabsf(I.y - A.y) + fabsf(I.z - A.z)) /
+	              (sample * 0.0001f + sqrtf(max(I.x + I.y + I.z, 0.0f)));
+
+	if(error < kernel_data.integrator.adaptive_threshold * (float)sample) {
+		buffer[kernel_data.film.pass_adaptive_aux_buffer + 3] = (float)sample;
+	}
+}
+
+/* Dilate the unconverged pixels of a tile row by one pixel.
+ * Returns whether any pixel of the row still needs sampling. */
+ccl_device bool kernel_do_adaptive_filter_x(KernelGlobals *kg, ccl_global float *buffer, int sample,
+	int y, int tile_x, int tile_w, int offset, int stride)
+{
+	bool any = false;
+	bool prev = false;
+
+	for(int x = tile_x; x < tile_x + tile_w; x++) {
+		ccl_global float *pixel = kernel_adaptive_pixel(kg, buffer, x, y, offset, stride);
+
+		if(!kernel_adaptive_is_converged(kg, pixel)) {
+			any = true;
+			if(x > tile_x && !prev) {
+				kernel_adaptive_unconverge(kg, pixel - kernel_data.film.pass_stride, sample);
+			}
+			prev = true;
+		}
+		else {
+			if(prev) {
+				kernel_adaptive_unconverge(kg, pixel, sample);
+			}
+			prev = false;
+		}
+	}
+
+	return any;
+}
+
+/* Same as above for a tile column. */
+ccl_device bool kernel_do_adaptive_filter_y(KernelGlobals *kg, ccl_global float *buffer, int sample,
+	int x, int tile_y, int tile_h, int offset, int stride)
+{
+	bool any = false;
+	bool prev = false;
+
+	for(int y = tile_y; y < tile_y + tile_h; y++) {
+		ccl_global float *pixel = kernel_adaptive_pixel(kg, buffer, x, y, offset, stride);
+
+		if(!kernel_adaptive_is_converged(kg, pixel)) {
+			any = true;
+			if(y > tile_y && !prev) {
+				kernel_adaptive_unconverge(kg, pixel - stride*kernel_data.film.pass_stride, sample);
+			}
+			prev = true;
+		}
+		else {
+			if(prev) {
+				kernel_adaptive_unconverge(kg, pixel, sample);
+			}
+			prev = false;
+		}
+	}
+
+	return any;
+}
+
+/* Variance passes of the denoising data, which the denoiser evaluates with the
+ * sample count of the pixel itself. */
+ccl_device_inline bool kernel_adaptive_is_denoising_variance(KernelGlobals *kg, int i)
+{
+	if(kernel_data.film.pass_denoising_data == 0) {
+		return false;
+	}
+
+	int offset = i - kernel_data.film.pass_denoising_data;
+	return (offset >= DENOISING_PASS_NORMAL_VAR && offset < DENOISING_PASS_NORMAL_VAR + 3) ||
+	       (offset >= DENOISING_PASS_ALBEDO_VAR && offset < DENOISING_PASS_ALBEDO_VAR + 3) ||
+	       (offset == DENOISING_PASS_DEPTH_VAR) ||
+	       (offset >= DENOISING_PASS_COLOR_VAR && offset < DENOISING_PASS_COLOR_VAR + 3);
+}
+
+/* Scale the passes of converged pixels, so they appear to have as many samples
+ * as the rest of the tile and the usual 1/sample film scale applies to all pixels.
+ * Passes only written on the first sample and denoising variances are left
+ * untouched. */
+ccl_device void kernel_adaptive_adjust_samples(KernelGlobals *kg, ccl_global float *buffer, int sample)
+{
+	ccl_global float *converged = buffer + kernel_data.film.pass_adaptive_aux_buffer + 3;
+
+	if(*converged == 0.0f || *converged >= (float)sample) {
+		return;
+	}
+
+	int flag = kernel_data.film.pass_flag;
+	int pass_depth = (flag & PASS_DEPTH)? kernel_data.film.pass_depth: -1;
+	int pass_object_id = (flag & PASS_OBJECT_ID)? kernel_data.film.pass_object_id: -1;
+	int pass_material_id = (flag & PASS_MATERIAL_ID)? kernel_data.film.pass_material_id: -1;
+	float sample_multiplier = (float)sample / *converged;
+
+	/* The auxiliary buffer comes last, after regular and denoising passes. */
+	for(int i = 0; i < kernel_data.film.pass_adaptive_aux_buffer; i++) {
+		if(i != pass_depth && i != pass_object_id && i != pass_material_id &&
+		   !kernel_adaptive_is_denoising_variance(kg, i))
+		{
+			buffer[i] *= sample_multiplier;
+		}
+	}
+
+	*converged = (float)sample;
+}
+
+CCL_NAMESPACE_END
@@ -564,6 +564,7 @@ typedef texture_image<half4> texture_image_half4;
 #define kernel_tex_lookup(tex, t, offset, size) (kg->tex.lookup(t, offset, size))
 
 #define kernel_tex_image_interp(tex,x,y) kernel_tex_image_interp_impl(kg,tex,x,y)
+#define kernel_tex_image_interp_d(tex, x, y, dx, dy) kernel_tex_image_interp_d_impl(kg, tex, x, y, dx, dy)
 #define kernel_tex_image_interp_3d(tex, x, y, z) kernel_tex_image_interp_3d_impl(kg,tex,x,y,z)
 #define kernel_tex_image_interp_3d_ex(tex, x, y, z, interpolation) kernel_tex_image_interp_3d_ex_impl(kg,tex, x, y, z, interpolation)
 
@@ -588,6 +589,10 @@ ccl_device_inline void print_sse3f(const char *label, sse3f& a)
 	print_ssef(label, a.z);
 }
 
+#ifdef __KERNEL_AVX__
+typedef vector3<avxf> avx3f;
+#endif
+
 ccl_device_inline void print_sse3i(const char *label, sse3i& a)
 {
 	print_ssei(label, a.x);
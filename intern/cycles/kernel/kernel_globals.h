@@ -38,6 +38,7 @@ struct OSLThreadData;
 struct OSLShadingSystem;
 #  endif
 
+struct OIIOGlobals;
 struct Intersection;
 struct VolumeStep;
 
@@ -63,6 +64,9 @@ typedef struct KernelGlobals {
 	OSLThreadData *osl_tdata;
 #  endif
 
+	/* Image textures streamed from disk, NULL when all images are in memory. */
+	OIIOGlobals *oiio;
+
 	/* **** Run-time data ****  */
 
 	/* Heap-allocated storage for transparent shadows intersections. */
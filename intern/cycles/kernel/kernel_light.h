@@ -848,6 +848,183 @@ ccl_device int light_distribution_sample(KernelGlobals *kg, float randt)
 	return clamp(first-1, 0, kernel_data.integrator.num_distribution-1);
 }
 
+/* Light Tree
+ *
+ * Picks an emitter by descending the light tree, choosing children
+ * proportional to the estimated importance of their cluster for the shading
+ * point. The multiple importance sampling pdf of the picked emitters is kept
+ * as in the regular distribution, only the evaluation factor compensates for
+ * the different selection probability, so hitting an emitter doesn't require
+ * finding its path through the tree. */
+
+ccl_device float light_tree_node_importance(KernelGlobals *kg, int node, float3 P)
+{
+	float4 data0 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 0);
+	float4 data1 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 1);
+	float4 data2 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 2);
+
+	float3 bbox_min = make_float3(data0.x, data0.y, data0.z);
+	float3 bbox_max = make_float3(data1.x, data1.y, data1.z);
+	float energy = data0.w;
+	float theta_o = data1.w;
+	float3 axis = make_float3(data2.x, data2.y, data2.z);
+	float theta_e = data2.w;
+
+	float3 centroid = 0.5f*(bbox_min + bbox_max);
+	float radius = 0.5f*len(bbox_max - bbox_min);
+	float distance;
+	float3 D = normalize_len(P - centroid, &distance);
+
+	/* Smallest angle between the emission cone and the direction towards P,
+	 * conservative over the bounding sphere of the cluster. Inside the sphere
+	 * any orientation is possible. */
+	float theta_i = 0.0f;
+
+	if(distance > radius) {
+		float theta = safe_acosf(dot(axis, D));
+		float theta_u = safe_asinf(radius/distance);
+		theta_i = max(theta - theta_o - theta_u, 0.0f);
+	}
+
+	if(theta_i >= theta_e) {
+		return 0.0f;
+	}
+
+	/* Clamp the distance to the cluster size to avoid a singularity near it. */
+	float distance_sq = max(max(distance*distance, radius*radius), 1e-6f);
+
+	return energy*cosf(theta_i)/distance_sq;
+}
+
+/* Descends from root to a leaf, rescaling randt for reuse at the next level.
+ * Returns the leaf node and the probability of picking it, or -1 when no
+ * cluster can contribute to P. */
+ccl_device int light_tree_sample_leaf(KernelGlobals *kg, int root, float3 P, float *randt, float *pdf)
+{
+	int node = root;
+	*pdf = 1.0f;
+
+	for(;;) {
+		float4 data3 = kernel_tex_fetch(__light_tree_nodes, node*LIGHT_TREE_NODE_SIZE + 3);
+
+		if(__float_as_int(data3.y) > 0) {
+			return node;
+		}
+
+		int left = node + 1;
+		int right = __float_as_int(data3.x);
+		float importance_left = light_tree_node_importance(kg, left, P);
+		float importance_right = light_tree_node_importance(kg, right, P);
+		float importance_sum = importance_left + importance_right;
+
+		if(importance_sum == 0.0f) {
+			return -1;
+		}
+
+		float prob_left = importance_left/importance_sum;
+
+		if(*randt < prob_left) {
+			node = left;
+			*randt = *randt/prob_left;
+			*pdf *= prob_left;
+		}
+		else {
+			node = right;
+			*randt = (*randt - prob_left)/(1.0f - prob_left);
+			*pdf *= 1.0f - prob_left;
+		}
+	}
+}
+
+/* Pick an emitter of the leaf using the energy CDF stored in the distribution. */
+ccl_device int light_tree_sample_emitter(KernelGlobals *kg, int leaf, float randt)
+{
+	float4 data3 = kernel_tex_fetch(__light_tree_nodes, leaf*LIGHT_TREE_NODE_SIZE + 3);
+	int first = __float_as_int(data3.x);
+	int num = __float_as_int(data3.y);
+	int index = first;
+
+	for(int i = 1; i < num; i++) {
+		if(randt < kernel_tex_fetch(__light_distribution, first + i).x) {
+			break;
+		}
+		index = first + i;
+	}
+
+	return index;
+}
+
+/* Light tree counterpart of light_distribution_sample. Triangles and lamps keep
+ * being picked with equal probability, and distant and background lights keep
+ * their share of the lamps, so pdf_triangles and pdf_lights remain valid. Returns
+ * the distribution index and the factor the evaluation has to be scaled by. */
+ccl_device int light_tree_distribution_sample(KernelGlobals *kg, float randt, float3 P, float *eval_fac)
+{
+	int num_lamps = kernel_data.integrator.num_all_lights;
+	int num_triangles = kernel_data.integrator.num_distribution - num_lamps;
+	bool use_triangles = (kernel_data.integrator.pdf_triangles != 0.0f);
+	float pdf;
+
+	*eval_fac = 1.0f;
+
+	if(use_triangles && num_lamps) {
+		if(randt < 0.5f) {
+			randt *= 2.0f;
+			num_lamps = 0;
+		}
+		else {
+			randt = 2.0f*randt - 1.0f;
+			use_triangles = false;
+		}
+	}
+
+	if(use_triangles) {
+		int root = kernel_data.integrator.light_tree_triangle_root;
+		int leaf = light_tree_sample_leaf(kg, root, P, &randt, &pdf);
+
+		if(leaf == -1) {
+			return -1;
+		}
+
+		/* Triangles within a leaf are picked proportional to their area, so
+		 * relative to the area based distribution only the leaf matters. */
+		float root_energy = kernel_tex_fetch(__light_tree_nodes, root*LIGHT_TREE_NODE_SIZE).w;
+		float leaf_energy = kernel_tex_fetch(__light_tree_nodes, leaf*LIGHT_TREE_NODE_SIZE).w;
+		*eval_fac = leaf_energy/(root_energy*pdf);
+
+		return light_tree_sample_emitter(kg, leaf, randt);
+	}
+
+	int num_tree_lamps = kernel_data.integrator.light_tree_num_lamps;
+	float prob_tree = (float)num_tree_lamps/(float)num_lamps;
+
+	if(randt < prob_tree) {
+		randt = randt/prob_tree;
+
+		int root = kernel_data.integrator.light_tree_lamp_root;
+		int leaf = light_tree_sample_leaf(kg, root, P, &randt, &pdf);
+
+		if(leaf == -1) {
+			return -1;
+		}
+
+		int index = light_tree_sample_emitter(kg, leaf, randt);
+
+		/* Lamps fold their selection probability into the evaluation, 1/num_lamps
+		 * of the regular distribution is replaced by the tree probability. */
+		pdf *= kernel_tex_fetch(__light_distribution, index).z;
+		*eval_fac = 1.0f/(num_tree_lamps*pdf);
+
+		return index;
+	}
+
+	/* Distant and background lights are stored after the lamps of the tree. */
+	int num_distant = num_lamps - num_tree_lamps;
+	int distant = (int)((randt - prob_tree)/(1.0f - prob_tree)*num_distant);
+
+	return num_triangles + num_tree_lamps + clamp(distant, 0, num_distant - 1);
+}
+
 /* Generic Light */
 
 ccl_device bool light_select_reached_max_bounces(KernelGlobals *kg, int index, int bounce)
@@ -866,7 +1043,18 @@ ccl_device_noinline bool light_sample(KernelGlobals *kg,
                                       LightSample *ls)
 {
 	/* sample index */
-	int index = light_distribution_sample(kg, randt);
+	int index;
+	float eval_fac = 1.0f;
+
+	if(kernel_data.integrator.use_light_tree) {
+		index = light_tree_distribution_sample(kg, randt, P, &eval_fac);
+		if(index == -1) {
+			return false;
+		}
+	}
+	else {
+		index = light_distribution_sample(kg, randt);
+	}
 
 	/* fetch light data */
 	float4 l = kernel_tex_fetch(__light_distribution, index);
@@ -881,6 +1069,7 @@ ccl_device_noinline bool light_sample(KernelGlobals *kg,
 		ls->D = normalize_len(ls->P - P, &ls->t);
 		ls->pdf = triangle_light_pdf(kg, ls->Ng, -ls->D, ls->t);
 		ls->shader |= shader_flag;
+		ls->eval_fac *= eval_fac;
 		return (ls->pdf > 0.0f);
 	}
 	else {
@@ -890,7 +1079,12 @@ ccl_device_noinline bool light_sample(KernelGlobals *kg,
 			return false;
 		}
 
-		return lamp_light_sample(kg, lamp, randu, randv, P, ls);
+		if(!lamp_light_sample(kg, lamp, randu, randv, P, ls)) {
+			return false;
+		}
+
+		ls->eval_fac *= eval_fac;
+		return true;
 	}
 }
 
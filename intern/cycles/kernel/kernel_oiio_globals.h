@@ -0,0 +1,47 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __KERNEL_OIIO_GLOBALS_H__
+#define __KERNEL_OIIO_GLOBALS_H__
+
+#include <OpenImageIO/texture.h>
+
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Image textures which are not loaded into memory, but streamed tile by tile
+ * from disk through an OpenImageIO texture system, indexed by flat slot. Only
+ * used by the CPU device. */
+
+struct OIIOGlobals {
+	struct Texture {
+		Texture() : handle(NULL), use_alpha(true) {}
+
+		OIIO::TextureSystem::TextureHandle *handle;
+		OIIO::TextureOpt options;
+		bool use_alpha;
+	};
+
+	OIIOGlobals() : texture_system(NULL) {}
+
+	OIIO::TextureSystem *texture_system;
+	vector<Texture> textures;
+};
+
+CCL_NAMESPACE_END
+
+#endif  /* __KERNEL_OIIO_GLOBALS_H__ */
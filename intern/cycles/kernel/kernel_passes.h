@@ -333,6 +333,18 @@ ccl_device_inline void kernel_write_light_passes(KernelGlobals *kg, ccl_global f
 #endif
 }
 
+/* Every other sample is also accumulated (doubled) into an auxiliary buffer, comparing it with
+ * the combined pass gives a per-pixel error estimate for adaptive sampling. */
+ccl_device_inline void kernel_write_adaptive_aux_buffer(KernelGlobals *kg, ccl_global float *buffer,
+	int sample, float3 L_sum)
+{
+	if(kernel_data.film.pass_adaptive_aux_buffer == 0 || !(sample & 1))
+		return;
+
+	kernel_write_pass_float4(buffer + kernel_data.film.pass_adaptive_aux_buffer, sample/2,
+	                         make_float4(L_sum.x*2.0f, L_sum.y*2.0f, L_sum.z*2.0f, 0.0f));
+}
+
 ccl_device_inline void kernel_write_result(KernelGlobals *kg, ccl_global float *buffer,
 	int sample, PathRadiance *L, float alpha, bool is_shadow_catcher)
 {
@@ -349,6 +361,7 @@ ccl_device_inline void kernel_write_result(KernelGlobals *kg, ccl_global float *
 		}
 
 		kernel_write_pass_float4(buffer, sample, make_float4(L_sum.x, L_sum.y, L_sum.z, alpha));
+		kernel_write_adaptive_aux_buffer(kg, buffer, sample, L_sum);
 
 		kernel_write_light_passes(kg, buffer, L, sample);
 
@@ -392,6 +405,7 @@ ccl_device_inline void kernel_write_result(KernelGlobals *kg, ccl_global float *
 	}
 	else {
 		kernel_write_pass_float4(buffer, sample, make_float4(0.0f, 0.0f, 0.0f, 0.0f));
+		kernel_write_adaptive_aux_buffer(kg, buffer, sample, make_float3(0.0f, 0.0f, 0.0f));
 
 #ifdef __DENOISING_FEATURES__
 		if(kernel_data.film.pass_denoising_data) {
@@ -38,6 +38,7 @@ CCL_NAMESPACE_BEGIN
 #define OBJECT_SIZE 		12
 #define OBJECT_VECTOR_SIZE	6
 #define LIGHT_SIZE		11
+#define LIGHT_TREE_NODE_SIZE	4
 #define FILTER_TABLE_SIZE	1024
 #define RAMP_TABLE_SIZE		256
 #define SHUTTER_TABLE_SIZE		256
@@ -80,6 +81,10 @@ CCL_NAMESPACE_BEGIN
 #ifdef __KERNEL_CPU__
 #  ifdef __KERNEL_SSE2__
 #    define __QBVH__
+#    define __BVH_STREAM__
+#  endif
+#  ifdef __KERNEL_AVX2__
+#    define __OBVH__
 #  endif
 #  define __KERNEL_SHADING__
 #  define __KERNEL_ADV_SHADING__
@@ -1186,7 +1191,7 @@ typedef struct KernelFilm {
 	int pass_denoising_data;
 	int pass_denoising_clean;
 	int denoising_flags;
-	int pad;
+	int pass_adaptive_aux_buffer;
 
 #ifdef __KERNEL_DEBUG__
 	int pass_bvh_traversed_nodes;
@@ -1282,7 +1287,17 @@ typedef struct KernelIntegrator {
 	float light_inv_rr_threshold;
 
 	int start_sample;
-	int pad1, pad2, pad3;
+
+	/* adaptive sampling */
+	int adaptive_min_samples;
+	int adaptive_step;
+	float adaptive_threshold;
+
+	/* light tree */
+	int use_light_tree;
+	int light_tree_triangle_root;
+	int light_tree_lamp_root;
+	int light_tree_num_lamps;
 } KernelIntegrator;
 static_assert_align(KernelIntegrator, 16);
 
@@ -1295,7 +1310,10 @@ typedef struct KernelBVH {
 	int have_instancing;
 	int use_qbvh;
 	int use_bvh_steps;
-	int pad1;
+	int use_bvh8;
+	int use_compressed_nodes;
+	int use_indexed_triangles;
+	int pad1, pad2;
 } KernelBVH;
 static_assert_align(KernelBVH, 16);
 
@@ -59,6 +59,7 @@
 #include "kernel/kernel.h"
 #define KERNEL_ARCH cpu
 #include "kernel/kernels/cpu/kernel_cpu_impl.h"
+#include "kernel/kernel_oiio_globals.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -210,4 +211,48 @@ void kernel_tex_copy(KernelGlobals *kg,
 		assert(0);
 }
 
+/* Texture Cache */
+
+bool kernel_tex_image_cache_lookup(KernelGlobals *kg,
+                                   int tex,
+                                   float x, float y,
+                                   float2 dx, float2 dy,
+                                   float4 *r)
+{
+	OIIOGlobals *oiio = kg->oiio;
+
+	if((size_t)tex >= oiio->textures.size() || oiio->textures[tex].handle == NULL) {
+		return false;
+	}
+
+	OIIOGlobals::Texture& texture = oiio->textures[tex];
+	OIIO::TextureOpt options = texture.options;
+	OIIO::TextureSystem::Perthread *thread_info = oiio->texture_system->get_perthread_info();
+	float result[4];
+
+	/* Images are stored bottom to top, OpenImageIO addresses them top to bottom. */
+	bool success = oiio->texture_system->texture(texture.handle,
+	                                             thread_info,
+	                                             options,
+	                                             x, 1.0f - y,
+	                                             dx.x, -dx.y,
+	                                             dy.x, -dy.y,
+	                                             4,
+	                                             result);
+
+	if(success) {
+		*r = make_float4(result[0], result[1], result[2], result[3]);
+	}
+	else {
+		/* Clear the error message, it would pile up otherwise. */
+		(void)oiio->texture_system->geterror();
+		*r = make_float4(TEX_IMAGE_MISSING_R,
+		                 TEX_IMAGE_MISSING_G,
+		                 TEX_IMAGE_MISSING_B,
+		                 TEX_IMAGE_MISSING_A);
+	}
+
+	return true;
+}
+
 CCL_NAMESPACE_END
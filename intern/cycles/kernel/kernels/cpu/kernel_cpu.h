@@ -24,6 +24,36 @@ void KERNEL_FUNCTION_FULL_NAME(path_trace)(KernelGlobals *kg,
                                            int offset,
                                            int stride);
 
+void KERNEL_FUNCTION_FULL_NAME(adaptive_stopping)(KernelGlobals *kg,
+                                                  float *buffer,
+                                                  int sample,
+                                                  int x, int y,
+                                                  int offset,
+                                                  int stride);
+
+bool KERNEL_FUNCTION_FULL_NAME(adaptive_filter_x)(KernelGlobals *kg,
+                                                  float *buffer,
+                                                  int sample,
+                                                  int y,
+                                                  int tile_x, int tile_w,
+                                                  int offset,
+                                                  int stride);
+
+bool KERNEL_FUNCTION_FULL_NAME(adaptive_filter_y)(KernelGlobals *kg,
+                                                  float *buffer,
+                                                  int sample,
+                                                  int x,
+                                                  int tile_y, int tile_h,
+                                                  int offset,
+                                                  int stride);
+
+void KERNEL_FUNCTION_FULL_NAME(adaptive_adjust_samples)(KernelGlobals *kg,
+                                                        float *buffer,
+                                                        int sample,
+                                                        int x, int y,
+                                                        int offset,
+                                                        int stride);
+
 void KERNEL_FUNCTION_FULL_NAME(convert_to_byte)(KernelGlobals *kg,
                                                 uchar4 *rgba,
                                                 float *buffer,
@@ -73,6 +103,7 @@ void KERNEL_FUNCTION_FULL_NAME(data_init)(
 
 DECLARE_SPLIT_KERNEL_FUNCTION(path_init)
 DECLARE_SPLIT_KERNEL_FUNCTION(scene_intersect)
+DECLARE_SPLIT_KERNEL_FUNCTION(scene_intersect_stream)
 DECLARE_SPLIT_KERNEL_FUNCTION(lamp_emission)
 DECLARE_SPLIT_KERNEL_FUNCTION(do_volume)
 DECLARE_SPLIT_KERNEL_FUNCTION(queue_enqueue)
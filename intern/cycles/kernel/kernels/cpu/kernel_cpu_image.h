@@ -21,8 +21,25 @@
 
 CCL_NAMESPACE_BEGIN
 
+/* Lookup into an image streamed through the texture cache, filtered over the
+ * footprint given by the derivatives of the texture coordinates. Returns false
+ * if the image is in memory instead. Implemented outside of the architecture
+ * specific kernels, in kernel.cpp. */
+bool kernel_tex_image_cache_lookup(KernelGlobals *kg,
+                                   int tex,
+                                   float x, float y,
+                                   float2 dx, float2 dy,
+                                   float4 *r);
+
 ccl_device float4 kernel_tex_image_interp_impl(KernelGlobals *kg, int tex, float x, float y)
 {
+	if(kg->oiio != NULL) {
+		float4 r;
+		if(kernel_tex_image_cache_lookup(kg, tex, x, y, make_float2(0.0f, 0.0f), make_float2(0.0f, 0.0f), &r)) {
+			return r;
+		}
+	}
+
 	switch(kernel_tex_type(tex)) {
 		case IMAGE_DATA_TYPE_HALF:
 			return kg->texture_half_images[kernel_tex_index(tex)].interp(x, y);
@@ -40,6 +57,18 @@ ccl_device float4 kernel_tex_image_interp_impl(KernelGlobals *kg, int tex, float
 	}
 }
 
+ccl_device float4 kernel_tex_image_interp_d_impl(KernelGlobals *kg, int tex, float x, float y, float2 dx, float2 dy)
+{
+	if(kg->oiio != NULL) {
+		float4 r;
+		if(kernel_tex_image_cache_lookup(kg, tex, x, y, dx, dy, &r)) {
+			return r;
+		}
+	}
+
+	return kernel_tex_image_interp_impl(kg, tex, x, y);
+}
+
 ccl_device float4 kernel_tex_image_interp_3d_impl(KernelGlobals *kg, int tex, float x, float y, float z)
 {
 	switch(kernel_tex_type(tex)) {
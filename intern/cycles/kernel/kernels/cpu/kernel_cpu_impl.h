@@ -35,6 +35,7 @@
 #    include "kernel/kernel_path.h"
 #    include "kernel/kernel_path_branched.h"
 #    include "kernel/kernel_bake.h"
+#    include "kernel/kernel_adaptive_sampling.h"
 #  else
 #    include "kernel/split/kernel_split_common.h"
 
@@ -102,6 +103,72 @@ void KERNEL_FUNCTION_FULL_NAME(path_trace)(KernelGlobals *kg,
 #endif /* KERNEL_STUB */
 }
 
+/* Adaptive Sampling */
+
+void KERNEL_FUNCTION_FULL_NAME(adaptive_stopping)(KernelGlobals *kg,
+                                                  float *buffer,
+                                                  int sample,
+                                                  int x, int y,
+                                                  int offset,
+                                                  int stride)
+{
+#ifdef KERNEL_STUB
+	STUB_ASSERT(KERNEL_ARCH, adaptive_stopping);
+#else
+	kernel_do_adaptive_stopping(kg,
+	                            kernel_adaptive_pixel(kg, buffer, x, y, offset, stride),
+	                            sample);
+#endif /* KERNEL_STUB */
+}
+
+bool KERNEL_FUNCTION_FULL_NAME(adaptive_filter_x)(KernelGlobals *kg,
+                                                  float *buffer,
+                                                  int sample,
+                                                  int y,
+                                                  int tile_x, int tile_w,
+                                                  int offset,
+                                                  int stride)
+{
+#ifdef KERNEL_STUB
+	STUB_ASSERT(KERNEL_ARCH, adaptive_filter_x);
+	return false;
+#else
+	return kernel_do_adaptive_filter_x(kg, buffer, sample, y, tile_x, tile_w, offset, stride);
+#endif /* KERNEL_STUB */
+}
+
+bool KERNEL_FUNCTION_FULL_NAME(adaptive_filter_y)(KernelGlobals *kg,
+                                                  float *buffer,
+                                                  int sample,
+                                                  int x,
+                                                  int tile_y, int tile_h,
+                                                  int offset,
+                                                  int stride)
+{
+#ifdef KERNEL_STUB
+	STUB_ASSERT(KERNEL_ARCH, adaptive_filter_y);
+	return false;
+#else
+	return kernel_do_adaptive_filter_y(kg, buffer, sample, x, tile_y, tile_h, offset, stride);
+#endif /* KERNEL_STUB */
+}
+
+void KERNEL_FUNCTION_FULL_NAME(adaptive_adjust_samples)(KernelGlobals *kg,
+                                                        float *buffer,
+                                                        int sample,
+                                                        int x, int y,
+                                                        int offset,
+                                                        int stride)
+{
+#ifdef KERNEL_STUB
+	STUB_ASSERT(KERNEL_ARCH, adaptive_adjust_samples);
+#else
+	kernel_adaptive_adjust_samples(kg,
+	                               kernel_adaptive_pixel(kg, buffer, x, y, offset, stride),
+	                               sample);
+#endif /* KERNEL_STUB */
+}
+
 /* Film */
 
 void KERNEL_FUNCTION_FULL_NAME(convert_to_byte)(KernelGlobals *kg,
@@ -219,6 +286,7 @@ void KERNEL_FUNCTION_FULL_NAME(shader)(KernelGlobals *kg,
 
 DEFINE_SPLIT_KERNEL_FUNCTION(path_init)
 DEFINE_SPLIT_KERNEL_FUNCTION(scene_intersect)
+DEFINE_SPLIT_KERNEL_FUNCTION(scene_intersect_stream)
 DEFINE_SPLIT_KERNEL_FUNCTION(lamp_emission)
 DEFINE_SPLIT_KERNEL_FUNCTION(do_volume)
 DEFINE_SPLIT_KERNEL_FUNCTION_LOCALS(queue_enqueue, QueueEnqueueLocals)
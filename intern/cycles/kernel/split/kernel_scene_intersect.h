@@ -16,6 +16,66 @@
 
 CCL_NAMESPACE_BEGIN
 
+ccl_device_inline uint kernel_scene_intersect_visibility(KernelGlobals *kg,
+                                                         const PathState *state,
+                                                         Ray *ray)
+{
+	uint visibility = path_state_ray_visibility(kg, state);
+
+	if(state->bounce > kernel_data.integrator.ao_bounces) {
+		visibility = PATH_RAY_SHADOW;
+		ray->t = kernel_data.background.ao_distance;
+	}
+
+	return visibility;
+}
+
+ccl_device_inline void kernel_scene_intersect_result(KernelGlobals *kg,
+                                                     int ray_index,
+                                                     const PathState *state,
+                                                     const Intersection *isect,
+                                                     bool hit)
+{
+	kernel_split_state.isect[ray_index] = *isect;
+
+#ifdef __KERNEL_DEBUG__
+	DebugData *debug_data = &kernel_split_state.debug_data[ray_index];
+	if(state->flag & PATH_RAY_CAMERA) {
+		debug_data->num_bvh_traversed_nodes += isect->num_traversed_nodes;
+		debug_data->num_bvh_traversed_instances += isect->num_traversed_instances;
+		debug_data->num_bvh_intersections += isect->num_intersections;
+	}
+	debug_data->num_ray_bounces++;
+#endif
+
+	if(!hit) {
+		/* Change the state of rays that hit the background;
+		 * These rays undergo special processing in the
+		 * background_bufferUpdate kernel.
+		 */
+		ASSIGN_RAY_STATE(kernel_split_state.ray_state, ray_index, RAY_HIT_BACKGROUND);
+	}
+}
+
+/* All regenerated rays become active here, returns whether the ray is to be
+ * intersected. */
+ccl_device_inline bool kernel_scene_intersect_activate(KernelGlobals *kg, int ray_index)
+{
+	if(IS_STATE(kernel_split_state.ray_state, ray_index, RAY_REGENERATED)) {
+#ifdef __BRANCHED_PATH__
+		if(kernel_split_state.branched_state[ray_index].waiting_on_shared_samples) {
+			kernel_split_path_end(kg, ray_index);
+		}
+		else
+#endif  /* __BRANCHED_PATH__ */
+		{
+			ASSIGN_RAY_STATE(kernel_split_state.ray_state, ray_index, RAY_ACTIVE);
+		}
+	}
+
+	return IS_STATE(kernel_split_state.ray_state, ray_index, RAY_ACTIVE);
+}
+
 /* This kernel takes care of scene_intersect function.
  *
  * This kernel changes the ray_state of RAY_REGENERATED rays to RAY_ACTIVE.
@@ -42,37 +102,16 @@ ccl_device void kernel_scene_intersect(KernelGlobals *kg)
 		}
 	}
 
-	/* All regenerated rays become active here */
-	if(IS_STATE(kernel_split_state.ray_state, ray_index, RAY_REGENERATED)) {
-#ifdef __BRANCHED_PATH__
-		if(kernel_split_state.branched_state[ray_index].waiting_on_shared_samples) {
-			kernel_split_path_end(kg, ray_index);
-		}
-		else
-#endif  /* __BRANCHED_PATH__ */
-		{
-			ASSIGN_RAY_STATE(kernel_split_state.ray_state, ray_index, RAY_ACTIVE);
-		}
-	}
-
-	if(!IS_STATE(kernel_split_state.ray_state, ray_index, RAY_ACTIVE)) {
+	if(!kernel_scene_intersect_activate(kg, ray_index)) {
 		return;
 	}
 
-#ifdef __KERNEL_DEBUG__
-	DebugData *debug_data = &kernel_split_state.debug_data[ray_index];
-#endif
 	Intersection isect;
 	PathState state = kernel_split_state.path_state[ray_index];
 	Ray ray = kernel_split_state.ray[ray_index];
 
 	/* intersect scene */
-	uint visibility = path_state_ray_visibility(kg, &state);
-
-	if(state.bounce > kernel_data.integrator.ao_bounces) {
-		visibility = PATH_RAY_SHADOW;
-		ray.t = kernel_data.background.ao_distance;
-	}
+	uint visibility = kernel_scene_intersect_visibility(kg, &state, &ray);
 
 #ifdef __HAIR__
 	float difl = 0.0f, extmax = 0.0f;
@@ -94,24 +133,92 @@ ccl_device void kernel_scene_intersect(KernelGlobals *kg)
 #else
 	bool hit = scene_intersect(kg, ray, visibility, &isect, NULL, 0.0f, 0.0f);
 #endif
-	kernel_split_state.isect[ray_index] = isect;
 
-#ifdef __KERNEL_DEBUG__
-	if(state.flag & PATH_RAY_CAMERA) {
-		debug_data->num_bvh_traversed_nodes += isect.num_traversed_nodes;
-		debug_data->num_bvh_traversed_instances += isect.num_traversed_instances;
-		debug_data->num_bvh_intersections += isect.num_intersections;
+	kernel_scene_intersect_result(kg, ray_index, &state, &isect, hit);
+}
+
+#ifdef __KERNEL_CPU__
+#  ifdef __BVH_STREAM__
+ccl_device_inline void kernel_scene_intersect_stream_flush(KernelGlobals *kg,
+                                                           const int *ray_index,
+                                                           const Ray *rays,
+                                                           const uint *visibility,
+                                                           int num_rays)
+{
+	Intersection isects[BVH_STREAM_SIZE];
+
+	scene_intersect_stream(kg, rays, visibility, isects, num_rays);
+
+	for(int i = 0; i < num_rays; i++) {
+		PathState state = kernel_split_state.path_state[ray_index[i]];
+		kernel_scene_intersect_result(kg,
+		                              ray_index[i],
+		                              &state,
+		                              &isects[i],
+		                              isects[i].prim != PRIM_NONE);
 	}
-	debug_data->num_ray_bounces++;
-#endif
+}
+#  endif  /* __BVH_STREAM__ */
 
-	if(!hit) {
-		/* Change the state of rays that hit the background;
-		 * These rays undergo special processing in the
-		 * background_bufferUpdate kernel.
-		 */
-		ASSIGN_RAY_STATE(kernel_split_state.ray_state, ray_index, RAY_HIT_BACKGROUND);
+/* Same as above, but invoked once for all rays instead of once per ray, so
+ * the active rays can be gathered into streams which traverse the BVH
+ * together. Only used by the CPU device. */
+ccl_device void kernel_scene_intersect_stream(KernelGlobals *kg)
+{
+	const int num_threads = ccl_global_size(0) * ccl_global_size(1);
+
+#  ifdef __BVH_STREAM__
+	if(scene_intersect_stream_supported(kg)) {
+		const char local_use_queues_flag = *kernel_split_params.use_queues_flag;
+
+		int ray_index[BVH_STREAM_SIZE];
+		Ray rays[BVH_STREAM_SIZE];
+		uint visibility[BVH_STREAM_SIZE];
+		int num_rays = 0;
+
+		for(int thread_index = 0; thread_index < num_threads; thread_index++) {
+			int index = thread_index;
+			if(local_use_queues_flag) {
+				index = get_ray_index(kg, thread_index,
+				                      QUEUE_ACTIVE_AND_REGENERATED_RAYS,
+				                      kernel_split_state.queue_data,
+				                      kernel_split_params.queue_size,
+				                      0);
+
+				if(index == QUEUE_EMPTY_SLOT) {
+					continue;
+				}
+			}
+
+			if(!kernel_scene_intersect_activate(kg, index)) {
+				continue;
+			}
+
+			PathState state = kernel_split_state.path_state[index];
+			rays[num_rays] = kernel_split_state.ray[index];
+			visibility[num_rays] = kernel_scene_intersect_visibility(kg, &state, &rays[num_rays]);
+			ray_index[num_rays] = index;
+
+			if(++num_rays == BVH_STREAM_SIZE) {
+				kernel_scene_intersect_stream_flush(kg, ray_index, rays, visibility, num_rays);
+				num_rays = 0;
+			}
+		}
+
+		if(num_rays != 0) {
+			kernel_scene_intersect_stream_flush(kg, ray_index, rays, visibility, num_rays);
+		}
+		return;
+	}
+#  endif  /* __BVH_STREAM__ */
+
+	/* Hair and wider BVH nodes are traversed one ray at a time. */
+	for(int thread_index = 0; thread_index < num_threads; thread_index++) {
+		kg->global_id = make_int2(thread_index % ccl_global_size(0),
+		                          thread_index / ccl_global_size(0));
+		kernel_scene_intersect(kg);
 	}
 }
+#endif  /* __KERNEL_CPU__ */
 
 CCL_NAMESPACE_END
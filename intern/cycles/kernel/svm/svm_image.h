@@ -29,10 +29,12 @@ CCL_NAMESPACE_BEGIN
 #  define TEX_NUM_FLOAT4_IMAGES	TEX_NUM_FLOAT4_OPENCL
 #endif
 
-ccl_device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y, uint srgb, uint use_alpha)
+/* The derivatives dx and dy of the texture coordinates are only used on the
+ * CPU, for images streamed through the texture cache. */
+ccl_device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y, float2 dx, float2 dy, uint srgb, uint use_alpha)
 {
 #ifdef __KERNEL_CPU__
-	float4 r = kernel_tex_image_interp(id, x, y);
+	float4 r = kernel_tex_image_interp_d(id, x, y, dx, dy);
 #elif defined(__KERNEL_OPENCL__)
 	float4 r = kernel_tex_image_interp(kg, id, x, y);
 #else
@@ -180,6 +182,28 @@ ccl_device float4 svm_image_texture(KernelGlobals *kg, int id, float x, float y,
 	return r;
 }
 
+/* Derivatives of the texture coordinates, when they are read unmodified from
+ * the UV map uv_id. Other coordinates get no filtering footprint. */
+ccl_device_inline void svm_image_texture_derivatives(KernelGlobals *kg, ShaderData *sd, uint uv_id, float2 *dx, float2 *dy)
+{
+	*dx = make_float2(0.0f, 0.0f);
+	*dy = make_float2(0.0f, 0.0f);
+
+#ifdef __RAY_DIFFERENTIALS__
+	if(uv_id == ATTR_STD_NONE) {
+		return;
+	}
+
+	AttributeDescriptor desc = find_attribute(kg, sd, uv_id);
+	if(desc.offset != ATTR_STD_NOT_FOUND) {
+		float3 duv_dx, duv_dy;
+		primitive_attribute_float3(kg, sd, desc, &duv_dx, &duv_dy);
+		*dx = make_float2(duv_dx.x, duv_dx.y);
+		*dy = make_float2(duv_dy.x, duv_dy.y);
+	}
+#endif
+}
+
 /* Remap coordnate from 0..1 box to -1..-1 */
 ccl_device_inline float3 texco_remap_square(float3 co)
 {
@@ -193,21 +217,34 @@ ccl_device void svm_node_tex_image(KernelGlobals *kg, ShaderData *sd, float *sta
 
 	decode_node_uchar4(node.z, &co_offset, &out_offset, &alpha_offset, &srgb);
 
+	/* Projection in the lower bits, UV map the coordinates come from above. */
+	uint projection = node.w & 0xFF;
+	uint uv_id = node.w >> 8;
+
 	float3 co = stack_load_float3(stack, co_offset);
 	float2 tex_co;
 	uint use_alpha = stack_valid(alpha_offset);
-	if(node.w == NODE_IMAGE_PROJ_SPHERE) {
+	if(projection == NODE_IMAGE_PROJ_SPHERE) {
 		co = texco_remap_square(co);
 		tex_co = map_to_sphere(co);
 	}
-	else if(node.w == NODE_IMAGE_PROJ_TUBE) {
+	else if(projection == NODE_IMAGE_PROJ_TUBE) {
 		co = texco_remap_square(co);
 		tex_co = map_to_tube(co);
 	}
 	else {
 		tex_co = make_float2(co.x, co.y);
 	}
-	float4 f = svm_image_texture(kg, id, tex_co.x, tex_co.y, srgb, use_alpha);
+
+	float2 dx = make_float2(0.0f, 0.0f);
+	float2 dy = make_float2(0.0f, 0.0f);
+#ifdef __KERNEL_CPU__
+	if(kg->oiio != NULL) {
+		svm_image_texture_derivatives(kg, sd, uv_id, &dx, &dy);
+	}
+#endif
+
+	float4 f = svm_image_texture(kg, id, tex_co.x, tex_co.y, dx, dy, srgb, use_alpha);
 
 	if(stack_valid(out_offset))
 		stack_store_float3(stack, out_offset, make_float3(f.x, f.y, f.z));
@@ -294,11 +331,11 @@ ccl_device void svm_node_tex_image_box(KernelGlobals *kg, ShaderData *sd, float
 	uint use_alpha = stack_valid(alpha_offset);
 
 	if(weight.x > 0.0f)
-		f += weight.x*svm_image_texture(kg, id, co.y, co.z, srgb, use_alpha);
+		f += weight.x*svm_image_texture(kg, id, co.y, co.z, make_float2(0.0f, 0.0f), make_float2(0.0f, 0.0f), srgb, use_alpha);
 	if(weight.y > 0.0f)
-		f += weight.y*svm_image_texture(kg, id, co.x, co.z, srgb, use_alpha);
+		f += weight.y*svm_image_texture(kg, id, co.x, co.z, make_float2(0.0f, 0.0f), make_float2(0.0f, 0.0f), srgb, use_alpha);
 	if(weight.z > 0.0f)
-		f += weight.z*svm_image_texture(kg, id, co.y, co.x, srgb, use_alpha);
+		f += weight.z*svm_image_texture(kg, id, co.y, co.x, make_float2(0.0f, 0.0f), make_float2(0.0f, 0.0f), srgb, use_alpha);
 
 	if(stack_valid(out_offset))
 		stack_store_float3(stack, out_offset, make_float3(f.x, f.y, f.z));
@@ -325,7 +362,7 @@ ccl_device void svm_node_tex_environment(KernelGlobals *kg, ShaderData *sd, floa
 		uv = direction_to_mirrorball(co);
 
 	uint use_alpha = stack_valid(alpha_offset);
-	float4 f = svm_image_texture(kg, id, uv.x, uv.y, srgb, use_alpha);
+	float4 f = svm_image_texture(kg, id, uv.x, uv.y, make_float2(0.0f, 0.0f), make_float2(0.0f, 0.0f), srgb, use_alpha);
 
 	if(stack_valid(out_offset))
 		stack_store_float3(stack, out_offset, make_float3(f.x, f.y, f.z));
@@ -44,6 +44,7 @@ BufferParams::BufferParams()
 
 	denoising_data_pass = false;
 	denoising_clean_pass = false;
+	adaptive_sampling_pass = false;
 
 	Pass::add(PASS_COMBINED, passes);
 }
@@ -62,6 +63,7 @@ bool BufferParams::modified(const BufferParams& params)
 		&& height == params.height
 		&& full_width == params.full_width
 		&& full_height == params.full_height
+		&& adaptive_sampling_pass == params.adaptive_sampling_pass
 		&& Pass::equals(passes, params.passes));
 }
 
@@ -77,7 +79,13 @@ int BufferParams::get_passes_size()
 		if(denoising_clean_pass) size += DENOISING_PASS_SIZE_CLEAN;
 	}
 
-	return align_up(size, 4);
+	size = align_up(size, 4);
+
+	if(adaptive_sampling_pass) {
+		size += 4;
+	}
+
+	return size;
 }
 
 int BufferParams::get_denoising_offset()
@@ -54,6 +54,8 @@ public:
 	bool denoising_data_pass;
 	/* If only some light path types should be denoised, an additional pass is needed. */
 	bool denoising_clean_pass;
+	/* Auxiliary buffer for adaptive sampling, placed after all other passes. */
+	bool adaptive_sampling_pass;
 
 	/* functions */
 	BufferParams();
@@ -283,6 +283,8 @@ NODE_DEFINE(Film)
 	SOCKET_BOOLEAN(denoising_clean_pass, "Generate Denoising Clean Pass", false);
 	SOCKET_INT(denoising_flags, "Denoising Flags", 0);
 
+	SOCKET_BOOLEAN(use_adaptive_sampling, "Use Adaptive Sampling", false);
+
 	return type;
 }
 
@@ -456,6 +458,14 @@ void Film::device_update(Device *device, DeviceScene *dscene, Scene *scene)
 	}
 
 	kfilm->pass_stride = align_up(kfilm->pass_stride, 4);
+
+	/* Adaptive sampling auxiliary buffer comes last, aligned for float4 access. */
+	kfilm->pass_adaptive_aux_buffer = 0;
+	if(use_adaptive_sampling) {
+		kfilm->pass_adaptive_aux_buffer = kfilm->pass_stride;
+		kfilm->pass_stride += 4;
+	}
+
 	kfilm->pass_alpha_threshold = pass_alpha_threshold;
 
 	/* update filter table */
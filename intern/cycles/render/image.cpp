@@ -18,6 +18,8 @@
 #include "render/image.h"
 #include "render/scene.h"
 
+#include "kernel/kernel_oiio_globals.h"
+
 #include "util/util_foreach.h"
 #include "util/util_logging.h"
 #include "util/util_path.h"
@@ -28,6 +30,8 @@
 #include <OSL/oslexec.h>
 #endif
 
+#include <OpenImageIO/imagebufalgo.h>
+
 CCL_NAMESPACE_BEGIN
 
 /* Some helpers to silence warning in templated function. */
@@ -723,6 +727,11 @@ void ImageManager::device_load_image(Device *device,
 	string filename = path_filename(images[type][slot]->filename);
 	progress->set_status("Updating Images", "Loading " + filename);
 
+	if(texture_cache_load_image(device, scene, type, slot)) {
+		img->need_load = false;
+		return;
+	}
+
 	const int texture_limit = scene->params.texture_limit;
 
 	/* Slot assignment */
@@ -925,7 +934,7 @@ void ImageManager::device_free_image(Device *device, DeviceScene *dscene, ImageD
 			((OSL::TextureSystem*)osl_texture_system)->invalidate(filename);
 #endif
 		}
-		else {
+		else if(!texture_cache_free_image(device, type, slot)) {
 			device_memory *tex_img = NULL;
 			switch(type) {
 				case IMAGE_DATA_TYPE_FLOAT4:
@@ -990,6 +999,225 @@ void ImageManager::device_free_image(Device *device, DeviceScene *dscene, ImageD
 	}
 }
 
+/* Texture Cache
+ *
+ * Instead of loading image files into memory up front, the CPU device can
+ * look them up through an OpenImageIO texture system, which reads tiles of
+ * the MIP level matching the lookup footprint on demand and keeps them in a
+ * cache of limited size. Tiled and mipmapped .tx files next to the images
+ * are used when present, and optionally written for the next render. */
+
+static OIIO::TextureOpt texture_cache_options(InterpolationType interpolation,
+                                              ExtensionType extension)
+{
+	OIIO::TextureOpt options;
+
+	switch(interpolation) {
+		case INTERPOLATION_CLOSEST:
+			options.interpmode = OIIO::TextureOpt::InterpClosest;
+			options.mipmode = OIIO::TextureOpt::MipModeOneLevel;
+			break;
+		case INTERPOLATION_CUBIC:
+			options.interpmode = OIIO::TextureOpt::InterpBicubic;
+			break;
+		case INTERPOLATION_SMART:
+			options.interpmode = OIIO::TextureOpt::InterpSmartBicubic;
+			break;
+		case INTERPOLATION_LINEAR:
+		default:
+			options.interpmode = OIIO::TextureOpt::InterpBilinear;
+			break;
+	}
+
+	switch(extension) {
+		case EXTENSION_EXTEND:
+			options.swrap = options.twrap = OIIO::TextureOpt::WrapClamp;
+			break;
+		case EXTENSION_CLIP:
+			options.swrap = options.twrap = OIIO::TextureOpt::WrapBlack;
+			break;
+		case EXTENSION_REPEAT:
+		default:
+			options.swrap = options.twrap = OIIO::TextureOpt::WrapPeriodic;
+			break;
+	}
+
+	/* Images without alpha channel are opaque. */
+	options.fill = 1.0f;
+
+	return options;
+}
+
+static string texture_cache_tx_filename(const string& filename)
+{
+	string name = path_filename(filename);
+	size_t dot = name.rfind('.');
+
+	if(dot != string::npos) {
+		name = name.substr(0, dot);
+	}
+
+	return path_join(path_dirname(filename), name + ".tx");
+}
+
+/* File to stream an image from, a tiled and mipmapped version of it if there
+ * is an up to date one. */
+static string texture_cache_filename(const string& filename, bool auto_convert)
+{
+	if(string_endswith(filename, ".tx")) {
+		return filename;
+	}
+
+	string tx_filename = texture_cache_tx_filename(filename);
+
+	if(path_exists(tx_filename) &&
+	   path_modified_time(tx_filename) >= path_modified_time(filename))
+	{
+		return tx_filename;
+	}
+
+	if(auto_convert) {
+		ImageSpec config;
+		config.tile_width = 64;
+		config.tile_height = 64;
+		config.attribute("compression", "zip");
+		config.attribute("maketx:filtername", "lanczos3");
+
+		if(ImageBufAlgo::make_texture(ImageBufAlgo::MakeTxTexture,
+		                              filename,
+		                              tx_filename,
+		                              config))
+		{
+			return tx_filename;
+		}
+
+		VLOG(1) << "Failed to convert " << filename << " to a tiled texture: "
+		        << OIIO::geterror();
+	}
+
+	return filename;
+}
+
+void ImageManager::texture_cache_init(Device *device, Scene *scene)
+{
+	OIIOGlobals *oiio = (OIIOGlobals*)device->oiio_memory();
+
+	/* OSL has a texture system of its own. */
+	if(oiio == NULL || !scene->params.use_texture_cache || osl_texture_system) {
+		return;
+	}
+
+	if(oiio->texture_system == NULL) {
+		OIIO::TextureSystem *texture_system = OIIO::TextureSystem::create(false);
+
+		texture_system->attribute("max_memory_MB", (float)scene->params.texture_cache_size);
+		texture_system->attribute("autotile", 64);
+		texture_system->attribute("automip", 1);
+		texture_system->attribute("gray_to_rgb", 1);
+
+		oiio->texture_system = texture_system;
+	}
+}
+
+void ImageManager::texture_cache_free(Device *device)
+{
+	OIIOGlobals *oiio = (OIIOGlobals*)device->oiio_memory();
+
+	if(oiio == NULL || oiio->texture_system == NULL) {
+		return;
+	}
+
+	VLOG(2) << "Texture cache stats:\n"
+	        << oiio->texture_system->getstats();
+
+	OIIO::TextureSystem::destroy(oiio->texture_system);
+	oiio->texture_system = NULL;
+	oiio->textures.clear();
+}
+
+bool ImageManager::texture_cache_load_image(Device *device,
+                                            Scene *scene,
+                                            ImageDataType type,
+                                            int slot)
+{
+	OIIOGlobals *oiio = (OIIOGlobals*)device->oiio_memory();
+	Image *img = images[type][slot];
+
+	if(oiio == NULL || oiio->texture_system == NULL || img->builtin_data) {
+		return false;
+	}
+
+	/* Missing images are handled by regular loading. */
+	if(!path_exists(img->filename) || path_is_directory(img->filename)) {
+		return false;
+	}
+
+	string filename = texture_cache_filename(img->filename,
+	                                         scene->params.texture_auto_convert);
+	ustring ufilename(filename);
+
+	/* Tiles cached from an earlier version of a reloaded image are outdated. */
+	oiio->texture_system->invalidate(ufilename);
+
+	ImageSpec spec;
+	if(!oiio->texture_system->get_imagespec(ufilename, 0, spec)) {
+		(void)oiio->texture_system->geterror();
+		return false;
+	}
+
+	/* Leave images to regular loading where its channel handling differs from
+	 * OpenImageIO: grayscale with alpha, extra channels and ignored alpha. */
+	if(spec.depth > 1 ||
+	   spec.nchannels == 2 ||
+	   spec.nchannels > 4 ||
+	   (spec.nchannels == 4 && !img->use_alpha))
+	{
+		return false;
+	}
+
+	OIIOGlobals::Texture texture;
+	texture.handle = oiio->texture_system->get_texture_handle(ufilename);
+	texture.options = texture_cache_options(img->interpolation, img->extension);
+
+	if(texture.handle == NULL) {
+		return false;
+	}
+
+	int flat_slot = type_index_to_flattened_slot(slot, type);
+
+	thread_scoped_lock device_lock(device_mutex);
+	if((size_t)flat_slot >= oiio->textures.size()) {
+		oiio->textures.resize(flat_slot + 1);
+	}
+	oiio->textures[flat_slot] = texture;
+
+	return true;
+}
+
+bool ImageManager::texture_cache_free_image(Device *device,
+                                            ImageDataType type,
+                                            int slot)
+{
+	OIIOGlobals *oiio = (OIIOGlobals*)device->oiio_memory();
+	int flat_slot = type_index_to_flattened_slot(slot, type);
+
+	if(oiio == NULL ||
+	   (size_t)flat_slot >= oiio->textures.size() ||
+	   oiio->textures[flat_slot].handle == NULL)
+	{
+		return false;
+	}
+
+	oiio->textures[flat_slot] = OIIOGlobals::Texture();
+
+	/* Drop cached tiles, in case the file changes before it's used again. */
+	Image *img = images[type][slot];
+	oiio->texture_system->invalidate(ustring(img->filename));
+	oiio->texture_system->invalidate(ustring(texture_cache_tx_filename(img->filename)));
+
+	return true;
+}
+
 void ImageManager::device_prepare_update(DeviceScene *dscene)
 {
 	for(int type = 0; type < IMAGE_DATA_NUM_TYPES; type++) {
@@ -1034,6 +1262,8 @@ void ImageManager::device_update(Device *device,
 	/* Make sure arrays are proper size. */
 	device_prepare_update(dscene);
 
+	texture_cache_init(device, scene);
+
 	TaskPool pool;
 	for(int type = 0; type < IMAGE_DATA_NUM_TYPES; type++) {
 		for(size_t slot = 0; slot < images[type].size(); slot++) {
@@ -1245,6 +1475,8 @@ void ImageManager::device_free(Device *device, DeviceScene *dscene)
 		images[type].clear();
 	}
 
+	texture_cache_free(device);
+
 	dscene->tex_float4_image.clear();
 	dscene->tex_byte4_image.clear();
 	dscene->tex_half4_image.clear();
@@ -153,6 +153,17 @@ private:
 	                       ImageDataType type,
 	                       int slot);
 
+	/* Images streamed from disk by the texture cache of the CPU device. */
+	void texture_cache_init(Device *device, Scene *scene);
+	void texture_cache_free(Device *device);
+	bool texture_cache_load_image(Device *device,
+	                              Scene *scene,
+	                              ImageDataType type,
+	                              int slot);
+	bool texture_cache_free_image(Device *device,
+	                              ImageDataType type,
+	                              int slot);
+
 	template<typename T>
 	void device_pack_images_type(
 	        ImageDataType type,
@@ -66,9 +66,13 @@ NODE_DEFINE(Integrator)
 	SOCKET_INT(volume_samples, "Volume Samples", 1);
 	SOCKET_INT(start_sample, "Start Sample", 0);
 
+	SOCKET_FLOAT(adaptive_threshold, "Adaptive Threshold", 0.0f);
+	SOCKET_INT(adaptive_min_samples, "Adaptive Min Samples", 0);
+
 	SOCKET_BOOLEAN(sample_all_lights_direct, "Sample All Lights Direct", true);
 	SOCKET_BOOLEAN(sample_all_lights_indirect, "Sample All Lights Indirect", true);
 	SOCKET_FLOAT(light_sampling_threshold, "Light Sampling Threshold", 0.05f);
+	SOCKET_BOOLEAN(use_light_tree, "Use Light Tree", false);
 
 	static NodeEnum method_enum;
 	method_enum.insert("path", PATH);
@@ -176,6 +180,21 @@ void Integrator::device_update(Device *device, DeviceScene *dscene, Scene *scene
 	kintegrator->sampling_pattern = sampling_pattern;
 	kintegrator->aa_samples = aa_samples;
 
+	/* Adaptive sampling, only used when the film has the auxiliary buffer.
+	 * Convergence is tested every few samples, an even number as half of the
+	 * samples are accumulated separately to estimate the error. Zero values
+	 * pick defaults based on the number of samples. */
+	kintegrator->adaptive_step = 4;
+	if(adaptive_threshold > 0.0f) {
+		kintegrator->adaptive_threshold = adaptive_threshold;
+	}
+	else {
+		kintegrator->adaptive_threshold = max(0.001f, 1.0f / (float)max(aa_samples, 1));
+	}
+	int min_samples = (adaptive_min_samples > 0)?
+	        adaptive_min_samples: max(4, (int)sqrtf((float)max(aa_samples, 0)));
+	kintegrator->adaptive_min_samples = (int)round_up(min_samples, kintegrator->adaptive_step);
+
 	if(light_sampling_threshold > 0.0f) {
 		kintegrator->light_inv_rr_threshold = 1.0f / light_sampling_threshold;
 	}
@@ -68,9 +68,13 @@ public:
 	int volume_samples;
 	int start_sample;
 
+	float adaptive_threshold;
+	int adaptive_min_samples;
+
 	bool sample_all_lights_direct;
 	bool sample_all_lights_indirect;
 	float light_sampling_threshold;
+	bool use_light_tree;
 
 	enum Method {
 		BRANCHED_PATH = 0,
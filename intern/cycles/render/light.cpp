@@ -19,6 +19,7 @@
 #include "render/integrator.h"
 #include "render/film.h"
 #include "render/light.h"
+#include "render/light_tree.h"
 #include "render/mesh.h"
 #include "render/object.h"
 #include "render/scene.h"
@@ -30,6 +31,9 @@
 
 CCL_NAMESPACE_BEGIN
 
+/* Maximum number of emissive triangles in a light tree leaf, lamps get a leaf each. */
+#define LIGHT_TREE_MAX_LEAF_TRIANGLES 4
+
 static void shade_background_pixels(Device *device, DeviceScene *dscene, int res, vector<float3>& pixels, Progress& progress)
 {
 	/* create input */
@@ -256,6 +260,9 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 	size_t num_triangles = 0;
 
 	bool background_mis = false;
+	bool use_light_tree = scene->integrator->use_light_tree;
+	vector<LightTreePrimitive> triangle_primitives;
+	vector<LightTreePrimitive> lamp_primitives;
 
 	foreach(Light *light, scene->lights) {
 		if(light->is_enabled) {
@@ -354,7 +361,22 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 					p3 = transform_point(&tfm, p3);
 				}
 
-				totarea += triangle_area(p1, p2, p3);
+				float area = triangle_area(p1, p2, p3);
+				totarea += area;
+
+				if(use_light_tree) {
+					/* Mesh lights emit from both sides. Energy must stay proportional
+					 * to the area, the kernel relies on it to keep using the area
+					 * based pdf for multiple importance sampling. */
+					LightTreePrimitive prim;
+					prim.bbox.grow(p1);
+					prim.bbox.grow(p2);
+					prim.bbox.grow(p3);
+					prim.cone = LightTreeCone::omnidirectional();
+					prim.energy = area;
+					prim.index = offset - 1;
+					triangle_primitives.push_back(prim);
+				}
 			}
 		}
 
@@ -385,6 +407,14 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 			background_mis = light->use_mis;
 		}
 
+		if(use_light_tree) {
+			LightTreePrimitive prim;
+			if(light_tree_primitive(scene, light, &prim)) {
+				prim.index = light_index;
+				lamp_primitives.push_back(prim);
+			}
+		}
+
 		light_index++;
 		offset++;
 	}
@@ -446,6 +476,22 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 		if(num_background_lights < num_lights)
 			kfilm->pass_shadow_scale *= (float)(num_lights - num_background_lights)/(float)num_lights;
 
+		/* Light tree */
+		if(use_light_tree) {
+			device_update_tree(device,
+			                   dscene,
+			                   num_triangles,
+			                   triangle_primitives,
+			                   lamp_primitives,
+			                   progress);
+		}
+		else {
+			kintegrator->use_light_tree = false;
+			kintegrator->light_tree_triangle_root = -1;
+			kintegrator->light_tree_lamp_root = -1;
+			kintegrator->light_tree_num_lamps = 0;
+		}
+
 		/* CDF */
 		device->tex_alloc("__light_distribution", dscene->light_distribution);
 
@@ -473,11 +519,133 @@ void LightManager::device_update_distribution(Device *device, DeviceScene *dscen
 		kintegrator->num_portals = 0;
 		kintegrator->portal_offset = 0;
 		kintegrator->portal_pdf = 0.0f;
+		kintegrator->use_light_tree = false;
+		kintegrator->light_tree_triangle_root = -1;
+		kintegrator->light_tree_lamp_root = -1;
+		kintegrator->light_tree_num_lamps = 0;
 
 		kfilm->pass_shadow_scale = 1.0f;
 	}
 }
 
+/* Fill in bounds, orientation and energy of a lamp for the light tree. Distant
+ * and background lights have no position and are sampled outside the tree. */
+bool LightManager::light_tree_primitive(Scene *scene, Light *light, LightTreePrimitive *prim)
+{
+	float3 co = light->co;
+
+	if(light->type == LIGHT_POINT || light->type == LIGHT_SPOT) {
+		prim->bbox.grow(co, light->size);
+
+		if(light->type == LIGHT_SPOT) {
+			float theta_o = min(light->spot_angle*0.5f, M_PI_F);
+			prim->cone = LightTreeCone(safe_normalize(light->dir), theta_o, M_PI_2_F);
+		}
+		else {
+			prim->cone = LightTreeCone::omnidirectional();
+		}
+	}
+	else if(light->type == LIGHT_AREA) {
+		float3 axisu = light->axisu*(light->sizeu*light->size);
+		float3 axisv = light->axisv*(light->sizev*light->size);
+		float3 corner = co - 0.5f*axisu - 0.5f*axisv;
+
+		prim->bbox.grow(corner);
+		prim->bbox.grow(corner + axisu);
+		prim->bbox.grow(corner + axisv);
+		prim->bbox.grow(corner + axisu + axisv);
+		prim->cone = LightTreeCone(safe_normalize(light->dir), 0.0f, M_PI_2_F);
+	}
+	else {
+		return false;
+	}
+
+	/* Only constant emission gives a usable strength estimate. */
+	Shader *shader = (light->shader) ? light->shader : scene->default_light;
+	float3 emission;
+	prim->energy = shader->is_constant_emission(&emission)? average(emission): 1.0f;
+
+	return true;
+}
+
+void LightManager::device_update_tree(Device *device,
+                                      DeviceScene *dscene,
+                                      size_t num_triangles,
+                                      vector<LightTreePrimitive>& triangle_primitives,
+                                      vector<LightTreePrimitive>& lamp_primitives,
+                                      Progress& progress)
+{
+	progress.set_status("Updating Lights", "Building light tree");
+
+	KernelIntegrator *kintegrator = &dscene->data.integrator;
+	float4 *distribution = dscene->light_distribution.get_data();
+	size_t num_lamps = dscene->light_distribution.size() - 1 - num_triangles;
+
+	LightTree triangle_tree(triangle_primitives, LIGHT_TREE_MAX_LEAF_TRIANGLES);
+	LightTree lamp_tree(lamp_primitives, 1);
+
+	triangle_tree.build();
+	lamp_tree.build();
+
+	int num_triangle_nodes = triangle_tree.num_nodes();
+	int num_nodes = num_triangle_nodes + lamp_tree.num_nodes();
+	float4 *nodes = dscene->light_tree_nodes.resize(max(num_nodes, 1)*LIGHT_TREE_NODE_SIZE);
+
+	size_t num_primitives = max(triangle_primitives.size(), lamp_primitives.size());
+	vector<float> leaf_cdf(max(num_primitives, (size_t)1));
+	vector<float> leaf_pdf(max(num_primitives, (size_t)1));
+
+	/* Triangles come first in the distribution, reorder them so each tree
+	 * leaf references a contiguous range. The CDF is replaced by the one
+	 * within the leaf. */
+	vector<float4> entries(distribution, distribution + num_triangles);
+
+	triangle_tree.pack(nodes, 0, 0, &leaf_cdf[0], &leaf_pdf[0]);
+
+	for(size_t i = 0; i < triangle_primitives.size(); i++) {
+		distribution[i] = entries[triangle_primitives[i].index];
+		distribution[i].x = leaf_cdf[i];
+	}
+
+	/* Followed by the lamps in tree order, and then the distant and background
+	 * lights which are picked uniformly. For lamps the probability within the
+	 * leaf is needed as well. */
+	float4 *lamp_distribution = distribution + num_triangles;
+	vector<bool> in_tree(num_lamps, false);
+	size_t lamp_offset = 0;
+
+	entries.assign(lamp_distribution, lamp_distribution + num_lamps);
+
+	lamp_tree.pack(nodes, num_triangle_nodes, num_triangles, &leaf_cdf[0], &leaf_pdf[0]);
+
+	for(size_t i = 0; i < lamp_primitives.size(); i++) {
+		int index = lamp_primitives[i].index;
+
+		lamp_distribution[lamp_offset] = entries[index];
+		lamp_distribution[lamp_offset].x = leaf_cdf[i];
+		lamp_distribution[lamp_offset].z = leaf_pdf[i];
+		in_tree[index] = true;
+		lamp_offset++;
+	}
+
+	for(size_t i = 0; i < num_lamps; i++) {
+		if(!in_tree[i]) {
+			lamp_distribution[lamp_offset++] = entries[i];
+		}
+	}
+
+	VLOG(1) << "Light tree with " << num_nodes << " nodes over "
+	        << triangle_primitives.size() << " triangles and "
+	        << lamp_primitives.size() << " lamps.";
+
+	kintegrator->use_light_tree = true;
+	kintegrator->light_tree_triangle_root = (num_triangle_nodes > 0)? 0: -1;
+	kintegrator->light_tree_lamp_root = (lamp_tree.num_nodes() > 0)? num_triangle_nodes: -1;
+	kintegrator->light_tree_num_lamps = lamp_primitives.size();
+
+	device->tex_alloc("__light_tree_nodes", dscene->light_tree_nodes);
+}
+
 static void background_cdf(int start,
                            int end,
                            int res,
@@ -846,11 +1014,13 @@ void LightManager::device_free(Device *device, DeviceScene *dscene)
 {
 	device->tex_free(dscene->light_distribution);
 	device->tex_free(dscene->light_data);
+	device->tex_free(dscene->light_tree_nodes);
 	device->tex_free(dscene->light_background_marginal_cdf);
 	device->tex_free(dscene->light_background_conditional_cdf);
 
 	dscene->light_distribution.clear();
 	dscene->light_data.clear();
+	dscene->light_tree_nodes.clear();
 	dscene->light_background_marginal_cdf.clear();
 	dscene->light_background_conditional_cdf.clear();
 }
@@ -29,6 +29,7 @@ CCL_NAMESPACE_BEGIN
 class Device;
 class DeviceScene;
 class Object;
+struct LightTreePrimitive;
 class Progress;
 class Scene;
 class Shader;
@@ -110,11 +111,20 @@ protected:
 	                                DeviceScene *dscene,
 	                                Scene *scene,
 	                                Progress& progress);
+	void device_update_tree(Device *device,
+	                        DeviceScene *dscene,
+	                        size_t num_triangles,
+	                        vector<LightTreePrimitive>& triangle_primitives,
+	                        vector<LightTreePrimitive>& lamp_primitives,
+	                        Progress& progress);
 	void device_update_background(Device *device,
 	                              DeviceScene *dscene,
 	                              Scene *scene,
 	                              Progress& progress);
 
+	/* Fill in a light tree primitive for lamps which have a position. */
+	bool light_tree_primitive(Scene *scene, Light *light, LightTreePrimitive *prim);
+
 	/* Check whether light manager can use the object as a light-emissive. */
 	bool object_usable_as_light(Object *object);
 };
@@ -0,0 +1,358 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "render/light_tree.h"
+
+#include "kernel/kernel_types.h"
+
+#include "util/util_algorithm.h"
+#include "util/util_math.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Number of buckets the centroids are binned into per axis. */
+#define LIGHT_TREE_NUM_BUCKETS 12
+
+static inline int light_tree_bucket(const LightTreePrimitive& prim,
+                                    int axis,
+                                    float split_min,
+                                    float inv_extent)
+{
+	int b = (int)((prim.bbox.center()[axis] - split_min)*inv_extent);
+	return clamp(b, 0, LIGHT_TREE_NUM_BUCKETS - 1);
+}
+
+/* Cone */
+
+LightTreeCone LightTreeCone::merge(const LightTreeCone& a, const LightTreeCone& b)
+{
+	if(b.theta_o > a.theta_o) {
+		return merge(b, a);
+	}
+
+	float theta_e = max(a.theta_e, b.theta_e);
+	float theta_d = safe_acosf(dot(a.axis, b.axis));
+
+	/* b is contained in a. */
+	if(min(theta_d + b.theta_o, M_PI_F) <= a.theta_o) {
+		return LightTreeCone(a.axis, a.theta_o, theta_e);
+	}
+
+	float theta_o = 0.5f*(a.theta_o + theta_d + b.theta_o);
+	if(theta_o >= M_PI_F) {
+		return LightTreeCone(a.axis, M_PI_F, theta_e);
+	}
+
+	/* Rotate the axis of a towards b, opposite axes bound all directions. */
+	float3 rotation_axis = cross(a.axis, b.axis);
+	if(len_squared(rotation_axis) < 1e-12f) {
+		return LightTreeCone(a.axis, M_PI_F, theta_e);
+	}
+
+	float3 axis = rotate_around_axis(a.axis, normalize(rotation_axis), theta_o - a.theta_o);
+	return LightTreeCone(normalize(axis), theta_o, theta_e);
+}
+
+float LightTreeCone::measure() const
+{
+	float theta_w = min(theta_o + theta_e, M_PI_F);
+	float cos_theta_o = cosf(theta_o);
+	float sin_theta_o = sinf(theta_o);
+
+	return M_2PI_F*(1.0f - cos_theta_o) +
+	       M_PI_2_F*(2.0f*theta_w*sin_theta_o -
+	                 cosf(theta_o - 2.0f*theta_w) -
+	                 2.0f*theta_o*sin_theta_o +
+	                 cos_theta_o);
+}
+
+/* Split */
+
+struct LightTreeSplitPredicate {
+	int axis;
+	int bucket;
+	float split_min;
+	float inv_extent;
+
+	LightTreeSplitPredicate(int axis_, int bucket_, float split_min_, float inv_extent_)
+	: axis(axis_), bucket(bucket_), split_min(split_min_), inv_extent(inv_extent_) {}
+
+	bool operator()(const LightTreePrimitive& prim) const
+	{
+		return light_tree_bucket(prim, axis, split_min, inv_extent) <= bucket;
+	}
+};
+
+/* Constructor / Destructor */
+
+LightTree::LightTree(vector<LightTreePrimitive>& primitives_, int max_leaf_size_)
+: primitives(primitives_),
+  max_leaf_size(max(max_leaf_size_, 1)),
+  root(NULL),
+  total_nodes(0)
+{
+}
+
+LightTree::~LightTree()
+{
+	delete root;
+}
+
+/* Build */
+
+void LightTree::build()
+{
+	delete root;
+	root = NULL;
+	total_nodes = 0;
+
+	if(primitives.size() == 0) {
+		return;
+	}
+
+	root = new Node();
+	build_node(root, 0, primitives.size());
+	task_pool.wait_work();
+
+	total_nodes = count_nodes(root);
+}
+
+void LightTree::thread_build_node(Node *node, int first, int num)
+{
+	build_node(node, first, num);
+}
+
+void LightTree::build_node(Node *node, int first, int num)
+{
+	node->first = first;
+	node->num = num;
+	node->cone = primitives[first].cone;
+
+	for(int i = first; i < first + num; i++) {
+		const LightTreePrimitive& prim = primitives[i];
+
+		node->bbox.grow(prim.bbox);
+		node->energy += prim.energy;
+		if(i != first) {
+			node->cone = LightTreeCone::merge(node->cone, prim.cone);
+		}
+	}
+
+	if(num <= max_leaf_size) {
+		return;
+	}
+
+	int split = find_split(node, first, num);
+	int num_left = split - first;
+	int num_right = num - num_left;
+
+	node->children[0] = new Node();
+	node->children[1] = new Node();
+
+	if(num < THREAD_TASK_SIZE) {
+		build_node(node->children[0], first, num_left);
+		build_node(node->children[1], split, num_right);
+	}
+	else {
+		task_pool.push(function_bind(&LightTree::thread_build_node,
+		                             this, node->children[0], first, num_left), true);
+		task_pool.push(function_bind(&LightTree::thread_build_node,
+		                             this, node->children[1], split, num_right), true);
+	}
+}
+
+/* Pick the centroid bucket boundary minimizing the surface area orientation
+ * heuristic, and partition the primitives around it. */
+int LightTree::find_split(const Node *node, int first, int num)
+{
+	BoundBox centroid_bbox = BoundBox::empty;
+	for(int i = first; i < first + num; i++) {
+		centroid_bbox.grow(primitives[i].bbox.center());
+	}
+
+	float3 centroid_extent = centroid_bbox.size();
+	float3 extent = node->bbox.size();
+	float max_extent = max3(extent);
+	float node_cost = node->cone.measure()*node->bbox.half_area();
+
+	float min_cost = FLT_MAX;
+	int min_axis = -1;
+	int min_bucket = 0;
+
+	for(int axis = 0; axis < 3; axis++) {
+		if(centroid_extent[axis] == 0.0f) {
+			continue;
+		}
+
+		int count[LIGHT_TREE_NUM_BUCKETS] = {0};
+		float energy[LIGHT_TREE_NUM_BUCKETS] = {0.0f};
+		BoundBox bbox[LIGHT_TREE_NUM_BUCKETS];
+		LightTreeCone cone[LIGHT_TREE_NUM_BUCKETS];
+
+		for(int b = 0; b < LIGHT_TREE_NUM_BUCKETS; b++) {
+			bbox[b] = BoundBox::empty;
+		}
+
+		float inv_extent = LIGHT_TREE_NUM_BUCKETS/centroid_extent[axis];
+		for(int i = first; i < first + num; i++) {
+			const LightTreePrimitive& prim = primitives[i];
+			int b = light_tree_bucket(prim, axis, centroid_bbox.min[axis], inv_extent);
+
+			cone[b] = (count[b] == 0)? prim.cone: LightTreeCone::merge(cone[b], prim.cone);
+			bbox[b].grow(prim.bbox);
+			energy[b] += prim.energy;
+			count[b]++;
+		}
+
+		/* Accumulate costs from the right to the left. */
+		float right_cost[LIGHT_TREE_NUM_BUCKETS];
+		BoundBox right_bbox = BoundBox::empty;
+		LightTreeCone right_cone;
+		float right_energy = 0.0f;
+		int right_count = 0;
+
+		for(int b = LIGHT_TREE_NUM_BUCKETS - 1; b > 0; b--) {
+			if(count[b] != 0) {
+				right_cone = (right_count == 0)? cone[b]: LightTreeCone::merge(right_cone, cone[b]);
+				right_bbox.grow(bbox[b]);
+				right_energy += energy[b];
+				right_count += count[b];
+			}
+			right_cost[b] = (right_count == 0)? -1.0f:
+			                right_energy*right_cone.measure()*right_bbox.half_area();
+		}
+
+		/* Regularization against thin slabs along the split axis. */
+		float regularization = max_extent/extent[axis];
+
+		BoundBox left_bbox = BoundBox::empty;
+		LightTreeCone left_cone;
+		float left_energy = 0.0f;
+		int left_count = 0;
+
+		for(int b = 0; b < LIGHT_TREE_NUM_BUCKETS - 1; b++) {
+			if(count[b] != 0) {
+				left_cone = (left_count == 0)? cone[b]: LightTreeCone::merge(left_cone, cone[b]);
+				left_bbox.grow(bbox[b]);
+				left_energy += energy[b];
+				left_count += count[b];
+			}
+
+			if(left_count == 0 || right_cost[b + 1] < 0.0f) {
+				continue;
+			}
+
+			float left_cost = left_energy*left_cone.measure()*left_bbox.half_area();
+			float cost = regularization*(left_cost + right_cost[b + 1]);
+			if(node_cost > 0.0f) {
+				cost /= node_cost;
+			}
+
+			if(cost < min_cost) {
+				min_cost = cost;
+				min_axis = axis;
+				min_bucket = b;
+			}
+		}
+	}
+
+	LightTreePrimitive *begin = &primitives[first];
+	LightTreePrimitive *end = begin + num;
+	LightTreePrimitive *middle;
+
+	if(min_axis == -1) {
+		/* All centroids coincide, split in the middle. */
+		middle = begin + num/2;
+	}
+	else {
+		LightTreeSplitPredicate predicate(min_axis,
+		                                  min_bucket,
+		                                  centroid_bbox.min[min_axis],
+		                                  LIGHT_TREE_NUM_BUCKETS/centroid_extent[min_axis]);
+		middle = std::partition(begin, end, predicate);
+
+		/* Float rounding could in theory still leave one side empty. */
+		if(middle == begin || middle == end) {
+			middle = begin + num/2;
+		}
+	}
+
+	return first + (int)(middle - begin);
+}
+
+int LightTree::count_nodes(const Node *node) const
+{
+	if(node->is_leaf()) {
+		return 1;
+	}
+	return 1 + count_nodes(node->children[0]) + count_nodes(node->children[1]);
+}
+
+/* Pack */
+
+void LightTree::pack(float4 *nodes,
+                     int node_offset,
+                     int prim_offset,
+                     float *leaf_cdf,
+                     float *leaf_pdf) const
+{
+	if(root != NULL) {
+		pack_node(root, nodes, node_offset, prim_offset, leaf_cdf, leaf_pdf);
+	}
+}
+
+int LightTree::pack_node(const Node *node,
+                         float4 *nodes,
+                         int index,
+                         int prim_offset,
+                         float *leaf_cdf,
+                         float *leaf_pdf) const
+{
+	float4 *data = nodes + index*LIGHT_TREE_NODE_SIZE;
+	const float3& bmin = node->bbox.min;
+	const float3& bmax = node->bbox.max;
+	const float3& axis = node->cone.axis;
+
+	data[0] = make_float4(bmin.x, bmin.y, bmin.z, node->energy);
+	data[1] = make_float4(bmax.x, bmax.y, bmax.z, node->cone.theta_o);
+	data[2] = make_float4(axis.x, axis.y, axis.z, node->cone.theta_e);
+
+	if(node->is_leaf()) {
+		data[3] = make_float4(__int_as_float(prim_offset + node->first),
+		                      __int_as_float(node->num),
+		                      0.0f, 0.0f);
+
+		/* Emitters of a leaf are picked proportional to their energy. */
+		float cdf = 0.0f;
+		for(int i = node->first; i < node->first + node->num; i++) {
+			float pdf = (node->energy > 0.0f)? primitives[i].energy/node->energy:
+			                                   1.0f/node->num;
+			leaf_cdf[i] = cdf;
+			leaf_pdf[i] = pdf;
+			cdf += pdf;
+		}
+
+		return index + 1;
+	}
+
+	/* Left child follows its parent, the right child index is stored. */
+	int right = pack_node(node->children[0], nodes, index + 1, prim_offset, leaf_cdf, leaf_pdf);
+	data[3] = make_float4(__int_as_float(right), __int_as_float(0), 0.0f, 0.0f);
+
+	return pack_node(node->children[1], nodes, right, prim_offset, leaf_cdf, leaf_pdf);
+}
+
+CCL_NAMESPACE_END
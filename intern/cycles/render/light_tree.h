@@ -0,0 +1,142 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef __LIGHT_TREE_H__
+#define __LIGHT_TREE_H__
+
+#include "util/util_boundbox.h"
+#include "util/util_task.h"
+#include "util/util_types.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+/* Bounds on the emission directions of a set of emitters: all their normals
+ * lie within theta_o around the axis, and each of them emits up to theta_e
+ * away from its normal. */
+
+struct LightTreeCone {
+	float3 axis;
+	float theta_o;
+	float theta_e;
+
+	LightTreeCone()
+	: axis(make_float3(0.0f, 0.0f, 1.0f)), theta_o(0.0f), theta_e(0.0f) {}
+
+	LightTreeCone(const float3& axis_, float theta_o_, float theta_e_)
+	: axis(axis_), theta_o(theta_o_), theta_e(theta_e_) {}
+
+	/* Emits into all directions. */
+	static LightTreeCone omnidirectional()
+	{
+		return LightTreeCone(make_float3(0.0f, 0.0f, 1.0f), M_PI_F, M_PI_2_F);
+	}
+
+	/* Smallest cone bounding both cones. */
+	static LightTreeCone merge(const LightTreeCone& a, const LightTreeCone& b);
+
+	/* Solid angle measure weighted by the cosine falloff, used by the build heuristic. */
+	float measure() const;
+};
+
+/* Emissive triangle or lamp the tree is built over. The index refers back
+ * to the caller's emitter, primitives get reordered by the build so that each
+ * leaf references a contiguous range of them. */
+
+struct LightTreePrimitive {
+	BoundBox bbox;
+	LightTreeCone cone;
+	float energy;
+	int index;
+
+	LightTreePrimitive() : bbox(BoundBox::empty), energy(0.0f), index(0) {}
+};
+
+/* Light Tree
+ *
+ * Bounding volume hierarchy over emitters, storing the total energy and the
+ * orientation bounds of each cluster, so the kernel can pick an emitter
+ * according to its estimated contribution to a shading point. Built top-down
+ * with the surface area orientation heuristic of "Importance Sampling of Many
+ * Lights with Adaptive Tree Splitting" (Conty Estevez and Kulla). */
+
+class LightTree {
+public:
+	LightTree(vector<LightTreePrimitive>& primitives, int max_leaf_size);
+	~LightTree();
+
+	void build();
+
+	int num_nodes() const { return total_nodes; }
+
+	/* Writes the nodes in the kernel layout starting at node_offset, with leaves
+	 * referencing primitives from prim_offset on. For every primitive in tree
+	 * order this also writes where its range starts in the energy CDF of its
+	 * leaf, and its probability of being picked within the leaf. */
+	void pack(float4 *nodes,
+	          int node_offset,
+	          int prim_offset,
+	          float *leaf_cdf,
+	          float *leaf_pdf) const;
+
+protected:
+	struct Node {
+		BoundBox bbox;
+		LightTreeCone cone;
+		float energy;
+		Node *children[2];
+		int first;
+		int num;
+
+		Node() : bbox(BoundBox::empty), energy(0.0f), first(0), num(0)
+		{
+			children[0] = children[1] = NULL;
+		}
+		~Node()
+		{
+			delete children[0];
+			delete children[1];
+		}
+
+		bool is_leaf() const { return children[0] == NULL; }
+	};
+
+	void build_node(Node *node, int first, int num);
+	void thread_build_node(Node *node, int first, int num);
+	int find_split(const Node *node, int first, int num);
+	int count_nodes(const Node *node) const;
+
+	int pack_node(const Node *node,
+	              float4 *nodes,
+	              int index,
+	              int prim_offset,
+	              float *leaf_cdf,
+	              float *leaf_pdf) const;
+
+	/* Threads. */
+	enum { THREAD_TASK_SIZE = 4096 };
+	TaskPool task_pool;
+
+	vector<LightTreePrimitive>& primitives;
+	int max_leaf_size;
+
+	Node *root;
+	int total_nodes;
+};
+
+CCL_NAMESPACE_END
+
+#endif  /* __LIGHT_TREE_H__ */
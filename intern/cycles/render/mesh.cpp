@@ -37,6 +37,7 @@
 #include "util/util_logging.h"
 #include "util/util_progress.h"
 #include "util/util_set.h"
+#include "util/util_string.h"
 
 CCL_NAMESPACE_BEGIN
 
@@ -1051,6 +1052,9 @@ void Mesh::compute_bvh(DeviceScene *dscene,
 			BVHParams bparams;
 			bparams.use_spatial_split = params->use_bvh_spatial_split;
 			bparams.use_qbvh = params->use_qbvh;
+			bparams.use_bvh8 = params->use_bvh8;
+			bparams.use_compressed_nodes = params->use_bvh_compressed_nodes;
+			bparams.use_indexed_triangles = params->use_bvh_indexed_triangles;
 			bparams.use_unaligned_nodes = dscene->data.bvh.have_curves &&
 			                              params->use_bvh_unaligned_nodes;
 			bparams.num_motion_triangle_steps = params->num_bvh_time_steps;
@@ -1795,6 +1799,10 @@ void MeshManager::device_update_mesh(Device *device,
 	}
 
 	if(for_displacement) {
+		/* Displacement kernels read the vertices per triangle, whatever
+		 * storage the BVH of the previous update used. */
+		dscene->data.bvh.use_indexed_triangles = false;
+
 		float4 *prim_tri_verts = dscene->prim_tri_verts.resize(tri_size * 3);
 		foreach(Mesh *mesh, scene->meshes) {
 			for(size_t i = 0; i < mesh->num_triangles(); ++i) {
@@ -1809,26 +1817,66 @@ void MeshManager::device_update_mesh(Device *device,
 	}
 }
 
-void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *scene, Progress& progress)
+void MeshManager::device_update_bvh(Device *device,
+                                    DeviceScene *dscene,
+                                    Scene *scene,
+                                    bool update_geometry,
+                                    Progress& progress)
 {
-	/* bvh build */
-	progress.set_status("Updating Scene BVH", "Building");
-
-	VLOG(1) << (scene->params.use_qbvh ? "Using QBVH optimization structure"
-	                                   : "Using regular BVH optimization structure");
-
 	BVHParams bparams;
 	bparams.top_level = true;
 	bparams.use_qbvh = scene->params.use_qbvh;
+	bparams.use_bvh8 = scene->params.use_bvh8;
+	bparams.use_compressed_nodes = scene->params.use_bvh_compressed_nodes;
+	bparams.use_indexed_triangles = scene->params.use_bvh_indexed_triangles;
 	bparams.use_spatial_split = scene->params.use_bvh_spatial_split;
 	bparams.use_unaligned_nodes = dscene->data.bvh.have_curves &&
 	                              scene->params.use_bvh_unaligned_nodes;
 	bparams.num_motion_triangle_steps = scene->params.num_bvh_time_steps;
 	bparams.num_motion_curve_steps = scene->params.num_bvh_time_steps;
 
-	delete bvh;
-	bvh = BVH::create(bparams, scene->objects);
-	bvh->build(progress);
+	/* Objects without geometry are left out of the top level, so a change
+	 * there changes its primitives. */
+	vector<bool> object_traceable;
+	foreach(Object *object, scene->objects) {
+		object_traceable.push_back(object->is_traceable());
+	}
+
+	if(bvh && !update_geometry &&
+	   !bvh->params.modified(bparams) &&
+	   object_traceable == bvh_object_traceable)
+	{
+		/* Instanced BVHs and primitives are all the same, only objects moved
+		 * or changed visibility, so the top level nodes are refit in place
+		 * instead of building and merging all BVHs again. */
+		progress.set_status("Updating Scene BVH", "Refitting");
+
+		VLOG(1) << "Refitting scene BVH for " << scene->objects.size() << " objects.";
+
+		bvh->objects = scene->objects;
+		bvh->refit_top_level(progress);
+	}
+	else {
+		/* bvh build */
+		progress.set_status("Updating Scene BVH", "Building");
+
+		VLOG(1) << (scene->params.use_bvh8 ? "Using OBVH optimization structure"
+		            : scene->params.use_qbvh ? "Using QBVH optimization structure"
+		                                     : "Using regular BVH optimization structure");
+
+		delete bvh;
+		bvh = BVH::create(bparams, scene->objects);
+		bvh->build(progress);
+
+		if(progress.get_cancel()) {
+			/* Never refit a partially built BVH. */
+			delete bvh;
+			bvh = NULL;
+			return;
+		}
+
+		bvh_object_traceable = object_traceable;
+	}
 
 	if(progress.get_cancel()) return;
 
@@ -1849,13 +1897,32 @@ void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *
 		dscene->object_node.reference((uint*)&pack.object_node[0], pack.object_node.size());
 		device->tex_alloc("__object_node", dscene->object_node);
 	}
-	if(pack.prim_tri_index.size()) {
-		dscene->prim_tri_index.reference((uint*)&pack.prim_tri_index[0], pack.prim_tri_index.size());
-		device->tex_alloc("__prim_tri_index", dscene->prim_tri_index);
+	if(scene->params.use_bvh_indexed_triangles) {
+		/* Triangles are looked up through their vertex indices, so only the
+		 * vertices of all meshes are copied, at their offset in __tri_vindex. */
+		size_t vert_size = 0;
+		foreach(Mesh *mesh, scene->meshes) {
+			vert_size = max(vert_size, mesh->vert_offset + mesh->verts.size());
+		}
+		if(vert_size) {
+			float4 *prim_tri_verts = dscene->prim_tri_verts.resize(vert_size);
+			foreach(Mesh *mesh, scene->meshes) {
+				for(size_t i = 0; i < mesh->verts.size(); i++) {
+					prim_tri_verts[mesh->vert_offset + i] = float3_to_float4(mesh->verts[i]);
+				}
+			}
+			device->tex_alloc("__prim_tri_verts", dscene->prim_tri_verts);
+		}
 	}
-	if(pack.prim_tri_verts.size()) {
-		dscene->prim_tri_verts.reference((float4*)&pack.prim_tri_verts[0], pack.prim_tri_verts.size());
-		device->tex_alloc("__prim_tri_verts", dscene->prim_tri_verts);
+	else {
+		if(pack.prim_tri_index.size()) {
+			dscene->prim_tri_index.reference((uint*)&pack.prim_tri_index[0], pack.prim_tri_index.size());
+			device->tex_alloc("__prim_tri_index", dscene->prim_tri_index);
+		}
+		if(pack.prim_tri_verts.size()) {
+			dscene->prim_tri_verts.reference((float4*)&pack.prim_tri_verts[0], pack.prim_tri_verts.size());
+			device->tex_alloc("__prim_tri_verts", dscene->prim_tri_verts);
+		}
 	}
 	if(pack.prim_type.size()) {
 		dscene->prim_type.reference((uint*)&pack.prim_type[0], pack.prim_type.size());
@@ -1880,7 +1947,21 @@ void MeshManager::device_update_bvh(Device *device, DeviceScene *dscene, Scene *
 
 	dscene->data.bvh.root = pack.root_index;
 	dscene->data.bvh.use_qbvh = scene->params.use_qbvh;
+	dscene->data.bvh.use_bvh8 = scene->params.use_bvh8;
 	dscene->data.bvh.use_bvh_steps = (scene->params.num_bvh_time_steps != 0);
+	/* Only QBVH nodes have a compressed layout. */
+	dscene->data.bvh.use_compressed_nodes = scene->params.use_qbvh &&
+	                                        !scene->params.use_bvh8 &&
+	                                        scene->params.use_bvh_compressed_nodes;
+	dscene->data.bvh.use_indexed_triangles = scene->params.use_bvh_indexed_triangles;
+
+	VLOG(1) << "Scene BVH memory: "
+	        << string_human_readable_size(dscene->bvh_nodes.memory_size()) << " nodes, "
+	        << string_human_readable_size(dscene->bvh_leaf_nodes.memory_size()) << " leaf nodes, "
+	        << string_human_readable_size(dscene->prim_tri_verts.memory_size() +
+	                                      dscene->prim_tri_index.memory_size())
+	        << " triangle vertices"
+	        << (scene->params.use_bvh_indexed_triangles ? " (indexed)." : ".");
 }
 
 void MeshManager::device_update_flags(Device * /*device*/,
@@ -2041,41 +2122,50 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 		                                           false);
 	}
 
-	/* Device update. */
-	device_free(device, dscene);
+	/* Device update. Only the BVH is updated when meshes and their
+	 * assignment to objects stayed the same, as for moving objects. */
+	bool update_geometry = need_update_geometry(scene);
 
-	mesh_calc_offset(scene);
-	if(true_displacement_used) {
-		device_update_mesh(device, dscene, scene, true, progress);
-	}
-	if(progress.get_cancel()) return;
+	if(update_geometry) {
+		device_free(device, dscene);
 
-	/* after mesh data has been copied to device memory we need to update
-	 * offsets for patch tables as this can't be known before hand */
-	scene->object_manager->device_update_patch_map_offsets(device, dscene, scene);
+		mesh_calc_offset(scene);
+		if(true_displacement_used) {
+			device_update_mesh(device, dscene, scene, true, progress);
+		}
+		if(progress.get_cancel()) return;
 
-	device_update_attributes(device, dscene, scene, progress);
-	if(progress.get_cancel()) return;
+		/* after mesh data has been copied to device memory we need to update
+		 * offsets for patch tables as this can't be known before hand */
+		scene->object_manager->device_update_patch_map_offsets(device, dscene, scene);
 
-	/* Update displacement. */
-	bool displacement_done = false;
-	foreach(Mesh *mesh, scene->meshes) {
-		if(mesh->need_update &&
-		   displace(device, dscene, scene, mesh, progress))
-		{
-			displacement_done = true;
+		device_update_attributes(device, dscene, scene, progress);
+		if(progress.get_cancel()) return;
+
+		/* Update displacement. */
+		bool displacement_done = false;
+		foreach(Mesh *mesh, scene->meshes) {
+			if(mesh->need_update &&
+			   displace(device, dscene, scene, mesh, progress))
+			{
+				displacement_done = true;
+			}
 		}
-	}
 
-	/* TODO: properly handle cancel halfway displacement */
-	if(progress.get_cancel()) return;
+		/* TODO: properly handle cancel halfway displacement */
+		if(progress.get_cancel()) return;
 
-	/* Device re-update after displacement. */
-	if(displacement_done) {
-		device_free(device, dscene);
+		/* Device re-update after displacement. */
+		if(displacement_done) {
+			device_free(device, dscene);
 
-		device_update_attributes(device, dscene, scene, progress);
-		if(progress.get_cancel()) return;
+			device_update_attributes(device, dscene, scene, progress);
+			if(progress.get_cancel()) return;
+		}
+	}
+	else {
+		VLOG(1) << "Meshes unchanged, only updating scene BVH.";
+		device_free_bvh(device, dscene);
 	}
 
 	/* Update bvh. */
@@ -2128,11 +2218,19 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 
 	if(progress.get_cancel()) return;
 
-	device_update_bvh(device, dscene, scene, progress);
+	device_update_bvh(device, dscene, scene, update_geometry, progress);
 	if(progress.get_cancel()) return;
 
-	device_update_mesh(device, dscene, scene, false, progress);
-	if(progress.get_cancel()) return;
+	if(update_geometry) {
+		device_update_mesh(device, dscene, scene, false, progress);
+		if(progress.get_cancel()) return;
+
+		packed_meshes = scene->meshes;
+		packed_object_meshes.clear();
+		foreach(Object *object, scene->objects) {
+			packed_object_meshes.push_back(object->mesh);
+		}
+	}
 
 	need_update = false;
 
@@ -2147,7 +2245,30 @@ void MeshManager::device_update(Device *device, DeviceScene *dscene, Scene *scen
 	}
 }
 
-void MeshManager::device_free(Device *device, DeviceScene *dscene)
+bool MeshManager::need_update_geometry(Scene *scene)
+{
+	if(scene->meshes != packed_meshes ||
+	   scene->objects.size() != packed_object_meshes.size())
+	{
+		return true;
+	}
+
+	for(size_t i = 0; i < scene->objects.size(); i++) {
+		if(scene->objects[i]->mesh != packed_object_meshes[i]) {
+			return true;
+		}
+	}
+
+	foreach(Mesh *mesh, scene->meshes) {
+		if(mesh->need_update) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void MeshManager::device_free_bvh(Device *device, DeviceScene *dscene)
 {
 	device->tex_free(dscene->bvh_nodes);
 	device->tex_free(dscene->bvh_leaf_nodes);
@@ -2159,6 +2280,23 @@ void MeshManager::device_free(Device *device, DeviceScene *dscene)
 	device->tex_free(dscene->prim_index);
 	device->tex_free(dscene->prim_object);
 	device->tex_free(dscene->prim_time);
+
+	dscene->bvh_nodes.clear();
+	dscene->bvh_leaf_nodes.clear();
+	dscene->object_node.clear();
+	dscene->prim_tri_verts.clear();
+	dscene->prim_tri_index.clear();
+	dscene->prim_type.clear();
+	dscene->prim_visibility.clear();
+	dscene->prim_index.clear();
+	dscene->prim_object.clear();
+	dscene->prim_time.clear();
+}
+
+void MeshManager::device_free(Device *device, DeviceScene *dscene)
+{
+	device_free_bvh(device, dscene);
+
 	device->tex_free(dscene->tri_shader);
 	device->tex_free(dscene->tri_vnormal);
 	device->tex_free(dscene->tri_vindex);
@@ -2172,15 +2310,6 @@ void MeshManager::device_free(Device *device, DeviceScene *dscene)
 	device->tex_free(dscene->attributes_float3);
 	device->tex_free(dscene->attributes_uchar4);
 
-	dscene->bvh_nodes.clear();
-	dscene->object_node.clear();
-	dscene->prim_tri_verts.clear();
-	dscene->prim_tri_index.clear();
-	dscene->prim_type.clear();
-	dscene->prim_visibility.clear();
-	dscene->prim_index.clear();
-	dscene->prim_object.clear();
-	dscene->prim_time.clear();
 	dscene->tri_shader.clear();
 	dscene->tri_vnormal.clear();
 	dscene->tri_vindex.clear();
@@ -2194,6 +2323,9 @@ void MeshManager::device_free(Device *device, DeviceScene *dscene)
 	dscene->attributes_float3.clear();
 	dscene->attributes_uchar4.clear();
 
+	packed_meshes.clear();
+	packed_object_meshes.clear();
+
 #ifdef WITH_OSL
 	OSLGlobals *og = (OSLGlobals*)device->osl_memory();
 
@@ -338,6 +338,17 @@ public:
 	void tag_update(Scene *scene);
 
 protected:
+	/* Meshes and object to mesh assignment the device arrays were packed for,
+	 * to only pack them again when these changed. */
+	vector<Mesh*> packed_meshes;
+	vector<Mesh*> packed_object_meshes;
+
+	/* Objects which were part of the top level BVH when it was built. */
+	vector<bool> bvh_object_traceable;
+
+	bool need_update_geometry(Scene *scene);
+	void device_free_bvh(Device *device, DeviceScene *dscene);
+
 	/* Calculate verts/triangles/curves offsets in global arrays. */
 	void mesh_calc_offset(Scene *scene);
 
@@ -360,6 +371,7 @@ protected:
 	void device_update_bvh(Device *device,
 	                       DeviceScene *dscene,
 	                       Scene *scene,
+	                       bool update_geometry,
 	                       Progress& progress);
 
 	void device_update_displacement_images(Device *device,
@@ -294,6 +294,35 @@ void ImageTextureNode::attributes(Shader *shader, AttributeRequestSet *attribute
 	ShaderNode::attributes(shader, attributes);
 }
 
+/* UV map the texture coordinates are read from without modification, so the
+ * kernel can derive the footprint of a lookup from its differentials. */
+static uint image_texture_uv_attribute(SVMCompiler& compiler,
+                                       ShaderInput *vector_in,
+                                       TextureMapping& tex_mapping)
+{
+	if(!tex_mapping.skip() || vector_in->link == NULL) {
+		return ATTR_STD_NONE;
+	}
+
+	ShaderNode *node = vector_in->link->parent;
+
+	if(node->type == TextureCoordinateNode::node_type) {
+		TextureCoordinateNode *texco = (TextureCoordinateNode*)node;
+		if(vector_in->link == texco->output("UV") && !texco->from_dupli) {
+			return compiler.attribute(ATTR_STD_UV);
+		}
+	}
+	else if(node->type == UVMapNode::node_type) {
+		UVMapNode *uvmap = (UVMapNode*)node;
+		if(!uvmap->from_dupli) {
+			return (uvmap->attribute != "")? compiler.attribute(uvmap->attribute):
+			                                 compiler.attribute(ATTR_STD_UV);
+		}
+	}
+
+	return ATTR_STD_NONE;
+}
+
 void ImageTextureNode::compile(SVMCompiler& compiler)
 {
 	ShaderInput *vector_in = input("Vector");
@@ -317,6 +346,8 @@ void ImageTextureNode::compile(SVMCompiler& compiler)
 
 	if(slot != -1) {
 		int srgb = (is_linear || color_space != NODE_COLOR_SPACE_COLOR)? 0: 1;
+		uint uv_attribute = (projection == NODE_IMAGE_PROJ_FLAT)?
+		        image_texture_uv_attribute(compiler, vector_in, tex_mapping): ATTR_STD_NONE;
 		int vector_offset = tex_mapping.compile_begin(compiler, vector_in);
 
 		if(projection != NODE_IMAGE_PROJ_BOX) {
@@ -327,7 +358,7 @@ void ImageTextureNode::compile(SVMCompiler& compiler)
 					compiler.stack_assign_if_linked(color_out),
 					compiler.stack_assign_if_linked(alpha_out),
 					srgb),
-				projection);
+				projection | (uv_attribute << 8));
 		}
 		else {
 			compiler.add_node(NODE_TEX_IMAGE_BOX,
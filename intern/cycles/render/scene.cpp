@@ -73,6 +73,15 @@ Scene::~Scene()
 
 void Scene::free_memory(bool final)
 {
+	/* With persistent data the scene is kept for the next frame, and synced
+	 * again for changes. Builtin images may change between frames and are
+	 * the only data reloaded. */
+	if(params.persistent_data && !final) {
+		if(device)
+			image_manager->device_free_builtin(device, &dscene);
+		return;
+	}
+
 	foreach(Shader *s, shaders)
 		delete s;
 	foreach(Mesh *m, meshes)
@@ -106,10 +115,7 @@ void Scene::free_memory(bool final)
 
 		bake_manager->device_free(device, &dscene);
 
-		if(!params.persistent_data || final)
-			image_manager->device_free(device, &dscene);
-		else
-			image_manager->device_free_builtin(device, &dscene);
+		image_manager->device_free(device, &dscene);
 
 		lookup_tables->device_free(device, &dscene);
 	}
@@ -96,6 +96,7 @@ public:
 	/* lights */
 	device_vector<float4> light_distribution;
 	device_vector<float4> light_data;
+	device_vector<float4> light_tree_nodes;
 	device_vector<float2> light_background_marginal_cdf;
 	device_vector<float2> light_background_conditional_cdf;
 
@@ -146,8 +147,14 @@ public:
 	bool use_bvh_unaligned_nodes;
 	int num_bvh_time_steps;
 	bool use_qbvh;
+	bool use_bvh8;
+	bool use_bvh_compressed_nodes;
+	bool use_bvh_indexed_triangles;
 	bool persistent_data;
 	int texture_limit;
+	bool use_texture_cache;
+	int texture_cache_size;
+	bool texture_auto_convert;
 
 	SceneParams()
 	{
@@ -157,8 +164,14 @@ public:
 		use_bvh_unaligned_nodes = true;
 		num_bvh_time_steps = 0;
 		use_qbvh = false;
+		use_bvh8 = false;
+		use_bvh_compressed_nodes = false;
+		use_bvh_indexed_triangles = false;
 		persistent_data = false;
 		texture_limit = 0;
+		use_texture_cache = false;
+		texture_cache_size = 1024;
+		texture_auto_convert = false;
 	}
 
 	bool modified(const SceneParams& params)
@@ -168,8 +181,14 @@ public:
 		&& use_bvh_unaligned_nodes == params.use_bvh_unaligned_nodes
 		&& num_bvh_time_steps == params.num_bvh_time_steps
 		&& use_qbvh == params.use_qbvh
+		&& use_bvh8 == params.use_bvh8
+		&& use_bvh_compressed_nodes == params.use_bvh_compressed_nodes
+		&& use_bvh_indexed_triangles == params.use_bvh_indexed_triangles
 		&& persistent_data == params.persistent_data
-		&& texture_limit == params.texture_limit); }
+		&& texture_limit == params.texture_limit
+		&& use_texture_cache == params.use_texture_cache
+		&& texture_cache_size == params.texture_cache_size
+		&& texture_auto_convert == params.texture_auto_convert); }
 };
 
 /* Scene */
@@ -0,0 +1,236 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "bvh/bvh_build.h"
+#include "bvh/bvh_node.h"
+#include "bvh/bvh_params.h"
+
+#include "render/mesh.h"
+#include "render/object.h"
+
+#include "util/util_progress.h"
+#include "util/util_task.h"
+#include "util/util_time.h"
+#include "util/util_vector.h"
+
+/* Run the build time benchmark (slow, prints timings). */
+//#define BVH_BUILD_RUN_BIG
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+/* Wavy grid of res*res quads, large enough for the top levels of the build to
+ * be binned and partitioned by multiple threads. */
+Mesh *create_grid_mesh(int res)
+{
+	Mesh *mesh = new Mesh();
+	mesh->reserve_mesh((res + 1)*(res + 1), res*res*2);
+
+	for(int y = 0; y <= res; y++) {
+		for(int x = 0; x <= res; x++) {
+			float u = (float)x/res, v = (float)y/res;
+			mesh->add_vertex(make_float3(u, v, 0.05f*sinf(20.0f*u)*cosf(13.0f*v)));
+		}
+	}
+
+	for(int y = 0; y < res; y++) {
+		for(int x = 0; x < res; x++) {
+			int v0 = y*(res + 1) + x;
+			int v1 = v0 + 1;
+			int v2 = v0 + res + 1;
+			int v3 = v2 + 1;
+			mesh->add_triangle(v0, v1, v3, 0, false);
+			mesh->add_triangle(v0, v3, v2, 0, false);
+		}
+	}
+
+	mesh->compute_bounds();
+	return mesh;
+}
+
+/* Tree flattened in depth first order, independent of where the builder
+ * stored the primitives of each leaf. */
+struct BuildResult {
+	vector<BoundBox> node_bounds;
+	vector<int> leaf_prims;
+	array<int> prim_index;
+	double build_time;
+};
+
+void flatten_node(const BVHNode *node, BuildResult *result)
+{
+	result->node_bounds.push_back(node->bounds);
+
+	if(node->is_leaf()) {
+		const LeafNode *leaf = (const LeafNode*)node;
+		for(int i = leaf->lo; i < leaf->hi; i++) {
+			result->leaf_prims.push_back(result->prim_index[i]);
+		}
+		return;
+	}
+
+	for(int i = 0; i < node->num_children(); i++) {
+		flatten_node(node->get_child(i), result);
+	}
+}
+
+void build_bvh(Object *object, bool use_spatial_split, int num_threads, BuildResult *result)
+{
+	TaskScheduler::init(num_threads);
+
+	vector<Object*> objects;
+	objects.push_back(object);
+
+	array<int> prim_type, prim_object;
+	array<float2> prim_time;
+	BVHParams params;
+	params.use_spatial_split = use_spatial_split;
+	Progress progress;
+
+	BVHBuild build(objects,
+	               prim_type,
+	               result->prim_index,
+	               prim_object,
+	               prim_time,
+	               params,
+	               progress);
+
+	BVHNode *root;
+	{
+		scoped_timer timer(&result->build_time);
+		root = build.run();
+	}
+	ASSERT_TRUE(root != NULL);
+	flatten_node(root, result);
+	root->deleteSubtree();
+
+	TaskScheduler::exit();
+}
+
+void expect_bounds_eq(const BoundBox& a, const BoundBox& b)
+{
+	for(int i = 0; i < 3; i++) {
+		EXPECT_FLOAT_EQ(a.min[i], b.min[i]);
+		EXPECT_FLOAT_EQ(a.max[i], b.max[i]);
+	}
+}
+
+void test_build(bool use_spatial_split)
+{
+	const int res = 384;
+	Mesh *mesh = create_grid_mesh(res);
+	Object *object = new Object();
+	object->mesh = mesh;
+	object->bounds = mesh->bounds;
+
+	/* Block sizes do not depend on the number of threads, so the tree must be
+	 * the same whether it is built by one or by all threads. */
+	BuildResult serial, parallel;
+	build_bvh(object, use_spatial_split, 1, &serial);
+	build_bvh(object, use_spatial_split, 0, &parallel);
+
+	ASSERT_FALSE(parallel.node_bounds.empty());
+	expect_bounds_eq(mesh->bounds, parallel.node_bounds[0]);
+
+	ASSERT_EQ(serial.node_bounds.size(), parallel.node_bounds.size());
+	for(size_t i = 0; i < serial.node_bounds.size(); i++) {
+		expect_bounds_eq(serial.node_bounds[i], parallel.node_bounds[i]);
+	}
+
+	ASSERT_EQ(serial.leaf_prims.size(), parallel.leaf_prims.size());
+	for(size_t i = 0; i < serial.leaf_prims.size(); i++) {
+		EXPECT_EQ(serial.leaf_prims[i], parallel.leaf_prims[i]);
+	}
+
+	/* Without spatial splits leaves are stored in place, so the primitive
+	 * arrays match as well. */
+	ASSERT_EQ(serial.prim_index.size(), parallel.prim_index.size());
+	if(!use_spatial_split) {
+		for(size_t i = 0; i < serial.prim_index.size(); i++) {
+			EXPECT_EQ(serial.prim_index[i], parallel.prim_index[i]);
+		}
+	}
+
+	/* Every triangle is referenced, and only once unless it was split. */
+	vector<int> num_references(mesh->num_triangles(), 0);
+	for(size_t i = 0; i < parallel.prim_index.size(); i++) {
+		num_references[parallel.prim_index[i]]++;
+	}
+	for(size_t i = 0; i < num_references.size(); i++) {
+		if(use_spatial_split) {
+			EXPECT_GE(num_references[i], 1);
+		}
+		else {
+			EXPECT_EQ(num_references[i], 1);
+		}
+	}
+
+	delete object;
+	delete mesh;
+}
+
+#ifdef BVH_BUILD_RUN_BIG
+void benchmark_build(bool use_spatial_split)
+{
+	/* 8 million triangles. */
+	const int res = 2048;
+	Mesh *mesh = create_grid_mesh(res);
+	Object *object = new Object();
+	object->mesh = mesh;
+	object->bounds = mesh->bounds;
+
+	BuildResult serial, parallel;
+	build_bvh(object, use_spatial_split, 1, &serial);
+	build_bvh(object, use_spatial_split, 0, &parallel);
+
+	printf("BVH build of %d triangles%s: %f s on 1 thread, %f s on all threads (%.2fx)\n",
+	       (int)mesh->num_triangles(),
+	       use_spatial_split ? " with spatial splits" : "",
+	       serial.build_time,
+	       parallel.build_time,
+	       serial.build_time / parallel.build_time);
+
+	EXPECT_EQ(serial.node_bounds.size(), parallel.node_bounds.size());
+
+	delete object;
+	delete mesh;
+}
+#endif
+
+}  // namespace
+
+TEST(bvh_build, binning) {
+	test_build(false);
+}
+
+TEST(bvh_build, spatial_split) {
+	test_build(true);
+}
+
+#ifdef BVH_BUILD_RUN_BIG
+TEST(bvh_build, benchmark_binning) {
+	benchmark_build(false);
+}
+
+TEST(bvh_build, benchmark_spatial_split) {
+	benchmark_build(true);
+}
+#endif
+
+CCL_NAMESPACE_END
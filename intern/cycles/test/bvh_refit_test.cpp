@@ -0,0 +1,137 @@
+/*
+ * Copyright 2011-2017 Blender Foundation
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "testing/testing.h"
+
+#include "bvh/bvh.h"
+#include "bvh/bvh_params.h"
+
+#include "render/mesh.h"
+#include "render/object.h"
+
+#include "util/util_progress.h"
+#include "util/util_task.h"
+#include "util/util_vector.h"
+
+CCL_NAMESPACE_BEGIN
+
+namespace {
+
+Mesh *create_triangle_mesh()
+{
+	Mesh *mesh = new Mesh();
+	mesh->reserve_mesh(3, 1);
+	mesh->add_vertex(make_float3(0.0f, 0.0f, 0.0f));
+	mesh->add_vertex(make_float3(1.0f, 0.0f, 0.0f));
+	mesh->add_vertex(make_float3(0.0f, 1.0f, 0.0f));
+	mesh->add_triangle(0, 1, 2, 0, false);
+	mesh->compute_bounds();
+	return mesh;
+}
+
+/* Bounds of the root node of the top level, from the bounds of its children. */
+BoundBox root_bounds(const BVH *bvh, bool use_qbvh)
+{
+	const float4 *data = (const float4*)&bvh->pack.nodes[0];
+	BoundBox bounds = BoundBox::empty;
+
+	if(use_qbvh) {
+		for(int i = 0; i < 4; i++) {
+			if(data[1][i] <= data[2][i]) {
+				bounds.grow(make_float3(data[1][i], data[3][i], data[5][i]));
+				bounds.grow(make_float3(data[2][i], data[4][i], data[6][i]));
+			}
+		}
+	}
+	else {
+		for(int i = 0; i < 2; i++) {
+			bounds.grow(make_float3(data[1][i], data[2][i], data[3][i]));
+			bounds.grow(make_float3(data[1][i + 2], data[2][i + 2], data[3][i + 2]));
+		}
+	}
+
+	return bounds;
+}
+
+void expect_bounds_eq(const BoundBox& a, const BoundBox& b)
+{
+	for(int i = 0; i < 3; i++) {
+		EXPECT_FLOAT_EQ(a.min[i], b.min[i]);
+		EXPECT_FLOAT_EQ(a.max[i], b.max[i]);
+	}
+}
+
+void test_refit_instances(bool use_qbvh)
+{
+	TaskScheduler::init(0);
+	Progress progress;
+
+	/* Two instances of the same mesh, each in a leaf of its own. */
+	Mesh *mesh = create_triangle_mesh();
+	Object *object_a = new Object();
+	Object *object_b = new Object();
+	object_a->mesh = object_b->mesh = mesh;
+	object_a->bounds = BoundBox(make_float3(0.0f, 0.0f, 0.0f), make_float3(1.0f, 1.0f, 0.0f));
+	object_b->bounds = BoundBox(make_float3(2.0f, 0.0f, 0.0f), make_float3(3.0f, 1.0f, 0.0f));
+
+	vector<Object*> objects;
+	objects.push_back(object_a);
+	objects.push_back(object_b);
+
+	BVHParams params;
+	params.use_qbvh = use_qbvh;
+	params.use_spatial_split = false;
+
+	vector<Object*> mesh_objects;
+	mesh_objects.push_back(object_a);
+	mesh->bvh = BVH::create(params, mesh_objects);
+	mesh->bvh->build(progress);
+
+	params.top_level = true;
+	BVH *bvh = BVH::create(params, objects);
+	bvh->build(progress);
+
+	BoundBox bounds = object_a->bounds;
+	bounds.grow(object_b->bounds);
+	expect_bounds_eq(bounds, root_bounds(bvh, use_qbvh));
+
+	/* Move one instance, the root must bound its new position only. */
+	object_b->bounds = BoundBox(make_float3(-4.0f, 2.0f, 1.0f), make_float3(-3.0f, 3.0f, 1.0f));
+	bvh->refit_top_level(progress);
+
+	bounds = object_a->bounds;
+	bounds.grow(object_b->bounds);
+	expect_bounds_eq(bounds, root_bounds(bvh, use_qbvh));
+
+	delete bvh;
+	delete object_a;
+	delete object_b;
+	delete mesh;
+
+	TaskScheduler::exit();
+}
+
+}  // namespace
+
+TEST(bvh_refit, instances_bvh2) {
+	test_refit_instances(false);
+}
+
+TEST(bvh_refit, instances_bvh4) {
+	test_refit_instances(true);
+}
+
+CCL_NAMESPACE_END
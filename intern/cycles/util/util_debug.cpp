@@ -30,7 +30,8 @@ DebugFlags::CPU::CPU()
     sse3(true),
     sse2(true),
     qbvh(true),
-    split_kernel(false)
+    split_kernel(false),
+    ray_stream(false)
 {
 	reset();
 }
@@ -57,6 +58,7 @@ void DebugFlags::CPU::reset()
 
 	qbvh = true;
 	split_kernel = false;
+	ray_stream = false;
 }
 
 DebugFlags::CUDA::CUDA()
@@ -142,7 +144,8 @@ std::ostream& operator <<(std::ostream &os,
 	   << "  SSE3   : " << string_from_bool(debug_flags.cpu.sse3)  << "\n"
 	   << "  SSE2   : " << string_from_bool(debug_flags.cpu.sse2)  << "\n"
 	   << "  QBVH   : " << string_from_bool(debug_flags.cpu.qbvh)  << "\n"
-	   << "  Split  : " << string_from_bool(debug_flags.cpu.split_kernel) << "\n";
+	   << "  Split  : " << string_from_bool(debug_flags.cpu.split_kernel) << "\n"
+	   << "  Stream : " << string_from_bool(debug_flags.cpu.ray_stream) << "\n";
 
 	os << "CUDA flags:\n"
 	   << " Adaptive Compile: " << string_from_bool(debug_flags.cuda.adaptive_compile) << "\n";
@@ -49,6 +49,9 @@ public:
 
 		/* Whether split kernel is used */
 		bool split_kernel;
+
+		/* Whether the split kernel intersects coherent rays as streams. */
+		bool ray_stream;
 	};
 
 	/* Descriptor of CUDA feature-set to be used. */
@@ -44,6 +44,7 @@ extern "C" {
 #include "DNA_space_types.h"  /* for FILE_MAX */
 
 #include "BLI_string.h"
+#include "BLI_task.h"
 
 #ifdef WIN32
 /* needed for MSCV because of snprintf from BLI_string */
@@ -108,6 +109,59 @@ static bool object_is_smoke_sim(Object *ob)
 	return false;
 }
 
+static void find_other_object_cb(void *userData, Object *ob, Object **obpoin, int /*cb_flag*/)
+{
+	bool *r_found = static_cast<bool *>(userData);
+
+	if (*obpoin != NULL && *obpoin != ob) {
+		*r_found = true;
+	}
+}
+
+/* Whether export data of the object can be evaluated from a worker thread,
+ * concurrently with other objects.
+ *
+ * Simulation modifiers store their state in the modifier itself, and are
+ * relying on evaluation happening in the frame order, so objects which uses
+ * them are always evaluated from the main thread.
+ *
+ * Modifiers referencing other objects (Boolean, Shrinkwrap, Array caps,
+ * Mesh Deform...) read or build the derived mesh of those objects, which
+ * might be evaluated by another thread at the same time, so such objects
+ * are evaluated from the main thread as well.
+ */
+static bool object_data_is_threadsafe(Object *ob)
+{
+	bool has_other_object = false;
+
+	modifiers_foreachObjectLink(ob, find_other_object_cb, &has_other_object);
+
+	if (has_other_object) {
+		return false;
+	}
+
+	for (ModifierData *md = static_cast<ModifierData *>(ob->modifiers.first); md; md = md->next) {
+		switch (md->type) {
+			case eModifierType_Softbody:
+			case eModifierType_ParticleSystem:
+			case eModifierType_ParticleInstance:
+			case eModifierType_Explode:
+			case eModifierType_Cloth:
+			case eModifierType_Collision:
+			case eModifierType_Fluidsim:
+			case eModifierType_Surface:
+			case eModifierType_Smoke:
+			case eModifierType_Ocean:
+			case eModifierType_DynamicPaint:
+				return false;
+			default:
+				break;
+		}
+	}
+
+	return true;
+}
+
 static bool object_type_is_exportable(Object *ob)
 {
 	switch (ob->type) {
@@ -290,6 +344,7 @@ void AbcExporter::operator()(Main *bmain, float &progress, bool &was_canceled)
 
 	createTransformWritersHierarchy(bmain->eval_ctx);
 	createShapeWriters(bmain->eval_ctx);
+	collectThreadedShapeWriters();
 
 	/* Make a list of frames to export. */
 
@@ -325,6 +380,8 @@ void AbcExporter::operator()(Main *bmain, float &progress, bool &was_canceled)
 		setCurrentFrame(bmain, frame);
 
 		if (shape_frames.count(frame) != 0) {
+			prepareShapes();
+
 			for (int i = 0, e = m_shapes.size(); i != e; ++i) {
 				m_shapes[i]->write();
 			}
@@ -522,6 +579,54 @@ void AbcExporter::exploreObject(EvaluationContext *eval_ctx, Object *ob, Object
 	free_object_duplilist(lb);
 }
 
+void AbcExporter::collectThreadedShapeWriters()
+{
+	/* Objects instanced several times are exported by several writers, those
+	 * are evaluating the same object, so they are kept on the main thread.
+	 * The same goes for objects sharing their data, evaluating them writes
+	 * to the shared data (tessellation, normals). */
+	std::map<Object *, int> users;
+	std::map<void *, int> data_users;
+	std::vector<std::pair<Object *, AbcObjectWriter *> >::const_iterator it;
+
+	for (it = m_mesh_writers.begin(); it != m_mesh_writers.end(); ++it) {
+		++users[it->first];
+		++data_users[it->first->data];
+	}
+
+	m_threaded_shapes.clear();
+
+	for (it = m_mesh_writers.begin(); it != m_mesh_writers.end(); ++it) {
+		if (users[it->first] == 1 && data_users[it->first->data] == 1 &&
+		    object_data_is_threadsafe(it->first))
+		{
+			m_threaded_shapes.push_back(it->second);
+		}
+	}
+}
+
+static void prepare_shape_cb(void *userdata, const int index)
+{
+	std::vector<AbcObjectWriter *> *shapes = static_cast<std::vector<AbcObjectWriter *> *>(userdata);
+	(*shapes)[index]->prepare();
+}
+
+/* Evaluate data of the shapes for the current frame.
+ *
+ * Frames themselves are evaluated one after another, since scene evaluation
+ * is happening in-place, but meshes of different objects are independent
+ * from each other, so their final (render) modifier stacks are evaluated in
+ * parallel before the archive is written from the main thread. */
+void AbcExporter::prepareShapes()
+{
+	const int num_shapes = m_threaded_shapes.size();
+
+	BLI_task_parallel_range(0, num_shapes,
+	                        &m_threaded_shapes,
+	                        prepare_shape_cb,
+	                        num_shapes > 1);
+}
+
 void AbcExporter::createParticleSystemsWriters(Object *ob, AbcTransformWriter *xform)
 {
 	if (!m_settings.export_hair && !m_settings.export_particles) {
@@ -578,7 +683,9 @@ void AbcExporter::createShapeWriter(Object *ob, Object *dupliObParent)
 				return;
 			}
 
-			m_shapes.push_back(new AbcMeshWriter(m_scene, ob, xform, m_shape_sampling_index, m_settings));
+			AbcMeshWriter *writer = new AbcMeshWriter(m_scene, ob, xform, m_shape_sampling_index, m_settings);
+			m_shapes.push_back(writer);
+			m_mesh_writers.push_back(std::make_pair(ob, writer));
 			break;
 		}
 		case OB_SURF:
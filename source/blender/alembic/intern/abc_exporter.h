@@ -97,6 +97,12 @@ class AbcExporter {
 
 	std::vector<AbcObjectWriter *> m_shapes;
 
+	/* Mesh shape writers along with the object they are exporting. */
+	std::vector<std::pair<Object *, AbcObjectWriter *> > m_mesh_writers;
+
+	/* Shape writers which data can be evaluated from worker threads. */
+	std::vector<AbcObjectWriter *> m_threaded_shapes;
+
 public:
 	AbcExporter(Scene *scene, const char *filename, ExportSettings &settings);
 	~AbcExporter();
@@ -119,6 +125,8 @@ private:
 	void createShapeWriters(EvaluationContext *eval_ctx);
 	void createShapeWriter(Object *ob, Object *dupliObParent);
 	void createParticleSystemsWriters(Object *ob, AbcTransformWriter *xform);
+	void collectThreadedShapeWriters();
+	void prepareShapes();
 
 	AbcTransformWriter *getXForm(const std::string &name);
 
@@ -49,6 +49,9 @@ class AbcMeshWriter : public AbcObjectWriter {
 	bool m_is_liquid;
 	bool m_is_subd;
 
+	/* Mesh evaluated by prepare(), consumed by the next write(). */
+	DerivedMesh *m_prepared_dm;
+
 public:
 	AbcMeshWriter(Scene *scene,
 	              Object *ob,
@@ -58,6 +61,8 @@ public:
 
 	~AbcMeshWriter();
 
+	virtual void prepare();
+
 private:
 	virtual void do_write();
 
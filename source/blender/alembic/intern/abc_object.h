@@ -68,6 +68,13 @@ public:
 
 	virtual Imath::Box3d bounds();
 
+	/* Evaluate data which is to be written for the current frame.
+	 *
+	 * Is called before write(), possibly from a worker thread concurrently
+	 * with other writers, so it must not access the archive.
+	 */
+	virtual void prepare() {}
+
 	void write();
 
 private:
@@ -740,6 +740,10 @@ void makeDerivedMesh(
         struct Scene *scene, struct Object *ob, struct BMEditMesh *em,
         CustomDataMask dataMask, const bool build_shapekey_layers);
 
+/* cached result of the leading modifiers of the stack, see mesh_calc_modifiers() */
+void DM_modifier_prefix_cache_free(struct Object *ob);
+void DM_modifier_prefix_cache_exit(void);
+
 void weight_to_rgb(float r_rgb[3], const float weight);
 /** Update the weight MCOL preview layer.
  * If weights are NULL, use object's active vgroup(s).
@@ -142,6 +142,8 @@ bool BKE_constraints_proxylocked_owner(struct Object *ob, struct bPoseChannel *p
 /* Constraint Evaluation function prototypes */
 struct bConstraintOb *BKE_constraints_make_evalob(struct Scene *scene, struct Object *ob, void *subdata, short datatype);
 void                  BKE_constraints_clear_evalob(struct bConstraintOb *cob);
+void BKE_constraints_evalob_init(struct bConstraintOb *cob, struct Scene *scene, struct Object *ob, void *subdata, short datatype);
+void BKE_constraints_evalob_apply(struct bConstraintOb *cob);
 
 void BKE_constraint_mat_convertspace(
         struct Object *ob, struct bPoseChannel *pchan, float mat[4][4], short from, short to, const bool keep_scale);
@@ -1248,6 +1248,12 @@ int ccgSubSurf_getSimpleSubdiv(const CCGSubSurf *ss)
 	return ss->meshIFC.simpleSubdiv;
 }
 
+/* False when elements are allocated from an arena, which never gives back memory of freed elements. */
+int ccgSubSurf_getUseStandardAllocator(const CCGSubSurf *ss)
+{
+	return ss->allocatorIFC.alloc == ccg_getStandardAllocatorIFC()->alloc;
+}
+
 /* Vert accessors */
 
 CCGVertHDL ccgSubSurf_getVertVertHandle(CCGVert *v)
@@ -30,6 +30,7 @@
 #include "BLI_utildefines.h" /* for BLI_assert */
 #include "BLI_listbase.h"
 #include "BLI_math.h"
+#include "BLI_task.h"
 #include "BLI_threads.h"
 
 #include "CCGSubSurf.h"
@@ -475,12 +476,35 @@ static bool opensubdiv_ensureEvaluator(CCGSubSurf *ss)
 	return ss->osd_evaluator != NULL;
 }
 
+typedef struct CCGSubSurfOSDCoarsePositionsData {
+	CCGSubSurf *ss;
+	float (*positions)[3];
+} CCGSubSurfOSDCoarsePositionsData;
+
+static void opensubdiv_updateEvaluatorCoarsePositions_cb(void *userdata, int i)
+{
+	CCGSubSurfOSDCoarsePositionsData *data = userdata;
+	CCGSubSurf *ss = data->ss;
+	float (*positions)[3] = data->positions;
+	int vertDataSize = ss->meshIFC.vertDataSize;
+	CCGVert *v = (CCGVert *) ss->vMap->buckets[i];
+
+	for (; v; v = v->next) {
+		float *co = VERT_getCo(v, 0);
+		BLI_assert(v->osd_index < ss->vMap->numEntries);
+		VertDataCopy(positions[v->osd_index], co, ss);
+		OSD_LOG("Point %d has value %f %f %f\n",
+		        v->osd_index,
+		        positions[v->osd_index][0],
+		        positions[v->osd_index][1],
+		        positions[v->osd_index][2]);
+	}
+}
+
 static void opensubdiv_updateEvaluatorCoarsePositions(CCGSubSurf *ss)
 {
 	float (*positions)[3];
-	int vertDataSize = ss->meshIFC.vertDataSize;
 	int num_basis_verts = ss->vMap->numEntries;
-	int i;
 
 	/* TODO(sergey): Avoid allocation on every update. We could either update
 	 * coordinates in chunks of 1K vertices (which will only use stack memory)
@@ -499,20 +523,11 @@ static void opensubdiv_updateEvaluatorCoarsePositions(CCGSubSurf *ss)
 		positions = MEM_callocN(3 * sizeof(float) * num_basis_verts,
 		                        "OpenSubdiv coarse points");
 	}
-#pragma omp parallel for
-	for (i = 0; i < ss->vMap->curSize; i++) {
-		CCGVert *v = (CCGVert *) ss->vMap->buckets[i];
-		for (; v; v = v->next) {
-			float *co = VERT_getCo(v, 0);
-			BLI_assert(v->osd_index < ss->vMap->numEntries);
-			VertDataCopy(positions[v->osd_index], co, ss);
-			OSD_LOG("Point %d has value %f %f %f\n",
-			        v->osd_index,
-			        positions[v->osd_index][0],
-			        positions[v->osd_index][1],
-			        positions[v->osd_index][2]);
-		}
-	}
+	CCGSubSurfOSDCoarsePositionsData data = {
+		.ss = ss,
+		.positions = positions,
+	};
+	BLI_task_parallel_range(0, ss->vMap->curSize, &data, opensubdiv_updateEvaluatorCoarsePositions_cb, true);
 
 	openSubdiv_setEvaluatorCoarsePositions(ss->osd_evaluator,
 	                                       (float *)positions,
@@ -522,120 +537,198 @@ static void opensubdiv_updateEvaluatorCoarsePositions(CCGSubSurf *ss)
 	MEM_freeN(positions);
 }
 
-static void opensubdiv_evaluateQuadFaceGrids(CCGSubSurf *ss,
-                                             CCGFace *face,
-                                             const int osd_face_index)
+typedef struct CCGSubSurfOSDFaceGridsData {
+	CCGSubSurf *ss;
+	CCGFace *face;
+	int osd_face_index;
+} CCGSubSurfOSDFaceGridsData;
+
+static void opensubdiv_evaluateQuadFaceGrids_cb(void *userdata, int S)
 {
+	CCGSubSurfOSDFaceGridsData *data = userdata;
+	CCGSubSurf *ss = data->ss;
+	CCGFace *face = data->face;
+	const int osd_face_index = data->osd_face_index;
 	int normalDataOffset = ss->normalDataOffset;
 	int subdivLevels = ss->subdivLevels;
 	int gridSize = ccg_gridsize(subdivLevels);
 	int edgeSize = ccg_edgesize(subdivLevels);
 	int vertDataSize = ss->meshIFC.vertDataSize;
-	int S;
 	bool do_normals = ss->meshIFC.numLayers == 3;
+	int x, y, k;
+	CCGEdge *edge = NULL;
+	bool inverse_edge;
+
+	for (x = 0; x < gridSize; x++) {
+		for (y = 0; y < gridSize; y++) {
+			float *co = FACE_getIFCo(face, subdivLevels, S, x, y);
+			float *no = FACE_getIFNo(face, subdivLevels, S, x, y);
+			float grid_u = (float) x / (gridSize - 1),
+			      grid_v = (float) y / (gridSize - 1);
+			float face_u, face_v;
+			float P[3], dPdu[3], dPdv[3];
 
-#pragma omp parallel for
-	for (S = 0; S < face->numVerts; S++) {
-		int x, y, k;
-		CCGEdge *edge = NULL;
-		bool inverse_edge;
-
-		for (x = 0; x < gridSize; x++) {
-			for (y = 0; y < gridSize; y++) {
-				float *co = FACE_getIFCo(face, subdivLevels, S, x, y);
-				float *no = FACE_getIFNo(face, subdivLevels, S, x, y);
-				float grid_u = (float) x / (gridSize - 1),
-				      grid_v = (float) y / (gridSize - 1);
-				float face_u, face_v;
-				float P[3], dPdu[3], dPdv[3];
-
-				ccgSubSurf__mapGridToFace(S, grid_u, grid_v, &face_u, &face_v);
-
-				/* TODO(sergey): Need proper port. */
-				openSubdiv_evaluateLimit(ss->osd_evaluator, osd_face_index,
-				                         face_u, face_v,
-				                         P,
-				                         do_normals ? dPdu : NULL,
-				                         do_normals ? dPdv : NULL);
-
-				OSD_LOG("face=%d, corner=%d, grid_u=%f, grid_v=%f, face_u=%f, face_v=%f, P=(%f, %f, %f)\n",
-				        osd_face_index, S, grid_u, grid_v, face_u, face_v, P[0], P[1], P[2]);
-
-				VertDataCopy(co, P, ss);
-				if (do_normals) {
-					cross_v3_v3v3(no, dPdu, dPdv);
-					normalize_v3(no);
-				}
+			ccgSubSurf__mapGridToFace(S, grid_u, grid_v, &face_u, &face_v);
+
+			/* TODO(sergey): Need proper port. */
+			openSubdiv_evaluateLimit(ss->osd_evaluator, osd_face_index,
+			                         face_u, face_v,
+			                         P,
+			                         do_normals ? dPdu : NULL,
+			                         do_normals ? dPdv : NULL);
 
-				if (x == gridSize - 1 && y == gridSize - 1) {
-					float *vert_co = VERT_getCo(FACE_getVerts(face)[S], subdivLevels);
-					VertDataCopy(vert_co, co, ss);
-					if (do_normals) {
-						float *vert_no = VERT_getNo(FACE_getVerts(face)[S], subdivLevels);
-						VertDataCopy(vert_no, no, ss);
-					}
+			OSD_LOG("face=%d, corner=%d, grid_u=%f, grid_v=%f, face_u=%f, face_v=%f, P=(%f, %f, %f)\n",
+			        osd_face_index, S, grid_u, grid_v, face_u, face_v, P[0], P[1], P[2]);
+
+			VertDataCopy(co, P, ss);
+			if (do_normals) {
+				cross_v3_v3v3(no, dPdu, dPdv);
+				normalize_v3(no);
+			}
+
+			if (x == gridSize - 1 && y == gridSize - 1) {
+				float *vert_co = VERT_getCo(FACE_getVerts(face)[S], subdivLevels);
+				VertDataCopy(vert_co, co, ss);
+				if (do_normals) {
+					float *vert_no = VERT_getNo(FACE_getVerts(face)[S], subdivLevels);
+					VertDataCopy(vert_no, no, ss);
 				}
-				if (S == 0 && x == 0 && y == 0) {
-					float *center_co = (float *)FACE_getCenterData(face);
-					VertDataCopy(center_co, co, ss);
-					if (do_normals) {
-						float *center_no = (float *)((byte *)FACE_getCenterData(face) + normalDataOffset);
-						VertDataCopy(center_no, no, ss);
-					}
+			}
+			if (S == 0 && x == 0 && y == 0) {
+				float *center_co = (float *)FACE_getCenterData(face);
+				VertDataCopy(center_co, co, ss);
+				if (do_normals) {
+					float *center_no = (float *)((byte *)FACE_getCenterData(face) + normalDataOffset);
+					VertDataCopy(center_no, no, ss);
 				}
 			}
 		}
+	}
 
-		for (x = 0; x < gridSize; x++) {
-			VertDataCopy(FACE_getIECo(face, subdivLevels, S, x),
-			             FACE_getIFCo(face, subdivLevels, S, x, 0), ss);
-			if (do_normals) {
-				VertDataCopy(FACE_getIENo(face, subdivLevels, S, x),
-				             FACE_getIFNo(face, subdivLevels, S, x, 0), ss);
-			}
+	for (x = 0; x < gridSize; x++) {
+		VertDataCopy(FACE_getIECo(face, subdivLevels, S, x),
+		             FACE_getIFCo(face, subdivLevels, S, x, 0), ss);
+		if (do_normals) {
+			VertDataCopy(FACE_getIENo(face, subdivLevels, S, x),
+			             FACE_getIFNo(face, subdivLevels, S, x, 0), ss);
 		}
+	}
 
-		for (k = 0; k < face->numVerts; k++) {
-			CCGEdge *current_edge = FACE_getEdges(face)[k];
-			CCGVert **face_verts = FACE_getVerts(face);
-			if (current_edge->v0 == face_verts[S] &&
-			    current_edge->v1 == face_verts[(S + 1) % face->numVerts])
-			{
-				edge = current_edge;
-				inverse_edge = false;
-				break;
-			}
-			if (current_edge->v1 == face_verts[S] &&
-			    current_edge->v0 == face_verts[(S + 1) % face->numVerts])
-			{
-				edge = current_edge;
-				inverse_edge = true;
-				break;
-			}
+	for (k = 0; k < face->numVerts; k++) {
+		CCGEdge *current_edge = FACE_getEdges(face)[k];
+		CCGVert **face_verts = FACE_getVerts(face);
+		if (current_edge->v0 == face_verts[S] &&
+		    current_edge->v1 == face_verts[(S + 1) % face->numVerts])
+		{
+			edge = current_edge;
+			inverse_edge = false;
+			break;
 		}
+		if (current_edge->v1 == face_verts[S] &&
+		    current_edge->v0 == face_verts[(S + 1) % face->numVerts])
+		{
+			edge = current_edge;
+			inverse_edge = true;
+			break;
+		}
+	}
 
-		BLI_assert(edge != NULL);
+	BLI_assert(edge != NULL);
 
-		for (x = 0; x < edgeSize; x++) {
-			float u = 0, v = 0;
-			float *co = EDGE_getCo(edge, subdivLevels, x);
-			float *no = EDGE_getNo(edge, subdivLevels, x);
+	for (x = 0; x < edgeSize; x++) {
+		float u = 0, v = 0;
+		float *co = EDGE_getCo(edge, subdivLevels, x);
+		float *no = EDGE_getNo(edge, subdivLevels, x);
+		float P[3], dPdu[3], dPdv[3];
+		ccgSubSurf__mapEdgeToFace(S, x,
+		                          inverse_edge,
+		                          edgeSize,
+		                          &u, &v);
+
+		/* TODO(sergey): Ideally we will re-use grid here, but for now
+		 * let's just re-evaluate for simplicity.
+		 */
+		/* TODO(sergey): Need proper port. */
+		openSubdiv_evaluateLimit(ss->osd_evaluator, osd_face_index, u, v, P, dPdu, dPdv);
+		VertDataCopy(co, P, ss);
+		if (do_normals) {
+			cross_v3_v3v3(no, dPdu, dPdv);
+			normalize_v3(no);
+		}
+	}
+}
+
+static void opensubdiv_evaluateQuadFaceGrids(CCGSubSurf *ss,
+                                             CCGFace *face,
+                                             const int osd_face_index)
+{
+	CCGSubSurfOSDFaceGridsData data = {
+		.ss = ss,
+		.face = face,
+		.osd_face_index = osd_face_index,
+	};
+
+	BLI_task_parallel_range(0, face->numVerts, &data, opensubdiv_evaluateQuadFaceGrids_cb, true);
+}
+
+static void opensubdiv_evaluateNGonFaceGrids_cb(void *userdata, int S)
+{
+	CCGSubSurfOSDFaceGridsData *data = userdata;
+	CCGSubSurf *ss = data->ss;
+	CCGFace *face = data->face;
+	const int osd_face_index = data->osd_face_index;
+	int normalDataOffset = ss->normalDataOffset;
+	int subdivLevels = ss->subdivLevels;
+	int gridSize = ccg_gridsize(subdivLevels);
+	int vertDataSize = ss->meshIFC.vertDataSize;
+	bool do_normals = ss->meshIFC.numLayers == 3;
+	int x, y;
+
+	for (x = 0; x < gridSize; x++) {
+		for (y = 0; y < gridSize; y++) {
+			float *co = FACE_getIFCo(face, subdivLevels, S, x, y);
+			float *no = FACE_getIFNo(face, subdivLevels, S, x, y);
+			float u = 1.0f - (float) y / (gridSize - 1),
+			      v = 1.0f - (float) x / (gridSize - 1);
 			float P[3], dPdu[3], dPdv[3];
-			ccgSubSurf__mapEdgeToFace(S, x,
-			                          inverse_edge,
-			                          edgeSize,
-			                          &u, &v);
 
-			/* TODO(sergey): Ideally we will re-use grid here, but for now
-			 * let's just re-evaluate for simplicity.
-			 */
 			/* TODO(sergey): Need proper port. */
-			openSubdiv_evaluateLimit(ss->osd_evaluator, osd_face_index, u, v, P, dPdu, dPdv);
+			openSubdiv_evaluateLimit(ss->osd_evaluator, osd_face_index + S, u, v, P, dPdu, dPdv);
+
+			OSD_LOG("face=%d, corner=%d, u=%f, v=%f, P=(%f, %f, %f)\n",
+			        osd_face_index + S, S, u, v, P[0], P[1], P[2]);
+
 			VertDataCopy(co, P, ss);
 			if (do_normals) {
 				cross_v3_v3v3(no, dPdu, dPdv);
 				normalize_v3(no);
 			}
+
+			/* TODO(sergey): De-dpuplicate with the quad case. */
+			if (x == gridSize - 1 && y == gridSize - 1) {
+				float *vert_co = VERT_getCo(FACE_getVerts(face)[S], subdivLevels);
+				VertDataCopy(vert_co, co, ss);
+				if (do_normals) {
+					float *vert_no = VERT_getNo(FACE_getVerts(face)[S], subdivLevels);
+					VertDataCopy(vert_no, no, ss);
+				}
+			}
+			if (S == 0 && x == 0 && y == 0) {
+				float *center_co = (float *)FACE_getCenterData(face);
+				VertDataCopy(center_co, co, ss);
+				if (do_normals) {
+					float *center_no = (float *)((byte *)FACE_getCenterData(face) + normalDataOffset);
+					VertDataCopy(center_no, no, ss);
+				}
+			}
+		}
+	}
+	for (x = 0; x < gridSize; x++) {
+		VertDataCopy(FACE_getIECo(face, subdivLevels, S, x),
+		             FACE_getIFCo(face, subdivLevels, S, x, 0), ss);
+		if (do_normals) {
+			VertDataCopy(FACE_getIENo(face, subdivLevels, S, x),
+			             FACE_getIFNo(face, subdivLevels, S, x, 0), ss);
 		}
 	}
 }
@@ -682,57 +775,12 @@ static void opensubdiv_evaluateNGonFaceGrids(CCGSubSurf *ss,
 	 */
 
 	/* Evaluate face grids. */
-#pragma omp parallel for
-	for (S = 0; S < face->numVerts; S++) {
-		int x, y;
-		for (x = 0; x < gridSize; x++) {
-			for (y = 0; y < gridSize; y++) {
-				float *co = FACE_getIFCo(face, subdivLevels, S, x, y);
-				float *no = FACE_getIFNo(face, subdivLevels, S, x, y);
-				float u = 1.0f - (float) y / (gridSize - 1),
-				      v = 1.0f - (float) x / (gridSize - 1);
-				float P[3], dPdu[3], dPdv[3];
-
-				/* TODO(sergey): Need proper port. */
-				openSubdiv_evaluateLimit(ss->osd_evaluator, osd_face_index + S, u, v, P, dPdu, dPdv);
-
-				OSD_LOG("face=%d, corner=%d, u=%f, v=%f, P=(%f, %f, %f)\n",
-				        osd_face_index + S, S, u, v, P[0], P[1], P[2]);
-
-				VertDataCopy(co, P, ss);
-				if (do_normals) {
-					cross_v3_v3v3(no, dPdu, dPdv);
-					normalize_v3(no);
-				}
-
-				/* TODO(sergey): De-dpuplicate with the quad case. */
-				if (x == gridSize - 1 && y == gridSize - 1) {
-					float *vert_co = VERT_getCo(FACE_getVerts(face)[S], subdivLevels);
-					VertDataCopy(vert_co, co, ss);
-					if (do_normals) {
-						float *vert_no = VERT_getNo(FACE_getVerts(face)[S], subdivLevels);
-						VertDataCopy(vert_no, no, ss);
-					}
-				}
-				if (S == 0 && x == 0 && y == 0) {
-					float *center_co = (float *)FACE_getCenterData(face);
-					VertDataCopy(center_co, co, ss);
-					if (do_normals) {
-						float *center_no = (float *)((byte *)FACE_getCenterData(face) + normalDataOffset);
-						VertDataCopy(center_no, no, ss);
-					}
-				}
-			}
-		}
-		for (x = 0; x < gridSize; x++) {
-			VertDataCopy(FACE_getIECo(face, subdivLevels, S, x),
-			             FACE_getIFCo(face, subdivLevels, S, x, 0), ss);
-			if (do_normals) {
-				VertDataCopy(FACE_getIENo(face, subdivLevels, S, x),
-				             FACE_getIFNo(face, subdivLevels, S, x, 0), ss);
-			}
-		}
-	}
+	CCGSubSurfOSDFaceGridsData data = {
+		.ss = ss,
+		.face = face,
+		.osd_face_index = osd_face_index,
+	};
+	BLI_task_parallel_range(0, face->numVerts, &data, opensubdiv_evaluateNGonFaceGrids_cb, true);
 
 	/* Evaluate edges. */
 	for (S = 0; S < face->numVerts; S++) {
@@ -34,6 +34,7 @@
 #include <limits.h>
 
 #include "MEM_guardedalloc.h"
+#include "MEM_CacheLimiterC-Api.h"
 
 #include "DNA_cloth_types.h"
 #include "DNA_key_types.h"
@@ -49,7 +50,9 @@
 #include "BLI_math.h"
 #include "BLI_utildefines.h"
 #include "BLI_linklist.h"
+#include "BLI_hash_mm2a.h"
 #include "BLI_task.h"
+#include "BLI_threads.h"
 
 #include "BKE_cdderivedmesh.h"
 #include "BKE_editmesh.h"
@@ -68,6 +71,8 @@
 #include "BKE_deform.h"
 #include "BKE_global.h" /* For debug flag, DM_update_tessface_data() func. */
 
+#include "RNA_access.h"
+
 #ifdef WITH_GAMEENGINE
 #include "BKE_navmesh_conversion.h"
 static DerivedMesh *navmesh_dm_createNavMeshForVisualization(DerivedMesh *dm);
@@ -1722,6 +1727,516 @@ static void dm_ensure_display_normals(DerivedMesh *dm)
 	}
 }
 
+/* -------------------------------------------------------------------- */
+/** \name Modifier Stack Prefix Cache
+ *
+ * Keeps a copy of the DerivedMesh produced by the constructive part of the modifier stack,
+ * up to (but not including) the last enabled modifier. When only a later modifier changed,
+ * #mesh_calc_modifiers resumes from this copy instead of re-evaluating the whole stack,
+ * which makes tweaking the last modifier of a heavy stack interactive.
+ *
+ * An entry stores the inputs it was built from: the evaluation settings, the data masks and
+ * the RNA settings of every modifier in the prefix (serialized into a key), and a hash of the
+ * input mesh data. It is only used when both match the current inputs. Only modifiers whose result
+ * is fully described by these inputs are cached: no time dependency, no ID references and
+ * no nested settings structs.
+ *
+ * Entries are managed by a #MEM_CacheLimiter, so they share the memory cache limit of the
+ * user preferences.
+ * \{ */
+
+/* Serialized evaluation settings, compared byte by byte. */
+typedef struct ModifierPrefixKey {
+	unsigned char *data;
+	size_t len, len_alloc;
+} ModifierPrefixKey;
+
+typedef struct ModifierPrefixCache {
+	Object *ob;
+	/* last modifier of the cached prefix */
+	ModifierData *md;
+	ModifierPrefixKey key;
+	/* hash of the input mesh data */
+	uint32_t mesh_hash;
+	DerivedMesh *dm;
+	MEM_CacheLimiterHandleC *handle;
+} ModifierPrefixCache;
+
+/* Input mesh layers hashed for the cache, multires data is only read by multires which is never cached. */
+#define MODIFIER_PREFIX_CD_MASK (CD_MASK_MESH & ~(CD_MASK_MDISPS | CD_MASK_GRID_PAINT_MASK))
+
+static MEM_CacheLimiterC *modifier_prefix_limiter = NULL;
+static ThreadMutex modifier_prefix_lock = BLI_MUTEX_INITIALIZER;
+
+static void modifier_prefix_key_add(ModifierPrefixKey *key, const void *data, size_t len)
+{
+	if (key->len + len > key->len_alloc) {
+		key->len_alloc = MAX2(key->len + len, key->len_alloc * 2);
+		key->data = (key->data) ? MEM_reallocN(key->data, key->len_alloc) : MEM_mallocN(key->len_alloc, __func__);
+	}
+
+	memcpy(key->data + key->len, data, len);
+	key->len += len;
+}
+
+static void modifier_prefix_key_add_int(ModifierPrefixKey *key, int value)
+{
+	modifier_prefix_key_add(key, &value, sizeof(value));
+}
+
+/* strings include their terminator, so consecutive strings can't be confused */
+static void modifier_prefix_key_add_string(ModifierPrefixKey *key, const char *str, size_t len)
+{
+	modifier_prefix_key_add(key, str, len);
+	modifier_prefix_key_add(key, "", 1);
+}
+
+static void modifier_prefix_key_free(ModifierPrefixKey *key)
+{
+	MEM_SAFE_FREE(key->data);
+	key->len = key->len_alloc = 0;
+}
+
+static void modifier_prefix_cache_destructor(void *data)
+{
+	ModifierPrefixCache *cache = data;
+
+	cache->ob->modifier_prefix_cache = NULL;
+	cache->dm->needsFree = 1;
+	cache->dm->release(cache->dm);
+	modifier_prefix_key_free(&cache->key);
+	MEM_freeN(cache);
+}
+
+static size_t customdata_layers_size(const CustomData *data, int totelem)
+{
+	size_t size = 0;
+	int i;
+
+	for (i = 0; i < data->totlayer; i++) {
+		size += (size_t)CustomData_sizeof(data->layers[i].type) * (size_t)totelem;
+	}
+
+	return size;
+}
+
+static size_t modifier_prefix_cache_size(void *data)
+{
+	ModifierPrefixCache *cache = data;
+	DerivedMesh *dm = cache->dm;
+
+	return sizeof(*cache) + cache->key.len_alloc +
+	       customdata_layers_size(&dm->vertData, dm->numVertData) +
+	       customdata_layers_size(&dm->edgeData, dm->numEdgeData) +
+	       customdata_layers_size(&dm->loopData, dm->numLoopData) +
+	       customdata_layers_size(&dm->polyData, dm->numPolyData);
+}
+
+/* caller must hold modifier_prefix_lock */
+static void modifier_prefix_cache_remove(Object *ob)
+{
+	ModifierPrefixCache *cache = ob->modifier_prefix_cache;
+
+	if (cache) {
+		MEM_CacheLimiter_unmanage(cache->handle);
+		modifier_prefix_cache_destructor(cache);
+	}
+}
+
+void DM_modifier_prefix_cache_free(Object *ob)
+{
+	if (ob->modifier_prefix_cache) {
+		BLI_mutex_lock(&modifier_prefix_lock);
+		modifier_prefix_cache_remove(ob);
+		BLI_mutex_unlock(&modifier_prefix_lock);
+	}
+}
+
+void DM_modifier_prefix_cache_exit(void)
+{
+	if (modifier_prefix_limiter) {
+		delete_MEM_CacheLimiter(modifier_prefix_limiter);
+		modifier_prefix_limiter = NULL;
+	}
+}
+
+static void modifier_prefix_cache_idlink_cb(void *userData, Object *UNUSED(ob), ID **idpoin, int UNUSED(cb_flag))
+{
+	if (*idpoin) {
+		*((bool *)userData) = true;
+	}
+}
+
+/* Properties which have no effect on the result of the modifier. */
+static bool modifier_prefix_cache_skip_property(PropertyRNA *prop)
+{
+	const char *identifier = RNA_property_identifier(prop);
+
+	return STREQ(identifier, "rna_type") ||
+	       STREQ(identifier, "name") ||
+	       STREQ(identifier, "show_expanded");
+}
+
+/**
+ * Add the settings of \a md to the key.
+ *
+ * \return false when the result of the modifier depends on something which is not part of the key.
+ */
+static bool modifier_prefix_cache_key_modifier(ModifierPrefixKey *key, Object *ob, ModifierData *md)
+{
+	const ModifierTypeInfo *mti = modifierType_getInfo(md->type);
+	PointerRNA ptr;
+	bool has_id = false;
+	bool ok = true;
+
+	/* shape keys, bind data and multires displacements are stored outside the modifier settings */
+	if (ELEM(md->type, eModifierType_ShapeKey, eModifierType_Multires,
+	         eModifierType_LaplacianDeform, eModifierType_CorrectiveSmooth))
+	{
+		return false;
+	}
+
+	if (mti->dependsOnTime && mti->dependsOnTime(md)) {
+		return false;
+	}
+
+	if (mti->foreachIDLink) {
+		mti->foreachIDLink(md, ob, modifier_prefix_cache_idlink_cb, &has_id);
+	}
+	else if (mti->foreachObjectLink) {
+		mti->foreachObjectLink(md, ob, (ObjectWalkFunc)modifier_prefix_cache_idlink_cb, &has_id);
+	}
+
+	if (has_id) {
+		return false;
+	}
+
+	modifier_prefix_key_add_int(key, md->type);
+
+	RNA_pointer_create(&ob->id, &RNA_Modifier, md, &ptr);
+
+	RNA_STRUCT_BEGIN (&ptr, prop)
+	{
+		const int len = RNA_property_array_length(&ptr, prop);
+
+		if (modifier_prefix_cache_skip_property(prop)) {
+			continue;
+		}
+
+		switch (RNA_property_type(prop)) {
+			case PROP_BOOLEAN:
+			case PROP_INT:
+			{
+				int value_fixed[16], *values = value_fixed;
+
+				if (len == 0) {
+					value_fixed[0] = (RNA_property_type(prop) == PROP_BOOLEAN) ?
+					                 RNA_property_boolean_get(&ptr, prop) : RNA_property_int_get(&ptr, prop);
+				}
+				else {
+					values = (len > 16) ? MEM_mallocN(sizeof(int) * len, __func__) : value_fixed;
+					if (RNA_property_type(prop) == PROP_BOOLEAN)
+						RNA_property_boolean_get_array(&ptr, prop, values);
+					else
+						RNA_property_int_get_array(&ptr, prop, values);
+				}
+				modifier_prefix_key_add(key, values, sizeof(int) * max_ii(len, 1));
+				if (values != value_fixed)
+					MEM_freeN(values);
+				break;
+			}
+			case PROP_FLOAT:
+			{
+				float value_fixed[16], *values = value_fixed;
+
+				if (len == 0) {
+					value_fixed[0] = RNA_property_float_get(&ptr, prop);
+				}
+				else {
+					values = (len > 16) ? MEM_mallocN(sizeof(float) * len, __func__) : value_fixed;
+					RNA_property_float_get_array(&ptr, prop, values);
+				}
+				modifier_prefix_key_add(key, values, sizeof(float) * max_ii(len, 1));
+				if (values != value_fixed)
+					MEM_freeN(values);
+				break;
+			}
+			case PROP_ENUM:
+				modifier_prefix_key_add_int(key, RNA_property_enum_get(&ptr, prop));
+				break;
+			case PROP_STRING:
+			{
+				char value_fixed[128];
+				int value_len;
+				char *value = RNA_property_string_get_alloc(&ptr, prop, value_fixed, sizeof(value_fixed), &value_len);
+
+				modifier_prefix_key_add_string(key, value, (size_t)value_len);
+				if (value != value_fixed)
+					MEM_freeN(value);
+				break;
+			}
+			case PROP_POINTER:
+			{
+				/* nested settings (curve mappings, particle systems...) are not part of the key */
+				if (RNA_property_pointer_get(&ptr, prop).data) {
+					ok = false;
+				}
+				break;
+			}
+			case PROP_COLLECTION:
+			{
+				if (RNA_property_collection_length(&ptr, prop) != 0) {
+					ok = false;
+				}
+				break;
+			}
+		}
+
+		if (!ok) {
+			break;
+		}
+	}
+	RNA_STRUCT_END;
+
+	return ok;
+}
+
+/* Selection flags have no effect on the modifiers, leave them out so selecting doesn't clear the cache. */
+static void modifier_prefix_cache_hash_layer(BLI_HashMurmur2A *mm2, const CustomDataLayer *layer, int totelem)
+{
+	int i;
+
+	BLI_hash_mm2a_add_int(mm2, layer->type);
+	BLI_hash_mm2a_add_int(mm2, layer->active);
+	BLI_hash_mm2a_add_int(mm2, layer->active_rnd);
+	BLI_hash_mm2a_add(mm2, (const unsigned char *)layer->name, strlen(layer->name) + 1);
+
+	switch (layer->type) {
+		case CD_MVERT:
+		{
+			const MVert *mv = layer->data;
+
+			for (i = 0; i < totelem; i++, mv++) {
+				BLI_hash_mm2a_add(mm2, (const unsigned char *)mv->co, sizeof(mv->co));
+				BLI_hash_mm2a_add_int(mm2, mv->flag & ~SELECT);
+				BLI_hash_mm2a_add_int(mm2, mv->bweight);
+			}
+			break;
+		}
+		case CD_MEDGE:
+		{
+			const MEdge *med = layer->data;
+
+			for (i = 0; i < totelem; i++, med++) {
+				BLI_hash_mm2a_add_int(mm2, (int)med->v1);
+				BLI_hash_mm2a_add_int(mm2, (int)med->v2);
+				BLI_hash_mm2a_add_int(mm2, med->flag & ~SELECT);
+				BLI_hash_mm2a_add_int(mm2, med->crease);
+				BLI_hash_mm2a_add_int(mm2, med->bweight);
+			}
+			break;
+		}
+		case CD_MPOLY:
+		{
+			const MPoly *mp = layer->data;
+
+			for (i = 0; i < totelem; i++, mp++) {
+				BLI_hash_mm2a_add_int(mm2, mp->loopstart);
+				BLI_hash_mm2a_add_int(mm2, mp->totloop);
+				BLI_hash_mm2a_add_int(mm2, mp->flag & ~ME_FACE_SEL);
+				BLI_hash_mm2a_add_int(mm2, mp->mat_nr);
+			}
+			break;
+		}
+		case CD_MDEFORMVERT:
+		{
+			const MDeformVert *dv = layer->data;
+
+			for (i = 0; i < totelem; i++, dv++) {
+				BLI_hash_mm2a_add_int(mm2, dv->totweight);
+				if (dv->totweight) {
+					BLI_hash_mm2a_add(mm2, (const unsigned char *)dv->dw, sizeof(*dv->dw) * (size_t)dv->totweight);
+				}
+			}
+			break;
+		}
+		default:
+			BLI_hash_mm2a_add(mm2, layer->data, (size_t)CustomData_sizeof(layer->type) * (size_t)totelem);
+			break;
+	}
+}
+
+static void modifier_prefix_cache_hash_customdata(BLI_HashMurmur2A *mm2, const CustomData *data, int totelem)
+{
+	int i;
+
+	BLI_hash_mm2a_add_int(mm2, totelem);
+
+	for (i = 0; i < data->totlayer; i++) {
+		const CustomDataLayer *layer = &data->layers[i];
+
+		/* same layers as skipped by CustomData_copy() */
+		if (!(CD_TYPE_AS_MASK(layer->type) & MODIFIER_PREFIX_CD_MASK) || (layer->flag & CD_FLAG_NOCOPY)) {
+			continue;
+		}
+
+		modifier_prefix_cache_hash_layer(mm2, layer, totelem);
+	}
+}
+
+/**
+ * Hash of the input mesh data, this avoids keeping a copy of the mesh to compare against,
+ * at the (small) risk of a stale result on a hash collision.
+ */
+static uint32_t modifier_prefix_cache_mesh_hash(const Mesh *me)
+{
+	BLI_HashMurmur2A mm2;
+
+	BLI_hash_mm2a_init(&mm2, 0);
+	modifier_prefix_cache_hash_customdata(&mm2, &me->vdata, me->totvert);
+	modifier_prefix_cache_hash_customdata(&mm2, &me->edata, me->totedge);
+	modifier_prefix_cache_hash_customdata(&mm2, &me->ldata, me->totloop);
+	modifier_prefix_cache_hash_customdata(&mm2, &me->pdata, me->totpoly);
+
+	return BLI_hash_mm2a_end(&mm2);
+}
+
+/**
+ * Find the last modifier of the prefix which is worth caching, starting at \a md.
+ *
+ * This is the last constructive modifier of the leading run of cacheable modifiers which is
+ * followed by at least one more enabled modifier (otherwise the prefix is the final result).
+ * \a datamask is the #CDMaskLink of \a md, the masks are walked along with the modifiers.
+ * \a r_key is filled with the settings the result of the prefix depends on, except for the
+ * input mesh data, it must be freed when a prefix is returned.
+ */
+static ModifierData *modifier_prefix_cache_find(
+        Scene *scene, Object *ob, ModifierData *md, CDMaskLink *datamask, const int required_mode,
+        CustomDataMask dataMask, ModifierPrefixKey *r_key)
+{
+	ModifierData *md_candidate = NULL, *md_prefix = NULL;
+	size_t len_prefix = 0;
+	Mesh *me = ob->data;
+	bDeformGroup *dg;
+
+	memset(r_key, 0, sizeof(*r_key));
+
+	modifier_prefix_key_add(r_key, &dataMask, sizeof(dataMask));
+	modifier_prefix_key_add_int(r_key, (scene->r.mode & R_SIMPLIFY) ? scene->r.simplify_subsurf : -1);
+	/* material indices are clamped to the number of materials */
+	modifier_prefix_key_add_int(r_key, ob->totcol);
+	/* auto smooth and its angle are read by the modifiers */
+	modifier_prefix_key_add_int(r_key, me->flag);
+	modifier_prefix_key_add(r_key, &me->smoothresh, sizeof(me->smoothresh));
+
+	/* vertex groups are referenced by name from the modifiers */
+	for (dg = ob->defbase.first; dg; dg = dg->next) {
+		modifier_prefix_key_add_string(r_key, dg->name, strlen(dg->name));
+	}
+
+	for (; md; md = md->next, datamask = datamask->next) {
+		const ModifierTypeInfo *mti = modifierType_getInfo(md->type);
+
+		if (!modifier_isEnabled(scene, md, required_mode)) {
+			continue;
+		}
+
+		/* layers requested from this modifier on, this is also the mask
+		 * the result of the previous enabled modifier is reduced to */
+		modifier_prefix_key_add(r_key, &datamask->mask, sizeof(datamask->mask));
+
+		/* the candidate is followed by an enabled modifier, so it is not the final result */
+		if (md_candidate) {
+			md_prefix = md_candidate;
+			len_prefix = r_key->len;
+			md_candidate = NULL;
+		}
+
+		if (mti->flags & eModifierTypeFlag_RequiresOriginalData) {
+			break;
+		}
+
+		if (!modifier_prefix_cache_key_modifier(r_key, ob, md)) {
+			break;
+		}
+
+		if (mti->type != eModifierTypeType_OnlyDeform) {
+			md_candidate = md;
+		}
+	}
+
+	if (md_prefix) {
+		r_key->len = len_prefix;
+	}
+	else {
+		modifier_prefix_key_free(r_key);
+	}
+
+	return md_prefix;
+}
+
+static DerivedMesh *modifier_prefix_cache_lookup(
+        Object *ob, ModifierData *md, const ModifierPrefixKey *key, const uint32_t mesh_hash)
+{
+	ModifierPrefixCache *cache;
+	DerivedMesh *dm;
+
+	BLI_mutex_lock(&modifier_prefix_lock);
+	cache = ob->modifier_prefix_cache;
+	if (cache && (cache->md != md || cache->mesh_hash != mesh_hash || cache->key.len != key->len ||
+	              memcmp(cache->key.data, key->data, key->len) != 0))
+	{
+		modifier_prefix_cache_remove(ob);
+		cache = NULL;
+	}
+	if (cache) {
+		/* keep the entry alive while copying it outside of the lock */
+		MEM_CacheLimiter_ref(cache->handle);
+		MEM_CacheLimiter_touch(cache->handle);
+	}
+	BLI_mutex_unlock(&modifier_prefix_lock);
+
+	if (cache == NULL) {
+		return NULL;
+	}
+
+	dm = CDDM_copy(cache->dm);
+
+	BLI_mutex_lock(&modifier_prefix_lock);
+	MEM_CacheLimiter_unref(cache->handle);
+	BLI_mutex_unlock(&modifier_prefix_lock);
+
+	return dm;
+}
+
+/* Takes ownership of \a key. */
+static void modifier_prefix_cache_store(
+        Object *ob, ModifierData *md, ModifierPrefixKey *key, const uint32_t mesh_hash, DerivedMesh *dm)
+{
+	ModifierPrefixCache *cache = MEM_mallocN(sizeof(*cache), __func__);
+
+	cache->ob = ob;
+	cache->md = md;
+	cache->key = *key;
+	memset(key, 0, sizeof(*key));
+	cache->mesh_hash = mesh_hash;
+
+	cache->dm = CDDM_copy(dm);
+
+	BLI_mutex_lock(&modifier_prefix_lock);
+	if (modifier_prefix_limiter == NULL) {
+		modifier_prefix_limiter = new_MEM_CacheLimiter(modifier_prefix_cache_destructor,
+		                                               modifier_prefix_cache_size);
+	}
+	modifier_prefix_cache_remove(ob);
+	ob->modifier_prefix_cache = cache;
+	cache->handle = MEM_CacheLimiter_insert(modifier_prefix_limiter, cache);
+	MEM_CacheLimiter_enforce_limits(modifier_prefix_limiter);
+	BLI_mutex_unlock(&modifier_prefix_lock);
+}
+
+/** \} */
+
 /**
  * new value for useDeform -1  (hack for the gameengine):
  *
@@ -1769,6 +2284,13 @@ static void mesh_calc_modifiers(
 	const bool do_loop_normals = (me->flag & ME_AUTOSMOOTH) != 0;
 	const float loop_normals_split_angle = me->smoothresh;
 
+	/* only the regular viewport evaluation of the whole stack uses the prefix cache */
+	const bool use_prefix_cache = (!useRenderParams && useCache && useDeform > 0 && index == -1 &&
+	                               !inputVertexCos && !build_shapekey_layers && !sculpt_mode && !need_mapping);
+	ModifierData *md_prefix = NULL;
+	ModifierPrefixKey prefix_key = {NULL};
+	uint32_t prefix_mesh_hash = 0;
+
 	VirtualModifierData virtualModifierData;
 
 	ModifierApplyFlag app_flags = useRenderParams ? MOD_APPLY_RENDER : 0;
@@ -1883,6 +2405,32 @@ static void mesh_calc_modifiers(
 	orcodm = NULL;
 	clothorcodm = NULL;
 
+	/* Resume from the cached result of the constructive prefix when it is still valid.
+	 * Not done when the leading modifiers deformed the mesh, or when orco layers have to be
+	 * built in parallel, since neither is part of the cache. */
+	if (use_prefix_cache && md && !deformedVerts && !previewmd && !do_init_wmcol &&
+	    !(curr->mask & (CD_MASK_ORCO | CD_MASK_CLOTH_ORCO)))
+	{
+		md_prefix = modifier_prefix_cache_find(scene, ob, md, curr, required_mode, dataMask, &prefix_key);
+
+		if (md_prefix) {
+			prefix_mesh_hash = modifier_prefix_cache_mesh_hash(me);
+			dm = modifier_prefix_cache_lookup(ob, md_prefix, &prefix_key, prefix_mesh_hash);
+
+			if (dm) {
+				while (md != md_prefix) {
+					md = md->next;
+					curr = curr->next;
+				}
+				md = md->next;
+				curr = curr->next;
+
+				dm->deformedOnly = false;
+				md_prefix = NULL;
+			}
+		}
+	}
+
 	for (; md; md = md->next, curr = curr->next) {
 		const ModifierTypeInfo *mti = modifierType_getInfo(md->type);
 
@@ -2125,6 +2673,10 @@ static void mesh_calc_modifiers(
 			}
 
 			dm->deformedOnly = false;
+
+			if (md == md_prefix && !deformedVerts && md->error == NULL) {
+				modifier_prefix_cache_store(ob, md, &prefix_key, prefix_mesh_hash, dm);
+			}
 		}
 
 		isPrevDeform = (mti->type == eModifierTypeType_OnlyDeform);
@@ -2138,6 +2690,9 @@ static void mesh_calc_modifiers(
 		}
 	}
 
+	/* not stored when the cache was used, or when evaluation stopped before the prefix */
+	modifier_prefix_key_free(&prefix_key);
+
 	for (md = firstmd; md; md = md->next)
 		modifier_freeTemporaryData(md);
 
@@ -2614,12 +3169,69 @@ static bool calc_modifiers_skip_orco(Scene *scene,
 }
 #endif
 
+/**
+ * Take the tessellation of the previous result (when there is one),
+ * so it can be reused by #mesh_build_data_looptri_reuse.
+ */
+static MLoopTri *mesh_build_data_looptri_steal(Object *ob, int *r_looptri_num)
+{
+	DerivedMesh *dm = ob->derivedFinal;
+	MLoopTri *looptri = NULL;
+
+	*r_looptri_num = 0;
+
+	if (dm && (dm->type == DM_TYPE_CDDM) && dm->looptris.array) {
+		looptri = dm->looptris.array;
+		*r_looptri_num = dm->looptris.num;
+
+		dm->looptris.array = NULL;
+		dm->looptris.num = 0;
+		dm->looptris.num_alloc = 0;
+	}
+
+	return looptri;
+}
+
+/**
+ * Animated deformations re-evaluate the modifier stack without changing the topology,
+ * in that case the previous tessellation is reused, only re-calculating ngons
+ * which can't be filled the same way anymore.
+ *
+ * Takes ownership of \a looptri.
+ */
+static void mesh_build_data_looptri_reuse(DerivedMesh *dm, MLoopTri *looptri, int looptri_num)
+{
+	if ((dm->type == DM_TYPE_CDDM) &&
+	    (dm->looptris.array == NULL) &&
+	    (dm->numPolyData != 0) &&
+	    (looptri_num == poly_to_tri_count(dm->numPolyData, dm->numLoopData)))
+	{
+		dm->looptris.array = looptri;
+		dm->looptris.num = looptri_num;
+		dm->looptris.num_alloc = looptri_num;
+
+		BKE_mesh_recalc_looptri_refit(
+		        dm->getLoopArray(dm), dm->getPolyArray(dm),
+		        dm->getVertArray(dm),
+		        dm->numLoopData, dm->numPolyData,
+		        looptri);
+	}
+	else {
+		MEM_freeN(looptri);
+	}
+}
+
 static void mesh_build_data(
         Scene *scene, Object *ob, CustomDataMask dataMask,
         const bool build_shapekey_layers, const bool need_mapping)
 {
+	MLoopTri *looptri_prev;
+	int looptri_prev_num;
+
 	BLI_assert(ob->type == OB_MESH);
 
+	looptri_prev = mesh_build_data_looptri_steal(ob, &looptri_prev_num);
+
 	BKE_object_free_derived_caches(ob);
 	BKE_object_sculpt_modifiers_changed(ob);
 
@@ -2636,6 +3248,10 @@ static void mesh_build_data(
 
 	DM_set_object_boundbox(ob, ob->derivedFinal);
 
+	if (looptri_prev) {
+		mesh_build_data_looptri_reuse(ob->derivedFinal, looptri_prev, looptri_prev_num);
+	}
+
 	ob->derivedFinal->needsFree = 0;
 	ob->derivedDeform->needsFree = 0;
 	ob->lastDataMask = dataMask;
@@ -955,6 +955,183 @@ static void armature_bbone_defmats_cb(void *userdata, Link *iter, int index)
 	}
 }
 
+typedef struct ArmatureUserdata {
+	Object *armOb;
+	float (*vertexCos)[3];
+	float (*defMats)[3][3];
+	float (*prevCos)[3];
+
+	bool use_envelope;
+	bool use_quaternion;
+	bool invert_vgroup;
+	bool use_dverts;
+
+	int armature_def_nr;
+
+	/* deform vertices, either from the DerivedMesh or the original object data */
+	MDeformVert *dverts;
+	int dverts_tot;
+
+	/* vertex group index to pose channel and its index in pdef_info_array */
+	int defbase_tot;
+	bPoseChannel **defnrToPC;
+	int *defnrToPCIndex;
+	bPoseChanDeform *pdef_info_array;
+
+	float premat[4][4];
+	float postmat[4][4];
+	float premat3[3][3];
+	float postmat3[3][3];
+} ArmatureUserdata;
+
+static void armature_vert_task(void *userdata, int i)
+{
+	ArmatureUserdata *data = userdata;
+	float (*const vertexCos)[3] = data->vertexCos;
+	float (*const defMats)[3][3] = data->defMats;
+	float (*const prevCos)[3] = data->prevCos;
+	const bool use_envelope = data->use_envelope;
+	const bool use_quaternion = data->use_quaternion;
+	const bool use_dverts = data->use_dverts;
+	const int armature_def_nr = data->armature_def_nr;
+	bPoseChanDeform *pdef_info;
+	bPoseChannel *pchan;
+	MDeformVert *dvert;
+	DualQuat sumdq, *dq = NULL;
+	float *co, dco[3];
+	float sumvec[3], summat[3][3];
+	float *vec = NULL, (*smat)[3] = NULL;
+	float contrib = 0.0f;
+	float armature_weight = 1.0f; /* default to 1 if no overall def group */
+	float prevco_weight = 1.0f;   /* weight for optional cached vertexcos */
+
+	if (use_quaternion) {
+		memset(&sumdq, 0, sizeof(DualQuat));
+		dq = &sumdq;
+	}
+	else {
+		sumvec[0] = sumvec[1] = sumvec[2] = 0.0f;
+		vec = sumvec;
+
+		if (defMats) {
+			zero_m3(summat);
+			smat = summat;
+		}
+	}
+
+	if ((use_dverts || armature_def_nr != -1) && data->dverts && i < data->dverts_tot)
+		dvert = data->dverts + i;
+	else
+		dvert = NULL;
+
+	if (armature_def_nr != -1 && dvert) {
+		armature_weight = defvert_find_weight(dvert, armature_def_nr);
+
+		if (data->invert_vgroup)
+			armature_weight = 1.0f - armature_weight;
+
+		/* hackish: the blending factor can be used for blending with prevCos too */
+		if (prevCos) {
+			prevco_weight = armature_weight;
+			armature_weight = 1.0f;
+		}
+	}
+
+	/* check if there's any  point in calculating for this vert */
+	if (armature_weight == 0.0f)
+		return;
+
+	/* get the coord we work on */
+	co = prevCos ? prevCos[i] : vertexCos[i];
+
+	/* Apply the object's matrix */
+	mul_m4_v3(data->premat, co);
+
+	if (use_dverts && dvert && dvert->totweight) { /* use weight groups ? */
+		const MDeformWeight *dw = dvert->dw;
+		int deformed = 0;
+		unsigned int j;
+
+		for (j = dvert->totweight; j != 0; j--, dw++) {
+			const int index = dw->def_nr;
+			if (index >= 0 && index < data->defbase_tot && (pchan = data->defnrToPC[index])) {
+				float weight = dw->weight;
+				Bone *bone = pchan->bone;
+				pdef_info = data->pdef_info_array + data->defnrToPCIndex[index];
+
+				deformed = 1;
+
+				if (bone && bone->flag & BONE_MULT_VG_ENV) {
+					weight *= distfactor_to_bone(co, bone->arm_head, bone->arm_tail,
+					                             bone->rad_head, bone->rad_tail, bone->dist);
+				}
+				pchan_bone_deform(pchan, pdef_info, weight, vec, dq, smat, co, &contrib);
+			}
+		}
+		/* if there are vertexgroups but not groups with bones
+		 * (like for softbody groups) */
+		if (deformed == 0 && use_envelope) {
+			pdef_info = data->pdef_info_array;
+			for (pchan = data->armOb->pose->chanbase.first; pchan; pchan = pchan->next, pdef_info++) {
+				if (!(pchan->bone->flag & BONE_NO_DEFORM))
+					contrib += dist_bone_deform(pchan, pdef_info, vec, dq, smat, co);
+			}
+		}
+	}
+	else if (use_envelope) {
+		pdef_info = data->pdef_info_array;
+		for (pchan = data->armOb->pose->chanbase.first; pchan; pchan = pchan->next, pdef_info++) {
+			if (!(pchan->bone->flag & BONE_NO_DEFORM))
+				contrib += dist_bone_deform(pchan, pdef_info, vec, dq, smat, co);
+		}
+	}
+
+	/* actually should be EPSILON? weight values and contrib can be like 10e-39 small */
+	if (contrib > 0.0001f) {
+		if (use_quaternion) {
+			normalize_dq(dq, contrib);
+
+			if (armature_weight != 1.0f) {
+				copy_v3_v3(dco, co);
+				mul_v3m3_dq(dco, (defMats) ? summat : NULL, dq);
+				sub_v3_v3(dco, co);
+				mul_v3_fl(dco, armature_weight);
+				add_v3_v3(co, dco);
+			}
+			else
+				mul_v3m3_dq(co, (defMats) ? summat : NULL, dq);
+
+			smat = summat;
+		}
+		else {
+			mul_v3_fl(vec, armature_weight / contrib);
+			add_v3_v3v3(co, vec, co);
+		}
+
+		if (defMats) {
+			float tmpmat[3][3];
+
+			copy_m3_m3(tmpmat, defMats[i]);
+
+			if (!use_quaternion) /* quaternion already is scale corrected */
+				mul_m3_fl(smat, armature_weight / contrib);
+
+			mul_m3_series(defMats[i], data->postmat3, smat, data->premat3, tmpmat);
+		}
+	}
+
+	/* always, check above code */
+	mul_m4_v3(data->postmat, co);
+
+	/* interpolate with previous modifier position using weight group */
+	if (prevCos) {
+		float mw = 1.0f - prevco_weight;
+		vertexCos[i][0] = prevco_weight * vertexCos[i][0] + mw * co[0];
+		vertexCos[i][1] = prevco_weight * vertexCos[i][1] + mw * co[1];
+		vertexCos[i][2] = prevco_weight * vertexCos[i][2] + mw * co[2];
+	}
+}
+
 void armature_deform_verts(Object *armOb, Object *target, DerivedMesh *dm, float (*vertexCos)[3],
                            float (*defMats)[3][3], int numVerts, int deformflag,
                            float (*prevCos)[3], const char *defgrp_name)
@@ -1028,16 +1205,16 @@ void armature_deform_verts(Object *armOb, Object *target, DerivedMesh *dm, float
 		}
 	}
 
+	/* if we have a DerivedMesh, its deform vertices replace the ones of the original data */
+	if (dm) {
+		dverts = dm->getVertDataArray(dm, CD_MDEFORMVERT);
+		target_totvert = dverts ? numVerts : 0;
+	}
+
 	/* get a vertex-deform-index to posechannel array */
 	if (deformflag & ARM_DEF_VGROUP) {
 		if (ELEM(target->type, OB_MESH, OB_LATTICE)) {
-			/* if we have a DerivedMesh, only use dverts if it has them */
-			if (dm) {
-				use_dverts = (dm->getVertDataArray(dm, CD_MDEFORMVERT) != NULL);
-			}
-			else if (dverts) {
-				use_dverts = true;
-			}
+			use_dverts = (dverts != NULL);
 
 			if (use_dverts) {
 				defnrToPC = MEM_callocN(sizeof(*defnrToPC) * defbase_tot, "defnrToBone");
@@ -1070,150 +1247,31 @@ void armature_deform_verts(Object *armOb, Object *target, DerivedMesh *dm, float
 		}
 	}
 
-	for (i = 0; i < numVerts; i++) {
-		MDeformVert *dvert;
-		DualQuat sumdq, *dq = NULL;
-		float *co, dco[3];
-		float sumvec[3], summat[3][3];
-		float *vec = NULL, (*smat)[3] = NULL;
-		float contrib = 0.0f;
-		float armature_weight = 1.0f; /* default to 1 if no overall def group */
-		float prevco_weight = 1.0f;   /* weight for optional cached vertexcos */
-
-		if (use_quaternion) {
-			memset(&sumdq, 0, sizeof(DualQuat));
-			dq = &sumdq;
-		}
-		else {
-			sumvec[0] = sumvec[1] = sumvec[2] = 0.0f;
-			vec = sumvec;
-
-			if (defMats) {
-				zero_m3(summat);
-				smat = summat;
-			}
-		}
-
-		if (use_dverts || armature_def_nr != -1) {
-			if (dm)
-				dvert = dm->getVertData(dm, i, CD_MDEFORMVERT);
-			else if (dverts && i < target_totvert)
-				dvert = dverts + i;
-			else
-				dvert = NULL;
-		}
-		else
-			dvert = NULL;
-
-		if (armature_def_nr != -1 && dvert) {
-			armature_weight = defvert_find_weight(dvert, armature_def_nr);
-
-			if (invert_vgroup)
-				armature_weight = 1.0f - armature_weight;
-
-			/* hackish: the blending factor can be used for blending with prevCos too */
-			if (prevCos) {
-				prevco_weight = armature_weight;
-				armature_weight = 1.0f;
-			}
-		}
-
-		/* check if there's any  point in calculating for this vert */
-		if (armature_weight == 0.0f)
-			continue;
-
-		/* get the coord we work on */
-		co = prevCos ? prevCos[i] : vertexCos[i];
-
-		/* Apply the object's matrix */
-		mul_m4_v3(premat, co);
-
-		if (use_dverts && dvert && dvert->totweight) { /* use weight groups ? */
-			MDeformWeight *dw = dvert->dw;
-			int deformed = 0;
-			unsigned int j;
-
-			for (j = dvert->totweight; j != 0; j--, dw++) {
-				const int index = dw->def_nr;
-				if (index >= 0 && index < defbase_tot && (pchan = defnrToPC[index])) {
-					float weight = dw->weight;
-					Bone *bone = pchan->bone;
-					pdef_info = pdef_info_array + defnrToPCIndex[index];
-
-					deformed = 1;
-
-					if (bone && bone->flag & BONE_MULT_VG_ENV) {
-						weight *= distfactor_to_bone(co, bone->arm_head, bone->arm_tail,
-						                             bone->rad_head, bone->rad_tail, bone->dist);
-					}
-					pchan_bone_deform(pchan, pdef_info, weight, vec, dq, smat, co, &contrib);
-				}
-			}
-			/* if there are vertexgroups but not groups with bones
-			 * (like for softbody groups) */
-			if (deformed == 0 && use_envelope) {
-				pdef_info = pdef_info_array;
-				for (pchan = armOb->pose->chanbase.first; pchan; pchan = pchan->next, pdef_info++) {
-					if (!(pchan->bone->flag & BONE_NO_DEFORM))
-						contrib += dist_bone_deform(pchan, pdef_info, vec, dq, smat, co);
-				}
-			}
-		}
-		else if (use_envelope) {
-			pdef_info = pdef_info_array;
-			for (pchan = armOb->pose->chanbase.first; pchan; pchan = pchan->next, pdef_info++) {
-				if (!(pchan->bone->flag & BONE_NO_DEFORM))
-					contrib += dist_bone_deform(pchan, pdef_info, vec, dq, smat, co);
-			}
-		}
-
-		/* actually should be EPSILON? weight values and contrib can be like 10e-39 small */
-		if (contrib > 0.0001f) {
-			if (use_quaternion) {
-				normalize_dq(dq, contrib);
-
-				if (armature_weight != 1.0f) {
-					copy_v3_v3(dco, co);
-					mul_v3m3_dq(dco, (defMats) ? summat : NULL, dq);
-					sub_v3_v3(dco, co);
-					mul_v3_fl(dco, armature_weight);
-					add_v3_v3(co, dco);
-				}
-				else
-					mul_v3m3_dq(co, (defMats) ? summat : NULL, dq);
-
-				smat = summat;
-			}
-			else {
-				mul_v3_fl(vec, armature_weight / contrib);
-				add_v3_v3v3(co, vec, co);
-			}
-
-			if (defMats) {
-				float pre[3][3], post[3][3], tmpmat[3][3];
-
-				copy_m3_m4(pre, premat);
-				copy_m3_m4(post, postmat);
-				copy_m3_m3(tmpmat, defMats[i]);
-
-				if (!use_quaternion) /* quaternion already is scale corrected */
-					mul_m3_fl(smat, armature_weight / contrib);
-
-				mul_m3_series(defMats[i], post, smat, pre, tmpmat);
-			}
-		}
-
-		/* always, check above code */
-		mul_m4_v3(postmat, co);
+	/* every vertex only reads the bone deform data and writes its own coordinate and matrix,
+	 * so they can be deformed in parallel */
+	ArmatureUserdata vert_data = {
+		.armOb = armOb,
+		.vertexCos = vertexCos,
+		.defMats = defMats,
+		.prevCos = prevCos,
+		.use_envelope = use_envelope,
+		.use_quaternion = use_quaternion,
+		.invert_vgroup = invert_vgroup,
+		.use_dverts = use_dverts,
+		.armature_def_nr = armature_def_nr,
+		.dverts = dverts,
+		.dverts_tot = target_totvert,
+		.defbase_tot = defbase_tot,
+		.defnrToPC = defnrToPC,
+		.defnrToPCIndex = defnrToPCIndex,
+		.pdef_info_array = pdef_info_array,
+	};
+	copy_m4_m4(vert_data.premat, premat);
+	copy_m4_m4(vert_data.postmat, postmat);
+	copy_m3_m4(vert_data.premat3, premat);
+	copy_m3_m4(vert_data.postmat3, postmat);
 
-		/* interpolate with previous modifier position using weight group */
-		if (prevCos) {
-			float mw = 1.0f - prevco_weight;
-			vertexCos[i][0] = prevco_weight * vertexCos[i][0] + mw * co[0];
-			vertexCos[i][1] = prevco_weight * vertexCos[i][1] + mw * co[1];
-			vertexCos[i][2] = prevco_weight * vertexCos[i][2] + mw * co[2];
-		}
-	}
+	BLI_task_parallel_range(0, numVerts, &vert_data, armature_vert_task, numVerts > 1000);
 
 	if (dualquats)
 		MEM_freeN(dualquats);
@@ -2221,24 +2279,25 @@ void BKE_pose_where_is_bone(Scene *scene, Object *ob, bPoseChannel *pchan, float
 
 		/* Do constraints */
 		if (pchan->constraints.first) {
-			bConstraintOb *cob;
+			bConstraintOb cob;
 			float vec[3];
 
 			/* make a copy of location of PoseChannel for later */
 			copy_v3_v3(vec, pchan->pose_mat[3]);
 
 			/* prepare PoseChannel for Constraint solving
-			 * - makes a copy of matrix, and creates temporary struct to use
+			 * - makes a copy of matrix, temporary struct lives on the stack since this
+			 *   is called for every bone from multiple threads
 			 */
-			cob = BKE_constraints_make_evalob(scene, ob, pchan, CONSTRAINT_OBTYPE_BONE);
+			BKE_constraints_evalob_init(&cob, scene, ob, pchan, CONSTRAINT_OBTYPE_BONE);
 
 			/* Solve PoseChannel's Constraints */
-			BKE_constraints_solve(&pchan->constraints, cob, ctime); /* ctime doesnt alter objects */
+			BKE_constraints_solve(&pchan->constraints, &cob, ctime); /* ctime doesnt alter objects */
 
 			/* cleanup after Constraint Solving
-			 * - applies matrix back to pchan, and frees temporary struct used
+			 * - applies matrix back to pchan
 			 */
-			BKE_constraints_clear_evalob(cob);
+			BKE_constraints_evalob_apply(&cob);
 
 			/* prevent constraints breaking a chain */
 			if (pchan->bone->flag & BONE_CONNECTED) {
@@ -120,13 +120,11 @@ void BKE_constraint_unique_name(bConstraint *con, ListBase *list)
 /* ----------------- Evaluation Loop Preparation --------------- */
 
 /* package an object/bone for use in constraint evaluation */
-/* This function MEM_calloc's a bConstraintOb struct, that will need to be freed after evaluation */
-bConstraintOb *BKE_constraints_make_evalob(Scene *scene, Object *ob, void *subdata, short datatype)
+/* Storage of cob is owned by the caller, so it can live on stack of the evaluation thread,
+ * avoiding allocation for every bone on every frame. */
+void BKE_constraints_evalob_init(bConstraintOb *cob, Scene *scene, Object *ob, void *subdata, short datatype)
 {
-	bConstraintOb *cob;
-	
-	/* create regardless of whether we have any data! */
-	cob = MEM_callocN(sizeof(bConstraintOb), "bConstraintOb");
+	memset(cob, 0, sizeof(bConstraintOb));
 	
 	/* for system time, part of deglobalization, code nicer later with local time (ton) */
 	cob->scene = scene;
@@ -135,7 +133,7 @@ bConstraintOb *BKE_constraints_make_evalob(Scene *scene, Object *ob, void *subda
 	switch (datatype) {
 		case CONSTRAINT_OBTYPE_OBJECT:
 		{
-			/* disregard subdata... calloc should set other values right */
+			/* disregard subdata... the memset above should set other values right */
 			if (ob) {
 				cob->ob = ob;
 				cob->type = datatype;
@@ -192,12 +190,23 @@ bConstraintOb *BKE_constraints_make_evalob(Scene *scene, Object *ob, void *subda
 			unit_m4(cob->startmat);
 			break;
 	}
+}
 
+/* This function allocates a bConstraintOb struct (initialized by BKE_constraints_evalob_init),
+ * that will need to be freed after evaluation */
+bConstraintOb *BKE_constraints_make_evalob(Scene *scene, Object *ob, void *subdata, short datatype)
+{
+	bConstraintOb *cob;
+	
+	/* create regardless of whether we have any data! */
+	cob = MEM_mallocN(sizeof(bConstraintOb), "bConstraintOb");
+	BKE_constraints_evalob_init(cob, scene, ob, subdata, datatype);
+	
 	return cob;
 }
 
-/* cleanup after constraint evaluation */
-void BKE_constraints_clear_evalob(bConstraintOb *cob)
+/* copy result of constraint evaluation back to the owner, does not free cob */
+void BKE_constraints_evalob_apply(bConstraintOb *cob)
 {
 	float delta[4][4], imat[4][4];
 	
@@ -240,6 +249,16 @@ void BKE_constraints_clear_evalob(bConstraintOb *cob)
 			break;
 		}
 	}
+}
+
+/* cleanup after constraint evaluation */
+void BKE_constraints_clear_evalob(bConstraintOb *cob)
+{
+	/* prevent crashes */
+	if (cob == NULL) 
+		return;
+	
+	BKE_constraints_evalob_apply(cob);
 	
 	/* free tempolary struct */
 	MEM_freeN(cob);
@@ -4957,8 +4976,9 @@ void BKE_constraint_targets_for_solving_get(bConstraint *con, bConstraintOb *cob
 /* This function is called whenever constraints need to be evaluated. Currently, all
  * constraints that can be evaluated are every time this gets run.
  *
- * BKE_constraints_make_evalob and BKE_constraints_clear_evalob should be called before and 
- * after running this function, to sort out cob
+ * BKE_constraints_make_evalob and BKE_constraints_clear_evalob (or BKE_constraints_evalob_init
+ * and BKE_constraints_evalob_apply) should be called before and after running this function,
+ * to sort out cob
  */
 void BKE_constraints_solve(ListBase *conlist, bConstraintOb *cob, float ctime)
 {
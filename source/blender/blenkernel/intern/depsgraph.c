@@ -1727,6 +1727,19 @@ void DAG_relations_tag_update(Main *bmain)
 	}
 }
 
+/* tag relations of the given ID for update */
+void DAG_id_relations_tag_update(Main *bmain, ID *id)
+{
+	if (DEG_depsgraph_use_legacy()) {
+		/* Old dependency graph can only be rebuilt entirely. */
+		DAG_relations_tag_update(bmain);
+	}
+	else {
+		/* New dependency graph. */
+		DEG_id_tag_relations_update(bmain, id);
+	}
+}
+
 /* rebuild dependency graph only for a given scene */
 void DAG_scene_relations_rebuild(Main *bmain, Scene *sce)
 {
@@ -3621,6 +3634,12 @@ void DAG_relations_tag_update(Main *bmain)
 	DEG_relations_tag_update(bmain);
 }
 
+/* Tag relations of the given ID for update. */
+void DAG_id_relations_tag_update(Main *bmain, ID *id)
+{
+	DEG_id_tag_relations_update(bmain, id);
+}
+
 /* Rebuild dependency graph only for a given scene. */
 void DAG_scene_relations_rebuild(Main *bmain, Scene *scene)
 {
@@ -1818,8 +1818,15 @@ void BKE_keyblock_mesh_calc_normals(
 		r_polynors = MEM_mallocN(sizeof(float[3]) * me.totpoly, __func__);
 		free_polynors = true;
 	}
-	BKE_mesh_calc_normals_poly(
-	            me.mvert, r_vertnors, me.totvert, me.mloop, me.mpoly, me.totloop, me.totpoly, r_polynors, false);
+	if (r_loopnors == NULL && r_vertnors != NULL) {
+		/* Short normals of the temp vertices are only needed for loop normals. */
+		BKE_mesh_calc_normals_poly_float(
+		            me.mvert, r_vertnors, me.totvert, me.mloop, me.mpoly, me.totloop, me.totpoly, r_polynors);
+	}
+	else {
+		BKE_mesh_calc_normals_poly(
+		            me.mvert, r_vertnors, me.totvert, me.mloop, me.mpoly, me.totloop, me.totpoly, r_polynors, false);
+	}
 
 	if (r_loopnors) {
 		short (*clnors)[2] = CustomData_get_layer(&mesh->ldata, CD_CUSTOMLOOPNORMAL);  /* May be NULL. */
@@ -171,9 +171,13 @@ void BKE_mesh_calc_normals_mapping_ex(
 typedef struct MeshCalcNormalsData {
 	const MPoly *mpolys;
 	const MLoop *mloop;
-	MVert *mverts;
+	const MVert *mverts;
 	float (*pnors)[3];
 	float (*vnors)[3];
+	/* When set, vertex normals are also written here (as shorts). */
+	MVert *mverts_dst;
+	/* Only accumulate with atomics when other threads may write to the same vertex. */
+	bool use_threading;
 } MeshCalcNormalsData;
 
 static void mesh_calc_normals_poly_task_cb(void *userdata, const int pidx)
@@ -237,8 +241,13 @@ static void mesh_calc_normals_poly_accum_task_cb(void *userdata, const int pidx)
 			const float fac = saacos(-dot_v3v3(cur_edge, prev_edge));
 
 			/* accumulate */
-			for (int k = 3; k--; ) {
-				atomic_add_and_fetch_fl(&vnors[ml[i].v][k], pnor[k] * fac);
+			if (data->use_threading) {
+				for (int k = 3; k--; ) {
+					atomic_add_and_fetch_fl(&vnors[ml[i].v][k], pnor[k] * fac);
+				}
+			}
+			else {
+				madd_v3_v3fl(vnors[ml[i].v], pnor, fac);
 			}
 			prev_edge = cur_edge;
 		}
@@ -246,28 +255,31 @@ static void mesh_calc_normals_poly_accum_task_cb(void *userdata, const int pidx)
 
 }
 
-void BKE_mesh_calc_normals_poly(
-        MVert *mverts, float (*r_vertnors)[3], int numVerts,
-        const MLoop *mloop, const MPoly *mpolys,
-        int UNUSED(numLoops), int numPolys, float (*r_polynors)[3],
-        const bool only_face_normals)
+static void mesh_calc_normals_poly_finalize_task_cb(void *userdata, const int vidx)
 {
-	float (*pnors)[3] = r_polynors;
-	float (*vnors)[3] = r_vertnors;
-	bool free_vnors = false;
-	int i;
-
-	if (only_face_normals) {
-		BLI_assert((pnors != NULL) || (numPolys == 0));
-		BLI_assert(r_vertnors == NULL);
+	MeshCalcNormalsData *data = userdata;
+	float *no = data->vnors[vidx];
 
-		MeshCalcNormalsData data = {
-		    .mpolys = mpolys, .mloop = mloop, .mverts = mverts, .pnors = pnors,
-		};
+	if (UNLIKELY(normalize_v3(no) == 0.0f)) {
+		/* following Mesh convention; we use vertex coordinate itself for normal in this case */
+		normalize_v3_v3(no, data->mverts[vidx].co);
+	}
 
-		BLI_task_parallel_range(0, numPolys, &data, mesh_calc_normals_poly_task_cb, (numPolys > BKE_MESH_OMP_LIMIT));
-		return;
+	if (data->mverts_dst) {
+		normal_float_to_short_v3(data->mverts_dst[vidx].no, no);
 	}
+}
+
+/**
+ * Calculate polygon and vertex normals, the vertex normals are always written as floats,
+ * \a r_mverts is optional, when set the normals are also stored in #MVert.no.
+ */
+static void mesh_calc_normals_poly_and_vert(
+        const MVert *mverts, MVert *r_mverts, float (*r_vertnors)[3], int numVerts,
+        const MLoop *mloop, const MPoly *mpolys, int numPolys, float (*r_polynors)[3])
+{
+	float (*vnors)[3] = r_vertnors;
+	bool free_vnors = false;
 
 	/* first go through and calculate normals for all the polys */
 	if (vnors == NULL) {
@@ -279,28 +291,57 @@ void BKE_mesh_calc_normals_poly(
 	}
 
 	MeshCalcNormalsData data = {
-	    .mpolys = mpolys, .mloop = mloop, .mverts = mverts, .pnors = pnors, .vnors = vnors,
+	    .mpolys = mpolys, .mloop = mloop, .mverts = mverts, .pnors = r_polynors, .vnors = vnors,
+	    .mverts_dst = r_mverts, .use_threading = (numPolys > BKE_MESH_OMP_LIMIT),
 	};
 
-	BLI_task_parallel_range(0, numPolys, &data, mesh_calc_normals_poly_accum_task_cb, (numPolys > BKE_MESH_OMP_LIMIT));
-
-	for (i = 0; i < numVerts; i++) {
-		MVert *mv = &mverts[i];
-		float *no = vnors[i];
-
-		if (UNLIKELY(normalize_v3(no) == 0.0f)) {
-			/* following Mesh convention; we use vertex coordinate itself for normal in this case */
-			normalize_v3_v3(no, mv->co);
-		}
+	BLI_task_parallel_range(0, numPolys, &data, mesh_calc_normals_poly_accum_task_cb, data.use_threading);
 
-		normal_float_to_short_v3(mv->no, no);
-	}
+	BLI_task_parallel_range(0, numVerts, &data, mesh_calc_normals_poly_finalize_task_cb, (numVerts > BKE_MESH_OMP_LIMIT));
 
 	if (free_vnors) {
 		MEM_freeN(vnors);
 	}
 }
 
+void BKE_mesh_calc_normals_poly(
+        MVert *mverts, float (*r_vertnors)[3], int numVerts,
+        const MLoop *mloop, const MPoly *mpolys,
+        int UNUSED(numLoops), int numPolys, float (*r_polynors)[3],
+        const bool only_face_normals)
+{
+	if (only_face_normals) {
+		BLI_assert((r_polynors != NULL) || (numPolys == 0));
+		BLI_assert(r_vertnors == NULL);
+
+		MeshCalcNormalsData data = {
+		    .mpolys = mpolys, .mloop = mloop, .mverts = mverts, .pnors = r_polynors,
+		};
+
+		BLI_task_parallel_range(0, numPolys, &data, mesh_calc_normals_poly_task_cb, (numPolys > BKE_MESH_OMP_LIMIT));
+		return;
+	}
+
+	mesh_calc_normals_poly_and_vert(mverts, mverts, r_vertnors, numVerts, mloop, mpolys, numPolys, r_polynors);
+}
+
+/**
+ * Calculate vertex normals (and optionally polygon normals) as floats,
+ * without writing them into #MVert.no, for callers which don't need the short normals.
+ *
+ * \param r_vertnors: Required, an array of vectors, same length as number of vertices.
+ * \param r_polynors: If non-NULL, an array of vectors, same length as number of polygons.
+ */
+void BKE_mesh_calc_normals_poly_float(
+        const MVert *mverts, float (*r_vertnors)[3], int numVerts,
+        const MLoop *mloop, const MPoly *mpolys,
+        int UNUSED(numLoops), int numPolys, float (*r_polynors)[3])
+{
+	BLI_assert((r_vertnors != NULL) || (numVerts == 0));
+
+	mesh_calc_normals_poly_and_vert(mverts, NULL, r_vertnors, numVerts, mloop, mpolys, numPolys, r_polynors);
+}
+
 void BKE_mesh_calc_normals(Mesh *mesh)
 {
 #ifdef DEBUG_TIME
@@ -1055,6 +1096,108 @@ static bool loop_split_generator_check_cyclic_smooth_fan(
 	}
 }
 
+/* Maximum number of loops walked around a vertex when classifying smooth fans in parallel,
+ * bigger fans are left to the serial check (see #loop_split_generator_check_cyclic_smooth_fan). */
+#define LOOP_SPLIT_FAN_WALK_MAX 64
+
+enum {
+	LOOP_SPLIT_FAN_SKIP     = 0,  /* Not the entry point of a cyclic smooth fan. */
+	LOOP_SPLIT_FAN_CYCLIC   = 1,  /* Entry point of a cyclic smooth fan. */
+	LOOP_SPLIT_FAN_DEFERRED = 2,  /* Fan too big to be walked here, needs the serial check. */
+};
+
+/* Whether loop \a a comes before loop \a b when iterating over polygons, then their loops. */
+BLI_INLINE bool loop_split_loop_is_before(const int *loop_to_poly, const int a, const int b)
+{
+	return (loop_to_poly[a] != loop_to_poly[b]) ? (loop_to_poly[a] < loop_to_poly[b]) : (a < b);
+}
+
+/* Thread-safe variant of #loop_split_generator_check_cyclic_smooth_fan, which doesn't need to know which
+ * loops were already walked: the entry point of a cyclic smooth fan is its first loop in iteration order,
+ * which is also the loop the serial check picks. */
+static char loop_split_generator_classify_cyclic_smooth_fan(
+        const MLoop *mloops, const MPoly *mpolys,
+        const int (*edge_to_loops)[2], const int *loop_to_poly, const int *e2l_prev,
+        const MLoop *ml_curr, const MLoop *ml_prev, const int ml_curr_index, const int ml_prev_index,
+        const int mp_curr_index)
+{
+	const unsigned int mv_pivot_index = ml_curr->v;  /* The vertex we are "fanning" around! */
+	const int *e2lfan_curr;
+	const MLoop *mlfan_curr;
+	/* mlfan_vert_index: the loop of our current edge might not be the loop of our current vertex! */
+	int mlfan_curr_index, mlfan_vert_index, mpfan_curr_index;
+	int i;
+
+	e2lfan_curr = e2l_prev;
+	if (IS_EDGE_SHARP(e2lfan_curr)) {
+		/* Sharp loop, so not a cyclic smooth fan... */
+		return LOOP_SPLIT_FAN_SKIP;
+	}
+
+	mlfan_curr = ml_prev;
+	mlfan_curr_index = ml_prev_index;
+	mlfan_vert_index = ml_curr_index;
+	mpfan_curr_index = mp_curr_index;
+
+	for (i = 0; i < LOOP_SPLIT_FAN_WALK_MAX; i++) {
+		/* Find next loop of the smooth fan. */
+		loop_manifold_fan_around_vert_next(
+		            mloops, mpolys, loop_to_poly, e2lfan_curr, mv_pivot_index,
+		            &mlfan_curr, &mlfan_curr_index, &mlfan_vert_index, &mpfan_curr_index);
+
+		e2lfan_curr = edge_to_loops[mlfan_curr->e];
+
+		if (IS_EDGE_SHARP(e2lfan_curr)) {
+			/* Sharp loop/edge, so not a cyclic smooth fan... */
+			return LOOP_SPLIT_FAN_SKIP;
+		}
+		else if (mlfan_vert_index == ml_curr_index) {
+			/* We walked around a whole cyclic smooth fan without finding any loop before this one. */
+			return LOOP_SPLIT_FAN_CYCLIC;
+		}
+		else if (loop_split_loop_is_before(loop_to_poly, mlfan_vert_index, ml_curr_index)) {
+			/* This fan has an earlier entry point. */
+			return LOOP_SPLIT_FAN_SKIP;
+		}
+	}
+
+	return LOOP_SPLIT_FAN_DEFERRED;
+}
+
+typedef struct LoopSplitClassifyData {
+	const LoopSplitTaskDataCommon *common_data;
+	char *loop_fan_types;
+} LoopSplitClassifyData;
+
+static void loop_split_generator_classify_task_cb(void *userdata, const int mp_index)
+{
+	LoopSplitClassifyData *data = userdata;
+	const LoopSplitTaskDataCommon *common_data = data->common_data;
+	char *loop_fan_types = data->loop_fan_types;
+
+	const MLoop *mloops = common_data->mloops;
+	const MPoly *mp = &common_data->mpolys[mp_index];
+	const int (*edge_to_loops)[2] = common_data->edge_to_loops;
+
+	const int ml_last_index = (mp->loopstart + mp->totloop) - 1;
+	int ml_curr_index = mp->loopstart;
+	int ml_prev_index = ml_last_index;
+
+	for (; ml_curr_index <= ml_last_index; ml_curr_index++) {
+		const MLoop *ml_curr = &mloops[ml_curr_index];
+		const MLoop *ml_prev = &mloops[ml_prev_index];
+
+		if (!IS_EDGE_SHARP(edge_to_loops[ml_curr->e])) {
+			loop_fan_types[ml_curr_index] = loop_split_generator_classify_cyclic_smooth_fan(
+			        mloops, common_data->mpolys, edge_to_loops, common_data->loop_to_poly,
+			        edge_to_loops[ml_prev->e],
+			        ml_curr, ml_prev, ml_curr_index, ml_prev_index, mp_index);
+		}
+
+		ml_prev_index = ml_curr_index;
+	}
+}
+
 static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common_data)
 {
 	MLoopNorSpaceArray *lnors_spacearr = common_data->lnors_spacearr;
@@ -1075,8 +1218,12 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
 	int ml_curr_index;
 	int ml_prev_index;
 
+	/* Only used by fans too big to be classified in parallel. */
 	BLI_bitmap *skip_loops = BLI_BITMAP_NEW(numLoops, __func__);
 
+	/* Which smooth loops start a cyclic fan, see #loop_split_generator_classify_task_cb. */
+	char *loop_fan_types = MEM_callocN(sizeof(*loop_fan_types) * (size_t)numLoops, __func__);
+
 	LoopSplitTaskData *data_buff = NULL;
 	int data_idx = 0;
 
@@ -1093,6 +1240,17 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
 		}
 	}
 
+	/* Finding the entry points of cyclic smooth fans is the costly part of the generator,
+	 * each fan is walked from its loops in parallel first. */
+	{
+		LoopSplitClassifyData data = {
+		    .common_data = common_data,
+		    .loop_fan_types = loop_fan_types,
+		};
+
+		BLI_task_parallel_range(0, numPolys, &data, loop_split_generator_classify_task_cb, (pool != NULL));
+	}
+
 	/* We now know edges that can be smoothed (with their vector, and their two loops), and edges that will be hard!
 	 * Now, time to generate the normals.
 	 */
@@ -1115,17 +1273,20 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
 
 			/* A smooth edge, we have to check for cyclic smooth fan case.
 			 * If we find a new, never-processed cyclic smooth fan, we can do it now using that loop/edge as
-			 * 'entry point', otherwise we can skip it. */
+			 * 'entry point', otherwise we can skip it.
+			 * This was already decided by the classification above, except for the biggest fans. */
 			/* Note: In theory, we could make loop_split_generator_check_cyclic_smooth_fan() store
 			 * mlfan_vert_index'es and edge indexes in two stacks, to avoid having to fan again around the vert during
 			 * actual computation of clnor & clnorspace. However, this would complicate the code, add more memory usage,
 			 * and despite its logical complexity, loop_manifold_fan_around_vert_next() is quite cheap in term of
 			 * CPU cycles, so really think it's not worth it. */
 			if (!IS_EDGE_SHARP(e2l_curr) &&
-			    (BLI_BITMAP_TEST(skip_loops, ml_curr_index) ||
-			     !loop_split_generator_check_cyclic_smooth_fan(
-			              mloops, mpolys, edge_to_loops, loop_to_poly, e2l_prev, skip_loops,
-			              ml_curr, ml_prev, ml_curr_index, ml_prev_index, mp_index)))
+			    ((loop_fan_types[ml_curr_index] == LOOP_SPLIT_FAN_SKIP) ||
+			     ((loop_fan_types[ml_curr_index] == LOOP_SPLIT_FAN_DEFERRED) &&
+			      (BLI_BITMAP_TEST(skip_loops, ml_curr_index) ||
+			       !loop_split_generator_check_cyclic_smooth_fan(
+			                mloops, mpolys, edge_to_loops, loop_to_poly, e2l_prev, skip_loops,
+			                ml_curr, ml_prev, ml_curr_index, ml_prev_index, mp_index)))))
 			{
 //				printf("SKIPPING!\n");
 			}
@@ -1208,12 +1369,84 @@ static void loop_split_generator(TaskPool *pool, LoopSplitTaskDataCommon *common
 		BLI_stack_free(edge_vectors);
 	}
 	MEM_freeN(skip_loops);
+	MEM_freeN(loop_fan_types);
 
 #ifdef DEBUG_TIME
 	TIMEIT_END_AVERAGED(loop_split_generator);
 #endif
 }
 
+typedef struct LoopSplitPrepareData {
+	const MVert *mverts;
+	const MEdge *medges;
+	const MLoop *mloops;
+	const MPoly *mpolys;
+	const float (*polynors)[3];
+
+	float (*loopnors)[3];
+	int (*edge_to_loops)[2];
+	int *loop_to_poly;
+
+	bool check_angle;
+	float split_angle;
+} LoopSplitPrepareData;
+
+static void loop_split_prepare_loops_task_cb(void *userdata, const int mp_index)
+{
+	LoopSplitPrepareData *data = userdata;
+	const MPoly *mp = &data->mpolys[mp_index];
+	const MLoop *ml_curr;
+	int ml_curr_index = mp->loopstart;
+	const int ml_last_index = (ml_curr_index + mp->totloop) - 1;
+
+	ml_curr = &data->mloops[ml_curr_index];
+
+	for (; ml_curr_index <= ml_last_index; ml_curr++, ml_curr_index++) {
+		data->loop_to_poly[ml_curr_index] = mp_index;
+
+		/* Pre-populate all loop normals as if their verts were all-smooth, this way we don't have to compute
+		 * those later!
+		 */
+		normal_short_to_float_v3(data->loopnors[ml_curr_index], data->mverts[ml_curr->v].no);
+	}
+}
+
+static void loop_split_prepare_edges_task_cb(void *userdata, const int me_index)
+{
+	LoopSplitPrepareData *data = userdata;
+	int *e2l = data->edge_to_loops[me_index];
+
+	if ((e2l[0] | e2l[1]) == 0) {
+		/* Loose edge. */
+		return;
+	}
+	else if (e2l[1] == INDEX_UNSET) {
+		/* Boundary edge, we have to check this here too, else we might miss some flat faces!!! */
+		if (!(data->mpolys[data->loop_to_poly[e2l[0]]].flag & ME_SMOOTH)) {
+			e2l[1] = INDEX_INVALID;
+		}
+	}
+	else if (!IS_EDGE_SHARP(e2l)) {
+		/* An edge is sharp if it is tagged as such, or one of its faces is not smooth,
+		 * or both poly have opposed (flipped) normals, i.e. both loops on the same edge share the same vertex,
+		 * or angle between both its polys' normals is above split_angle value.
+		 */
+		const int mp_index_a = data->loop_to_poly[e2l[0]];
+		const int mp_index_b = data->loop_to_poly[e2l[1]];
+
+		if (!(data->mpolys[mp_index_a].flag & ME_SMOOTH) || !(data->mpolys[mp_index_b].flag & ME_SMOOTH) ||
+		    (data->medges[me_index].flag & ME_SHARP) ||
+		    data->mloops[e2l[0]].v == data->mloops[e2l[1]].v ||
+		    (data->check_angle &&
+		     dot_v3v3(data->polynors[mp_index_a], data->polynors[mp_index_b]) < data->split_angle))
+		{
+			/* Note: we are sure that loop != 0 here ;) */
+			e2l[1] = INDEX_INVALID;
+		}
+	}
+	/* Else, more than two loops use this edge, it's already sharp. */
+}
+
 /**
  * Compute split normals, i.e. vertex normals associated with each poly (hence 'loop normals').
  * Useful to materialize sharp edges (or non-smooth faces) without actually modifying the geometry (splitting edges).
@@ -1295,55 +1528,48 @@ void BKE_mesh_normals_loop_split(
 		BKE_lnor_spacearr_init(r_lnors_spacearr, numLoops);
 	}
 
-	/* This first loop check which edges are actually smooth, and compute edge vectors. */
-	for (mp = mpolys, mp_index = 0; mp_index < numPolys; mp++, mp_index++) {
-		MLoop *ml_curr;
-		int *e2l;
-		int ml_curr_index = mp->loopstart;
-		const int ml_last_index = (ml_curr_index + mp->totloop) - 1;
+	/* This first part checks which edges are actually smooth. */
+	{
+		LoopSplitPrepareData data = {
+		    .mverts = mverts, .medges = medges, .mloops = mloops, .mpolys = mpolys, .polynors = polynors,
+		    .loopnors = r_loopnors, .edge_to_loops = edge_to_loops, .loop_to_poly = loop_to_poly,
+		    .check_angle = check_angle, .split_angle = split_angle,
+		};
 
-		ml_curr = &mloops[ml_curr_index];
+		BLI_task_parallel_range(
+		        0, numPolys, &data, loop_split_prepare_loops_task_cb, (numPolys > BKE_MESH_OMP_LIMIT));
 
-		for (; ml_curr_index <= ml_last_index; ml_curr++, ml_curr_index++) {
-			e2l = edge_to_loops[ml_curr->e];
+		/* Store the (up to two) loops using each edge, this has to follow the order of loops. */
+		for (mp = mpolys, mp_index = 0; mp_index < numPolys; mp++, mp_index++) {
+			const MLoop *ml_curr;
+			int *e2l;
+			int ml_curr_index = mp->loopstart;
+			const int ml_last_index = (ml_curr_index + mp->totloop) - 1;
 
-			loop_to_poly[ml_curr_index] = mp_index;
+			ml_curr = &mloops[ml_curr_index];
 
-			/* Pre-populate all loop normals as if their verts were all-smooth, this way we don't have to compute
-			 * those later!
-			 */
-			normal_short_to_float_v3(r_loopnors[ml_curr_index], mverts[ml_curr->v].no);
-
-			/* Check whether current edge might be smooth or sharp */
-			if ((e2l[0] | e2l[1]) == 0) {
-				/* 'Empty' edge until now, set e2l[0] (and e2l[1] to INDEX_UNSET to tag it as unset). */
-				e2l[0] = ml_curr_index;
-				/* We have to check this here too, else we might miss some flat faces!!! */
-				e2l[1] = (mp->flag & ME_SMOOTH) ? INDEX_UNSET : INDEX_INVALID;
-			}
-			else if (e2l[1] == INDEX_UNSET) {
-				/* Second loop using this edge, time to test its sharpness.
-				 * An edge is sharp if it is tagged as such, or its face is not smooth,
-				 * or both poly have opposed (flipped) normals, i.e. both loops on the same edge share the same vertex,
-				 * or angle between both its polys' normals is above split_angle value.
-				 */
-				if (!(mp->flag & ME_SMOOTH) || (medges[ml_curr->e].flag & ME_SHARP) ||
-				    ml_curr->v == mloops[e2l[0]].v ||
-				    (check_angle && dot_v3v3(polynors[loop_to_poly[e2l[0]]], polynors[mp_index]) < split_angle))
-				{
-					/* Note: we are sure that loop != 0 here ;) */
-					e2l[1] = INDEX_INVALID;
+			for (; ml_curr_index <= ml_last_index; ml_curr++, ml_curr_index++) {
+				e2l = edge_to_loops[ml_curr->e];
+
+				if ((e2l[0] | e2l[1]) == 0) {
+					/* 'Empty' edge until now, set e2l[0] (and e2l[1] to INDEX_UNSET to tag it as unset). */
+					e2l[0] = ml_curr_index;
+					e2l[1] = INDEX_UNSET;
 				}
-				else {
+				else if (e2l[1] == INDEX_UNSET) {
+					/* Second loop using this edge, its sharpness is tested below. */
 					e2l[1] = ml_curr_index;
 				}
+				else if (!IS_EDGE_SHARP(e2l)) {
+					/* More than two loops using this edge, tag as sharp if not yet done. */
+					e2l[1] = INDEX_INVALID;
+				}
+				/* Else, edge is already 'disqualified' (i.e. sharp)! */
 			}
-			else if (!IS_EDGE_SHARP(e2l)) {
-				/* More than two loops using this edge, tag as sharp if not yet done. */
-				e2l[1] = INDEX_INVALID;
-			}
-			/* Else, edge is already 'disqualified' (i.e. sharp)! */
 		}
+
+		BLI_task_parallel_range(
+		        0, numEdges, &data, loop_split_prepare_edges_task_cb, (numEdges > BKE_MESH_OMP_LIMIT));
 	}
 
 	/* Init data common to all tasks. */
@@ -2782,131 +3008,273 @@ int BKE_mesh_recalc_tessellation(
 }
 
 /**
- * Calculate tessellation into #MLoopTri which exist only for this purpose.
+ * Calculate the 2D projection used to fill an ngon,
+ * the normal is flipped to get a positive 2d cross product.
  */
-void BKE_mesh_recalc_looptri(
-        const MLoop *mloop, const MPoly *mpoly,
-        const MVert *mvert,
-        int totloop, int totpoly,
-        MLoopTri *mlooptri)
-{
-	/* use this to avoid locking pthread for _every_ polygon
-	 * and calling the fill function */
+static void mesh_calc_ngon_axis_mat(
+        const MLoop *mloop, const MPoly *mp, const MVert *mvert,
+        float r_axis_mat[3][3])
+{
+	const unsigned int mp_totloop = (unsigned int)mp->totloop;
+	const MLoop *ml = mloop + mp->loopstart;
+	const float *co_curr, *co_prev;
+	float normal[3];
+	unsigned int j;
 
-#define USE_TESSFACE_SPEEDUP
+	zero_v3(normal);
 
-	const MPoly *mp;
+	co_prev = mvert[ml[mp_totloop - 1].v].co;
+	for (j = 0; j < mp_totloop; j++, ml++) {
+		co_curr = mvert[ml->v].co;
+		add_newell_cross_v3_v3v3(normal, co_prev, co_curr);
+		co_prev = co_curr;
+	}
+	if (UNLIKELY(normalize_v3(normal) == 0.0f)) {
+		normal[2] = 1.0f;
+	}
+
+	axis_dominant_v3_to_m3_negate(r_axis_mat, normal);
+}
+
+static void mesh_calc_looptri_ngon(
+        const MLoop *mloop, const MPoly *mp, const MVert *mvert, const unsigned int poly_index,
+        MLoopTri *mlt, MemArena *arena)
+{
+	const unsigned int mp_loopstart = (unsigned int)mp->loopstart;
+	const unsigned int mp_totloop = (unsigned int)mp->totloop;
+	const unsigned int totfilltri = mp_totloop - 2;
 	const MLoop *ml;
-	MLoopTri *mlt;
-	MemArena *arena = NULL;
-	int poly_index, mlooptri_index;
+	float axis_mat[3][3];
+	float (*projverts)[2];
+	unsigned int (*tris)[3];
 	unsigned int j;
 
-	mlooptri_index = 0;
-	mp = mpoly;
-	for (poly_index = 0; poly_index < totpoly; poly_index++, mp++) {
-		const unsigned int mp_loopstart = (unsigned int)mp->loopstart;
-		const unsigned int mp_totloop = (unsigned int)mp->totloop;
-		unsigned int l1, l2, l3;
-		if (mp_totloop < 3) {
-			/* do nothing */
-		}
-
-#ifdef USE_TESSFACE_SPEEDUP
+	tris = BLI_memarena_alloc(arena, sizeof(*tris) * (size_t)totfilltri);
+	projverts = BLI_memarena_alloc(arena, sizeof(*projverts) * (size_t)mp_totloop);
 
-#define ML_TO_MLT(i1, i2, i3)  { \
-			mlt = &mlooptri[mlooptri_index]; \
-			l1 = mp_loopstart + i1; \
-			l2 = mp_loopstart + i2; \
-			l3 = mp_loopstart + i3; \
-			ARRAY_SET_ITEMS(mlt->tri, l1, l2, l3); \
-			mlt->poly = (unsigned int)poly_index; \
-		} ((void)0)
+	/* project verts to 2d */
+	mesh_calc_ngon_axis_mat(mloop, mp, mvert, axis_mat);
 
-		else if (mp_totloop == 3) {
-			ML_TO_MLT(0, 1, 2);
-			mlooptri_index++;
-		}
-		else if (mp_totloop == 4) {
-			ML_TO_MLT(0, 1, 2);
-			mlooptri_index++;
-			ML_TO_MLT(0, 2, 3);
-			mlooptri_index++;
-		}
-#endif /* USE_TESSFACE_SPEEDUP */
-		else {
-			const float *co_curr, *co_prev;
+	ml = mloop + mp_loopstart;
+	for (j = 0; j < mp_totloop; j++, ml++) {
+		mul_v2_m3v3(projverts[j], axis_mat, mvert[ml->v].co);
+	}
 
-			float normal[3];
+	BLI_polyfill_calc_arena((const float (*)[2])projverts, mp_totloop, 1, tris, arena);
 
-			float axis_mat[3][3];
-			float (*projverts)[2];
-			unsigned int (*tris)[3];
+	/* apply fill */
+	for (j = 0; j < totfilltri; j++, mlt++) {
+		const unsigned int *tri = tris[j];
 
-			const unsigned int totfilltri = mp_totloop - 2;
+		ARRAY_SET_ITEMS(mlt->tri, mp_loopstart + tri[0], mp_loopstart + tri[1], mp_loopstart + tri[2]);
+		mlt->poly = poly_index;
+	}
 
-			if (UNLIKELY(arena == NULL)) {
-				arena = BLI_memarena_new(BLI_MEMARENA_STD_BUFSIZE, __func__);
-			}
+	BLI_memarena_clear(arena);
+}
 
-			tris = BLI_memarena_alloc(arena, sizeof(*tris) * (size_t)totfilltri);
-			projverts = BLI_memarena_alloc(arena, sizeof(*projverts) * (size_t)mp_totloop);
+/**
+ * Check the (previously calculated) triangles of an ngon are still a valid fill of it:
+ * they must all use its loops, keep its winding and add up to its area.
+ *
+ * This only fails when the ngon was deformed enough to fold its existing fill,
+ * in that case it has to be calculated again.
+ */
+static bool mesh_looptri_ngon_is_valid(
+        const MLoop *mloop, const MPoly *mp, const MVert *mvert, const unsigned int poly_index,
+        const MLoopTri *mlt)
+{
+	const unsigned int mp_loopstart = (unsigned int)mp->loopstart;
+	const unsigned int mp_totloop = (unsigned int)mp->totloop;
+	const unsigned int totfilltri = mp_totloop - 2;
+	const MLoop *ml;
+	float axis_mat[3][3];
+	float co_first[2], co_prev[2], co_curr[2];
+	float area_poly = 0.0f, area_tris = 0.0f;
+	unsigned int j;
 
-			zero_v3(normal);
+	mesh_calc_ngon_axis_mat(mloop, mp, mvert, axis_mat);
 
-			/* calc normal, flipped: to get a positive 2d cross product */
-			ml = mloop + mp_loopstart;
-			co_prev = mvert[ml[mp_totloop - 1].v].co;
-			for (j = 0; j < mp_totloop; j++, ml++) {
-				co_curr = mvert[ml->v].co;
-				add_newell_cross_v3_v3v3(normal, co_prev, co_curr);
-				co_prev = co_curr;
-			}
-			if (UNLIKELY(normalize_v3(normal) == 0.0f)) {
-				normal[2] = 1.0f;
-			}
+	for (j = 0; j < totfilltri; j++, mlt++) {
+		float tri_co[3][2];
+		float area;
+		int k;
 
-			/* project verts to 2d */
-			axis_dominant_v3_to_m3_negate(axis_mat, normal);
+		if (mlt->poly != poly_index) {
+			return false;
+		}
 
-			ml = mloop + mp_loopstart;
-			for (j = 0; j < mp_totloop; j++, ml++) {
-				mul_v2_m3v3(projverts[j], axis_mat, mvert[ml->v].co);
+		for (k = 0; k < 3; k++) {
+			if ((mlt->tri[k] < mp_loopstart) || (mlt->tri[k] >= mp_loopstart + mp_totloop)) {
+				return false;
 			}
+			mul_v2_m3v3(tri_co[k], axis_mat, mvert[mloop[mlt->tri[k]].v].co);
+		}
 
-			BLI_polyfill_calc_arena((const float (*)[2])projverts, mp_totloop, 1, tris, arena);
+		area = cross_tri_v2(UNPACK3(tri_co));
+		if (area < 0.0f) {
+			return false;
+		}
+		area_tris += area;
+	}
 
-			/* apply fill */
-			for (j = 0; j < totfilltri; j++) {
-				unsigned int *tri = tris[j];
+	/* shoelace formula, without storing the projected coords */
+	ml = mloop + mp_loopstart;
+	mul_v2_m3v3(co_first, axis_mat, mvert[ml->v].co);
+	copy_v2_v2(co_prev, co_first);
+	for (j = 1, ml++; j < mp_totloop; j++, ml++) {
+		mul_v2_m3v3(co_curr, axis_mat, mvert[ml->v].co);
+		area_poly += cross_v2v2(co_prev, co_curr);
+		copy_v2_v2(co_prev, co_curr);
+	}
+	area_poly += cross_v2v2(co_prev, co_first);
 
-				mlt = &mlooptri[mlooptri_index];
+	return fabsf(area_tris - area_poly) <= (fabsf(area_poly) * 1e-4f) + FLT_EPSILON;
+}
 
-				/* set loop indices, transformed to vert indices later */
-				l1 = mp_loopstart + tri[0];
-				l2 = mp_loopstart + tri[1];
-				l3 = mp_loopstart + tri[2];
+typedef struct LoopTriTaskData {
+	const MLoop *mloop;
+	const MPoly *mpoly;
+	const MVert *mvert;
+	MLoopTri *mlooptri;
+	/* index of the first triangle of each polygon */
+	const unsigned int *poly_looptri_index;
+	bool use_refit;
+} LoopTriTaskData;
+
+typedef struct LoopTriTaskChunk {
+	/* only allocated when ngons are found */
+	MemArena *arena;
+} LoopTriTaskChunk;
+
+static void mesh_recalc_looptri_task_cb(void *userdata, void *userdata_chunk, const int poly_index, const int UNUSED(thread_id))
+{
+	LoopTriTaskData *data = userdata;
+	LoopTriTaskChunk *chunk = userdata_chunk;
+	const MPoly *mp = &data->mpoly[poly_index];
+	const unsigned int mp_loopstart = (unsigned int)mp->loopstart;
+	const unsigned int mp_totloop = (unsigned int)mp->totloop;
+	MLoopTri *mlt = &data->mlooptri[data->poly_looptri_index[poly_index]];
+
+	/* use this to avoid calling the fill function */
+#define USE_TESSFACE_SPEEDUP
 
-				ARRAY_SET_ITEMS(mlt->tri, l1, l2, l3);
-				mlt->poly = (unsigned int)poly_index;
+#define ML_TO_MLT(i1, i2, i3)  { \
+		ARRAY_SET_ITEMS(mlt->tri, mp_loopstart + i1, mp_loopstart + i2, mp_loopstart + i3); \
+		mlt->poly = (unsigned int)poly_index; \
+		mlt++; \
+	} ((void)0)
 
-				mlooptri_index++;
-			}
+	if (mp_totloop < 3) {
+		/* do nothing */
+	}
+#ifdef USE_TESSFACE_SPEEDUP
+	else if (mp_totloop == 3) {
+		ML_TO_MLT(0, 1, 2);
+	}
+	else if (mp_totloop == 4) {
+		ML_TO_MLT(0, 1, 2);
+		ML_TO_MLT(0, 2, 3);
+	}
+#endif /* USE_TESSFACE_SPEEDUP */
+	else {
+		if (data->use_refit &&
+		    mesh_looptri_ngon_is_valid(data->mloop, mp, data->mvert, (unsigned int)poly_index, mlt))
+		{
+			return;
+		}
 
-			BLI_memarena_clear(arena);
+		if (UNLIKELY(chunk->arena == NULL)) {
+			chunk->arena = BLI_memarena_new(BLI_MEMARENA_STD_BUFSIZE, __func__);
 		}
+
+		mesh_calc_looptri_ngon(data->mloop, mp, data->mvert, (unsigned int)poly_index, mlt, chunk->arena);
 	}
 
-	if (arena) {
-		BLI_memarena_free(arena);
-		arena = NULL;
+#undef USE_TESSFACE_SPEEDUP
+#undef ML_TO_MLT
+}
+
+static void mesh_recalc_looptri_task_finalize(void *UNUSED(userdata), void *userdata_chunk)
+{
+	LoopTriTaskChunk *chunk = userdata_chunk;
+
+	if (chunk->arena) {
+		BLI_memarena_free(chunk->arena);
+	}
+}
+
+static void mesh_recalc_looptri_ex(
+        const MLoop *mloop, const MPoly *mpoly,
+        const MVert *mvert,
+        int totloop, int totpoly,
+        MLoopTri *mlooptri, const bool use_refit)
+{
+	LoopTriTaskData data;
+	LoopTriTaskChunk chunk = {NULL};
+	unsigned int *poly_looptri_index;
+	unsigned int mlooptri_index;
+	int poly_index;
+
+	if (totpoly == 0) {
+		return;
+	}
+
+	/* polygons with less than 3 sides have no triangles */
+	poly_looptri_index = MEM_mallocN(sizeof(*poly_looptri_index) * (size_t)totpoly, __func__);
+	for (poly_index = 0, mlooptri_index = 0; poly_index < totpoly; poly_index++) {
+		const int mp_totloop = mpoly[poly_index].totloop;
+		poly_looptri_index[poly_index] = mlooptri_index;
+		if (mp_totloop >= 3) {
+			mlooptri_index += (unsigned int)(mp_totloop - 2);
+		}
 	}
 
-	BLI_assert(mlooptri_index == poly_to_tri_count(totpoly, totloop));
+	BLI_assert((int)mlooptri_index == poly_to_tri_count(totpoly, totloop));
 	UNUSED_VARS_NDEBUG(totloop);
 
-#undef USE_TESSFACE_SPEEDUP
-#undef ML_TO_MLT
+	data.mloop = mloop;
+	data.mpoly = mpoly;
+	data.mvert = mvert;
+	data.mlooptri = mlooptri;
+	data.poly_looptri_index = poly_looptri_index;
+	data.use_refit = use_refit;
+
+	BLI_task_parallel_range_finalize(
+	        0, totpoly, &data, &chunk, sizeof(chunk),
+	        mesh_recalc_looptri_task_cb, mesh_recalc_looptri_task_finalize,
+	        (totpoly > BKE_MESH_OMP_LIMIT), false);
+
+	MEM_freeN(poly_looptri_index);
+}
+
+/**
+ * Calculate tessellation into #MLoopTri which exist only for this purpose.
+ */
+void BKE_mesh_recalc_looptri(
+        const MLoop *mloop, const MPoly *mpoly,
+        const MVert *mvert,
+        int totloop, int totpoly,
+        MLoopTri *mlooptri)
+{
+	mesh_recalc_looptri_ex(mloop, mpoly, mvert, totloop, totpoly, mlooptri, false);
+}
+
+/**
+ * Update \a mlooptri, calculated for a mesh with the same number of polygons & loops,
+ * typically the same topology with different vertex coordinates.
+ *
+ * Triangles and quads don't depend on the coordinates, they are set directly,
+ * the fill of ngons is kept as long as it's still valid (see #mesh_looptri_ngon_is_valid),
+ * so only ngons which were folded by a deformation are calculated again.
+ */
+void BKE_mesh_recalc_looptri_refit(
+        const MLoop *mloop, const MPoly *mpoly,
+        const MVert *mvert,
+        int totloop, int totpoly,
+        MLoopTri *mlooptri)
+{
+	mesh_recalc_looptri_ex(mloop, mpoly, mvert, totloop, totpoly, mlooptri, true);
 }
 
 /* -------------------------------------------------------------------- */
@@ -36,13 +36,17 @@
 #include "BLI_utildefines.h"
 #include "BLI_bitmap.h"
 #include "BLI_math.h"
+#include "BLI_task.h"
 
+#include "BKE_mesh.h"
 #include "BKE_mesh_mapping.h"
 #include "BKE_customdata.h"
 #include "BLI_memarena.h"
 
 #include "BLI_strict_flags.h"
 
+#include "atomic_ops.h"
+
 
 /* -------------------------------------------------------------------- */
 
@@ -188,6 +192,112 @@ void BKE_mesh_uv_vert_map_free(UvVertMap *vmap)
 	}
 }
 
+/* -------------------------------------------------------------------- */
+/* Threaded map creation.
+ *
+ * Users are counted and added with atomics, the indices of each element are then sorted,
+ * so the maps match the ones created on a single thread. */
+
+typedef struct MeshElemMapThreadData {
+	MeshElemMap *map;
+	const MEdge *medge;
+	const MPoly *mpoly;
+	const MLoop *mloop;
+	/* Key polys by their edges instead of their vertices. */
+	bool use_edges;
+	/* Fill the indices, otherwise only count the users. */
+	bool do_fill;
+} MeshElemMapThreadData;
+
+BLI_INLINE void mesh_elem_map_add_user(
+        MeshElemMap *map, const unsigned int key, const int index, const bool do_fill)
+{
+	if (do_fill) {
+		const int slot = (int)atomic_fetch_and_add_uint32((uint32_t *)&map[key].count, 1);
+		map[key].indices[slot] = index;
+	}
+	else {
+		atomic_add_and_fetch_uint32((uint32_t *)&map[key].count, 1);
+	}
+}
+
+static void mesh_vert_edge_map_task_cb(void *userdata, const int i)
+{
+	MeshElemMapThreadData *data = userdata;
+	const MEdge *me = &data->medge[i];
+
+	mesh_elem_map_add_user(data->map, me->v1, i, data->do_fill);
+	mesh_elem_map_add_user(data->map, me->v2, i, data->do_fill);
+}
+
+static void mesh_poly_map_task_cb(void *userdata, const int i)
+{
+	MeshElemMapThreadData *data = userdata;
+	const MPoly *mp = &data->mpoly[i];
+	const MLoop *ml = &data->mloop[mp->loopstart];
+	int j;
+
+	for (j = 0; j < mp->totloop; j++, ml++) {
+		mesh_elem_map_add_user(data->map, data->use_edges ? ml->e : ml->v, i, data->do_fill);
+	}
+}
+
+static int mesh_elem_map_cmp_index(const void *a_v, const void *b_v)
+{
+	const int a = *(const int *)a_v, b = *(const int *)b_v;
+	return (a > b) - (a < b);
+}
+
+static void mesh_elem_map_sort_task_cb(void *userdata, const int i)
+{
+	MeshElemMapThreadData *data = userdata;
+	int *indices = data->map[i].indices;
+	const int count = data->map[i].count;
+
+	if (count > 16) {
+		qsort(indices, (size_t)count, sizeof(*indices), mesh_elem_map_cmp_index);
+	}
+	else {
+		/* Insertion sort, most elements only have a few users. */
+		int j, k;
+		for (j = 1; j < count; j++) {
+			const int index = indices[j];
+			for (k = j; (k > 0) && (indices[k - 1] > index); k--) {
+				indices[k] = indices[k - 1];
+			}
+			indices[k] = index;
+		}
+	}
+}
+
+static void mesh_elem_map_create_threaded(
+        MeshElemMapThreadData *data, TaskParallelRangeFunc func,
+        const int totelem, const int totuser, int *indices)
+{
+	MeshElemMap *map = data->map;
+	int *index_iter = indices;
+	int i;
+
+	/* Count number of users for each element */
+	data->do_fill = false;
+	BLI_task_parallel_range(0, totuser, data, func, true);
+
+	/* Assign indices mem */
+	for (i = 0; i < totelem; i++) {
+		map[i].indices = index_iter;
+		index_iter += map[i].count;
+
+		/* Reset 'count' for use as index when filling */
+		map[i].count = 0;
+	}
+
+	/* Find the users */
+	data->do_fill = true;
+	BLI_task_parallel_range(0, totuser, data, func, true);
+
+	BLI_task_parallel_range(0, totelem, data, mesh_elem_map_sort_task_cb, (totelem > BKE_MESH_OMP_LIMIT));
+}
+
 /**
  * Generates a map where the key is the vertex and the value is a list
  * of polys or loops that use that vertex as a corner. The lists are allocated
@@ -206,6 +316,17 @@ static void mesh_vert_poly_or_loop_map_create(
 
 	indices = index_iter = MEM_mallocN(sizeof(int) * (size_t)totloop, __func__);
 
+	/* Loops are added in the order of their polys, which sorting wouldn't give back. */
+	if (!do_loops && (totpoly > BKE_MESH_OMP_LIMIT)) {
+		MeshElemMapThreadData data = {.map = map, .mpoly = mpoly, .mloop = mloop};
+
+		mesh_elem_map_create_threaded(&data, mesh_poly_map_task_cb, totvert, totpoly, indices);
+
+		*r_map = map;
+		*r_mem = indices;
+		return;
+	}
+
 	/* Count number of polys for each vertex */
 	for (i = 0; i < totpoly; i++) {
 		const MPoly *p = &mpoly[i];
@@ -319,6 +440,16 @@ void BKE_mesh_vert_edge_map_create(MeshElemMap **r_map, int **r_mem,
 
 	int i;
 
+	if (totedge > BKE_MESH_OMP_LIMIT) {
+		MeshElemMapThreadData data = {.map = map, .medge = medge};
+
+		mesh_elem_map_create_threaded(&data, mesh_vert_edge_map_task_cb, totvert, totedge, indices);
+
+		*r_map = map;
+		*r_mem = indices;
+		return;
+	}
+
 	/* Count number of edges for each vertex */
 	for (i = 0; i < totedge; i++) {
 		map[medge[i].v1].count++;
@@ -461,6 +592,16 @@ void BKE_mesh_edge_poly_map_create(MeshElemMap **r_map, int **r_mem,
 	const MPoly *mp;
 	int i;
 
+	if (totpoly > BKE_MESH_OMP_LIMIT) {
+		MeshElemMapThreadData data = {.map = map, .mpoly = mpoly, .mloop = mloop, .use_edges = true};
+
+		mesh_elem_map_create_threaded(&data, mesh_poly_map_task_cb, totedge, totpoly, indices);
+
+		*r_map = map;
+		*r_mem = indices;
+		return;
+	}
+
 	/* count face users */
 	for (i = 0, mp = mpoly; i < totpoly; mp++, i++) {
 		const MLoop *ml;
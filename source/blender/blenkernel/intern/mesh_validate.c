@@ -41,6 +41,7 @@
 #include "BLI_edgehash.h"
 #include "BLI_math_base.h"
 #include "BLI_math_vector.h"
+#include "BLI_task.h"
 
 #include "BKE_deform.h"
 #include "BKE_depsgraph.h"
@@ -190,6 +191,116 @@ static int search_polyloop_cmp(const void *v1, const void *v2)
 	/* Else, sort on loopstart. */
 	return sp1->loopstart > sp2->loopstart ? 1 : sp1->loopstart < sp2->loopstart ? -1 : 0;
 }
+
+/* Sorted edge keys, replacing an EdgeHash for duplicate edges and edge lookups,
+ * which does not scale well on huge meshes. */
+typedef struct EdgeSortKey {
+	uint64_t key;  /* Lower vert index in the high bits. */
+	unsigned int index;
+} EdgeSortKey;
+
+BLI_INLINE uint64_t edge_sort_key(unsigned int v1, unsigned int v2)
+{
+	return (v1 < v2) ? (((uint64_t)v1 << 32) | v2) : (((uint64_t)v2 << 32) | v1);
+}
+
+/**
+ * Stable LSD radix sort, so edges sharing the same key stay ordered by index.
+ * Passes where all keys share the same byte are skipped.
+ */
+static void edge_sort_keys_radix_sort(EdgeSortKey *keys, EdgeSortKey *keys_tmp, const unsigned int keys_num)
+{
+	EdgeSortKey *src = keys, *dst = keys_tmp;
+	unsigned int count[256];
+	unsigned int i, shift;
+
+	for (shift = 0; shift < 64; shift += 8) {
+		unsigned int offset = 0;
+
+		memset(count, 0, sizeof(count));
+		for (i = 0; i < keys_num; i++) {
+			count[(src[i].key >> shift) & 0xff]++;
+		}
+		if (count[(src[0].key >> shift) & 0xff] == keys_num) {
+			continue;
+		}
+		for (i = 0; i < 256; i++) {
+			const unsigned int tot = count[i];
+			count[i] = offset;
+			offset += tot;
+		}
+		for (i = 0; i < keys_num; i++) {
+			dst[count[(src[i].key >> shift) & 0xff]++] = src[i];
+		}
+		SWAP(EdgeSortKey *, src, dst);
+	}
+
+	if (src != keys) {
+		memcpy(keys, src, sizeof(*keys) * keys_num);
+	}
+}
+
+/**
+ * \return the index of the first edge using given verts in sorted \a keys (one entry per key), or -1.
+ */
+static int edge_sort_keys_lookup(const EdgeSortKey *keys, const unsigned int keys_num,
+                                 const unsigned int v1, const unsigned int v2)
+{
+	const uint64_t key = edge_sort_key(v1, v2);
+	unsigned int lo = 0, hi = keys_num;
+
+	if (v1 == v2) {
+		return -1;
+	}
+	while (lo < hi) {
+		const unsigned int mid = lo + (hi - lo) / 2;
+		if (keys[mid].key < key) {
+			lo = mid + 1;
+		}
+		else {
+			hi = mid;
+		}
+	}
+	return (lo < keys_num && keys[lo].key == key) ? (int)keys[lo].index : -1;
+}
+
+enum {
+	VERT_CHECK_INVALID_CO  = (1 << 0),
+	VERT_CHECK_ZERO_NO     = (1 << 1),
+};
+
+typedef struct MeshValidateData {
+	const MVert *mverts;
+	const MEdge *medges;
+	char *vert_check;
+	EdgeSortKey *edge_keys;
+} MeshValidateData;
+
+/* Only flag vertices needing attention here, reports and fixes are done afterwards in index order,
+ * keeping the output the same whether threaded or not. */
+static void mesh_validate_verts_task_cb(void *userdata, const int i)
+{
+	MeshValidateData *data = userdata;
+	const MVert *mv = &data->mverts[i];
+	char check = 0;
+
+	if (!(isfinite(mv->co[0]) && isfinite(mv->co[1]) && isfinite(mv->co[2]))) {
+		check |= VERT_CHECK_INVALID_CO;
+	}
+	if (mv->no[0] == 0 && mv->no[1] == 0 && mv->no[2] == 0) {
+		check |= VERT_CHECK_ZERO_NO;
+	}
+	data->vert_check[i] = check;
+}
+
+static void mesh_validate_edge_keys_task_cb(void *userdata, const int i)
+{
+	MeshValidateData *data = userdata;
+	const MEdge *me = &data->medges[i];
+
+	data->edge_keys[i].key = edge_sort_key(me->v1, me->v2);
+	data->edge_keys[i].index = (unsigned int)i;
+}
 /** \} */
 
 
@@ -264,7 +375,12 @@ bool BKE_mesh_validate_arrays(Mesh *mesh,
 		int as_flag;
 	} recalc_flag;
 
-	EdgeHash *edge_hash = BLI_edgehash_new_ex(__func__, totedge);
+	MeshValidateData data = {NULL};
+	const bool use_threading = (totvert > BKE_MESH_OMP_LIMIT) || (totedge > BKE_MESH_OMP_LIMIT);
+	char *vert_check;
+	EdgeSortKey *edge_keys;
+	unsigned int edge_keys_num = 0;
+	int *edge_dup_of;
 
 	BLI_assert(!(do_fixes && mesh == NULL));
 
@@ -280,9 +396,54 @@ bool BKE_mesh_validate_arrays(Mesh *mesh,
 		recalc_flag.edges = do_fixes;
 	}
 
+	vert_check = MEM_mallocN(sizeof(*vert_check) * totvert, "mesh validate's vert_check");
+	edge_keys = MEM_mallocN(sizeof(*edge_keys) * totedge, "mesh validate's edge_keys");
+	edge_dup_of = MEM_mallocN(sizeof(*edge_dup_of) * totedge, "mesh validate's edge_dup_of");
+
+	data.mverts = mverts;
+	data.medges = medges;
+	data.vert_check = vert_check;
+	data.edge_keys = edge_keys;
+
+	BLI_task_parallel_range(0, (int)totvert, &data, mesh_validate_verts_task_cb, use_threading);
+	BLI_task_parallel_range(0, (int)totedge, &data, mesh_validate_edge_keys_task_cb, use_threading);
+
+	if (totedge != 0) {
+		EdgeSortKey *edge_keys_tmp = MEM_mallocN(sizeof(*edge_keys_tmp) * totedge, __func__);
+		edge_sort_keys_radix_sort(edge_keys, edge_keys_tmp, totedge);
+		MEM_freeN(edge_keys_tmp);
+	}
+
+	/* Find duplicate edges, and compact edge keys to one entry per used edge (its first occurrence).
+	 * Matching verts edges are never used, nor are out of range ones when fixing (they get removed). */
+	for (i = 0; i < totedge; ) {
+		const uint64_t key = edge_keys[i].key;
+		const unsigned int v_lo = (unsigned int)(key >> 32), v_hi = (unsigned int)(key & UINT_MAX);
+		const bool is_used = (v_lo != v_hi) && (!do_fixes || v_hi < totvert);
+		const unsigned int index_first = edge_keys[i].index;
+		unsigned int index_prev = index_first;
+
+		edge_dup_of[index_first] = -1;
+		for (i++; (i < totedge) && (edge_keys[i].key == key); i++) {
+			/* Without fixes all duplicates are kept, report the previous one. */
+			edge_dup_of[edge_keys[i].index] = is_used ? (int)(do_fixes ? index_first : index_prev) : -1;
+			index_prev = edge_keys[i].index;
+		}
+
+		if (is_used) {
+			edge_keys[edge_keys_num].key = key;
+			edge_keys[edge_keys_num].index = index_first;
+			edge_keys_num++;
+		}
+	}
+
 	for (i = 0; i < totvert; i++, mv++) {
 		bool fix_normal = true;
 
+		if (vert_check[i] == 0) {
+			continue;
+		}
+
 		for (j = 0; j < 3; j++) {
 			if (!isfinite(mv->co[j])) {
 				PRINT_ERR("\tVertex %u: has invalid coordinate\n", i);
@@ -323,22 +484,19 @@ bool BKE_mesh_validate_arrays(Mesh *mesh,
 			remove = do_fixes;
 		}
 
-		if ((me->v1 != me->v2) && BLI_edgehash_haskey(edge_hash, me->v1, me->v2)) {
-			PRINT_ERR("\tEdge %u: is a duplicate of %d\n", i,
-			          GET_INT_FROM_POINTER(BLI_edgehash_lookup(edge_hash, me->v1, me->v2)));
+		if ((me->v1 != me->v2) && (edge_dup_of[i] != -1)) {
+			PRINT_ERR("\tEdge %u: is a duplicate of %d\n", i, edge_dup_of[i]);
 			remove = do_fixes;
 		}
 
-		if (remove == false) {
-			if (me->v1 != me->v2) {
-				BLI_edgehash_insert(edge_hash, me->v1, me->v2, SET_INT_IN_POINTER(i));
-			}
-		}
-		else {
+		if (remove) {
 			REMOVE_EDGE_TAG(me);
 		}
 	}
 
+	MEM_freeN(vert_check);
+	MEM_freeN(edge_dup_of);
+
 	if (mfaces && !mpolys) {
 #		define REMOVE_FACE_TAG(_mf) { _mf->v3 = 0; free_flag.faces = do_fixes; } (void)0
 #		define CHECK_FACE_VERT_INDEX(a, b) \
@@ -347,7 +505,7 @@ bool BKE_mesh_validate_arrays(Mesh *mesh,
 						remove = do_fixes; \
 					} (void)0
 #		define CHECK_FACE_EDGE(a, b) \
-					if (!BLI_edgehash_haskey(edge_hash, mf->a, mf->b)) { \
+					if (edge_sort_keys_lookup(edge_keys, edge_keys_num, mf->a, mf->b) == -1) { \
 						PRINT_ERR("    face %u: edge " STRINGIFY(a) "/" STRINGIFY(b) \
 						          " (%u,%u) is missing edge data\n", i, mf->a, mf->b); \
 						recalc_flag.edges = do_fixes; \
@@ -495,8 +653,18 @@ bool BKE_mesh_validate_arrays(Mesh *mesh,
 	{
 		SortPoly *sort_polys = MEM_callocN(sizeof(SortPoly) * totpoly, "mesh validate's sort_polys");
 		SortPoly *prev_sp, *sp = sort_polys;
+		int *sort_polys_verts, *sp_verts;
+		size_t sort_polys_verts_len = 0;
 		int prev_end;
 
+		/* Single allocation for the vert indices of all polys, polys may share loops so don't use loop indices. */
+		for (i = 0, mp = mpolys; i < totpoly; i++, mp++) {
+			if (!(mp->loopstart < 0 || mp->totloop < 3) && !(mp->loopstart + mp->totloop > totloop)) {
+				sort_polys_verts_len += (size_t)mp->totloop;
+			}
+		}
+		sort_polys_verts = sp_verts = MEM_mallocN(sizeof(int) * sort_polys_verts_len, "Vert idx of SortPoly");
+
 		for (i = 0, mp = mpolys; i < totpoly; i++, mp++, sp++) {
 			sp->index = i;
 
@@ -515,8 +683,10 @@ bool BKE_mesh_validate_arrays(Mesh *mesh,
 			else {
 				/* Poly itself is valid, for now. */
 				int v1, v2; /* v1 is prev loop vert idx, v2 is current loop one. */
+				int e_found;
 				sp->invalid = false;
-				sp->verts = v = MEM_mallocN(sizeof(int) * mp->totloop, "Vert idx of SortPoly");
+				sp->verts = v = sp_verts;
+				sp_verts += mp->totloop;
 				sp->numverts = mp->totloop;
 				sp->loopstart = mp->loopstart;
 
@@ -552,7 +722,17 @@ bool BKE_mesh_validate_arrays(Mesh *mesh,
 				for (j = 0, ml = &mloops[sp->loopstart]; j < mp->totloop; j++, ml++) {
 					v1 = ml->v;
 					v2 = mloops[sp->loopstart + (j + 1) % mp->totloop].v;
-					if (!BLI_edgehash_haskey(edge_hash, v1, v2)) {
+
+					/* Common case, the edge is valid and no lookup is needed. */
+					if (ml->e < totedge) {
+						me = &medges[ml->e];
+						if (!IS_REMOVED_EDGE(me) && ((me->v1 == v1 && me->v2 == v2) || (me->v1 == v2 && me->v2 == v1))) {
+							continue;
+						}
+					}
+
+					e_found = edge_sort_keys_lookup(edge_keys, edge_keys_num, (unsigned int)v1, (unsigned int)v2);
+					if (e_found == -1) {
 						/* Edge not existing. */
 						PRINT_ERR("\tPoly %u needs missing edge (%d, %d)\n", sp->index, v1, v2);
 						if (do_fixes)
@@ -565,7 +745,7 @@ bool BKE_mesh_validate_arrays(Mesh *mesh,
 						 * We already know from previous text that a valid edge exists, use it (if allowed)! */
 						if (do_fixes) {
 							int prev_e = ml->e;
-							ml->e = GET_INT_FROM_POINTER(BLI_edgehash_lookup(edge_hash, v1, v2));
+							ml->e = (unsigned int)e_found;
 							fix_flag.loops_edge = true;
 							PRINT_ERR("\tLoop %u has invalid edge reference (%d), fixed using edge %u\n",
 							          sp->loopstart + j, prev_e, ml->e);
@@ -576,21 +756,19 @@ bool BKE_mesh_validate_arrays(Mesh *mesh,
 						}
 					}
 					else {
+						/* The pointed edge is invalid (tagged as removed, or vert idx mismatch),
+						 * and we already know from previous test that a valid one exists, use it (if allowed)! */
 						me = &medges[ml->e];
-						if (IS_REMOVED_EDGE(me) || !((me->v1 == v1 && me->v2 == v2) || (me->v1 == v2 && me->v2 == v1))) {
-							/* The pointed edge is invalid (tagged as removed, or vert idx mismatch),
-							 * and we already know from previous test that a valid one exists, use it (if allowed)! */
-							if (do_fixes) {
-								int prev_e = ml->e;
-								ml->e = GET_INT_FROM_POINTER(BLI_edgehash_lookup(edge_hash, v1, v2));
-								fix_flag.loops_edge = true;
-								PRINT_ERR("\tPoly %u has invalid edge reference (%d, is_removed: %d), fixed using edge %u\n",
-								          sp->index, prev_e, IS_REMOVED_EDGE(me), ml->e);
-							}
-							else {
-								PRINT_ERR("\tPoly %u has invalid edge reference (%u)\n", sp->index, ml->e);
-								sp->invalid = true;
-							}
+						if (do_fixes) {
+							int prev_e = ml->e;
+							ml->e = (unsigned int)e_found;
+							fix_flag.loops_edge = true;
+							PRINT_ERR("\tPoly %u has invalid edge reference (%d, is_removed: %d), fixed using edge %u\n",
+							          sp->index, prev_e, IS_REMOVED_EDGE(me), ml->e);
+						}
+						else {
+							PRINT_ERR("\tPoly %u has invalid edge reference (%u)\n", sp->index, ml->e);
+							sp->invalid = true;
 						}
 					}
 				}
@@ -698,10 +876,6 @@ bool BKE_mesh_validate_arrays(Mesh *mesh,
 		prev_sp = NULL;
 		prev_end = 0;
 		for (i = 0; i < totpoly; i++, sp++) {
-			/* Free this now, we don't need it anymore, and avoid us another loop! */
-			if (sp->verts)
-				MEM_freeN(sp->verts);
-
 			/* Note above prev_sp: in following code, we make sure it is always valid poly (or NULL). */
 			if (sp->invalid) {
 				if (do_fixes) {
@@ -752,10 +926,11 @@ bool BKE_mesh_validate_arrays(Mesh *mesh,
 			}
 		}
 
+		MEM_freeN(sort_polys_verts);
 		MEM_freeN(sort_polys);
 	}
 
-	BLI_edgehash_free(edge_hash, NULL);
+	MEM_freeN(edge_keys);
 
 	/* fix deform verts */
 	if (dverts) {
@@ -217,6 +217,7 @@ void BKE_object_free_modifiers(Object *ob)
 
 	/* modifiers may have stored data in the DM cache */
 	BKE_object_free_derived_caches(ob);
+	DM_modifier_prefix_cache_free(ob);
 }
 
 void BKE_object_modifier_hook_reset(Object *ob, HookModifierData *hmd)
@@ -396,6 +397,9 @@ void BKE_object_free_caches(Object *object)
 		}
 	}
 
+	/* Cached result of the leading modifiers is simply rebuilt on the next evaluation. */
+	DM_modifier_prefix_cache_free(object);
+
 	/* Tag object for update, so once memory critical operation is over and
 	 * scene update routines are back to it's business the object will be
 	 * guaranteed to be in a known state.
@@ -1167,6 +1171,7 @@ Object *BKE_object_copy_ex(Main *bmain, const Object *ob, bool copy_caches)
 	
 	obn->derivedDeform = NULL;
 	obn->derivedFinal = NULL;
+	obn->modifier_prefix_cache = NULL;
 
 	BLI_listbase_clear(&obn->gpulamp);
 	BLI_listbase_clear(&obn->pc_ids);
@@ -2091,10 +2096,10 @@ void BKE_object_where_is_calc_time_ex(Scene *scene, Object *ob, float ctime,
 	
 	/* solve constraints */
 	if (ob->constraints.first && !(ob->transflag & OB_NO_CONSTRAINTS)) {
-		bConstraintOb *cob;
-		cob = BKE_constraints_make_evalob(scene, ob, NULL, CONSTRAINT_OBTYPE_OBJECT);
-		BKE_constraints_solve(&ob->constraints, cob, ctime);
-		BKE_constraints_clear_evalob(cob);
+		bConstraintOb cob;
+		BKE_constraints_evalob_init(&cob, scene, ob, NULL, CONSTRAINT_OBTYPE_OBJECT);
+		BKE_constraints_solve(&ob->constraints, &cob, ctime);
+		BKE_constraints_evalob_apply(&cob);
 	}
 	
 	/* set negative scale flag in object */
@@ -117,7 +117,7 @@ void BKE_object_eval_constraints(EvaluationContext *UNUSED(eval_ctx),
                                  Scene *scene,
                                  Object *ob)
 {
-	bConstraintOb *cob;
+	bConstraintOb cob;
 	float ctime = BKE_scene_frame_get(scene);
 
 	DEBUG_PRINT("%s on %s\n", __func__, ob->id.name);
@@ -131,9 +131,9 @@ void BKE_object_eval_constraints(EvaluationContext *UNUSED(eval_ctx),
 	 * Not sure why, this is from Joshua - sergey
 	 *
 	 */
-	cob = BKE_constraints_make_evalob(scene, ob, NULL, CONSTRAINT_OBTYPE_OBJECT);
-	BKE_constraints_solve(&ob->constraints, cob, ctime);
-	BKE_constraints_clear_evalob(cob);
+	BKE_constraints_evalob_init(&cob, scene, ob, NULL, CONSTRAINT_OBTYPE_OBJECT);
+	BKE_constraints_solve(&ob->constraints, &cob, ctime);
+	BKE_constraints_evalob_apply(&cob);
 }
 
 void BKE_object_eval_done(EvaluationContext *UNUSED(eval_ctx), Object *ob)
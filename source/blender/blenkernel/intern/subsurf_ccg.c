@@ -151,7 +151,8 @@ static CCGSubSurf *_getSubSurf(CCGSubSurf *prevSS, int subdivLevels,
 		ccgSubSurf_getUseAgeCounts(prevSS, &oldUseAging, NULL, NULL, NULL);
 
 		if ((oldUseAging != useAging) ||
-		    (ccgSubSurf_getSimpleSubdiv(prevSS) != !!(flags & CCG_SIMPLE_SUBDIV)))
+		    (ccgSubSurf_getSimpleSubdiv(prevSS) != !!(flags & CCG_SIMPLE_SUBDIV)) ||
+		    (ccgSubSurf_getUseStandardAllocator(prevSS) == !!useArena))
 		{
 			ccgSubSurf_free(prevSS);
 		}
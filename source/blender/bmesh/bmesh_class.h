@@ -417,11 +417,11 @@ typedef bool (*BMLoopFilterFunc)(const BMLoop *, void *user_data);
 #define BM_LOOP_RADIAL_MAX 10000
 #define BM_NGON_MAX 100000
 
-/* setting zero so we can catch bugs in OpenMP/BMesh */
+/* setting zero so we can catch bugs in threaded BMesh code */
 #ifdef DEBUG
-#  define BM_OMP_LIMIT 0
+#  define BM_THREAD_LIMIT 0
 #else
-#  define BM_OMP_LIMIT 10000
+#  define BM_THREAD_LIMIT 10000
 #endif
 
 #endif /* __BMESH_CLASS_H__ */
@@ -39,35 +39,34 @@
 
 #include "BLI_math.h"
 #include "BLI_listbase.h"
+#include "BLI_task.h"
 
 #include "bmesh.h"
 #include "bmesh_structure.h"
 
-static void recount_totsels(BMesh *bm)
+static void recount_totsels_cb(void *userdata, int i)
 {
+	BMesh *bm = userdata;
 	const char iter_types[3] = {BM_VERTS_OF_MESH,
 	                            BM_EDGES_OF_MESH,
 	                            BM_FACES_OF_MESH};
-	int *tots[3];
-	int i;
+	int *tots[3] = {&bm->totvertsel, &bm->totedgesel, &bm->totfacesel};
+	BMIter iter;
+	BMElem *ele;
+	int count = 0;
 
+	BM_ITER_MESH (ele, &iter, bm, iter_types[i]) {
+		if (BM_elem_flag_test(ele, BM_ELEM_SELECT)) count += 1;
+	}
+	*tots[i] = count;
+}
+
+static void recount_totsels(BMesh *bm)
+{
 	/* recount (tot * sel) variables */
 	bm->totvertsel = bm->totedgesel = bm->totfacesel = 0;
-	tots[0] = &bm->totvertsel;
-	tots[1] = &bm->totedgesel;
-	tots[2] = &bm->totfacesel;
-
-#pragma omp parallel for schedule(static) if (bm->totvert + bm->totedge + bm->totface >= BM_OMP_LIMIT)
-	for (i = 0; i < 3; i++) {
-		BMIter iter;
-		BMElem *ele;
-		int count = 0;
 
-		BM_ITER_MESH (ele, &iter, bm, iter_types[i]) {
-			if (BM_elem_flag_test(ele, BM_ELEM_SELECT)) count += 1;
-		}
-		*tots[i] = count;
-	}
+	BLI_task_parallel_range(0, 3, bm, recount_totsels_cb, bm->totvert + bm->totedge + bm->totface >= BM_THREAD_LIMIT);
 }
 
 /** \name BMesh helper functions for selection & hide flushing.
@@ -234,6 +233,51 @@ void BM_mesh_select_mode_clean(BMesh *bm)
 	BM_mesh_select_mode_clean_ex(bm, bm->selectmode);
 }
 
+static void bm_mesh_select_mode_flush_vert_cb(void *userdata, int section)
+{
+	BMesh *bm = userdata;
+
+	if (section == 0) {
+		BMEdge *e;
+		BMIter eiter;
+
+		BM_ITER_MESH (e, &eiter, bm, BM_EDGES_OF_MESH) {
+			if (BM_elem_flag_test(e->v1, BM_ELEM_SELECT) &&
+			    BM_elem_flag_test(e->v2, BM_ELEM_SELECT) &&
+			    !BM_elem_flag_test(e, BM_ELEM_HIDDEN))
+			{
+				BM_elem_flag_enable(e, BM_ELEM_SELECT);
+			}
+			else {
+				BM_elem_flag_disable(e, BM_ELEM_SELECT);
+			}
+		}
+	}
+	else {
+		BMFace *f;
+		BMIter fiter;
+
+		BM_ITER_MESH (f, &fiter, bm, BM_FACES_OF_MESH) {
+			bool ok = true;
+			if (!BM_elem_flag_test(f, BM_ELEM_HIDDEN)) {
+				BMLoop *l_iter, *l_first;
+				l_iter = l_first = BM_FACE_FIRST_LOOP(f);
+				do {
+					if (!BM_elem_flag_test(l_iter->v, BM_ELEM_SELECT)) {
+						ok = false;
+						break;
+					}
+				} while ((l_iter = l_iter->next) != l_first);
+			}
+			else {
+				ok = false;
+			}
+
+			BM_elem_flag_set(f, BM_ELEM_SELECT, ok);
+		}
+	}
+}
+
 /**
  * \brief Select Mode Flush
  *
@@ -243,54 +287,15 @@ void BM_mesh_select_mode_clean(BMesh *bm)
  */
 void BM_mesh_select_mode_flush_ex(BMesh *bm, const short selectmode)
 {
-	BMEdge *e;
 	BMLoop *l_iter;
 	BMLoop *l_first;
 	BMFace *f;
 
-	BMIter eiter;
 	BMIter fiter;
 
 	if (selectmode & SCE_SELECT_VERTEX) {
 		/* both loops only set edge/face flags and read off verts */
-#pragma omp parallel sections if (bm->totedge + bm->totface >= BM_OMP_LIMIT)
-		{
-#pragma omp section
-			{
-				BM_ITER_MESH (e, &eiter, bm, BM_EDGES_OF_MESH) {
-					if (BM_elem_flag_test(e->v1, BM_ELEM_SELECT) &&
-					    BM_elem_flag_test(e->v2, BM_ELEM_SELECT) &&
-					    !BM_elem_flag_test(e, BM_ELEM_HIDDEN))
-					{
-						BM_elem_flag_enable(e, BM_ELEM_SELECT);
-					}
-					else {
-						BM_elem_flag_disable(e, BM_ELEM_SELECT);
-					}
-				}
-			}
-#pragma omp section
-			{
-				BM_ITER_MESH (f, &fiter, bm, BM_FACES_OF_MESH) {
-					bool ok = true;
-					if (!BM_elem_flag_test(f, BM_ELEM_HIDDEN)) {
-						l_iter = l_first = BM_FACE_FIRST_LOOP(f);
-						do {
-							if (!BM_elem_flag_test(l_iter->v, BM_ELEM_SELECT)) {
-								ok = false;
-								break;
-							}
-						} while ((l_iter = l_iter->next) != l_first);
-					}
-					else {
-						ok = false;
-					}
-
-					BM_elem_flag_set(f, BM_ELEM_SELECT, ok);
-				}
-			}
-		}
-		/* end sections */
+		BLI_task_parallel_range(0, 2, bm, bm_mesh_select_mode_flush_vert_cb, bm->totedge + bm->totface >= BM_THREAD_LIMIT);
 	}
 	else if (selectmode & SCE_SELECT_EDGE) {
 		BM_ITER_MESH (f, &fiter, bm, BM_FACES_OF_MESH) {
@@ -360,59 +365,57 @@ void BM_mesh_deselect_flush(BMesh *bm)
 }
 
 
-/**
- * mode independent flushing up/down
- */
-void BM_mesh_select_flush(BMesh *bm)
+static void bm_mesh_select_flush_cb(void *userdata, int section)
 {
-	BMEdge *e;
-	BMLoop *l_iter;
-	BMLoop *l_first;
-	BMFace *f;
-
-	BMIter eiter;
-	BMIter fiter;
+	BMesh *bm = userdata;
 
-	bool ok;
+	if (section == 0) {
+		BMEdge *e;
+		BMIter eiter;
 
-	/* we can use 2 sections here because the second loop isnt checking edge selection */
-#pragma omp parallel sections if (bm->totedge + bm->totface >= BM_OMP_LIMIT)
-	{
-#pragma omp section
-		{
-			BM_ITER_MESH (e, &eiter, bm, BM_EDGES_OF_MESH) {
-				if (BM_elem_flag_test(e->v1, BM_ELEM_SELECT) &&
-				    BM_elem_flag_test(e->v2, BM_ELEM_SELECT) &&
-				    !BM_elem_flag_test(e, BM_ELEM_HIDDEN))
-				{
-					BM_elem_flag_enable(e, BM_ELEM_SELECT);
-				}
+		BM_ITER_MESH (e, &eiter, bm, BM_EDGES_OF_MESH) {
+			if (BM_elem_flag_test(e->v1, BM_ELEM_SELECT) &&
+			    BM_elem_flag_test(e->v2, BM_ELEM_SELECT) &&
+			    !BM_elem_flag_test(e, BM_ELEM_HIDDEN))
+			{
+				BM_elem_flag_enable(e, BM_ELEM_SELECT);
 			}
 		}
+	}
+	else {
+		BMFace *f;
+		BMIter fiter;
 
-#pragma omp section
-		{
-			BM_ITER_MESH (f, &fiter, bm, BM_FACES_OF_MESH) {
-				ok = true;
-				if (!BM_elem_flag_test(f, BM_ELEM_HIDDEN)) {
-					l_iter = l_first = BM_FACE_FIRST_LOOP(f);
-					do {
-						if (!BM_elem_flag_test(l_iter->v, BM_ELEM_SELECT)) {
-							ok = false;
-							break;
-						}
-					} while ((l_iter = l_iter->next) != l_first);
-				}
-				else {
-					ok = false;
-				}
+		BM_ITER_MESH (f, &fiter, bm, BM_FACES_OF_MESH) {
+			bool ok = true;
+			if (!BM_elem_flag_test(f, BM_ELEM_HIDDEN)) {
+				BMLoop *l_iter, *l_first;
+				l_iter = l_first = BM_FACE_FIRST_LOOP(f);
+				do {
+					if (!BM_elem_flag_test(l_iter->v, BM_ELEM_SELECT)) {
+						ok = false;
+						break;
+					}
+				} while ((l_iter = l_iter->next) != l_first);
+			}
+			else {
+				ok = false;
+			}
 
-				if (ok) {
-					BM_elem_flag_enable(f, BM_ELEM_SELECT);
-				}
+			if (ok) {
+				BM_elem_flag_enable(f, BM_ELEM_SELECT);
 			}
 		}
 	}
+}
+
+/**
+ * mode independent flushing up/down
+ */
+void BM_mesh_select_flush(BMesh *bm)
+{
+	/* we can use 2 sections here because the second loop isnt checking edge selection */
+	BLI_task_parallel_range(0, 2, bm, bm_mesh_select_flush_cb, bm->totedge + bm->totface >= BM_THREAD_LIMIT);
 
 	recount_totsels(bm);
 }
@@ -1080,6 +1083,21 @@ GHash *BM_select_history_map_create(BMesh *bm)
 	return map;
 }
 
+static void bm_mesh_elem_hflag_disable_select_cb(void *userdata, int i)
+{
+	BMesh *bm = userdata;
+	const char iter_types[3] = {BM_VERTS_OF_MESH,
+	                            BM_EDGES_OF_MESH,
+	                            BM_FACES_OF_MESH};
+	BMIter iter;
+	BMElem *ele;
+
+	ele = BM_iter_new(&iter, bm, iter_types[i], NULL);
+	for ( ; ele; ele = BM_iter_step(&iter)) {
+		BM_elem_flag_disable(ele, BM_ELEM_SELECT);
+	}
+}
+
 void BM_mesh_elem_hflag_disable_test(
         BMesh *bm, const char htype, const char hflag,
         const bool respecthide, const bool overwrite, const char hflag_test)
@@ -1108,16 +1126,7 @@ void BM_mesh_elem_hflag_disable_test(
 		/* fast path for deselect all, avoid topology loops
 		 * since we know all will be de-selected anyway. */
 
-#pragma omp parallel for schedule(static) if (bm->totvert + bm->totedge + bm->totface >= BM_OMP_LIMIT)
-		for (i = 0; i < 3; i++) {
-			BMIter iter;
-			BMElem *ele;
-
-			ele = BM_iter_new(&iter, bm, iter_types[i], NULL);
-			for ( ; ele; ele = BM_iter_step(&iter)) {
-				BM_elem_flag_disable(ele, BM_ELEM_SELECT);
-			}
-		}
+		BLI_task_parallel_range(0, 3, bm, bm_mesh_elem_hflag_disable_select_cb, bm->totvert + bm->totedge + bm->totface >= BM_THREAD_LIMIT);
 
 		bm->totvertsel = bm->totedgesel = bm->totfacesel = 0;
 	}
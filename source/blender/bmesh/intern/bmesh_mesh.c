@@ -35,6 +35,7 @@
 #include "BLI_listbase.h"
 #include "BLI_math.h"
 #include "BLI_stack.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "BKE_cdderivedmesh.h"
@@ -100,21 +101,12 @@ static void bm_mempool_init(BMesh *bm, const BMAllocTemplate *allocsize, const b
 #endif
 }
 
-void BM_mesh_elem_toolflags_ensure(BMesh *bm)
+static void bm_mesh_elem_toolflags_ensure_cb(void *userdata, int section)
 {
-	BLI_assert(bm->use_toolflags);
-
-	if (bm->vtoolflagpool && bm->etoolflagpool && bm->ftoolflagpool) {
-		return;
-	}
+	BMesh *bm = userdata;
 
-	bm->vtoolflagpool = BLI_mempool_create(sizeof(BMFlagLayer), bm->totvert, 512, BLI_MEMPOOL_NOP);
-	bm->etoolflagpool = BLI_mempool_create(sizeof(BMFlagLayer), bm->totedge, 512, BLI_MEMPOOL_NOP);
-	bm->ftoolflagpool = BLI_mempool_create(sizeof(BMFlagLayer), bm->totface, 512, BLI_MEMPOOL_NOP);
-
-#pragma omp parallel sections if (bm->totvert + bm->totedge + bm->totface >= BM_OMP_LIMIT)
-	{
-#pragma omp section
+	switch (section) {
+		case 0:
 		{
 			BLI_mempool *toolflagpool = bm->vtoolflagpool;
 			BMIter iter;
@@ -122,8 +114,9 @@ void BM_mesh_elem_toolflags_ensure(BMesh *bm)
 			BM_ITER_MESH (ele, &iter, bm, BM_VERTS_OF_MESH) {
 				ele->oflags = BLI_mempool_calloc(toolflagpool);
 			}
+			break;
 		}
-#pragma omp section
+		case 1:
 		{
 			BLI_mempool *toolflagpool = bm->etoolflagpool;
 			BMIter iter;
@@ -131,8 +124,9 @@ void BM_mesh_elem_toolflags_ensure(BMesh *bm)
 			BM_ITER_MESH (ele, &iter, bm, BM_EDGES_OF_MESH) {
 				ele->oflags = BLI_mempool_calloc(toolflagpool);
 			}
+			break;
 		}
-#pragma omp section
+		case 2:
 		{
 			BLI_mempool *toolflagpool = bm->ftoolflagpool;
 			BMIter iter;
@@ -140,8 +134,24 @@ void BM_mesh_elem_toolflags_ensure(BMesh *bm)
 			BM_ITER_MESH (ele, &iter, bm, BM_FACES_OF_MESH) {
 				ele->oflags = BLI_mempool_calloc(toolflagpool);
 			}
+			break;
 		}
 	}
+}
+
+void BM_mesh_elem_toolflags_ensure(BMesh *bm)
+{
+	BLI_assert(bm->use_toolflags);
+
+	if (bm->vtoolflagpool && bm->etoolflagpool && bm->ftoolflagpool) {
+		return;
+	}
+
+	bm->vtoolflagpool = BLI_mempool_create(sizeof(BMFlagLayer), bm->totvert, 512, BLI_MEMPOOL_NOP);
+	bm->etoolflagpool = BLI_mempool_create(sizeof(BMFlagLayer), bm->totedge, 512, BLI_MEMPOOL_NOP);
+	bm->ftoolflagpool = BLI_mempool_create(sizeof(BMFlagLayer), bm->totface, 512, BLI_MEMPOOL_NOP);
+
+	BLI_task_parallel_range(0, 3, bm, bm_mesh_elem_toolflags_ensure_cb, bm->totvert + bm->totedge + bm->totface >= BM_THREAD_LIMIT);
 
 
 	bm->totflags = 1;
@@ -408,18 +418,18 @@ static void bm_mesh_verts_calc_normals(
 	}
 }
 
-/**
- * \brief BMesh Compute Normals
- *
- * Updates the normals of a mesh.
- */
-void BM_mesh_normals_update(BMesh *bm)
+typedef struct BMeshNormalsUpdateData {
+	BMesh *bm;
+	float (*edgevec)[3];
+} BMeshNormalsUpdateData;
+
+static void bm_mesh_normals_update_cb(void *userdata, int section)
 {
-	float (*edgevec)[3] = MEM_mallocN(sizeof(*edgevec) * bm->totedge, __func__);
+	BMeshNormalsUpdateData *data = userdata;
+	BMesh *bm = data->bm;
 
-#pragma omp parallel sections if (bm->totvert + bm->totedge + bm->totface >= BM_OMP_LIMIT)
-	{
-#pragma omp section
+	switch (section) {
+		case 0:
 		{
 			/* calculate all face normals */
 			BMIter fiter;
@@ -430,9 +440,9 @@ void BM_mesh_normals_update(BMesh *bm)
 				BM_elem_index_set(f, i); /* set_inline */
 				BM_face_normal_update(f);
 			}
-			bm->elem_index_dirty &= ~BM_FACE;
+			break;
 		}
-#pragma omp section
+		case 1:
 		{
 			/* Zero out vertex normals */
 			BMIter viter;
@@ -443,17 +453,32 @@ void BM_mesh_normals_update(BMesh *bm)
 				BM_elem_index_set(v, i); /* set_inline */
 				zero_v3(v->no);
 			}
-			bm->elem_index_dirty &= ~BM_VERT;
+			break;
 		}
-#pragma omp section
+		case 2:
 		{
 			/* Compute normalized direction vectors for each edge.
 			 * Directions will be used for calculating the weights of the face normals on the vertex normals.
 			 */
-			bm_mesh_edges_calc_vectors(bm, edgevec, NULL);
+			bm_mesh_edges_calc_vectors(bm, data->edgevec, NULL);
+			break;
 		}
 	}
-	/* end omp */
+}
+
+/**
+ * \brief BMesh Compute Normals
+ *
+ * Updates the normals of a mesh.
+ */
+void BM_mesh_normals_update(BMesh *bm)
+{
+	float (*edgevec)[3] = MEM_mallocN(sizeof(*edgevec) * bm->totedge, __func__);
+
+	BMeshNormalsUpdateData data = {bm, edgevec};
+
+	BLI_task_parallel_range(0, 3, &data, bm_mesh_normals_update_cb, bm->totvert + bm->totedge + bm->totface >= BM_THREAD_LIMIT);
+	bm->elem_index_dirty &= ~(BM_VERT | BM_FACE);
 
 	/* Add weighted face normals to vertices, and normalize vert normals. */
 	bm_mesh_verts_calc_normals(bm, (const float(*)[3])edgevec, NULL, NULL, NULL);
@@ -1096,24 +1121,19 @@ void bmesh_edit_end(BMesh *bm, BMOpTypeFlag type_flag)
 	}
 }
 
-void BM_mesh_elem_index_ensure(BMesh *bm, const char htype)
-{
-	const char htype_needed = bm->elem_index_dirty & htype;
-
-#ifdef DEBUG
-	BM_ELEM_INDEX_VALIDATE(bm, "Should Never Fail!", __func__);
-#endif
-
-	if (htype_needed == 0) {
-		goto finally;
-	}
+typedef struct BMeshElemIndexEnsureData {
+	BMesh *bm;
+	char htype;
+} BMeshElemIndexEnsureData;
 
-	/* skip if we only need to operate on one element */
-#pragma omp parallel sections if ((!ELEM(htype_needed, BM_VERT, BM_EDGE, BM_FACE, BM_LOOP, BM_FACE | BM_LOOP)) && \
-	                              (bm->totvert + bm->totedge + bm->totface >= BM_OMP_LIMIT))
-	{
-#pragma omp section
+static void bm_mesh_elem_index_ensure_cb(void *userdata, int section)
+{
+	BMeshElemIndexEnsureData *data = userdata;
+	BMesh *bm = data->bm;
+	const char htype = data->htype;
 
+	switch (section) {
+		case 0:
 		{
 			if (htype & BM_VERT) {
 				if (bm->elem_index_dirty & BM_VERT) {
@@ -1130,9 +1150,9 @@ void BM_mesh_elem_index_ensure(BMesh *bm, const char htype)
 					// printf("%s: skipping vert index calc!\n", __func__);
 				}
 			}
+			break;
 		}
-
-#pragma omp section
+		case 1:
 		{
 			if (htype & BM_EDGE) {
 				if (bm->elem_index_dirty & BM_EDGE) {
@@ -1149,9 +1169,9 @@ void BM_mesh_elem_index_ensure(BMesh *bm, const char htype)
 					// printf("%s: skipping edge index calc!\n", __func__);
 				}
 			}
+			break;
 		}
-
-#pragma omp section
+		case 2:
 		{
 			if (htype & (BM_FACE | BM_LOOP)) {
 				if (bm->elem_index_dirty & (BM_FACE | BM_LOOP)) {
@@ -1188,8 +1208,29 @@ void BM_mesh_elem_index_ensure(BMesh *bm, const char htype)
 					// printf("%s: skipping face/loop index calc!\n", __func__);
 				}
 			}
+			break;
 		}
 	}
+}
+
+void BM_mesh_elem_index_ensure(BMesh *bm, const char htype)
+{
+	const char htype_needed = bm->elem_index_dirty & htype;
+	BMeshElemIndexEnsureData data = {bm, htype};
+
+#ifdef DEBUG
+	BM_ELEM_INDEX_VALIDATE(bm, "Should Never Fail!", __func__);
+#endif
+
+	if (htype_needed == 0) {
+		goto finally;
+	}
+
+	/* skip if we only need to operate on one element */
+	BLI_task_parallel_range(
+	        0, 3, &data, bm_mesh_elem_index_ensure_cb,
+	        (!ELEM(htype_needed, BM_VERT, BM_EDGE, BM_FACE, BM_LOOP, BM_FACE | BM_LOOP)) &&
+	        (bm->totvert + bm->totedge + bm->totface >= BM_THREAD_LIMIT));
 
 
 finally:
@@ -1313,12 +1354,44 @@ bool BM_mesh_elem_table_check(BMesh *bm)
 
 
 
+static void bm_mesh_elem_table_ensure_cb(void *userdata, int section)
+{
+	BMeshElemIndexEnsureData *data = userdata;
+	BMesh *bm = data->bm;
+	const char htype_needed = data->htype;
+
+	switch (section) {
+		case 0:
+		{
+			if (htype_needed & BM_VERT) {
+				BM_iter_as_array(bm, BM_VERTS_OF_MESH, NULL, (void **)bm->vtable, bm->totvert);
+			}
+			break;
+		}
+		case 1:
+		{
+			if (htype_needed & BM_EDGE) {
+				BM_iter_as_array(bm, BM_EDGES_OF_MESH, NULL, (void **)bm->etable, bm->totedge);
+			}
+			break;
+		}
+		case 2:
+		{
+			if (htype_needed & BM_FACE) {
+				BM_iter_as_array(bm, BM_FACES_OF_MESH, NULL, (void **)bm->ftable, bm->totface);
+			}
+			break;
+		}
+	}
+}
+
 void BM_mesh_elem_table_ensure(BMesh *bm, const char htype)
 {
 	/* assume if the array is non-null then its valid and no need to recalc */
 	const char htype_needed = (((bm->vtable && ((bm->elem_table_dirty & BM_VERT) == 0)) ? 0 : BM_VERT) |
 	                           ((bm->etable && ((bm->elem_table_dirty & BM_EDGE) == 0)) ? 0 : BM_EDGE) |
 	                           ((bm->ftable && ((bm->elem_table_dirty & BM_FACE) == 0)) ? 0 : BM_FACE)) & htype;
+	BMeshElemIndexEnsureData data = {bm, htype_needed};
 
 	BLI_assert((htype & ~BM_ALL_NOLOOP) == 0);
 
@@ -1364,28 +1437,10 @@ void BM_mesh_elem_table_ensure(BMesh *bm, const char htype)
 	}
 
 	/* skip if we only need to operate on one element */
-#pragma omp parallel sections if ((!ELEM(htype_needed, BM_VERT, BM_EDGE, BM_FACE)) && \
-	                              (bm->totvert + bm->totedge + bm->totface >= BM_OMP_LIMIT))
-	{
-#pragma omp section
-		{
-			if (htype_needed & BM_VERT) {
-				BM_iter_as_array(bm, BM_VERTS_OF_MESH, NULL, (void **)bm->vtable, bm->totvert);
-			}
-		}
-#pragma omp section
-		{
-			if (htype_needed & BM_EDGE) {
-				BM_iter_as_array(bm, BM_EDGES_OF_MESH, NULL, (void **)bm->etable, bm->totedge);
-			}
-		}
-#pragma omp section
-		{
-			if (htype_needed & BM_FACE) {
-				BM_iter_as_array(bm, BM_FACES_OF_MESH, NULL, (void **)bm->ftable, bm->totface);
-			}
-		}
-	}
+	BLI_task_parallel_range(
+	        0, 3, &data, bm_mesh_elem_table_ensure_cb,
+	        (!ELEM(htype_needed, BM_VERT, BM_EDGE, BM_FACE)) &&
+	        (bm->totvert + bm->totedge + bm->totface >= BM_THREAD_LIMIT));
 
 finally:
 	/* Only clear dirty flags when all the pointers and data are actually valid.
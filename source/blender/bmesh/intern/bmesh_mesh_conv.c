@@ -86,6 +86,8 @@
 #include "BLI_listbase.h"
 #include "BLI_alloca.h"
 #include "BLI_math_vector.h"
+#include "BLI_mempool.h"
+#include "BLI_task.h"
 
 #include "BKE_mesh.h"
 #include "BKE_customdata.h"
@@ -217,25 +219,207 @@ static BMFace *bm_face_create_from_mpoly(
 }
 
 
+/**
+ * Allocate the custom-data block of an element created with #BM_CREATE_SKIP_CD,
+ * so it can be filled by #CustomData_to_bmesh_block from multiple threads.
+ */
+BLI_INLINE void bm_elem_cd_block_alloc(CustomData *cd, void **r_block)
+{
+	*r_block = (cd->totsize > 0) ? BLI_mempool_alloc(cd->pool) : NULL;
+}
+
+typedef struct BMeshFromMeshData {
+	BMesh *bm;
+	Mesh *me;
+	const struct BMeshFromMeshParams *params;
+
+	BMVert **vtable;
+	BMEdge **etable;
+	BMFace **ftable;
+
+	const float (*keyco)[3];
+	const float (**shape_key_table)[3];
+	int tot_shape_keys;
+
+	int cd_vert_bweight_offset;
+	int cd_edge_bweight_offset;
+	int cd_edge_crease_offset;
+	int cd_shape_key_offset;
+	int cd_shape_keyindex_offset;
+
+	/* accumulated from #BMeshFromMeshSelectChunk */
+	int totsel;
+	bool need_select_flush;
+} BMeshFromMeshData;
+
+typedef struct BMeshFromMeshSelectChunk {
+	int totsel;
+	/* a selected element uses elements which aren't selected yet */
+	bool need_select_flush;
+} BMeshFromMeshSelectChunk;
+
+static void bm_mesh_bm_from_me_select_finalize(void *userdata, void *userdata_chunk)
+{
+	BMeshFromMeshData *data = userdata;
+	BMeshFromMeshSelectChunk *chunk = userdata_chunk;
+
+	data->totsel += chunk->totsel;
+	data->need_select_flush |= chunk->need_select_flush;
+}
+
+static void bm_mesh_bm_from_me_verts_cb(void *userdata, void *userdata_chunk, const int i, const int UNUSED(thread_id))
+{
+	BMeshFromMeshData *data = userdata;
+	BMeshFromMeshSelectChunk *chunk = userdata_chunk;
+	BMesh *bm = data->bm;
+	Mesh *me = data->me;
+	const MVert *mvert = &me->mvert[i];
+	BMVert *v = data->vtable[i];
+
+	copy_v3_v3(v->co, data->keyco ? data->keyco[i] : mvert->co);
+	normal_short_to_float_v3(v->no, mvert->no);
+
+	/* transfer flag */
+	v->head.hflag = BM_vert_flag_from_mflag(mvert->flag & ~SELECT);
+
+	/* same as #BM_vert_select_set, the selection count is accumulated per chunk */
+	if ((mvert->flag & SELECT) && !BM_elem_flag_test(v, BM_ELEM_HIDDEN)) {
+		BM_elem_flag_enable(v, BM_ELEM_SELECT);
+		chunk->totsel++;
+	}
+
+	/* Copy Custom Data */
+	CustomData_to_bmesh_block(&me->vdata, &bm->vdata, i, &v->head.data, true);
+
+	if (data->cd_vert_bweight_offset != -1) {
+		BM_ELEM_CD_SET_FLOAT(v, data->cd_vert_bweight_offset, (float)mvert->bweight / 255.0f);
+	}
+
+	/* set shape key original index */
+	if (data->cd_shape_keyindex_offset != -1) {
+		BM_ELEM_CD_SET_INT(v, data->cd_shape_keyindex_offset, i);
+	}
+
+	/* set shapekey data */
+	if (data->tot_shape_keys) {
+		float (*co_dst)[3] = BM_ELEM_CD_GET_VOID_P(v, data->cd_shape_key_offset);
+		int j;
+		for (j = 0; j < data->tot_shape_keys; j++, co_dst++) {
+			copy_v3_v3(*co_dst, data->shape_key_table[j][i]);
+		}
+	}
+}
+
+static void bm_mesh_bm_from_me_edges_cb(void *userdata, void *userdata_chunk, const int i, const int UNUSED(thread_id))
+{
+	BMeshFromMeshData *data = userdata;
+	BMeshFromMeshSelectChunk *chunk = userdata_chunk;
+	BMesh *bm = data->bm;
+	Mesh *me = data->me;
+	const MEdge *medge = &me->medge[i];
+	BMEdge *e = data->etable[i];
+
+	/* transfer flags */
+	e->head.hflag = BM_edge_flag_from_mflag(medge->flag & ~SELECT);
+
+	/* same as #BM_edge_select_set, flushing to the verts is left to the caller */
+	if ((medge->flag & SELECT) && !BM_elem_flag_test(e, BM_ELEM_HIDDEN)) {
+		BM_elem_flag_enable(e, BM_ELEM_SELECT);
+		chunk->totsel++;
+
+		if (!BM_elem_flag_test(e->v1, BM_ELEM_SELECT | BM_ELEM_HIDDEN) ||
+		    !BM_elem_flag_test(e->v2, BM_ELEM_SELECT | BM_ELEM_HIDDEN))
+		{
+			chunk->need_select_flush = true;
+		}
+	}
+
+	/* Copy Custom Data */
+	CustomData_to_bmesh_block(&me->edata, &bm->edata, i, &e->head.data, true);
+
+	if (data->cd_edge_bweight_offset != -1) {
+		BM_ELEM_CD_SET_FLOAT(e, data->cd_edge_bweight_offset, (float)medge->bweight / 255.0f);
+	}
+	if (data->cd_edge_crease_offset != -1) {
+		BM_ELEM_CD_SET_FLOAT(e, data->cd_edge_crease_offset, (float)medge->crease / 255.0f);
+	}
+}
+
+static void bm_mesh_bm_from_me_faces_cb(void *userdata, void *userdata_chunk, const int i, const int UNUSED(thread_id))
+{
+	BMeshFromMeshData *data = userdata;
+	BMeshFromMeshSelectChunk *chunk = userdata_chunk;
+	BMesh *bm = data->bm;
+	Mesh *me = data->me;
+	const MPoly *mp = &me->mpoly[i];
+	BMFace *f = data->ftable[i];
+	BMLoop *l_iter, *l_first;
+	bool is_select = false;
+	int j;
+
+	/* bad face, skipped on creation */
+	if (UNLIKELY(f == NULL)) {
+		return;
+	}
+
+	/* transfer flag */
+	f->head.hflag = BM_face_flag_from_mflag(mp->flag & ~ME_FACE_SEL);
+
+	/* same as #BM_face_select_set, flushing to the verts & edges is left to the caller */
+	if ((mp->flag & ME_FACE_SEL) && !BM_elem_flag_test(f, BM_ELEM_HIDDEN)) {
+		BM_elem_flag_enable(f, BM_ELEM_SELECT);
+		chunk->totsel++;
+		is_select = true;
+	}
+
+	f->mat_nr = mp->mat_nr;
+
+	j = mp->loopstart;
+	l_iter = l_first = BM_FACE_FIRST_LOOP(f);
+	do {
+		/* Save index of correspsonding MLoop */
+		CustomData_to_bmesh_block(&me->ldata, &bm->ldata, j++, &l_iter->head.data, true);
+
+		if (is_select &&
+		    (!BM_elem_flag_test(l_iter->v, BM_ELEM_SELECT | BM_ELEM_HIDDEN) ||
+		     !BM_elem_flag_test(l_iter->e, BM_ELEM_SELECT | BM_ELEM_HIDDEN)))
+		{
+			chunk->need_select_flush = true;
+		}
+	} while ((l_iter = l_iter->next) != l_first);
+
+	/* Copy Custom Data */
+	CustomData_to_bmesh_block(&me->pdata, &bm->pdata, i, &f->head.data, true);
+
+	if (data->params->calc_face_normal) {
+		BM_face_normal_update(f);
+	}
+}
+
 /**
  * \brief Mesh -> BMesh
  *
+ * The topology is created single threaded (element pools and disk/radial cycles can't be
+ * modified concurrently), with custom-data blocks allocated up-front.
+ * All per-element data is then filled in in parallel.
+ *
  * \warning This function doesn't calculate face normals.
  */
 void BM_mesh_bm_from_me(
         BMesh *bm, Mesh *me,
         const struct BMeshFromMeshParams *params)
 {
-	MVert *mvert;
 	MEdge *medge;
 	MLoop *mloop;
 	MPoly *mp;
 	KeyBlock *actkey, *block;
 	BMVert *v, **vtable = NULL;
 	BMEdge *e, **etable = NULL;
-	BMFace *f;
+	BMFace *f, **ftable = NULL;
 	float (*keyco)[3] = NULL;
 	int totuv, totloops, i, j;
+	BMeshFromMeshData data;
+	BMeshFromMeshSelectChunk chunk = {0};
 
 	/* free custom data */
 	/* this isnt needed in most cases but do just incase */
@@ -333,155 +517,143 @@ void BM_mesh_bm_from_me(
 	const int cd_shape_keyindex_offset = (tot_shape_keys || params->add_key_index) ?
 	          CustomData_get_offset(&bm->vdata, CD_SHAPE_KEYINDEX) : -1;
 
-	for (i = 0, mvert = me->mvert; i < me->totvert; i++, mvert++) {
-		v = vtable[i] = BM_vert_create(
-		        bm, keyco && params->use_shapekey ? keyco[i] : mvert->co, NULL,
-		        BM_CREATE_SKIP_CD);
+	/* create the topology, element data is filled in below */
+	for (i = 0; i < me->totvert; i++) {
+		v = vtable[i] = BM_vert_create(bm, NULL, NULL, BM_CREATE_SKIP_CD);
 		BM_elem_index_set(v, i); /* set_ok */
-
-		/* transfer flag */
-		v->head.hflag = BM_vert_flag_from_mflag(mvert->flag & ~SELECT);
-
-		/* this is necessary for selection counts to work properly */
-		if (mvert->flag & SELECT) {
-			BM_vert_select_set(bm, v, true);
-		}
-
-		normal_short_to_float_v3(v->no, mvert->no);
-
-		/* Copy Custom Data */
-		CustomData_to_bmesh_block(&me->vdata, &bm->vdata, i, &v->head.data, true);
-
-		if (cd_vert_bweight_offset != -1) BM_ELEM_CD_SET_FLOAT(v, cd_vert_bweight_offset, (float)mvert->bweight / 255.0f);
-
-		/* set shape key original index */
-		if (cd_shape_keyindex_offset != -1) BM_ELEM_CD_SET_INT(v, cd_shape_keyindex_offset, i);
-
-		/* set shapekey data */
-		if (tot_shape_keys) {
-			float (*co_dst)[3] = BM_ELEM_CD_GET_VOID_P(v, cd_shape_key_offset);
-			for (j = 0; j < tot_shape_keys; j++, co_dst++) {
-				copy_v3_v3(*co_dst, shape_key_table[j][i]);
-			}
-		}
+		bm_elem_cd_block_alloc(&bm->vdata, &v->head.data);
 	}
 
 	bm->elem_index_dirty &= ~BM_VERT; /* added in order, clear dirty flag */
 
-	if (!me->totedge) {
-		MEM_freeN(vtable);
-		return;
-	}
-
-	etable = MEM_mallocN(sizeof(void **) * me->totedge, "mesh to bmesh etable");
-
-	medge = me->medge;
-	for (i = 0; i < me->totedge; i++, medge++) {
-		e = etable[i] = BM_edge_create(bm, vtable[medge->v1], vtable[medge->v2], NULL, BM_CREATE_SKIP_CD);
-		BM_elem_index_set(e, i); /* set_ok */
-
-		/* transfer flags */
-		e->head.hflag = BM_edge_flag_from_mflag(medge->flag & ~SELECT);
+	if (me->totedge) {
+		etable = MEM_mallocN(sizeof(void **) * me->totedge, "mesh to bmesh etable");
 
-		/* this is necessary for selection counts to work properly */
-		if (medge->flag & SELECT) {
-			BM_edge_select_set(bm, e, true);
+		medge = me->medge;
+		for (i = 0; i < me->totedge; i++, medge++) {
+			e = etable[i] = BM_edge_create(bm, vtable[medge->v1], vtable[medge->v2], NULL, BM_CREATE_SKIP_CD);
+			BM_elem_index_set(e, i); /* set_ok */
+			bm_elem_cd_block_alloc(&bm->edata, &e->head.data);
 		}
 
-		/* Copy Custom Data */
-		CustomData_to_bmesh_block(&me->edata, &bm->edata, i, &e->head.data, true);
-
-		if (cd_edge_bweight_offset != -1) BM_ELEM_CD_SET_FLOAT(e, cd_edge_bweight_offset, (float)medge->bweight / 255.0f);
-		if (cd_edge_crease_offset  != -1) BM_ELEM_CD_SET_FLOAT(e, cd_edge_crease_offset,  (float)medge->crease  / 255.0f);
-
+		bm->elem_index_dirty &= ~BM_EDGE; /* added in order, clear dirty flag */
 	}
 
-	bm->elem_index_dirty &= ~BM_EDGE; /* added in order, clear dirty flag */
+	if (me->totedge && me->totpoly) {
+		ftable = MEM_mallocN(sizeof(void **) * me->totpoly, "mesh to bmesh ftable");
 
-	mloop = me->mloop;
-	mp = me->mpoly;
-	for (i = 0, totloops = 0; i < me->totpoly; i++, mp++) {
-		BMLoop *l_iter;
-		BMLoop *l_first;
+		mloop = me->mloop;
+		mp = me->mpoly;
+		for (i = 0, totloops = 0; i < me->totpoly; i++, mp++) {
+			BMLoop *l_iter;
+			BMLoop *l_first;
 
-		f = bm_face_create_from_mpoly(mp, mloop + mp->loopstart,
-		                              bm, vtable, etable);
+			f = ftable[i] = bm_face_create_from_mpoly(mp, mloop + mp->loopstart,
+			                                          bm, vtable, etable);
 
-		if (UNLIKELY(f == NULL)) {
-			printf("%s: Warning! Bad face in mesh"
-			       " \"%s\" at index %d!, skipping\n",
-			       __func__, me->id.name + 2, i);
-			continue;
-		}
+			if (UNLIKELY(f == NULL)) {
+				printf("%s: Warning! Bad face in mesh"
+				       " \"%s\" at index %d!, skipping\n",
+				       __func__, me->id.name + 2, i);
+				continue;
+			}
 
-		/* don't use 'i' since we may have skipped the face */
-		BM_elem_index_set(f, bm->totface - 1); /* set_ok */
+			/* don't use 'i' since we may have skipped the face */
+			BM_elem_index_set(f, bm->totface - 1); /* set_ok */
+			bm_elem_cd_block_alloc(&bm->pdata, &f->head.data);
 
-		/* transfer flag */
-		f->head.hflag = BM_face_flag_from_mflag(mp->flag & ~ME_FACE_SEL);
+			l_iter = l_first = BM_FACE_FIRST_LOOP(f);
+			do {
+				/* don't use 'j' since we may have skipped some faces, hence some loops. */
+				BM_elem_index_set(l_iter, totloops++); /* set_ok */
+				bm_elem_cd_block_alloc(&bm->ldata, &l_iter->head.data);
+			} while ((l_iter = l_iter->next) != l_first);
 
-		/* this is necessary for selection counts to work properly */
-		if (mp->flag & ME_FACE_SEL) {
-			BM_face_select_set(bm, f, true);
+			if (i == me->act_face) bm->act_face = f;
 		}
 
-		f->mat_nr = mp->mat_nr;
-		if (i == me->act_face) bm->act_face = f;
-
-		j = mp->loopstart;
-		l_iter = l_first = BM_FACE_FIRST_LOOP(f);
-		do {
-			/* don't use 'j' since we may have skipped some faces, hence some loops. */
-			BM_elem_index_set(l_iter, totloops++); /* set_ok */
+		bm->elem_index_dirty &= ~(BM_FACE | BM_LOOP); /* added in order, clear dirty flag */
+	}
 
-			/* Save index of correspsonding MLoop */
-			CustomData_to_bmesh_block(&me->ldata, &bm->ldata, j++, &l_iter->head.data, true);
-		} while ((l_iter = l_iter->next) != l_first);
+	/* fill in the element data, these only touch their own element (and read the verts/edges they use) */
+	data.bm = bm;
+	data.me = me;
+	data.params = params;
+	data.vtable = vtable;
+	data.etable = etable;
+	data.ftable = ftable;
+	data.keyco = params->use_shapekey ? (const float (*)[3])keyco : NULL;
+	data.shape_key_table = shape_key_table;
+	data.tot_shape_keys = tot_shape_keys;
+	data.cd_vert_bweight_offset = cd_vert_bweight_offset;
+	data.cd_edge_bweight_offset = cd_edge_bweight_offset;
+	data.cd_edge_crease_offset = cd_edge_crease_offset;
+	data.cd_shape_key_offset = cd_shape_key_offset;
+	data.cd_shape_keyindex_offset = cd_shape_keyindex_offset;
+	data.need_select_flush = false;
+
+	data.totsel = 0;
+	BLI_task_parallel_range_finalize(
+	        0, me->totvert, &data, &chunk, sizeof(chunk),
+	        bm_mesh_bm_from_me_verts_cb, bm_mesh_bm_from_me_select_finalize,
+	        me->totvert >= BM_THREAD_LIMIT, false);
+	bm->totvertsel += data.totsel;
 
-		/* Copy Custom Data */
-		CustomData_to_bmesh_block(&me->pdata, &bm->pdata, i, &f->head.data, true);
+	if (!me->totedge) {
+		MEM_freeN(vtable);
+		return;
+	}
 
-		if (params->calc_face_normal) {
-			BM_face_normal_update(f);
+	data.totsel = 0;
+	BLI_task_parallel_range_finalize(
+	        0, me->totedge, &data, &chunk, sizeof(chunk),
+	        bm_mesh_bm_from_me_edges_cb, bm_mesh_bm_from_me_select_finalize,
+	        me->totedge >= BM_THREAD_LIMIT, false);
+	bm->totedgesel += data.totsel;
+
+	data.totsel = 0;
+	BLI_task_parallel_range_finalize(
+	        0, me->totpoly, &data, &chunk, sizeof(chunk),
+	        bm_mesh_bm_from_me_faces_cb, bm_mesh_bm_from_me_select_finalize,
+	        me->totpoly >= BM_THREAD_LIMIT, false);
+	bm->totfacesel += data.totsel;
+
+	/* Only for meshes with inconsistent selection, select the elements
+	 * selected edges & faces use, this is necessary for selection counts to work properly. */
+	if (data.need_select_flush) {
+		for (i = 0; i < me->totedge; i++) {
+			e = etable[i];
+			if (BM_elem_flag_test(e, BM_ELEM_SELECT)) {
+				BM_edge_select_set(bm, e, true);
+			}
+		}
+		for (i = 0; i < me->totpoly; i++) {
+			f = ftable[i];
+			if (f && BM_elem_flag_test(f, BM_ELEM_SELECT)) {
+				BM_face_select_set(bm, f, true);
+			}
 		}
 	}
 
-	bm->elem_index_dirty &= ~(BM_FACE | BM_LOOP); /* added in order, clear dirty flag */
-
 	if (me->mselect && me->totselect != 0) {
-
-		BMVert **vert_array = MEM_mallocN(sizeof(BMVert *) * bm->totvert, "VSelConv");
-		BMEdge **edge_array = MEM_mallocN(sizeof(BMEdge *) * bm->totedge, "ESelConv");
-		BMFace **face_array = MEM_mallocN(sizeof(BMFace *) * bm->totface, "FSelConv");
 		MSelect *msel;
 
-#pragma omp parallel sections if (bm->totvert + bm->totedge + bm->totface >= BM_OMP_LIMIT)
-		{
-#pragma omp section
-			{ BM_iter_as_array(bm, BM_VERTS_OF_MESH, NULL, (void **)vert_array, bm->totvert); }
-#pragma omp section
-			{ BM_iter_as_array(bm, BM_EDGES_OF_MESH, NULL, (void **)edge_array, bm->totedge); }
-#pragma omp section
-			{ BM_iter_as_array(bm, BM_FACES_OF_MESH, NULL, (void **)face_array, bm->totface); }
-		}
+		/* the lookup tables are filled in parallel and stay valid for later use of the BMesh */
+		BM_mesh_elem_table_ensure(bm, BM_VERT | BM_EDGE | BM_FACE);
 
 		for (i = 0, msel = me->mselect; i < me->totselect; i++, msel++) {
 			switch (msel->type) {
 				case ME_VSEL:
-					BM_select_history_store(bm, (BMElem *)vert_array[msel->index]);
+					BM_select_history_store(bm, (BMElem *)bm->vtable[msel->index]);
 					break;
 				case ME_ESEL:
-					BM_select_history_store(bm, (BMElem *)edge_array[msel->index]);
+					BM_select_history_store(bm, (BMElem *)bm->etable[msel->index]);
 					break;
 				case ME_FSEL:
-					BM_select_history_store(bm, (BMElem *)face_array[msel->index]);
+					BM_select_history_store(bm, (BMElem *)bm->ftable[msel->index]);
 					break;
 			}
 		}
-
-		MEM_freeN(vert_array);
-		MEM_freeN(edge_array);
-		MEM_freeN(face_array);
 	}
 	else {
 		me->totselect = 0;
@@ -493,6 +665,9 @@ void BM_mesh_bm_from_me(
 
 	MEM_freeN(vtable);
 	MEM_freeN(etable);
+	if (ftable) {
+		MEM_freeN(ftable);
+	}
 }
 
 
@@ -576,6 +751,103 @@ BLI_INLINE void bmesh_quick_edgedraw_flag(MEdge *med, BMEdge *e)
 	}
 }
 
+typedef struct BMeshToMeshData {
+	BMesh *bm;
+	Mesh *me;
+
+	MVert *mvert;
+	MEdge *medge;
+	MLoop *mloop;
+	MPoly *mpoly;
+
+	int cd_vert_bweight_offset;
+	int cd_edge_bweight_offset;
+	int cd_edge_crease_offset;
+} BMeshToMeshData;
+
+static void bm_mesh_bm_to_me_verts_cb(void *userdata, const int i)
+{
+	BMeshToMeshData *data = userdata;
+	BMVert *v = data->bm->vtable[i];
+	MVert *mvert = &data->mvert[i];
+
+	copy_v3_v3(mvert->co, v->co);
+	normal_float_to_short_v3(mvert->no, v->no);
+
+	mvert->flag = BM_vert_flag_to_mflag(v);
+
+	/* copy over customdat */
+	CustomData_from_bmesh_block(&data->bm->vdata, &data->me->vdata, v->head.data, i);
+
+	if (data->cd_vert_bweight_offset != -1) {
+		mvert->bweight = BM_ELEM_CD_GET_FLOAT_AS_UCHAR(v, data->cd_vert_bweight_offset);
+	}
+
+	BM_CHECK_ELEMENT(v);
+}
+
+static void bm_mesh_bm_to_me_edges_cb(void *userdata, const int i)
+{
+	BMeshToMeshData *data = userdata;
+	BMEdge *e = data->bm->etable[i];
+	MEdge *med = &data->medge[i];
+
+	med->v1 = BM_elem_index_get(e->v1);
+	med->v2 = BM_elem_index_get(e->v2);
+
+	med->flag = BM_edge_flag_to_mflag(e);
+
+	/* copy over customdata */
+	CustomData_from_bmesh_block(&data->bm->edata, &data->me->edata, e->head.data, i);
+
+	bmesh_quick_edgedraw_flag(med, e);
+
+	if (data->cd_edge_crease_offset != -1) {
+		med->crease = BM_ELEM_CD_GET_FLOAT_AS_UCHAR(e, data->cd_edge_crease_offset);
+	}
+	if (data->cd_edge_bweight_offset != -1) {
+		med->bweight = BM_ELEM_CD_GET_FLOAT_AS_UCHAR(e, data->cd_edge_bweight_offset);
+	}
+
+	BM_CHECK_ELEMENT(e);
+}
+
+static void bm_mesh_bm_to_me_faces_cb(void *userdata, const int i)
+{
+	BMeshToMeshData *data = userdata;
+	BMFace *f = data->bm->ftable[i];
+	MPoly *mpoly = &data->mpoly[i];
+	MLoop *mloop;
+	BMLoop *l_iter, *l_first;
+	int j;
+
+	/* 'loopstart' & 'totloop' are set by the caller */
+	mpoly->mat_nr = f->mat_nr;
+	mpoly->flag = BM_face_flag_to_mflag(f);
+
+	j = mpoly->loopstart;
+	mloop = &data->mloop[j];
+	l_iter = l_first = BM_FACE_FIRST_LOOP(f);
+	do {
+		mloop->e = BM_elem_index_get(l_iter->e);
+		mloop->v = BM_elem_index_get(l_iter->v);
+
+		/* copy over customdata */
+		CustomData_from_bmesh_block(&data->bm->ldata, &data->me->ldata, l_iter->head.data, j);
+
+		j++;
+		mloop++;
+		BM_CHECK_ELEMENT(l_iter);
+		BM_CHECK_ELEMENT(l_iter->e);
+		BM_CHECK_ELEMENT(l_iter->v);
+	} while ((l_iter = l_iter->next) != l_first);
+
+	/* copy over customdata */
+	CustomData_from_bmesh_block(&data->bm->pdata, &data->me->pdata, f->head.data, i);
+
+	BM_CHECK_ELEMENT(f);
+}
+
 void BM_mesh_bm_to_me(
         BMesh *bm, Mesh *me,
         const struct BMeshToMeshParams *params)
@@ -583,9 +855,8 @@ void BM_mesh_bm_to_me(
 	MLoop *mloop;
 	MPoly *mpoly;
 	MVert *mvert, *oldverts;
-	MEdge *med, *medge;
-	BMVert *v, *eve;
-	BMEdge *e;
+	MEdge *medge;
+	BMVert *eve;
 	BMFace *f;
 	BMIter iter;
 	int i, j, ototvert;
@@ -657,83 +928,31 @@ void BM_mesh_bm_to_me(
 	/* this is called again, 'dotess' arg is used there */
 	BKE_mesh_update_customdata_pointers(me, 0);
 
-	i = 0;
-	BM_ITER_MESH (v, &iter, bm, BM_VERTS_OF_MESH) {
-		copy_v3_v3(mvert->co, v->co);
-		normal_float_to_short_v3(mvert->no, v->no);
-
-		mvert->flag = BM_vert_flag_to_mflag(v);
+	/* the element data is written in parallel, using the element tables & indices for lookups */
+	BM_mesh_elem_index_ensure(bm, BM_VERT | BM_EDGE | BM_FACE);
+	BM_mesh_elem_table_ensure(bm, BM_VERT | BM_EDGE | BM_FACE);
 
-		BM_elem_index_set(v, i); /* set_inline */
-
-		/* copy over customdat */
-		CustomData_from_bmesh_block(&bm->vdata, &me->vdata, v->head.data, i);
-
-		if (cd_vert_bweight_offset != -1) mvert->bweight = BM_ELEM_CD_GET_FLOAT_AS_UCHAR(v, cd_vert_bweight_offset);
-
-		i++;
-		mvert++;
-
-		BM_CHECK_ELEMENT(v);
-	}
-	bm->elem_index_dirty &= ~BM_VERT;
-
-	med = medge;
-	i = 0;
-	BM_ITER_MESH (e, &iter, bm, BM_EDGES_OF_MESH) {
-		med->v1 = BM_elem_index_get(e->v1);
-		med->v2 = BM_elem_index_get(e->v2);
-
-		med->flag = BM_edge_flag_to_mflag(e);
-
-		BM_elem_index_set(e, i); /* set_inline */
-
-		/* copy over customdata */
-		CustomData_from_bmesh_block(&bm->edata, &me->edata, e->head.data, i);
-
-		bmesh_quick_edgedraw_flag(med, e);
-
-		if (cd_edge_crease_offset  != -1) med->crease  = BM_ELEM_CD_GET_FLOAT_AS_UCHAR(e, cd_edge_crease_offset);
-		if (cd_edge_bweight_offset != -1) med->bweight = BM_ELEM_CD_GET_FLOAT_AS_UCHAR(e, cd_edge_bweight_offset);
-
-		i++;
-		med++;
-		BM_CHECK_ELEMENT(e);
-	}
-	bm->elem_index_dirty &= ~BM_EDGE;
-
-	i = 0;
-	j = 0;
-	BM_ITER_MESH (f, &iter, bm, BM_FACES_OF_MESH) {
-		BMLoop *l_iter, *l_first;
-		mpoly->loopstart = j;
-		mpoly->totloop = f->len;
-		mpoly->mat_nr = f->mat_nr;
-		mpoly->flag = BM_face_flag_to_mflag(f);
-
-		l_iter = l_first = BM_FACE_FIRST_LOOP(f);
-		do {
-			mloop->e = BM_elem_index_get(l_iter->e);
-			mloop->v = BM_elem_index_get(l_iter->v);
-
-			/* copy over customdata */
-			CustomData_from_bmesh_block(&bm->ldata, &me->ldata, l_iter->head.data, j);
-
-			j++;
-			mloop++;
-			BM_CHECK_ELEMENT(l_iter);
-			BM_CHECK_ELEMENT(l_iter->e);
-			BM_CHECK_ELEMENT(l_iter->v);
-		} while ((l_iter = l_iter->next) != l_first);
+	for (i = 0, j = 0; i < bm->totface; i++) {
+		f = bm->ftable[i];
+		mpoly[i].loopstart = j;
+		mpoly[i].totloop = f->len;
+		j += f->len;
 
 		if (f == bm->act_face) me->act_face = i;
+	}
 
-		/* copy over customdata */
-		CustomData_from_bmesh_block(&bm->pdata, &me->pdata, f->head.data, i);
-
-		i++;
-		mpoly++;
-		BM_CHECK_ELEMENT(f);
+	{
+		BMeshToMeshData data = {
+			.bm = bm, .me = me,
+			.mvert = mvert, .medge = medge, .mloop = mloop, .mpoly = mpoly,
+			.cd_vert_bweight_offset = cd_vert_bweight_offset,
+			.cd_edge_bweight_offset = cd_edge_bweight_offset,
+			.cd_edge_crease_offset = cd_edge_crease_offset,
+		};
+
+		BLI_task_parallel_range(0, bm->totvert, &data, bm_mesh_bm_to_me_verts_cb, bm->totvert >= BM_THREAD_LIMIT);
+		BLI_task_parallel_range(0, bm->totedge, &data, bm_mesh_bm_to_me_edges_cb, bm->totedge >= BM_THREAD_LIMIT);
+		BLI_task_parallel_range(0, bm->totface, &data, bm_mesh_bm_to_me_faces_cb, bm->totface >= BM_THREAD_LIMIT);
 	}
 
 	/* patch hook indices and vertex parents */
@@ -34,6 +34,7 @@
 #include "BLI_memarena.h"
 #include "BLI_mempool.h"
 #include "BLI_listbase.h"
+#include "BLI_task.h"
 
 #include "BLT_translation.h"
 
@@ -544,48 +545,76 @@ void BMO_slot_vec_get(BMOpSlot slot_args[BMO_OP_MAX_SLOTS], const char *slot_nam
  *
  */
 
-static int bmo_mesh_flag_count(
-        BMesh *bm, const char htype, const short oflag,
-        const bool test_for_enabled)
-{
-	int count_vert = 0, count_edge = 0, count_face = 0;
-
-#pragma omp parallel sections if ((bm->totvert + bm->totedge + bm->totface >= BM_OMP_LIMIT) && \
-	                              (ELEM(htype, BM_VERT, BM_EDGE, BM_FACE) == 0))
-	{
-#pragma omp section
-		if (htype & BM_VERT) {
-			BMIter iter;
-			BMVert *ele;
-			BM_ITER_MESH (ele, &iter, bm, BM_VERTS_OF_MESH) {
-				if (BMO_vert_flag_test_bool(bm, ele, oflag) == test_for_enabled) {
-					count_vert++;
+typedef struct BMOFlagData {
+	BMesh *bm;
+	char htype;
+	short oflag;
+	bool test_for_enabled;
+
+	/* Per element type result of #bmo_mesh_flag_count. */
+	int count[3];
+} BMOFlagData;
+
+static void bmo_mesh_flag_count_cb(void *userdata, int section)
+{
+	BMOFlagData *data = userdata;
+	BMesh *bm = data->bm;
+	const char htype = data->htype;
+	const short oflag = data->oflag;
+	const bool test_for_enabled = data->test_for_enabled;
+	int count = 0;
+
+	switch (section) {
+		case 0:
+			if (htype & BM_VERT) {
+				BMIter iter;
+				BMVert *ele;
+				BM_ITER_MESH (ele, &iter, bm, BM_VERTS_OF_MESH) {
+					if (BMO_vert_flag_test_bool(bm, ele, oflag) == test_for_enabled) {
+						count++;
+					}
 				}
 			}
-		}
-#pragma omp section
-		if (htype & BM_EDGE) {
-			BMIter iter;
-			BMEdge *ele;
-			BM_ITER_MESH (ele, &iter, bm, BM_EDGES_OF_MESH) {
-				if (BMO_edge_flag_test_bool(bm, ele, oflag) == test_for_enabled) {
-					count_edge++;
+			break;
+		case 1:
+			if (htype & BM_EDGE) {
+				BMIter iter;
+				BMEdge *ele;
+				BM_ITER_MESH (ele, &iter, bm, BM_EDGES_OF_MESH) {
+					if (BMO_edge_flag_test_bool(bm, ele, oflag) == test_for_enabled) {
+						count++;
+					}
 				}
 			}
-		}
-#pragma omp section
-		if (htype & BM_FACE) {
-			BMIter iter;
-			BMFace *ele;
-			BM_ITER_MESH (ele, &iter, bm, BM_FACES_OF_MESH) {
-				if (BMO_face_flag_test_bool(bm, ele, oflag) == test_for_enabled) {
-					count_face++;
+			break;
+		case 2:
+			if (htype & BM_FACE) {
+				BMIter iter;
+				BMFace *ele;
+				BM_ITER_MESH (ele, &iter, bm, BM_FACES_OF_MESH) {
+					if (BMO_face_flag_test_bool(bm, ele, oflag) == test_for_enabled) {
+						count++;
+					}
 				}
 			}
-		}
+			break;
 	}
 
-	return (count_vert + count_edge + count_face);
+	data->count[section] = count;
+}
+
+static int bmo_mesh_flag_count(
+        BMesh *bm, const char htype, const short oflag,
+        const bool test_for_enabled)
+{
+	BMOFlagData data = {bm, htype, oflag, test_for_enabled, {0}};
+
+	BLI_task_parallel_range(
+	        0, 3, &data, bmo_mesh_flag_count_cb,
+	        (bm->totvert + bm->totedge + bm->totface >= BM_THREAD_LIMIT) &&
+	        (ELEM(htype, BM_VERT, BM_EDGE, BM_FACE) == 0));
+
+	return (data.count[0] + data.count[1] + data.count[2]);
 }
 
 
@@ -599,39 +628,54 @@ int BMO_mesh_disabled_flag_count(BMesh *bm, const char htype, const short oflag)
 	return bmo_mesh_flag_count(bm, htype, oflag, false);
 }
 
-void BMO_mesh_flag_disable_all(BMesh *bm, BMOperator *UNUSED(op), const char htype, const short oflag)
+static void bmo_mesh_flag_disable_all_cb(void *userdata, int section)
 {
+	BMOFlagData *data = userdata;
+	BMesh *bm = data->bm;
+	const char htype = data->htype;
+	const short oflag = data->oflag;
 
-#pragma omp parallel sections if ((bm->totvert + bm->totedge + bm->totface >= BM_OMP_LIMIT) && \
-	                              (ELEM(htype, BM_VERT, BM_EDGE, BM_FACE) == 0))
-	{
-#pragma omp section
-		if (htype & BM_VERT) {
-			BMIter iter;
-			BMVert *ele;
-			BM_ITER_MESH (ele, &iter, bm, BM_VERTS_OF_MESH) {
-				BMO_vert_flag_disable(bm, ele, oflag);
+	switch (section) {
+		case 0:
+			if (htype & BM_VERT) {
+				BMIter iter;
+				BMVert *ele;
+				BM_ITER_MESH (ele, &iter, bm, BM_VERTS_OF_MESH) {
+					BMO_vert_flag_disable(bm, ele, oflag);
+				}
 			}
-		}
-#pragma omp section
-		if (htype & BM_EDGE) {
-			BMIter iter;
-			BMEdge *ele;
-			BM_ITER_MESH (ele, &iter, bm, BM_EDGES_OF_MESH) {
-				BMO_edge_flag_disable(bm, ele, oflag);
+			break;
+		case 1:
+			if (htype & BM_EDGE) {
+				BMIter iter;
+				BMEdge *ele;
+				BM_ITER_MESH (ele, &iter, bm, BM_EDGES_OF_MESH) {
+					BMO_edge_flag_disable(bm, ele, oflag);
+				}
 			}
-		}
-#pragma omp section
-		if (htype & BM_FACE) {
-			BMIter iter;
-			BMFace *ele;
-			BM_ITER_MESH (ele, &iter, bm, BM_FACES_OF_MESH) {
-				BMO_face_flag_disable(bm, ele, oflag);
+			break;
+		case 2:
+			if (htype & BM_FACE) {
+				BMIter iter;
+				BMFace *ele;
+				BM_ITER_MESH (ele, &iter, bm, BM_FACES_OF_MESH) {
+					BMO_face_flag_disable(bm, ele, oflag);
+				}
 			}
-		}
+			break;
 	}
 }
 
+void BMO_mesh_flag_disable_all(BMesh *bm, BMOperator *UNUSED(op), const char htype, const short oflag)
+{
+	BMOFlagData data = {bm, htype, oflag, false, {0}};
+
+	BLI_task_parallel_range(
+	        0, 3, &data, bmo_mesh_flag_disable_all_cb,
+	        (bm->totvert + bm->totedge + bm->totface >= BM_THREAD_LIMIT) &&
+	        (ELEM(htype, BM_VERT, BM_EDGE, BM_FACE) == 0));
+}
+
 void BMO_mesh_selected_remap(
         BMesh *bm,
         BMOpSlot *slot_vert_map,
@@ -1205,40 +1249,20 @@ void BMO_slot_buffer_flag_disable(
 }
 
 
-/**
- * \brief ALLOC/FREE FLAG LAYER
- *
- * Used by operator stack to free/allocate
- * private flag data. This is allocated
- * using a mempool so the allocation/frees
- * should be quite fast.
- *
- * BMESH_TODO:
- * Investigate not freeing flag layers until
- * all operators have been executed. This would
- * save a lot of realloc potentially.
- */
-static void bmo_flag_layer_alloc(BMesh *bm)
-{
-	/* set the index values since we are looping over all data anyway,
-	 * may save time later on */
-
-	BLI_mempool *voldpool = bm->vtoolflagpool;  /* old flag pool */
-	BLI_mempool *eoldpool = bm->etoolflagpool;  /* old flag pool */
-	BLI_mempool *foldpool = bm->ftoolflagpool;  /* old flag pool */
-
-	/* store memcpy size for reuse */
-	const size_t old_totflags_size = (bm->totflags * sizeof(BMFlagLayer));
+typedef struct BMOFlagLayerData {
+	BMesh *bm;
+	size_t totflags_size;
+	int totflags_offset;
+} BMOFlagLayerData;
 
-	bm->totflags++;
-
-	bm->vtoolflagpool = BLI_mempool_create(sizeof(BMFlagLayer) * bm->totflags, bm->totvert, 512, BLI_MEMPOOL_NOP);
-	bm->etoolflagpool = BLI_mempool_create(sizeof(BMFlagLayer) * bm->totflags, bm->totedge, 512, BLI_MEMPOOL_NOP);
-	bm->ftoolflagpool = BLI_mempool_create(sizeof(BMFlagLayer) * bm->totflags, bm->totface, 512, BLI_MEMPOOL_NOP);
+static void bmo_flag_layer_alloc_cb(void *userdata, int section)
+{
+	BMOFlagLayerData *data = userdata;
+	BMesh *bm = data->bm;
+	const size_t old_totflags_size = data->totflags_size;
 
-#pragma omp parallel sections if (bm->totvert + bm->totedge + bm->totface >= BM_OMP_LIMIT)
-	{
-#pragma omp section
+	switch (section) {
+		case 0:
 		{
 			BMIter iter;
 			BMVert_OFlag *ele;
@@ -1254,8 +1278,9 @@ static void bmo_flag_layer_alloc(BMesh *bm)
 				BM_elem_index_set(&ele->base, i); /* set_inline */
 				BM_ELEM_API_FLAG_CLEAR((BMElemF *)ele);
 			}
+			break;
 		}
-#pragma omp section
+		case 1:
 		{
 			BMIter iter;
 			BMEdge_OFlag *ele;
@@ -1270,8 +1295,9 @@ static void bmo_flag_layer_alloc(BMesh *bm)
 				BM_elem_index_set(&ele->base, i); /* set_inline */
 				BM_ELEM_API_FLAG_CLEAR((BMElemF *)ele);
 			}
+			break;
 		}
-#pragma omp section
+		case 2:
 		{
 			BMIter iter;
 			BMFace_OFlag *ele;
@@ -1286,38 +1312,61 @@ static void bmo_flag_layer_alloc(BMesh *bm)
 				BM_elem_index_set(&ele->base, i); /* set_inline */
 				BM_ELEM_API_FLAG_CLEAR((BMElemF *)ele);
 			}
+			break;
 		}
 	}
-
-	BLI_mempool_destroy(voldpool);
-	BLI_mempool_destroy(eoldpool);
-	BLI_mempool_destroy(foldpool);
-
-	bm->elem_index_dirty &= ~(BM_VERT | BM_EDGE | BM_FACE);
 }
 
-static void bmo_flag_layer_free(BMesh *bm)
+/**
+ * \brief ALLOC/FREE FLAG LAYER
+ *
+ * Used by operator stack to free/allocate
+ * private flag data. This is allocated
+ * using a mempool so the allocation/frees
+ * should be quite fast.
+ *
+ * BMESH_TODO:
+ * Investigate not freeing flag layers until
+ * all operators have been executed. This would
+ * save a lot of realloc potentially.
+ */
+static void bmo_flag_layer_alloc(BMesh *bm)
 {
 	/* set the index values since we are looping over all data anyway,
 	 * may save time later on */
 
-	BLI_mempool *voldpool = bm->vtoolflagpool;
-	BLI_mempool *eoldpool = bm->etoolflagpool;
-	BLI_mempool *foldpool = bm->ftoolflagpool;
+	BLI_mempool *voldpool = bm->vtoolflagpool;  /* old flag pool */
+	BLI_mempool *eoldpool = bm->etoolflagpool;  /* old flag pool */
+	BLI_mempool *foldpool = bm->ftoolflagpool;  /* old flag pool */
 
 	/* store memcpy size for reuse */
-	const size_t new_totflags_size = ((bm->totflags - 1) * sizeof(BMFlagLayer));
+	const size_t old_totflags_size = (bm->totflags * sizeof(BMFlagLayer));
 
-	/* de-increment the totflags first.. */
-	bm->totflags--;
+	bm->totflags++;
 
-	bm->vtoolflagpool = BLI_mempool_create(new_totflags_size, bm->totvert, 512, BLI_MEMPOOL_NOP);
-	bm->etoolflagpool = BLI_mempool_create(new_totflags_size, bm->totedge, 512, BLI_MEMPOOL_NOP);
-	bm->ftoolflagpool = BLI_mempool_create(new_totflags_size, bm->totface, 512, BLI_MEMPOOL_NOP);
+	bm->vtoolflagpool = BLI_mempool_create(sizeof(BMFlagLayer) * bm->totflags, bm->totvert, 512, BLI_MEMPOOL_NOP);
+	bm->etoolflagpool = BLI_mempool_create(sizeof(BMFlagLayer) * bm->totflags, bm->totedge, 512, BLI_MEMPOOL_NOP);
+	bm->ftoolflagpool = BLI_mempool_create(sizeof(BMFlagLayer) * bm->totflags, bm->totface, 512, BLI_MEMPOOL_NOP);
 
-#pragma omp parallel sections if (bm->totvert + bm->totedge + bm->totface >= BM_OMP_LIMIT)
-	{
-#pragma omp section
+	BMOFlagLayerData data = {bm, old_totflags_size, 0};
+
+	BLI_task_parallel_range(0, 3, &data, bmo_flag_layer_alloc_cb, bm->totvert + bm->totedge + bm->totface >= BM_THREAD_LIMIT);
+
+	BLI_mempool_destroy(voldpool);
+	BLI_mempool_destroy(eoldpool);
+	BLI_mempool_destroy(foldpool);
+
+	bm->elem_index_dirty &= ~(BM_VERT | BM_EDGE | BM_FACE);
+}
+
+static void bmo_flag_layer_free_cb(void *userdata, int section)
+{
+	BMOFlagLayerData *data = userdata;
+	BMesh *bm = data->bm;
+	const size_t new_totflags_size = data->totflags_size;
+
+	switch (section) {
+		case 0:
 		{
 			BMIter iter;
 			BMVert_OFlag *ele;
@@ -1333,8 +1382,9 @@ static void bmo_flag_layer_free(BMesh *bm)
 				BM_elem_index_set(&ele->base, i); /* set_inline */
 				BM_ELEM_API_FLAG_CLEAR((BMElemF *)ele);
 			}
+			break;
 		}
-#pragma omp section
+		case 1:
 		{
 			BMIter iter;
 			BMEdge_OFlag *ele;
@@ -1349,8 +1399,9 @@ static void bmo_flag_layer_free(BMesh *bm)
 				BM_elem_index_set(&ele->base, i); /* set_inline */
 				BM_ELEM_API_FLAG_CLEAR((BMElemF *)ele);
 			}
+			break;
 		}
-#pragma omp section
+		case 2:
 		{
 			BMIter iter;
 			BMFace_OFlag *ele;
@@ -1365,8 +1416,33 @@ static void bmo_flag_layer_free(BMesh *bm)
 				BM_elem_index_set(&ele->base, i); /* set_inline */
 				BM_ELEM_API_FLAG_CLEAR((BMElemF *)ele);
 			}
+			break;
 		}
 	}
+}
+
+static void bmo_flag_layer_free(BMesh *bm)
+{
+	/* set the index values since we are looping over all data anyway,
+	 * may save time later on */
+
+	BLI_mempool *voldpool = bm->vtoolflagpool;
+	BLI_mempool *eoldpool = bm->etoolflagpool;
+	BLI_mempool *foldpool = bm->ftoolflagpool;
+
+	/* store memcpy size for reuse */
+	const size_t new_totflags_size = ((bm->totflags - 1) * sizeof(BMFlagLayer));
+
+	/* de-increment the totflags first.. */
+	bm->totflags--;
+
+	bm->vtoolflagpool = BLI_mempool_create(new_totflags_size, bm->totvert, 512, BLI_MEMPOOL_NOP);
+	bm->etoolflagpool = BLI_mempool_create(new_totflags_size, bm->totedge, 512, BLI_MEMPOOL_NOP);
+	bm->ftoolflagpool = BLI_mempool_create(new_totflags_size, bm->totface, 512, BLI_MEMPOOL_NOP);
+
+	BMOFlagLayerData data = {bm, new_totflags_size, 0};
+
+	BLI_task_parallel_range(0, 3, &data, bmo_flag_layer_free_cb, bm->totvert + bm->totedge + bm->totface >= BM_THREAD_LIMIT);
 
 	BLI_mempool_destroy(voldpool);
 	BLI_mempool_destroy(eoldpool);
@@ -1375,18 +1451,15 @@ static void bmo_flag_layer_free(BMesh *bm)
 	bm->elem_index_dirty &= ~(BM_VERT | BM_EDGE | BM_FACE);
 }
 
-static void bmo_flag_layer_clear(BMesh *bm)
+static void bmo_flag_layer_clear_cb(void *userdata, int section)
 {
-	/* set the index values since we are looping over all data anyway,
-	 * may save time later on */
+	BMOFlagLayerData *data = userdata;
+	BMesh *bm = data->bm;
 	const BMFlagLayer zero_flag = {0};
+	const int totflags_offset = data->totflags_offset;
 
-	const int totflags_offset = bm->totflags - 1;
-
-#pragma omp parallel sections if (bm->totvert + bm->totedge + bm->totface >= BM_OMP_LIMIT)
-	{
-		/* now go through and memcpy all the flag */
-#pragma omp section
+	switch (section) {
+		case 0:
 		{
 			BMIter iter;
 			BMVert_OFlag *ele;
@@ -1395,8 +1468,9 @@ static void bmo_flag_layer_clear(BMesh *bm)
 				ele->oflags[totflags_offset] = zero_flag;
 				BM_elem_index_set(&ele->base, i); /* set_inline */
 			}
+			break;
 		}
-#pragma omp section
+		case 1:
 		{
 			BMIter iter;
 			BMEdge_OFlag *ele;
@@ -1405,8 +1479,9 @@ static void bmo_flag_layer_clear(BMesh *bm)
 				ele->oflags[totflags_offset] = zero_flag;
 				BM_elem_index_set(&ele->base, i); /* set_inline */
 			}
+			break;
 		}
-#pragma omp section
+		case 2:
 		{
 			BMIter iter;
 			BMFace_OFlag *ele;
@@ -1415,8 +1490,19 @@ static void bmo_flag_layer_clear(BMesh *bm)
 				ele->oflags[totflags_offset] = zero_flag;
 				BM_elem_index_set(&ele->base, i); /* set_inline */
 			}
+			break;
 		}
 	}
+}
+
+static void bmo_flag_layer_clear(BMesh *bm)
+{
+	/* set the index values since we are looping over all data anyway,
+	 * may save time later on */
+	BMOFlagLayerData data = {bm, 0, bm->totflags - 1};
+
+	/* now go through and memcpy all the flag */
+	BLI_task_parallel_range(0, 3, &data, bmo_flag_layer_clear_cb, bm->totvert + bm->totedge + bm->totface >= BM_THREAD_LIMIT);
 
 	bm->elem_index_dirty &= ~(BM_VERT | BM_EDGE | BM_FACE);
 }
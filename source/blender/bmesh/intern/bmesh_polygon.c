@@ -887,249 +887,247 @@ bool BM_face_point_inside_test(const BMFace *f, const float co[3])
 }
 
 /**
- * \brief BMESH TRIANGULATE FACE
+ * Calculate the triangles #BM_face_triangulate creates, without modifying the mesh.
  *
- * Breaks all quads and ngons down to triangles.
- * It uses polyfill for the ngons splitting, and
- * the beautify operator when use_beauty is true.
+ * This only reads the face (and its vertex coordinates),
+ * so it can run for many faces in parallel before they're triangulated.
  *
- * \param r_faces_new if non-null, must be an array of BMFace pointers,
- * with a length equal to (f->len - 3). It will be filled with the new
- * triangles (not including the original triangle).
- *
- * \param r_faces_double: When newly created faces are duplicates of existing faces, they're added to this list.
- * Caller must handle de-duplication.
- * This is done because its possible _all_ faces exist already,
- * and in that case we would have to remove all faces including the one passed,
- * which causes complications adding/removing faces while looking over them.
- *
- * \note The number of faces is _almost_ always (f->len - 3),
- *       However there may be faces that already occupying the
- *       triangles we would make, so the caller must check \a r_faces_new_tot.
- *
- * \note use_tag tags new flags and edges.
+ * \param r_loops: Filled with the faces loops, the triangles index into this array (length \a f->len).
+ * \param r_tris: Filled with the triangles (length \a f->len - 2).
  */
-void BM_face_triangulate(
-        BMesh *bm, BMFace *f,
-        BMFace **r_faces_new,
-        int     *r_faces_new_tot,
-        BMEdge **r_edges_new,
-        int     *r_edges_new_tot,
-        LinkNode **r_faces_double,
+void BM_face_triangulate_calc(
+        BMFace *f,
+        BMLoop **r_loops,
+        uint (*r_tris)[3],
         const int quad_method,
         const int ngon_method,
-        const bool use_tag,
         /* use for ngons only! */
         MemArena *pf_arena,
 
         /* use for MOD_TRIANGULATE_NGON_BEAUTY only! */
         struct Heap *pf_heap, struct EdgeHash *pf_ehash)
 {
-	const int cd_loop_mdisp_offset = CustomData_get_offset(&bm->ldata, CD_MDISPS);
 	const bool use_beauty = (ngon_method == MOD_TRIANGULATE_NGON_BEAUTY);
-	BMLoop *l_first, *l_new;
-	BMFace *f_new;
-	int nf_i = 0;
-	int ne_i = 0;
+	BMLoop *l_first;
+	int i;
 
 	BLI_assert(BM_face_is_normal_valid(f));
+	BLI_assert(f->len > 3);
 
-	/* ensure both are valid or NULL */
-	BLI_assert((r_faces_new == NULL) == (r_faces_new_tot == NULL));
+	if (f->len == 4) {
+		/* even though we're not using BLI_polyfill, fill in 'tris' and 'loops'
+		 * so we can share code to handle face creation afterwards. */
+		BMLoop *l_v1, *l_v2;
 
-	BLI_assert(f->len > 3);
+		l_first = BM_FACE_FIRST_LOOP(f);
 
-	{
-		BMLoop **loops = BLI_array_alloca(loops, f->len);
-		uint (*tris)[3] = BLI_array_alloca(tris, f->len);
-		const int totfilltri = f->len - 2;
-		const int last_tri = f->len - 3;
-		int i;
-		/* for mdisps */
-		float f_center[3];
-
-		if (f->len == 4) {
-			/* even though we're not using BLI_polyfill, fill in 'tris' and 'loops'
-			 * so we can share code to handle face creation afterwards. */
-			BMLoop *l_v1, *l_v2;
-
-			l_first = BM_FACE_FIRST_LOOP(f);
-
-			switch (quad_method) {
-				case MOD_TRIANGULATE_QUAD_FIXED:
-				{
-					l_v1 = l_first;
-					l_v2 = l_first->next->next;
-					break;
-				}
-				case MOD_TRIANGULATE_QUAD_ALTERNATE:
-				{
-					l_v1 = l_first->next;
-					l_v2 = l_first->prev;
-					break;
+		switch (quad_method) {
+			case MOD_TRIANGULATE_QUAD_FIXED:
+			{
+				l_v1 = l_first;
+				l_v2 = l_first->next->next;
+				break;
+			}
+			case MOD_TRIANGULATE_QUAD_ALTERNATE:
+			{
+				l_v1 = l_first->next;
+				l_v2 = l_first->prev;
+				break;
+			}
+			case MOD_TRIANGULATE_QUAD_SHORTEDGE:
+			case MOD_TRIANGULATE_QUAD_BEAUTY:
+			default:
+			{
+				BMLoop *l_v3, *l_v4;
+				bool split_24;
+
+				l_v1 = l_first->next;
+				l_v2 = l_first->next->next;
+				l_v3 = l_first->prev;
+				l_v4 = l_first;
+
+				if (quad_method == MOD_TRIANGULATE_QUAD_SHORTEDGE) {
+					float d1, d2;
+					d1 = len_squared_v3v3(l_v4->v->co, l_v2->v->co);
+					d2 = len_squared_v3v3(l_v1->v->co, l_v3->v->co);
+					split_24 = ((d2 - d1) > 0.0f);
 				}
-				case MOD_TRIANGULATE_QUAD_SHORTEDGE:
-				case MOD_TRIANGULATE_QUAD_BEAUTY:
-				default:
-				{
-					BMLoop *l_v3, *l_v4;
-					bool split_24;
-
-					l_v1 = l_first->next;
-					l_v2 = l_first->next->next;
-					l_v3 = l_first->prev;
-					l_v4 = l_first;
-
-					if (quad_method == MOD_TRIANGULATE_QUAD_SHORTEDGE) {
-						float d1, d2;
-						d1 = len_squared_v3v3(l_v4->v->co, l_v2->v->co);
-						d2 = len_squared_v3v3(l_v1->v->co, l_v3->v->co);
-						split_24 = ((d2 - d1) > 0.0f);
+				else {
+					/* first check if the quad is concave on either diagonal */
+					const int flip_flag = is_quad_flip_v3(l_v1->v->co, l_v2->v->co, l_v3->v->co, l_v4->v->co);
+					if (UNLIKELY(flip_flag & (1 << 0))) {
+						split_24 = true;
 					}
-					else {
-						/* first check if the quad is concave on either diagonal */
-						const int flip_flag = is_quad_flip_v3(l_v1->v->co, l_v2->v->co, l_v3->v->co, l_v4->v->co);
-						if (UNLIKELY(flip_flag & (1 << 0))) {
-							split_24 = true;
-						}
-						else if (UNLIKELY(flip_flag & (1 << 1))) {
-							split_24 = false;
-						}
-						else {
-							split_24 = (BM_verts_calc_rotate_beauty(l_v1->v, l_v2->v, l_v3->v, l_v4->v, 0, 0) > 0.0f);
-						}
-					}
-
-					/* named confusingly, l_v1 is in fact the second vertex */
-					if (split_24) {
-						l_v1 = l_v4;
-						//l_v2 = l_v2;
+					else if (UNLIKELY(flip_flag & (1 << 1))) {
+						split_24 = false;
 					}
 					else {
-						//l_v1 = l_v1;
-						l_v2 = l_v3;
+						split_24 = (BM_verts_calc_rotate_beauty(l_v1->v, l_v2->v, l_v3->v, l_v4->v, 0, 0) > 0.0f);
 					}
-					break;
 				}
-			}
 
-			loops[0] = l_v1;
-			loops[1] = l_v1->next;
-			loops[2] = l_v2;
-			loops[3] = l_v2->next;
-
-			ARRAY_SET_ITEMS(tris[0], 0, 1, 2);
-			ARRAY_SET_ITEMS(tris[1], 0, 2, 3);
+				/* named confusingly, l_v1 is in fact the second vertex */
+				if (split_24) {
+					l_v1 = l_v4;
+					//l_v2 = l_v2;
+				}
+				else {
+					//l_v1 = l_v1;
+					l_v2 = l_v3;
+				}
+				break;
+			}
 		}
-		else {
-			BMLoop *l_iter;
-			float axis_mat[3][3];
-			float (*projverts)[2] = BLI_array_alloca(projverts, f->len);
-
-			axis_dominant_v3_to_m3_negate(axis_mat, f->no);
 
-			for (i = 0, l_iter = BM_FACE_FIRST_LOOP(f); i < f->len; i++, l_iter = l_iter->next) {
-				loops[i] = l_iter;
-				mul_v2_m3v3(projverts[i], axis_mat, l_iter->v->co);
-			}
+		r_loops[0] = l_v1;
+		r_loops[1] = l_v1->next;
+		r_loops[2] = l_v2;
+		r_loops[3] = l_v2->next;
 
-			BLI_polyfill_calc_arena((const float (*)[2])projverts, f->len, 1, tris,
-			                        pf_arena);
+		ARRAY_SET_ITEMS(r_tris[0], 0, 1, 2);
+		ARRAY_SET_ITEMS(r_tris[1], 0, 2, 3);
+	}
+	else {
+		BMLoop *l_iter;
+		float axis_mat[3][3];
+		float (*projverts)[2] = BLI_array_alloca(projverts, f->len);
 
-			if (use_beauty) {
-				BLI_polyfill_beautify(
-				        (const float (*)[2])projverts, f->len, tris,
-				        pf_arena, pf_heap, pf_ehash);
-			}
+		axis_dominant_v3_to_m3_negate(axis_mat, f->no);
 
-			BLI_memarena_clear(pf_arena);
+		for (i = 0, l_iter = BM_FACE_FIRST_LOOP(f); i < f->len; i++, l_iter = l_iter->next) {
+			r_loops[i] = l_iter;
+			mul_v2_m3v3(projverts[i], axis_mat, l_iter->v->co);
 		}
 
-		if (cd_loop_mdisp_offset != -1) {
-			BM_face_calc_center_mean(f, f_center);
+		BLI_polyfill_calc_arena((const float (*)[2])projverts, f->len, 1, r_tris,
+		                        pf_arena);
+
+		if (use_beauty) {
+			BLI_polyfill_beautify(
+			        (const float (*)[2])projverts, f->len, r_tris,
+			        pf_arena, pf_heap, pf_ehash);
 		}
 
-		/* loop over calculated triangles and create new geometry */
-		for (i = 0; i < totfilltri; i++) {
-			BMLoop *l_tri[3] = {
-			    loops[tris[i][0]],
-			    loops[tris[i][1]],
-			    loops[tris[i][2]]};
+		BLI_memarena_clear(pf_arena);
+	}
+}
+
+/**
+ * Create the triangles calculated by #BM_face_triangulate_calc,
+ * see #BM_face_triangulate for a description of the arguments.
+ */
+void BM_face_triangulate_from_tris(
+        BMesh *bm, BMFace *f,
+        BMLoop **loops,
+        const uint (*tris)[3],
+        BMFace **r_faces_new,
+        int     *r_faces_new_tot,
+        BMEdge **r_edges_new,
+        int     *r_edges_new_tot,
+        LinkNode **r_faces_double,
+        const bool use_tag)
+{
+	const int cd_loop_mdisp_offset = CustomData_get_offset(&bm->ldata, CD_MDISPS);
+	const int totfilltri = f->len - 2;
+	const int last_tri = f->len - 3;
+	BMLoop *l_first, *l_new;
+	BMFace *f_new;
+	int nf_i = 0;
+	int ne_i = 0;
+	int i;
+	/* for mdisps */
+	float f_center[3];
+
+	/* ensure both are valid or NULL */
+	BLI_assert((r_faces_new == NULL) == (r_faces_new_tot == NULL));
 
-			BMVert *v_tri[3] = {
-			    l_tri[0]->v,
-			    l_tri[1]->v,
-			    l_tri[2]->v};
+	BLI_assert(f->len > 3);
 
-			f_new = BM_face_create_verts(bm, v_tri, 3, f, BM_CREATE_NOP, true);
-			l_new = BM_FACE_FIRST_LOOP(f_new);
+	if (cd_loop_mdisp_offset != -1) {
+		BM_face_calc_center_mean(f, f_center);
+	}
 
-			BLI_assert(v_tri[0] == l_new->v);
+	/* loop over calculated triangles and create new geometry */
+	for (i = 0; i < totfilltri; i++) {
+		BMLoop *l_tri[3] = {
+		    loops[tris[i][0]],
+		    loops[tris[i][1]],
+		    loops[tris[i][2]]};
 
-			/* check for duplicate */
-			if (l_new->radial_next != l_new) {
-				BMLoop *l_iter = l_new->radial_next;
-				do {
-					if (UNLIKELY((l_iter->f->len == 3) && (l_new->prev->v == l_iter->prev->v))) {
-						/* Check the last tri because we swap last f_new with f at the end... */
-						BLI_linklist_prepend(r_faces_double, (i != last_tri) ? f_new : f);
-						break;
-					}
-				} while ((l_iter = l_iter->radial_next) != l_new);
-			}
+		BMVert *v_tri[3] = {
+		    l_tri[0]->v,
+		    l_tri[1]->v,
+		    l_tri[2]->v};
 
-			/* copy CD data */
-			BM_elem_attrs_copy(bm, bm, l_tri[0], l_new);
-			BM_elem_attrs_copy(bm, bm, l_tri[1], l_new->next);
-			BM_elem_attrs_copy(bm, bm, l_tri[2], l_new->prev);
+		f_new = BM_face_create_verts(bm, v_tri, 3, f, BM_CREATE_NOP, true);
+		l_new = BM_FACE_FIRST_LOOP(f_new);
 
-			/* add all but the last face which is swapped and removed (below) */
-			if (i != last_tri) {
-				if (use_tag) {
-					BM_elem_flag_enable(f_new, BM_ELEM_TAG);
-				}
-				if (r_faces_new) {
-					r_faces_new[nf_i++] = f_new;
+		BLI_assert(v_tri[0] == l_new->v);
+
+		/* check for duplicate */
+		if (l_new->radial_next != l_new) {
+			BMLoop *l_iter = l_new->radial_next;
+			do {
+				if (UNLIKELY((l_iter->f->len == 3) && (l_new->prev->v == l_iter->prev->v))) {
+					/* Check the last tri because we swap last f_new with f at the end... */
+					BLI_linklist_prepend(r_faces_double, (i != last_tri) ? f_new : f);
+					break;
 				}
-			}
+			} while ((l_iter = l_iter->radial_next) != l_new);
+		}
 
-			if (use_tag || r_edges_new) {
-				/* new faces loops */
-				BMLoop *l_iter;
+		/* copy CD data */
+		BM_elem_attrs_copy(bm, bm, l_tri[0], l_new);
+		BM_elem_attrs_copy(bm, bm, l_tri[1], l_new->next);
+		BM_elem_attrs_copy(bm, bm, l_tri[2], l_new->prev);
 
-				l_iter = l_first = l_new;
-				do {
-					BMEdge *e = l_iter->e;
-					/* confusing! if its not a boundary now, we know it will be later
-					 * since this will be an edge of one of the new faces which we're in the middle of creating */
-					bool is_new_edge = (l_iter == l_iter->radial_next);
-
-					if (is_new_edge) {
-						if (use_tag) {
-							BM_elem_flag_enable(e, BM_ELEM_TAG);
-						}
-						if (r_edges_new) {
-							r_edges_new[ne_i++] = e;
-						}
-					}
-					/* note, never disable tag's */
-				} while ((l_iter = l_iter->next) != l_first);
+		/* add all but the last face which is swapped and removed (below) */
+		if (i != last_tri) {
+			if (use_tag) {
+				BM_elem_flag_enable(f_new, BM_ELEM_TAG);
 			}
-
-			if (cd_loop_mdisp_offset != -1) {
-				float f_new_center[3];
-				BM_face_calc_center_mean(f_new, f_new_center);
-				BM_face_interp_multires_ex(bm, f_new, f, f_new_center, f_center, cd_loop_mdisp_offset);
+			if (r_faces_new) {
+				r_faces_new[nf_i++] = f_new;
 			}
 		}
 
-		{
-			/* we can't delete the real face, because some of the callers expect it to remain valid.
-			 * so swap data and delete the last created tri */
-			bmesh_face_swap_data(f, f_new);
-			BM_face_kill(bm, f_new);
+		if (use_tag || r_edges_new) {
+			/* new faces loops */
+			BMLoop *l_iter;
+
+			l_iter = l_first = l_new;
+			do {
+				BMEdge *e = l_iter->e;
+				/* confusing! if its not a boundary now, we know it will be later
+				 * since this will be an edge of one of the new faces which we're in the middle of creating */
+				bool is_new_edge = (l_iter == l_iter->radial_next);
+
+				if (is_new_edge) {
+					if (use_tag) {
+						BM_elem_flag_enable(e, BM_ELEM_TAG);
+					}
+					if (r_edges_new) {
+						r_edges_new[ne_i++] = e;
+					}
+				}
+				/* note, never disable tag's */
+			} while ((l_iter = l_iter->next) != l_first);
+		}
+
+		if (cd_loop_mdisp_offset != -1) {
+			float f_new_center[3];
+			BM_face_calc_center_mean(f_new, f_new_center);
+			BM_face_interp_multires_ex(bm, f_new, f, f_new_center, f_center, cd_loop_mdisp_offset);
 		}
 	}
+
+	{
+		/* we can't delete the real face, because some of the callers expect it to remain valid.
+		 * so swap data and delete the last created tri */
+		bmesh_face_swap_data(f, f_new);
+		BM_face_kill(bm, f_new);
+	}
+
 	bm->elem_index_dirty |= BM_FACE;
 
 	if (r_faces_new_tot) {
@@ -1141,6 +1139,60 @@ void BM_face_triangulate(
 	}
 }
 
+/**
+ * \brief BMESH TRIANGULATE FACE
+ *
+ * Breaks all quads and ngons down to triangles.
+ * It uses polyfill for the ngons splitting, and
+ * the beautify operator when use_beauty is true.
+ *
+ * \param r_faces_new if non-null, must be an array of BMFace pointers,
+ * with a length equal to (f->len - 3). It will be filled with the new
+ * triangles (not including the original triangle).
+ *
+ * \param r_faces_double: When newly created faces are duplicates of existing faces, they're added to this list.
+ * Caller must handle de-duplication.
+ * This is done because its possible _all_ faces exist already,
+ * and in that case we would have to remove all faces including the one passed,
+ * which causes complications adding/removing faces while looking over them.
+ *
+ * \note The number of faces is _almost_ always (f->len - 3),
+ *       However there may be faces that already occupying the
+ *       triangles we would make, so the caller must check \a r_faces_new_tot.
+ *
+ * \note use_tag tags new flags and edges.
+ */
+void BM_face_triangulate(
+        BMesh *bm, BMFace *f,
+        BMFace **r_faces_new,
+        int     *r_faces_new_tot,
+        BMEdge **r_edges_new,
+        int     *r_edges_new_tot,
+        LinkNode **r_faces_double,
+        const int quad_method,
+        const int ngon_method,
+        const bool use_tag,
+        /* use for ngons only! */
+        MemArena *pf_arena,
+
+        /* use for MOD_TRIANGULATE_NGON_BEAUTY only! */
+        struct Heap *pf_heap, struct EdgeHash *pf_ehash)
+{
+	BMLoop **loops = BLI_array_alloca(loops, f->len);
+	uint (*tris)[3] = BLI_array_alloca(tris, f->len);
+
+	BM_face_triangulate_calc(
+	        f, loops, tris,
+	        quad_method, ngon_method,
+	        pf_arena, pf_heap, pf_ehash);
+
+	BM_face_triangulate_from_tris(
+	        bm, f, loops, (const uint (*)[3])tris,
+	        r_faces_new, r_faces_new_tot,
+	        r_edges_new, r_edges_new_tot,
+	        r_faces_double, use_tag);
+}
+
 /**
  * each pair of loops defines a new edge, a split.  this function goes
  * through and sets pairs that are geometrically invalid to null.  a
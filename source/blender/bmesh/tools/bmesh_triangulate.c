@@ -37,6 +37,8 @@
 #include "BLI_heap.h"
 #include "BLI_edgehash.h"
 #include "BLI_linklist.h"
+#include "BLI_math_base.h"
+#include "BLI_task.h"
 
 /* only for defines */
 #include "BLI_polyfill2d.h"
@@ -51,27 +53,21 @@
  */
 static void bm_face_triangulate_mapping(
         BMesh *bm, BMFace *face,
-        const int quad_method, const int ngon_method,
+        BMLoop **loops, const uint (*tris)[3],
         const bool use_tag,
-        BMOperator *op, BMOpSlot *slot_facemap_out, BMOpSlot *slot_facemap_double_out,
-
-        MemArena *pf_arena,
-        /* use for MOD_TRIANGULATE_NGON_BEAUTY only! */
-        struct Heap *pf_heap, struct EdgeHash *pf_ehash)
+        BMOperator *op, BMOpSlot *slot_facemap_out, BMOpSlot *slot_facemap_double_out)
 {
 	int faces_array_tot = face->len - 3;
 	BMFace  **faces_array = BLI_array_alloca(faces_array, faces_array_tot);
 	LinkNode *faces_double = NULL;
 	BLI_assert(face->len > 3);
 
-	BM_face_triangulate(
-	        bm, face,
+	BM_face_triangulate_from_tris(
+	        bm, face, loops, tris,
 	        faces_array, &faces_array_tot,
 	        NULL, NULL,
 	        &faces_double,
-	        quad_method, ngon_method, use_tag,
-	        pf_arena,
-	        pf_heap, pf_ehash);
+	        use_tag);
 
 	if (faces_array_tot) {
 		int i;
@@ -89,73 +85,140 @@ static void bm_face_triangulate_mapping(
 	}
 }
 
-
-void BM_mesh_triangulate(
-        BMesh *bm, const int quad_method, const int ngon_method, const bool tag_only,
-        BMOperator *op, BMOpSlot *slot_facemap_out, BMOpSlot *slot_facemap_double_out)
-{
-	BMIter iter;
-	BMFace *face;
+typedef struct TriangulateCalcData {
+	BMFace **faces;
+	/* each faces offset into 'loops', its triangles start at (offset - (2 * index)) */
+	int *faces_loop_offset;
+	BMLoop **loops;
+	uint (*tris)[3];
+	int quad_method;
+	int ngon_method;
+} TriangulateCalcData;
+
+/* thread local polyfill memory, only allocated when ngons are found */
+typedef struct TriangulateCalcChunk {
 	MemArena *pf_arena;
 	Heap *pf_heap;
 	EdgeHash *pf_ehash;
+} TriangulateCalcChunk;
+
+static void bm_mesh_triangulate_calc_cb(void *userdata, void *userdata_chunk, const int i, const int UNUSED(thread_id))
+{
+	TriangulateCalcData *data = userdata;
+	TriangulateCalcChunk *chunk = userdata_chunk;
+	BMFace *face = data->faces[i];
+	const int loop_offset = data->faces_loop_offset[i];
+
+	if ((face->len > 4) && (chunk->pf_arena == NULL)) {
+		chunk->pf_arena = BLI_memarena_new(BLI_POLYFILL_ARENA_SIZE, __func__);
+		if (data->ngon_method == MOD_TRIANGULATE_NGON_BEAUTY) {
+			chunk->pf_heap = BLI_heap_new_ex(BLI_POLYFILL_ALLOC_NGON_RESERVE);
+			chunk->pf_ehash = BLI_edgehash_new_ex(__func__, BLI_POLYFILL_ALLOC_NGON_RESERVE);
+		}
+	}
+
+	BM_face_triangulate_calc(
+	        face, &data->loops[loop_offset], &data->tris[loop_offset - (2 * i)],
+	        data->quad_method, data->ngon_method,
+	        chunk->pf_arena, chunk->pf_heap, chunk->pf_ehash);
+}
 
-	pf_arena = BLI_memarena_new(BLI_POLYFILL_ARENA_SIZE, __func__);
+static void bm_mesh_triangulate_calc_finalize(void *UNUSED(userdata), void *userdata_chunk)
+{
+	TriangulateCalcChunk *chunk = userdata_chunk;
 
-	if (ngon_method == MOD_TRIANGULATE_NGON_BEAUTY) {
-		pf_heap = BLI_heap_new_ex(BLI_POLYFILL_ALLOC_NGON_RESERVE);
-		pf_ehash = BLI_edgehash_new_ex(__func__, BLI_POLYFILL_ALLOC_NGON_RESERVE);
+	if (chunk->pf_arena) {
+		BLI_memarena_free(chunk->pf_arena);
+	}
+	if (chunk->pf_heap) {
+		BLI_heap_free(chunk->pf_heap, NULL);
 	}
-	else {
-		pf_heap = NULL;
-		pf_ehash = NULL;
+	if (chunk->pf_ehash) {
+		BLI_edgehash_free(chunk->pf_ehash, NULL);
 	}
+}
 
-	if (slot_facemap_out) {
-		/* same as below but call: bm_face_triangulate_mapping() */
-		BM_ITER_MESH (face, &iter, bm, BM_FACES_OF_MESH) {
-			if (face->len > 3) {
-				if (tag_only == false || BM_elem_flag_test(face, BM_ELEM_TAG)) {
-					bm_face_triangulate_mapping(
-					        bm, face,
-					        quad_method, ngon_method, tag_only,
-					        op, slot_facemap_out, slot_facemap_double_out,
-					        pf_arena,
-					        pf_heap, pf_ehash);
-				}
+/**
+ * Triangulate all (or only tagged) faces.
+ *
+ * Calculating the triangles of each face only reads the mesh,
+ * this runs in parallel first, the geometry is then created single threaded,
+ * in the same order as the faces are iterated over (so the result doesn't depend on threading).
+ */
+void BM_mesh_triangulate(
+        BMesh *bm, const int quad_method, const int ngon_method, const bool tag_only,
+        BMOperator *op, BMOpSlot *slot_facemap_out, BMOpSlot *slot_facemap_double_out)
+{
+	BMIter iter;
+	BMFace *face;
+	TriangulateCalcData data;
+	TriangulateCalcChunk chunk = {NULL};
+	LinkNode *faces_double = NULL;
+	int faces_len = 0, loops_len = 0;
+	int i;
+
+	data.faces = MEM_mallocN(sizeof(*data.faces) * (size_t)max_ii(bm->totface, 1), __func__);
+	data.faces_loop_offset = MEM_mallocN(sizeof(*data.faces_loop_offset) * (size_t)max_ii(bm->totface, 1), __func__);
+
+	BM_ITER_MESH (face, &iter, bm, BM_FACES_OF_MESH) {
+		if (face->len > 3) {
+			if (tag_only == false || BM_elem_flag_test(face, BM_ELEM_TAG)) {
+				data.faces[faces_len] = face;
+				data.faces_loop_offset[faces_len] = loops_len;
+				loops_len += face->len;
+				faces_len++;
 			}
 		}
 	}
-	else {
-		LinkNode *faces_double = NULL;
-
-		BM_ITER_MESH (face, &iter, bm, BM_FACES_OF_MESH) {
-			if (face->len > 3) {
-				if (tag_only == false || BM_elem_flag_test(face, BM_ELEM_TAG)) {
-					BM_face_triangulate(
-					        bm, face,
-					        NULL, NULL,
-					        NULL, NULL,
-					        &faces_double,
-					        quad_method, ngon_method, tag_only,
-					        pf_arena,
-					        pf_heap, pf_ehash);
-				}
-			}
-		}
 
-		while (faces_double) {
-			LinkNode *next = faces_double->next;
-			BM_face_kill(bm, faces_double->link);
-			MEM_freeN(faces_double);
-			faces_double = next;
-		}
+	if (faces_len == 0) {
+		MEM_freeN(data.faces);
+		MEM_freeN(data.faces_loop_offset);
+		return;
 	}
 
-	BLI_memarena_free(pf_arena);
+	data.loops = MEM_mallocN(sizeof(*data.loops) * (size_t)loops_len, __func__);
+	data.tris = MEM_mallocN(sizeof(*data.tris) * (size_t)(loops_len - (2 * faces_len)), __func__);
+	data.quad_method = quad_method;
+	data.ngon_method = ngon_method;
+
+	/* ngons vary a lot in size, use dynamic scheduling */
+	BLI_task_parallel_range_finalize(
+	        0, faces_len, &data, &chunk, sizeof(chunk),
+	        bm_mesh_triangulate_calc_cb, bm_mesh_triangulate_calc_finalize,
+	        faces_len >= BM_THREAD_LIMIT, true);
+
+	for (i = 0; i < faces_len; i++) {
+		const int loop_offset = data.faces_loop_offset[i];
+		BMLoop **loops = &data.loops[loop_offset];
+		const uint (*tris)[3] = (const uint (*)[3])&data.tris[loop_offset - (2 * i)];
+
+		face = data.faces[i];
 
-	if (ngon_method == MOD_TRIANGULATE_NGON_BEAUTY) {
-		BLI_heap_free(pf_heap, NULL);
-		BLI_edgehash_free(pf_ehash, NULL);
+		if (slot_facemap_out) {
+			bm_face_triangulate_mapping(
+			        bm, face, loops, tris, tag_only,
+			        op, slot_facemap_out, slot_facemap_double_out);
+		}
+		else {
+			BM_face_triangulate_from_tris(
+			        bm, face, loops, tris,
+			        NULL, NULL,
+			        NULL, NULL,
+			        &faces_double,
+			        tag_only);
+		}
 	}
+
+	while (faces_double) {
+		LinkNode *next = faces_double->next;
+		BM_face_kill(bm, faces_double->link);
+		MEM_freeN(faces_double);
+		faces_double = next;
+	}
+
+	MEM_freeN(data.faces);
+	MEM_freeN(data.faces_loop_offset);
+	MEM_freeN(data.loops);
+	MEM_freeN(data.tris);
 }
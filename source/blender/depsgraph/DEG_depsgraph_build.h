@@ -40,6 +40,7 @@ struct Depsgraph;
 
 /* ------------------------------------------------ */
 
+struct ID;
 struct Main;
 struct Scene;
 struct Group;
@@ -64,6 +65,13 @@ void DEG_graph_tag_relations_update(struct Depsgraph *graph);
 /* Tag all relations in the database for update.*/
 void DEG_relations_tag_update(struct Main *bmain);
 
+/* Tag relations of the given ID for update.
+ *
+ * Unlike DEG_relations_tag_update() this only rebuilds nodes of the ID and
+ * relations of the ID and IDs which directly depend on it, if possible.
+ */
+void DEG_id_tag_relations_update(struct Main *bmain, struct ID *id);
+
 /* Create new graph if didn't exist yet,
  * or update relations if graph was tagged for update.
  */
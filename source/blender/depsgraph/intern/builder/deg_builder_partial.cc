@@ -0,0 +1,373 @@
+/*
+ * ***** BEGIN GPL LICENSE BLOCK *****
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301, USA.
+ *
+ * The Original Code is Copyright (C) 2016 Blender Foundation.
+ * All rights reserved.
+ *
+ * ***** END GPL LICENSE BLOCK *****
+ */
+
+/** \file blender/depsgraph/intern/builder/deg_builder_partial.cc
+ *  \ingroup depsgraph
+ *
+ * Incremental update of the graph relations.
+ *
+ * Instead of rebuilding the whole graph when relations of a single object
+ * changed (for example, constraint was added), only nodes of tagged objects
+ * are re-created, and only relations of tagged objects and objects which
+ * directly depend on them are re-created.
+ */
+
+#include "intern/builder/deg_builder_partial.h"
+
+#include "MEM_guardedalloc.h"
+
+#include "BLI_utildefines.h"
+#include "BLI_ghash.h"
+
+extern "C" {
+#include "DNA_node_types.h"
+#include "DNA_object_types.h"
+#include "DNA_scene_types.h"
+
+#include "BKE_global.h"
+#include "BKE_main.h"
+#include "BKE_node.h"
+#include "BKE_scene.h"
+} /* extern "C" */
+
+#include "intern/builder/deg_builder.h"
+#include "intern/builder/deg_builder_cycle.h"
+#include "intern/builder/deg_builder_nodes.h"
+#include "intern/builder/deg_builder_relations.h"
+#include "intern/builder/deg_builder_transitive.h"
+
+#include "intern/nodes/deg_node.h"
+#include "intern/nodes/deg_node_component.h"
+#include "intern/nodes/deg_node_operation.h"
+
+#include "intern/depsgraph.h"
+#include "intern/depsgraph_types.h"
+
+#include "util/deg_util_foreach.h"
+
+namespace DEG {
+
+/* Check whether nodes and relations of the given ID can be re-created without
+ * touching the rest of the graph.
+ *
+ * Relations which are built by scene-level builders (rigid body world) or by
+ * other objects (proxies) are not tracked here, such IDs always cause full
+ * rebuild.
+ */
+static bool deg_partial_id_node_is_supported(Scene *scene, IDDepsNode *id_node)
+{
+	ID *id = id_node->id;
+	if (GS(id->name) != ID_OB) {
+		return false;
+	}
+	Object *ob = (Object *)id;
+	if (ob->proxy != NULL || ob->proxy_from != NULL) {
+		return false;
+	}
+	/* Base is needed to get proper visibility layers of the object. */
+	if (BKE_scene_base_find(scene, ob) == NULL) {
+		return false;
+	}
+	return true;
+}
+
+/* Add all ID nodes which depends on the given one to the set. */
+static bool deg_partial_collect_dependents(Scene *scene,
+                                           IDDepsNode *id_node,
+                                           GSet *dependents)
+{
+	GHASH_FOREACH_BEGIN(ComponentDepsNode *, comp_node, id_node->components)
+	{
+		foreach (OperationDepsNode *op_node, comp_node->operations) {
+			foreach (DepsRelation *rel, op_node->outlinks) {
+				if (rel->to->type != DEG_NODE_TYPE_OPERATION) {
+					return false;
+				}
+				OperationDepsNode *to = (OperationDepsNode *)rel->to;
+				IDDepsNode *to_id_node = to->owner->owner;
+				if (to_id_node == id_node ||
+				    BLI_gset_haskey(dependents, to_id_node))
+				{
+					continue;
+				}
+				if (!deg_partial_id_node_is_supported(scene, to_id_node)) {
+					return false;
+				}
+				BLI_gset_insert(dependents, to_id_node);
+			}
+		}
+	}
+	GHASH_FOREACH_END();
+	return true;
+}
+
+static void deg_partial_collect_node_relations(DepsNode *node,
+                                               GSet *relations,
+                                               bool outlinks)
+{
+	foreach (DepsRelation *rel, node->inlinks) {
+		BLI_gset_add(relations, rel);
+	}
+	if (outlinks) {
+		foreach (DepsRelation *rel, node->outlinks) {
+			BLI_gset_add(relations, rel);
+		}
+	}
+}
+
+/* Collect relations which will be re-created by the partial update.
+ *
+ * For the IDs which nodes are re-created this is all the relations, for the
+ * dependent IDs only incoming relations are re-created.
+ */
+static void deg_partial_collect_id_relations(IDDepsNode *id_node,
+                                             GSet *relations,
+                                             bool outlinks)
+{
+	deg_partial_collect_node_relations(id_node, relations, outlinks);
+	GHASH_FOREACH_BEGIN(ComponentDepsNode *, comp_node, id_node->components)
+	{
+		deg_partial_collect_node_relations(comp_node, relations, outlinks);
+		foreach (OperationDepsNode *op_node, comp_node->operations) {
+			deg_partial_collect_node_relations(op_node, relations, outlinks);
+		}
+	}
+	GHASH_FOREACH_END();
+}
+
+/* Check whether ID node was created by the current build pass. */
+static bool deg_partial_id_node_is_new(IDDepsNode *id_node)
+{
+	GHASH_FOREACH_BEGIN(ComponentDepsNode *, comp_node, id_node->components)
+	{
+		if (comp_node->operations_map != NULL) {
+			return true;
+		}
+	}
+	GHASH_FOREACH_END();
+	return false;
+}
+
+/* Use LIB_TAG_DOIT the same way as builders do: IDs which nodes are up to date
+ * are tagged, so builders will skip them.
+ */
+static void deg_partial_tag_built_ids(Depsgraph *graph,
+                                      Main *bmain,
+                                      GSet *rebuild_id_nodes)
+{
+	BKE_main_id_tag_all(bmain, LIB_TAG_DOIT, false);
+	FOREACH_NODETREE(bmain, nodetree, id) {
+		if (id != (ID *)nodetree) {
+			nodetree->id.tag &= ~LIB_TAG_DOIT;
+		}
+	} FOREACH_NODETREE_END
+	GHASH_FOREACH_BEGIN(IDDepsNode *, id_node, graph->id_hash)
+	{
+		if (!BLI_gset_haskey(rebuild_id_nodes, id_node)) {
+			id_node->id->tag |= LIB_TAG_DOIT;
+		}
+	}
+	GHASH_FOREACH_END();
+}
+
+bool deg_graph_build_partial(Depsgraph *graph, Main *bmain, Scene *scene)
+{
+	/* Rigid body world and set scenes are adding relations to the objects
+	 * from the scene level, those are not re-created here.
+	 */
+	if (scene->rigidbody_world != NULL || scene->set != NULL) {
+		return false;
+	}
+
+	/* IDs which nodes are to be re-created. */
+	GSet *tagged_id_nodes = BLI_gset_ptr_new("DEG partial tagged IDs");
+	/* IDs which relations are to be re-created, includes tagged IDs. */
+	GSet *relink_id_nodes = BLI_gset_ptr_new("DEG partial relink IDs");
+	bool is_supported = true;
+	GSET_FOREACH_BEGIN(ID *, id, graph->id_relations_tags)
+	{
+		IDDepsNode *id_node = graph->find_id_node(id);
+		if (id_node == NULL ||
+		    !deg_partial_id_node_is_supported(scene, id_node))
+		{
+			is_supported = false;
+			break;
+		}
+		BLI_gset_add(tagged_id_nodes, id_node);
+		BLI_gset_add(relink_id_nodes, id_node);
+	}
+	GSET_FOREACH_END();
+	if (is_supported) {
+		GSET_FOREACH_BEGIN(IDDepsNode *, id_node, tagged_id_nodes)
+		{
+			if (!deg_partial_collect_dependents(scene,
+			                                    id_node,
+			                                    relink_id_nodes))
+			{
+				is_supported = false;
+				break;
+			}
+		}
+		GSET_FOREACH_END();
+	}
+	if (!is_supported) {
+		BLI_gset_free(tagged_id_nodes, NULL);
+		BLI_gset_free(relink_id_nodes, NULL);
+		return false;
+	}
+
+	const unsigned int num_id_nodes = BLI_ghash_size(graph->id_hash);
+
+	/* 1) Remove all the relations which are to be re-created. */
+	GSet *relations = BLI_gset_ptr_new("DEG partial relations");
+	GSET_FOREACH_BEGIN(IDDepsNode *, id_node, relink_id_nodes)
+	{
+		const bool is_tagged = BLI_gset_haskey(tagged_id_nodes, id_node);
+		deg_partial_collect_id_relations(id_node, relations, is_tagged);
+	}
+	GSET_FOREACH_END();
+	GSET_FOREACH_BEGIN(DepsRelation *, rel, relations)
+	{
+		rel->unlink();
+		OBJECT_GUARDED_DELETE(rel, DepsRelation);
+	}
+	GSET_FOREACH_END();
+	BLI_gset_free(relations, NULL);
+
+	/* 2) Remove nodes of tagged IDs. */
+	Depsgraph::OperationNodes operations;
+	operations.reserve(graph->operations.size());
+	foreach (OperationDepsNode *op_node, graph->operations) {
+		if (BLI_gset_haskey(tagged_id_nodes, op_node->owner->owner)) {
+			BLI_gset_remove(graph->entry_tags, op_node, NULL);
+		}
+		else {
+			operations.push_back(op_node);
+		}
+	}
+	graph->operations.swap(operations);
+	GSET_FOREACH_BEGIN(IDDepsNode *, id_node, tagged_id_nodes)
+	{
+		BLI_ghash_remove(graph->id_hash, id_node->id, NULL, NULL);
+		OBJECT_GUARDED_DELETE(id_node, IDDepsNode);
+	}
+	GSET_FOREACH_END();
+
+	/* 3) Re-create nodes of tagged objects. */
+	GSet *relink_ids = BLI_gset_ptr_new("DEG partial relink ID datablocks");
+	GSET_FOREACH_BEGIN(IDDepsNode *, id_node, relink_id_nodes)
+	{
+		BLI_gset_insert(relink_ids, id_node->id);
+	}
+	GSET_FOREACH_END();
+	BLI_gset_free(relink_id_nodes, NULL);
+	/* Nodes of tagged IDs are freed now, so only the empty set is passed. */
+	BLI_gset_clear(tagged_id_nodes, NULL);
+	deg_partial_tag_built_ids(graph, bmain, tagged_id_nodes);
+	BLI_gset_free(tagged_id_nodes, NULL);
+
+	DepsgraphNodeBuilder node_builder(bmain, graph);
+	GSET_FOREACH_BEGIN(ID *, id, graph->id_relations_tags)
+	{
+		Object *ob = (Object *)id;
+		Base *base = BKE_scene_base_find(scene, ob);
+		node_builder.build_object(scene, base, ob);
+	}
+	GSET_FOREACH_END();
+	if (BLI_ghash_size(graph->id_hash) != num_id_nodes) {
+		/* Tagged objects started to depend on IDs which were not in the graph
+		 * yet, their relations are to be built as well.
+		 */
+		GHASH_FOREACH_BEGIN(IDDepsNode *, id_node, graph->id_hash)
+		{
+			if (!deg_partial_id_node_is_new(id_node)) {
+				continue;
+			}
+			if (GS(id_node->id->name) != ID_OB) {
+				is_supported = false;
+				break;
+			}
+			BLI_gset_add(relink_ids, id_node->id);
+		}
+		GHASH_FOREACH_END();
+		if (!is_supported) {
+			BLI_gset_free(relink_ids, NULL);
+			return false;
+		}
+	}
+
+	/* 4) Re-create relations of tagged objects and their dependents.
+	 *
+	 * Builders also add relations between IDs which were kept, for example
+	 * from the shape key or the time source to the object data. Those still
+	 * exist in the graph and are not to be added again.
+	 */
+	GSet *relink_id_nodes_new = BLI_gset_ptr_new("DEG partial relink IDs");
+	GSET_FOREACH_BEGIN(ID *, id, relink_ids)
+	{
+		BLI_gset_add(relink_id_nodes_new, graph->find_id_node(id));
+	}
+	GSET_FOREACH_END();
+	deg_partial_tag_built_ids(graph, bmain, relink_id_nodes_new);
+	DepsgraphRelationBuilder relation_builder(graph);
+	graph->skip_existing_relations = true;
+	GSET_FOREACH_BEGIN(ID *, id, relink_ids)
+	{
+		relation_builder.build_object(bmain, scene, (Object *)id);
+	}
+	GSET_FOREACH_END();
+	graph->skip_existing_relations = false;
+	foreach (OperationDepsNode *op_node, graph->operations) {
+		IDDepsNode *id_node = op_node->owner->owner;
+		if (BLI_gset_haskey(relink_id_nodes_new, id_node)) {
+			Object *object = (Object *)id_node->id;
+			object->customdata_mask |= op_node->customdata_mask;
+		}
+	}
+	BLI_gset_free(relink_ids, NULL);
+
+	/* 5) Detect and solve cycles.
+	 *
+	 * Cycles might have been broken by the update, so clear flags from the
+	 * previous detection pass first.
+	 */
+	foreach (OperationDepsNode *op_node, graph->operations) {
+		foreach (DepsRelation *rel, op_node->outlinks) {
+			rel->flag &= ~DEPSREL_FLAG_CYCLIC;
+		}
+	}
+	deg_graph_detect_cycles(graph);
+
+	/* 6) Simplify the graph, only re-created relations are affected. */
+	if (G.debug_value == 799) {
+		deg_graph_transitive_reduction_partial(graph, relink_id_nodes_new);
+	}
+	BLI_gset_free(relink_id_nodes_new, NULL);
+
+	/* 7) Flush visibility layer and re-schedule nodes for update. */
+	deg_graph_build_finalize(graph);
+
+	return true;
+}
+
+}  // namespace DEG
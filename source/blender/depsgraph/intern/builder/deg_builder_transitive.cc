@@ -32,6 +32,9 @@
 
 #include "MEM_guardedalloc.h"
 
+#include "BLI_utildefines.h"
+#include "BLI_ghash.h"
+
 #include "intern/nodes/deg_node.h"
 #include "intern/nodes/deg_node_component.h"
 #include "intern/nodes/deg_node_operation.h"
@@ -48,7 +51,8 @@ namespace DEG {
  * https://en.wikipedia.org/wiki/Transitive_reduction
  *
  * XXX The current implementation is somewhat naive and has O(V*E) worst case
- * runtime.
+ * runtime. When only a part of the graph was rebuilt, reduction is only
+ * performed for the relations coming into the rebuilt IDs.
  * A more optimized algorithm can be implemented later, e.g.
  *
  *   http://www.sciencedirect.com/science/article/pii/0304397588900321/pdf?md5=3391e309b708b6f9cdedcd08f84f4afc&pid=1-s2.0-0304397588900321-main.pdf
@@ -62,56 +66,95 @@ enum {
 	OP_REACHABLE = 2,
 };
 
-static void deg_graph_tag_paths_recursive(DepsNode *node)
+typedef vector<DepsNode *> TouchedNodes;
+
+static void deg_graph_tag_paths_recursive(DepsNode *node,
+                                          TouchedNodes *touched_nodes)
 {
 	if (node->done & OP_VISITED) {
 		return;
 	}
+	if (node->done == 0) {
+		touched_nodes->push_back(node);
+	}
 	node->done |= OP_VISITED;
 	foreach (DepsRelation *rel, node->inlinks) {
-		deg_graph_tag_paths_recursive(rel->from);
+		deg_graph_tag_paths_recursive(rel->from, touched_nodes);
 		/* Do this only in inlinks loop, so the target node does not get
 		 * flagged.
 		 */
+		if (rel->from->done == 0) {
+			touched_nodes->push_back(rel->from);
+		}
 		rel->from->done |= OP_REACHABLE;
 	}
 }
 
-void deg_graph_transitive_reduction(Depsgraph *graph)
+/* Remove redundant relations coming to the given target.
+ *
+ * Only nodes which were touched by the traversal gets their tags cleared, so
+ * the cost is proportional to the size of the target's upstream subgraph
+ * rather than to the size of the whole graph.
+ */
+static void deg_graph_transitive_reduction_target(OperationDepsNode *target,
+                                                  TouchedNodes *touched_nodes)
 {
-	foreach (OperationDepsNode *target, graph->operations) {
-		/* Clear tags. */
-		foreach (OperationDepsNode *node, graph->operations) {
-			node->done = 0;
-		}
+	/* mark nodes from which we can reach the target
+	 * start with children, so the target node and direct children are not
+	 * flagged.
+	 */
+	target->done |= OP_VISITED;
+	touched_nodes->push_back(target);
+	foreach (DepsRelation *rel, target->inlinks) {
+		deg_graph_tag_paths_recursive(rel->from, touched_nodes);
+	}
 
-		/* mark nodes from which we can reach the target
-		 * start with children, so the target node and direct children are not
-		 * flagged.
-		 */
-		target->done |= OP_VISITED;
-		foreach (DepsRelation *rel, target->inlinks) {
-			deg_graph_tag_paths_recursive(rel->from);
+	/* Remove redundant paths to the target. */
+	DepsNode::Relations relations_to_remove;
+	foreach (DepsRelation *rel, target->inlinks) {
+		if (rel->from->type == DEG_NODE_TYPE_TIMESOURCE) {
+			/* HACK: time source nodes don't get "done" flag set/cleared. */
+			/* TODO: there will be other types in future, so iterators above
+			 * need modifying.
+			 */
+		}
+		else if (rel->from->done & OP_REACHABLE) {
+			relations_to_remove.push_back(rel);
 		}
+	}
+	foreach (DepsRelation *rel, relations_to_remove) {
+		rel->unlink();
+		OBJECT_GUARDED_DELETE(rel, DepsRelation);
+	}
+
+	/* Clear tags. */
+	foreach (DepsNode *node, *touched_nodes) {
+		node->done = 0;
+	}
+	touched_nodes->clear();
+}
+
+void deg_graph_transitive_reduction(Depsgraph *graph)
+{
+	TouchedNodes touched_nodes;
+	foreach (OperationDepsNode *node, graph->operations) {
+		node->done = 0;
+	}
+	foreach (OperationDepsNode *target, graph->operations) {
+		deg_graph_transitive_reduction_target(target, &touched_nodes);
+	}
+}
 
-		/* Remove redundant paths to the target. */
-		for (DepsNode::Relations::const_iterator it_rel = target->inlinks.begin();
-		     it_rel != target->inlinks.end();
-		     )
-		{
-			DepsRelation *rel = *it_rel;
-			/* Increment in advance, so we can safely remove the relation. */
-			++it_rel;
-
-			if (rel->from->type == DEG_NODE_TYPE_TIMESOURCE) {
-				/* HACK: time source nodes don't get "done" flag set/cleared. */
-				/* TODO: there will be other types in future, so iterators above
-				 * need modifying.
-				 */
-			}
-			else if (rel->from->done & OP_REACHABLE) {
-				OBJECT_GUARDED_DELETE(rel, DepsRelation);
-			}
+void deg_graph_transitive_reduction_partial(Depsgraph *graph, GSet *id_nodes)
+{
+	TouchedNodes touched_nodes;
+	foreach (OperationDepsNode *node, graph->operations) {
+		node->done = 0;
+	}
+	foreach (OperationDepsNode *target, graph->operations) {
+		IDDepsNode *id_node = target->owner->owner;
+		if (BLI_gset_haskey(id_nodes, id_node)) {
+			deg_graph_transitive_reduction_target(target, &touched_nodes);
 		}
 	}
 }
@@ -30,6 +30,8 @@
 
 #pragma once
 
+struct GSet;
+
 namespace DEG {
 
 struct Depsgraph;
@@ -37,4 +39,9 @@ struct Depsgraph;
 /* Performs a transitive reduction to remove redundant relations. */
 void deg_graph_transitive_reduction(Depsgraph *graph);
 
+/* Same as above, but only relations coming to operations of the given
+ * set of ID nodes are being reduced.
+ */
+void deg_graph_transitive_reduction_partial(Depsgraph *graph, GSet *id_nodes);
+
 }  // namespace DEG
@@ -71,11 +71,13 @@ static DEG_EditorUpdateScenePreCb deg_editor_update_scene_pre_cb = NULL;
 Depsgraph::Depsgraph()
   : time_source(NULL),
     need_update(false),
+    skip_existing_relations(false),
     layers(0)
 {
 	BLI_spin_init(&lock);
 	id_hash = BLI_ghash_ptr_new("Depsgraph id hash");
 	entry_tags = BLI_gset_ptr_new("Depsgraph entry_tags");
+	id_relations_tags = BLI_gset_ptr_new("Depsgraph id_relations_tags");
 }
 
 Depsgraph::~Depsgraph()
@@ -83,6 +85,7 @@ Depsgraph::~Depsgraph()
 	clear_id_nodes();
 	BLI_ghash_free(id_hash, NULL, NULL);
 	BLI_gset_free(entry_tags, NULL);
+	BLI_gset_free(id_relations_tags, NULL);
 	if (time_source != NULL) {
 		OBJECT_GUARDED_DELETE(time_source, TimeSourceDepsNode);
 	}
@@ -296,11 +299,27 @@ void Depsgraph::clear_id_nodes()
 	BLI_ghash_clear(id_hash, NULL, id_node_deleter);
 }
 
+static DepsRelation *find_existing_relation(DepsNode *from, DepsNode *to)
+{
+	foreach (DepsRelation *rel, from->outlinks) {
+		if (rel->to == to) {
+			return rel;
+		}
+	}
+	return NULL;
+}
+
 /* Add new relationship between two nodes. */
 DepsRelation *Depsgraph::add_new_relation(OperationDepsNode *from,
                                           OperationDepsNode *to,
                                           const char *description)
 {
+	if (skip_existing_relations) {
+		DepsRelation *rel = find_existing_relation(from, to);
+		if (rel != NULL) {
+			return rel;
+		}
+	}
 	/* Create new relation, and add it to the graph. */
 	DepsRelation *rel = OBJECT_GUARDED_NEW(DepsRelation, from, to, description);
 	/* TODO(sergey): Find a better place for this. */
@@ -324,6 +343,12 @@ DepsRelation *Depsgraph::add_new_relation(OperationDepsNode *from,
 DepsRelation *Depsgraph::add_new_relation(DepsNode *from, DepsNode *to,
                                           const char *description)
 {
+	if (skip_existing_relations) {
+		DepsRelation *rel = find_existing_relation(from, to);
+		if (rel != NULL) {
+			return rel;
+		}
+	}
 	/* Create new relation, and add it to the graph. */
 	DepsRelation *rel = OBJECT_GUARDED_NEW(DepsRelation, from, to, description);
 	return rel;
@@ -382,6 +407,30 @@ DepsRelation::~DepsRelation()
 	BLI_assert(this->from && this->to);
 }
 
+void DepsRelation::unlink()
+{
+	/* Sanity check. */
+	BLI_assert(this->from && this->to);
+	for (DepsNode::Relations::iterator it = from->outlinks.begin();
+	     it != from->outlinks.end();
+	     ++it)
+	{
+		if (*it == this) {
+			from->outlinks.erase(it);
+			break;
+		}
+	}
+	for (DepsNode::Relations::iterator it = to->inlinks.begin();
+	     it != to->inlinks.end();
+	     ++it)
+	{
+		if (*it == this) {
+			to->inlinks.erase(it);
+			break;
+		}
+	}
+}
+
 /* Low level tagging -------------------------------------- */
 
 /* Tag a specific node as needing updates. */
@@ -84,6 +84,9 @@ struct DepsRelation {
 	             const char *description);
 
 	~DepsRelation();
+
+	/* Remove relation from the nodes it connects. */
+	void unlink();
 };
 
 /* ********* */
@@ -141,6 +144,16 @@ struct Depsgraph {
 	/* Indicates whether relations needs to be updated. */
 	bool need_update;
 
+	/* IDs which relations are to be updated, used when only a small part of
+	 * the graph changed and full rebuild is not required (see need_update).
+	 */
+	GSet *id_relations_tags;
+
+	/* Don't add relations between nodes which are already connected. Set by
+	 * the partial update, which builds relations of kept IDs again.
+	 */
+	bool skip_existing_relations;
+
 	/* Quick-Access Temp Data ............. */
 
 	/* Nodes which have been tagged as "directly modified". */
@@ -61,6 +61,7 @@ extern "C" {
 #include "builder/deg_builder.h"
 #include "builder/deg_builder_cycle.h"
 #include "builder/deg_builder_nodes.h"
+#include "builder/deg_builder_partial.h"
 #include "builder/deg_builder_relations.h"
 #include "builder/deg_builder_transitive.h"
 
@@ -264,6 +265,28 @@ void DEG_relations_tag_update(Main *bmain)
 	}
 }
 
+/* Tag relations of the given ID for update. */
+void DEG_id_tag_relations_update(Main *bmain, ID *id)
+{
+	for (Scene *scene = (Scene *)bmain->scene.first;
+	     scene != NULL;
+	     scene = (Scene *)scene->id.next)
+	{
+		if (scene->depsgraph == NULL) {
+			continue;
+		}
+		DEG::Depsgraph *deg_graph =
+		        reinterpret_cast<DEG::Depsgraph *>(scene->depsgraph);
+		if (deg_graph->find_id_node(id) != NULL) {
+			BLI_gset_add(deg_graph->id_relations_tags, id);
+		}
+		else {
+			/* ID is not in the graph yet, so can't be updated locally. */
+			deg_graph->need_update = true;
+		}
+	}
+}
+
 /* Create new graph if didn't exist yet,
  * or update relations if graph was tagged for update.
  */
@@ -278,8 +301,15 @@ void DEG_scene_relations_update(Main *bmain, Scene *scene)
 
 	DEG::Depsgraph *graph = reinterpret_cast<DEG::Depsgraph *>(scene->depsgraph);
 	if (!graph->need_update) {
-		/* Graph is up to date, nothing to do. */
-		return;
+		if (BLI_gset_size(graph->id_relations_tags) == 0) {
+			/* Graph is up to date, nothing to do. */
+			return;
+		}
+		/* Only few IDs were tagged, try to update relations locally. */
+		if (DEG::deg_graph_build_partial(graph, bmain, scene)) {
+			BLI_gset_clear(graph->id_relations_tags, NULL);
+			return;
+		}
 	}
 
 	/* Clear all previous nodes and operations. */
@@ -292,6 +322,7 @@ void DEG_scene_relations_update(Main *bmain, Scene *scene)
 	                           bmain,
 	                           scene);
 
+	BLI_gset_clear(graph->id_relations_tags, NULL);
 	graph->need_update = false;
 }
 
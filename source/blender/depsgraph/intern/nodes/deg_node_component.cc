@@ -165,7 +165,7 @@ string ComponentDepsNode::identifier() const
 
 OperationDepsNode *ComponentDepsNode::find_operation(OperationIDKey key) const
 {
-	OperationDepsNode *node = reinterpret_cast<OperationDepsNode *>(BLI_ghash_lookup(operations_map, &key));
+	OperationDepsNode *node = has_operation(key);
 	if (node != NULL) {
 		return node;
 	}
@@ -187,7 +187,22 @@ OperationDepsNode *ComponentDepsNode::find_operation(eDepsOperation_Code opcode,
 
 OperationDepsNode *ComponentDepsNode::has_operation(OperationIDKey key) const
 {
-	return reinterpret_cast<OperationDepsNode *>(BLI_ghash_lookup(operations_map, &key));
+	if (operations_map != NULL) {
+		return reinterpret_cast<OperationDepsNode *>(BLI_ghash_lookup(operations_map, &key));
+	}
+	/* Component was already finalized, this happens when relations are being
+	 * updated for a part of the graph only. Components have few operations,
+	 * so linear lookup is fine here.
+	 */
+	foreach (OperationDepsNode *op_node, operations) {
+		if (op_node->opcode == key.opcode &&
+		    op_node->name_tag == key.name_tag &&
+		    STREQ(op_node->name, key.name))
+		{
+			return op_node;
+		}
+	}
+	return NULL;
 }
 
 OperationDepsNode *ComponentDepsNode::has_operation(eDepsOperation_Code opcode,
@@ -203,6 +218,7 @@ OperationDepsNode *ComponentDepsNode::add_operation(const DepsEvalOperationCb& o
                                                     const char *name,
                                                     int name_tag)
 {
+	BLI_assert(operations_map != NULL);
 	OperationDepsNode *op_node = has_operation(opcode, name, name_tag);
 	if (!op_node) {
 		DepsNodeFactory *factory = deg_get_node_factory(DEG_NODE_TYPE_OPERATION);
@@ -224,6 +240,7 @@ OperationDepsNode *ComponentDepsNode::add_operation(const DepsEvalOperationCb& o
 	/* attach extra data */
 	op_node->evaluate = op;
 	op_node->opcode = opcode;
+	op_node->name_tag = name_tag;
 	op_node->name = name;
 
 	return op_node;
@@ -321,6 +338,10 @@ OperationDepsNode *ComponentDepsNode::get_exit_operation()
 
 void ComponentDepsNode::finalize_build()
 {
+	if (operations_map == NULL) {
+		/* Component was finalized by a previous build pass already. */
+		return;
+	}
 	operations.reserve(BLI_ghash_size(operations_map));
 	GHASH_FOREACH_BEGIN(OperationDepsNode *, op_node, operations_map)
 	{
@@ -85,6 +85,9 @@ struct OperationDepsNode : public DepsNode {
 	/* Identifier for the operation being performed. */
 	eDepsOperation_Code opcode;
 
+	/* Tag used to distinguish operations with the same opcode and name. */
+	int name_tag;
+
 	/* (eDepsOperation_Flag) extra settings affecting evaluation. */
 	int flag;
 
@@ -40,6 +40,7 @@
 #include "BLI_buffer.h"
 #include "BLI_kdtree.h"
 #include "BLI_listbase.h"
+#include "BLI_task.h"
 
 #include "BKE_DerivedMesh.h"
 #include "BKE_context.h"
@@ -1225,6 +1226,20 @@ void EDBM_mesh_hide(BMEditMesh *em, bool swap)
 }
 
 
+static void edbm_mesh_reveal_tag_hidden_cb(void *userdata, int i)
+{
+	BMesh *bm = userdata;
+	const char iter_types[3] = {BM_VERTS_OF_MESH,
+	                            BM_EDGES_OF_MESH,
+	                            BM_FACES_OF_MESH};
+	BMIter iter;
+	BMElem *ele;
+
+	BM_ITER_MESH (ele, &iter, bm, iter_types[i]) {
+		BM_elem_flag_set(ele, BM_ELEM_TAG, BM_elem_flag_test(ele, BM_ELEM_HIDDEN));
+	}
+}
+
 void EDBM_mesh_reveal(BMEditMesh *em)
 {
 	const char iter_types[3] = {BM_VERTS_OF_MESH,
@@ -1240,15 +1255,8 @@ void EDBM_mesh_reveal(BMEditMesh *em)
 
 	/* Use tag flag to remember what was hidden before all is revealed.
 	 * BM_ELEM_HIDDEN --> BM_ELEM_TAG */
-#pragma omp parallel for schedule(static) if (em->bm->totvert + em->bm->totedge + em->bm->totface >= BM_OMP_LIMIT)
-	for (i = 0; i < 3; i++) {
-		BMIter iter;
-		BMElem *ele;
-
-		BM_ITER_MESH (ele, &iter, em->bm, iter_types[i]) {
-			BM_elem_flag_set(ele, BM_ELEM_TAG, BM_elem_flag_test(ele, BM_ELEM_HIDDEN));
-		}
-	}
+	BLI_task_parallel_range(0, 3, em->bm, edbm_mesh_reveal_tag_hidden_cb,
+	                        em->bm->totvert + em->bm->totedge + em->bm->totface >= BM_THREAD_LIMIT);
 
 	/* Reveal everything */
 	EDBM_flag_disable_all(em, BM_ELEM_HIDDEN);
@@ -299,6 +299,9 @@ typedef struct Object {
 	LodLevel *currentlod;
 
 	struct PreviewImage *preview;
+
+	/* Runtime, cached result of the leading modifiers of the stack, see mesh_calc_modifiers() */
+	struct ModifierPrefixCache *modifier_prefix_cache;
 } Object;
 
 /* Warning, this is not used anymore because hooks are now modifiers */
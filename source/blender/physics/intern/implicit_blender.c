@@ -43,6 +43,7 @@
 
 #include "BLI_math.h"
 #include "BLI_linklist.h"
+#include "BLI_task.h"
 #include "BLI_utildefines.h"
 
 #include "BKE_cloth.h"
@@ -56,9 +57,7 @@
 #  pragma GCC diagnostic ignored "-Wtype-limits"
 #endif
 
-#ifdef _OPENMP
-#  define CLOTH_OPENMP_LIMIT 512
-#endif
+#define CLOTH_THREADING_LIMIT 512
 
 //#define DEBUG_TIME
 
@@ -204,7 +203,7 @@ DO_INLINE float dot_lfvector(float (*fLongVectorA)[3], float (*fLongVectorB)[3],
 // due to non-commutative nature of floating point ops this makes the sim give
 // different results each time you run it!
 // schedule(guided, 2)
-//#pragma omp parallel for reduction(+: temp) if (verts > CLOTH_OPENMP_LIMIT)
+//#pragma omp parallel for reduction(+: temp) if (verts > CLOTH_THREADING_LIMIT)
 	for (i = 0; i < (long)verts; i++) {
 		temp += dot_v3v3(fLongVectorA[i], fLongVectorB[i]);
 	}
@@ -585,31 +584,48 @@ DO_INLINE void initdiag_bfmatrix(fmatrix3x3 *matrix, float m3[3][3])
 	}
 }
 
+typedef struct MulBFMatrixLFVectorData {
+	float (*to)[3];
+	fmatrix3x3 *from;
+	lfVector *fLongVector;
+	lfVector *temp;
+} MulBFMatrixLFVectorData;
+
+static void mul_bfmatrix_lfvector_cb(void *userdata, int part)
+{
+	MulBFMatrixLFVectorData *data = userdata;
+	fmatrix3x3 *from = data->from;
+	lfVector *fLongVector = data->fLongVector;
+	unsigned int i;
+
+	/* Both halves of the symmetric product write to separate vectors,
+	 * so they can run side by side. */
+	if (part == 0) {
+		float (*to)[3] = data->to;
+		for (i = from[0].vcount; i < from[0].vcount+from[0].scount; i++) {
+			muladd_fmatrix_fvector(to[from[i].c], from[i].m, fLongVector[from[i].r]);
+		}
+	}
+	else {
+		lfVector *temp = data->temp;
+		for (i = 0; i < from[0].vcount+from[0].scount; i++) {
+			muladd_fmatrix_fvector(temp[from[i].r], from[i].m, fLongVector[from[i].c]);
+		}
+	}
+}
+
 /* SPARSE SYMMETRIC multiply big matrix with long vector*/
 /* STATUS: verified */
 DO_INLINE void mul_bfmatrix_lfvector( float (*to)[3], fmatrix3x3 *from, lfVector *fLongVector)
 {
-	unsigned int i = 0;
 	unsigned int vcount = from[0].vcount;
 	lfVector *temp = create_lfvector(vcount);
+	MulBFMatrixLFVectorData data = {to, from, fLongVector, temp};
 	
 	zero_lfvector(to, vcount);
 
-#pragma omp parallel sections private(i) if (vcount > CLOTH_OPENMP_LIMIT)
-	{
-#pragma omp section
-		{
-			for (i = from[0].vcount; i < from[0].vcount+from[0].scount; i++) {
-				muladd_fmatrix_fvector(to[from[i].c], from[i].m, fLongVector[from[i].r]);
-			}
-		}
-#pragma omp section
-		{
-			for (i = 0; i < from[0].vcount+from[0].scount; i++) {
-				muladd_fmatrix_fvector(temp[from[i].r], from[i].m, fLongVector[from[i].c]);
-			}
-		}
-	}
+	BLI_task_parallel_range(0, 2, &data, mul_bfmatrix_lfvector_cb, vcount > CLOTH_THREADING_LIMIT);
+
 	add_lfvector_lfvector(to, to, temp, from[0].vcount);
 	
 	del_lfvector(temp);
@@ -909,7 +925,7 @@ DO_INLINE void BuildPPinv(fmatrix3x3 *lA, fmatrix3x3 *P, fmatrix3x3 *Pinv)
 	unsigned int i = 0;
 	
 	// Take only the diagonal blocks of A
-// #pragma omp parallel for private(i) if (lA[0].vcount > CLOTH_OPENMP_LIMIT)
+// #pragma omp parallel for private(i) if (lA[0].vcount > CLOTH_THREADING_LIMIT)
 	for (i = 0; i<lA[0].vcount; i++) {
 		// block diagonalizer
 		cp_fmatrix(P[i].m, lA[i].m);
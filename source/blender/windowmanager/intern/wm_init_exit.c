@@ -518,6 +518,7 @@ void WM_exit_ext(bContext *C, const bool do_python)
 #endif
 	
 	BKE_blender_free();  /* blender.c, does entire library and spacetypes */
+	DM_modifier_prefix_cache_exit();  /* after BKE_blender_free, which frees the cached entries */
 //	free_matcopybuf();
 	ANIM_fcurves_copybuf_free();
 	ANIM_drivers_copybuf_free();
@@ -0,0 +1,167 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+
+#include "DNA_meshdata_types.h"
+
+#include "BKE_mesh.h"
+}
+
+/* Run the 10 million vertices test (slow in debug builds). */
+//#define MESH_NORMALS_RUN_BIG
+
+typedef struct MeshArrays {
+	MVert *mvert;
+	MLoop *mloop;
+	MPoly *mpoly;
+	int totvert, totloop, totpoly;
+} MeshArrays;
+
+/* Grid of quads with a wave along both axes, so no two normals are the same. */
+static void mesh_arrays_grid_create(MeshArrays *ma, const int size)
+{
+	int x, y;
+
+	ma->totvert = size * size;
+	ma->totpoly = (size - 1) * (size - 1);
+	ma->totloop = ma->totpoly * 4;
+	ma->mvert = (MVert *)MEM_callocN(sizeof(*ma->mvert) * (size_t)ma->totvert, __func__);
+	ma->mloop = (MLoop *)MEM_callocN(sizeof(*ma->mloop) * (size_t)ma->totloop, __func__);
+	ma->mpoly = (MPoly *)MEM_callocN(sizeof(*ma->mpoly) * (size_t)ma->totpoly, __func__);
+
+	for (y = 0; y < size; y++) {
+		for (x = 0; x < size; x++) {
+			MVert *mv = &ma->mvert[y * size + x];
+			mv->co[0] = (float)x;
+			mv->co[1] = (float)y;
+			mv->co[2] = sinf((float)x * 0.3f) + cosf((float)y * 0.2f);
+		}
+	}
+
+	for (y = 0; y < size - 1; y++) {
+		for (x = 0; x < size - 1; x++) {
+			const int i = y * (size - 1) + x;
+			MPoly *mp = &ma->mpoly[i];
+			MLoop *ml = &ma->mloop[i * 4];
+
+			mp->loopstart = i * 4;
+			mp->totloop = 4;
+
+			ml[0].v = (unsigned int)(y * size + x);
+			ml[1].v = (unsigned int)(y * size + x + 1);
+			ml[2].v = (unsigned int)((y + 1) * size + x + 1);
+			ml[3].v = (unsigned int)((y + 1) * size + x);
+		}
+	}
+}
+
+static void mesh_arrays_free(MeshArrays *ma)
+{
+	MEM_freeN(ma->mvert);
+	MEM_freeN(ma->mloop);
+	MEM_freeN(ma->mpoly);
+}
+
+/* Single threaded reference, written out in full so it doesn't share code with the threaded version. */
+static void mesh_normals_calc_serial(const MeshArrays *ma, float (*r_vnors)[3], float (*r_pnors)[3])
+{
+	int i, j;
+
+	memset(r_vnors, 0, sizeof(*r_vnors) * (size_t)ma->totvert);
+
+	for (i = 0; i < ma->totpoly; i++) {
+		const MPoly *mp = &ma->mpoly[i];
+		const MLoop *ml = &ma->mloop[mp->loopstart];
+		/* the grid is all quads */
+		float *vnors[4];
+		const float *vcos[4];
+		float vdiffs[4][3];
+
+		ASSERT_EQ(mp->totloop, 4);
+		BKE_mesh_calc_poly_normal(mp, ml, ma->mvert, r_pnors[i]);
+
+		for (j = 0; j < mp->totloop; j++) {
+			vnors[j] = r_vnors[ml[j].v];
+			vcos[j] = ma->mvert[ml[j].v].co;
+		}
+		accumulate_vertex_normals_poly(vnors, r_pnors[i], vcos, vdiffs, mp->totloop);
+	}
+
+	for (i = 0; i < ma->totvert; i++) {
+		normalize_v3(r_vnors[i]);
+	}
+}
+
+static void mesh_normals_grid(const int size)
+{
+	MeshArrays ma;
+	float (*vnors)[3], (*pnors)[3];
+	float (*vnors_float)[3], (*pnors_float)[3];
+	float (*vnors_serial)[3], (*pnors_serial)[3];
+	int i;
+
+	mesh_arrays_grid_create(&ma, size);
+
+	vnors = (float (*)[3])MEM_mallocN(sizeof(*vnors) * (size_t)ma.totvert, __func__);
+	pnors = (float (*)[3])MEM_mallocN(sizeof(*pnors) * (size_t)ma.totpoly, __func__);
+	vnors_float = (float (*)[3])MEM_mallocN(sizeof(*vnors_float) * (size_t)ma.totvert, __func__);
+	pnors_float = (float (*)[3])MEM_mallocN(sizeof(*pnors_float) * (size_t)ma.totpoly, __func__);
+	vnors_serial = (float (*)[3])MEM_mallocN(sizeof(*vnors_serial) * (size_t)ma.totvert, __func__);
+	pnors_serial = (float (*)[3])MEM_mallocN(sizeof(*pnors_serial) * (size_t)ma.totpoly, __func__);
+
+	BKE_mesh_calc_normals_poly(
+	        ma.mvert, vnors, ma.totvert, ma.mloop, ma.mpoly, ma.totloop, ma.totpoly, pnors, false);
+	BKE_mesh_calc_normals_poly_float(
+	        ma.mvert, vnors_float, ma.totvert, ma.mloop, ma.mpoly, ma.totloop, ma.totpoly, pnors_float);
+	mesh_normals_calc_serial(&ma, vnors_serial, pnors_serial);
+
+	for (i = 0; i < ma.totpoly; i++) {
+		EXPECT_TRUE(equals_v3v3(pnors[i], pnors_float[i]));
+		EXPECT_TRUE(compare_v3v3(pnors[i], pnors_serial[i], 1e-6f));
+		/* all faces point up */
+		EXPECT_GT(pnors[i][2], 0.0f);
+	}
+	for (i = 0; i < ma.totvert; i++) {
+		float no_short[3];
+		/* threaded accumulation may add in a different order, allow for rounding */
+		EXPECT_TRUE(compare_v3v3(vnors[i], vnors_float[i], 1e-6f));
+		EXPECT_TRUE(compare_v3v3(vnors[i], vnors_serial[i], 1e-5f));
+		EXPECT_NEAR(len_v3(vnors_float[i]), 1.0f, 1e-5f);
+
+		/* short normals match the float ones */
+		normal_short_to_float_v3(no_short, ma.mvert[i].no);
+		EXPECT_TRUE(compare_v3v3(no_short, vnors_float[i], 1e-4f));
+	}
+
+	MEM_freeN(vnors);
+	MEM_freeN(pnors);
+	MEM_freeN(vnors_float);
+	MEM_freeN(pnors_float);
+	MEM_freeN(vnors_serial);
+	MEM_freeN(pnors_serial);
+	mesh_arrays_free(&ma);
+}
+
+TEST(mesh_normals, GridSmall)
+{
+	mesh_normals_grid(8);
+}
+
+/* Large enough to use threading. */
+TEST(mesh_normals, GridMedium)
+{
+	mesh_normals_grid(512);
+}
+
+#ifdef MESH_NORMALS_RUN_BIG
+/* 10 million vertices, for profiling. */
+TEST(mesh_normals, GridBig)
+{
+	mesh_normals_grid(3163);
+}
+#endif
@@ -0,0 +1,257 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+
+#include "DNA_mesh_types.h"
+#include "DNA_meshdata_types.h"
+#include "DNA_object_types.h"  /* SELECT */
+
+#include "BKE_customdata.h"
+#include "BKE_mesh.h"
+}
+
+#include "bmesh.h"
+
+/* Grid of quads, every third face is selected (without selecting its verts & edges),
+ * so converting needs to flush the selection. */
+static Mesh *mesh_grid_create(const int size)
+{
+	const int totvert = size * size;
+	const int totedge = 2 * size * (size - 1);
+	const int totpoly = (size - 1) * (size - 1);
+	const int totloop = totpoly * 4;
+	const int edge_vert_offset = size * (size - 1);
+	Mesh *me = (Mesh *)MEM_callocN(sizeof(Mesh), __func__);
+	int x, y;
+
+	BKE_mesh_init(me);
+	me->totvert = totvert;
+	me->totedge = totedge;
+	me->totloop = totloop;
+	me->totpoly = totpoly;
+	CustomData_add_layer(&me->vdata, CD_MVERT, CD_CALLOC, NULL, totvert);
+	CustomData_add_layer(&me->edata, CD_MEDGE, CD_CALLOC, NULL, totedge);
+	CustomData_add_layer(&me->ldata, CD_MLOOP, CD_CALLOC, NULL, totloop);
+	CustomData_add_layer(&me->pdata, CD_MPOLY, CD_CALLOC, NULL, totpoly);
+	BKE_mesh_update_customdata_pointers(me, false);
+
+	for (y = 0; y < size; y++) {
+		for (x = 0; x < size; x++) {
+			MVert *mv = &me->mvert[y * size + x];
+			mv->co[0] = (float)x;
+			mv->co[1] = (float)y;
+			mv->no[2] = 32767;
+		}
+	}
+
+	/* edges along X first, then along Y */
+	for (y = 0; y < size; y++) {
+		for (x = 0; x < size - 1; x++) {
+			MEdge *med = &me->medge[y * (size - 1) + x];
+			med->v1 = y * size + x;
+			med->v2 = y * size + x + 1;
+		}
+	}
+	for (y = 0; y < size - 1; y++) {
+		for (x = 0; x < size; x++) {
+			MEdge *med = &me->medge[edge_vert_offset + y * size + x];
+			med->v1 = y * size + x;
+			med->v2 = (y + 1) * size + x;
+		}
+	}
+
+	for (y = 0; y < size - 1; y++) {
+		for (x = 0; x < size - 1; x++) {
+			const int i = y * (size - 1) + x;
+			MPoly *mp = &me->mpoly[i];
+			MLoop *ml = &me->mloop[i * 4];
+
+			mp->loopstart = i * 4;
+			mp->totloop = 4;
+			mp->mat_nr = (short)(i % 4);
+			mp->flag = (i % 3 == 0) ? ME_FACE_SEL : 0;
+
+			ml[0].v = y * size + x;
+			ml[0].e = y * (size - 1) + x;
+			ml[1].v = y * size + x + 1;
+			ml[1].e = edge_vert_offset + y * size + x + 1;
+			ml[2].v = (y + 1) * size + x + 1;
+			ml[2].e = (y + 1) * (size - 1) + x;
+			ml[3].v = (y + 1) * size + x;
+			ml[3].e = edge_vert_offset + y * size + x;
+		}
+	}
+
+	me->act_face = 1;
+
+	return me;
+}
+
+static void mesh_free(Mesh *me)
+{
+	BKE_mesh_free(me);
+	MEM_freeN(me);
+}
+
+static BMesh *bmesh_from_mesh(Mesh *me)
+{
+	const BMAllocTemplate allocsize = BMALLOC_TEMPLATE_FROM_ME(me);
+	BMeshCreateParams bm_create_params = {0};
+	BMeshFromMeshParams bm_from_me_params = {0};
+	BMesh *bm;
+
+	bm_create_params.use_toolflags = true;
+	bm = BM_mesh_create(&allocsize, &bm_create_params);
+
+	bm_from_me_params.calc_face_normal = true;
+	BM_mesh_bm_from_me(bm, me, &bm_from_me_params);
+
+	return bm;
+}
+
+static Mesh *bmesh_to_mesh(BMesh *bm)
+{
+	BMeshToMeshParams bm_to_me_params = {0};
+	Mesh *me = (Mesh *)MEM_callocN(sizeof(Mesh), __func__);
+
+	BKE_mesh_init(me);
+	BM_mesh_bm_to_me(bm, me, &bm_to_me_params);
+
+	return me;
+}
+
+/* Single threaded reference for the selection flushed from the faces. */
+static void mesh_select_flush_serial(const Mesh *me, bool *r_vert_sel, bool *r_edge_sel)
+{
+	int i, j;
+
+	memset(r_vert_sel, 0, sizeof(*r_vert_sel) * (size_t)me->totvert);
+	memset(r_edge_sel, 0, sizeof(*r_edge_sel) * (size_t)me->totedge);
+
+	for (i = 0; i < me->totpoly; i++) {
+		const MPoly *mp = &me->mpoly[i];
+		if (mp->flag & ME_FACE_SEL) {
+			for (j = 0; j < mp->totloop; j++) {
+				const MLoop *ml = &me->mloop[mp->loopstart + j];
+				r_vert_sel[ml->v] = true;
+				r_edge_sel[ml->e] = true;
+			}
+		}
+	}
+}
+
+static void bmesh_mesh_conv_roundtrip(const int size)
+{
+	Mesh *me_src = mesh_grid_create(size);
+	BMesh *bm;
+	Mesh *me_dst;
+	BMIter iter;
+	BMVert *v;
+	BMEdge *e;
+	BMFace *f;
+	bool *vert_sel = (bool *)MEM_mallocN(sizeof(*vert_sel) * (size_t)me_src->totvert, __func__);
+	bool *edge_sel = (bool *)MEM_mallocN(sizeof(*edge_sel) * (size_t)me_src->totedge, __func__);
+	int i, totfacesel = 0;
+
+	mesh_select_flush_serial(me_src, vert_sel, edge_sel);
+
+	bm = bmesh_from_mesh(me_src);
+	BM_mesh_elem_index_ensure(bm, BM_VERT | BM_EDGE);
+
+	EXPECT_EQ(bm->totvert, me_src->totvert);
+	EXPECT_EQ(bm->totedge, me_src->totedge);
+	EXPECT_EQ(bm->totloop, me_src->totloop);
+	EXPECT_EQ(bm->totface, me_src->totpoly);
+	EXPECT_EQ(BM_elem_index_get(bm->act_face), me_src->act_face);
+
+	/* selection is flushed from the faces & matches the counts */
+	BM_ITER_MESH_INDEX (f, &iter, bm, BM_FACES_OF_MESH, i) {
+		if (BM_elem_flag_test(f, BM_ELEM_SELECT)) {
+			BMLoop *l_iter, *l_first;
+			l_iter = l_first = BM_FACE_FIRST_LOOP(f);
+			do {
+				EXPECT_TRUE(BM_elem_flag_test(l_iter->v, BM_ELEM_SELECT));
+				EXPECT_TRUE(BM_elem_flag_test(l_iter->e, BM_ELEM_SELECT));
+			} while ((l_iter = l_iter->next) != l_first);
+			totfacesel++;
+		}
+		EXPECT_EQ(f->mat_nr, me_src->mpoly[i].mat_nr);
+		EXPECT_EQ(f->no[2], 1.0f);
+	}
+
+	/* element by element against the serial reference */
+	BM_ITER_MESH_INDEX (v, &iter, bm, BM_VERTS_OF_MESH, i) {
+		EXPECT_TRUE(equals_v3v3(v->co, me_src->mvert[i].co));
+		EXPECT_EQ(BM_elem_flag_test_bool(v, BM_ELEM_SELECT), vert_sel[i]);
+	}
+	BM_ITER_MESH_INDEX (e, &iter, bm, BM_EDGES_OF_MESH, i) {
+		EXPECT_EQ(BM_elem_index_get(e->v1), (int)me_src->medge[i].v1);
+		EXPECT_EQ(BM_elem_index_get(e->v2), (int)me_src->medge[i].v2);
+		EXPECT_EQ(BM_elem_flag_test_bool(e, BM_ELEM_SELECT), edge_sel[i]);
+	}
+	BM_ITER_MESH_INDEX (f, &iter, bm, BM_FACES_OF_MESH, i) {
+		const MPoly *mp = &me_src->mpoly[i];
+		BMLoop *l_iter = BM_FACE_FIRST_LOOP(f);
+		int j;
+
+		ASSERT_EQ(f->len, mp->totloop);
+		for (j = 0; j < mp->totloop; j++, l_iter = l_iter->next) {
+			EXPECT_EQ(BM_elem_index_get(l_iter->v), (int)me_src->mloop[mp->loopstart + j].v);
+			EXPECT_EQ(BM_elem_index_get(l_iter->e), (int)me_src->mloop[mp->loopstart + j].e);
+		}
+	}
+	EXPECT_EQ(bm->totfacesel, totfacesel);
+	EXPECT_EQ(bm->totedgesel, BM_iter_mesh_count_flag(BM_EDGES_OF_MESH, bm, BM_ELEM_SELECT, true));
+	EXPECT_EQ(bm->totvertsel, BM_iter_mesh_count_flag(BM_VERTS_OF_MESH, bm, BM_ELEM_SELECT, true));
+
+	me_dst = bmesh_to_mesh(bm);
+
+	ASSERT_EQ(me_dst->totvert, me_src->totvert);
+	ASSERT_EQ(me_dst->totedge, me_src->totedge);
+	ASSERT_EQ(me_dst->totloop, me_src->totloop);
+	ASSERT_EQ(me_dst->totpoly, me_src->totpoly);
+	EXPECT_EQ(me_dst->act_face, me_src->act_face);
+
+	for (i = 0; i < me_src->totvert; i++) {
+		EXPECT_TRUE(equals_v3v3(me_dst->mvert[i].co, me_src->mvert[i].co));
+		EXPECT_EQ((me_dst->mvert[i].flag & SELECT) != 0, vert_sel[i]);
+	}
+	for (i = 0; i < me_src->totedge; i++) {
+		EXPECT_EQ(me_dst->medge[i].v1, me_src->medge[i].v1);
+		EXPECT_EQ(me_dst->medge[i].v2, me_src->medge[i].v2);
+		EXPECT_EQ((me_dst->medge[i].flag & SELECT) != 0, edge_sel[i]);
+	}
+	for (i = 0; i < me_src->totpoly; i++) {
+		const MPoly *mp_src = &me_src->mpoly[i], *mp_dst = &me_dst->mpoly[i];
+		EXPECT_EQ(mp_dst->loopstart, mp_src->loopstart);
+		EXPECT_EQ(mp_dst->totloop, mp_src->totloop);
+		EXPECT_EQ(mp_dst->mat_nr, mp_src->mat_nr);
+		EXPECT_EQ(mp_dst->flag & ME_FACE_SEL, mp_src->flag & ME_FACE_SEL);
+	}
+	for (i = 0; i < me_src->totloop; i++) {
+		EXPECT_EQ(me_dst->mloop[i].v, me_src->mloop[i].v);
+		EXPECT_EQ(me_dst->mloop[i].e, me_src->mloop[i].e);
+	}
+
+	MEM_freeN(vert_sel);
+	MEM_freeN(edge_sel);
+	BM_mesh_free(bm);
+	mesh_free(me_dst);
+	mesh_free(me_src);
+}
+
+TEST(bmesh_mesh_conv, RoundTripSmall)
+{
+	bmesh_mesh_conv_roundtrip(8);
+}
+
+/* Large enough to use threading in both directions. */
+TEST(bmesh_mesh_conv, RoundTripLarge)
+{
+	bmesh_mesh_conv_roundtrip(512);
+}
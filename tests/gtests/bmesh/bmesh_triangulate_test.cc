@@ -0,0 +1,166 @@
+/* Apache License, Version 2.0 */
+
+#include "testing/testing.h"
+
+extern "C" {
+#include "MEM_guardedalloc.h"
+#include "BLI_utildefines.h"
+#include "BLI_math.h"
+#include "BLI_memarena.h"
+#include "BLI_heap.h"
+#include "BLI_edgehash.h"
+#include "BLI_linklist.h"
+#include "BLI_polyfill2d.h"
+#include "BLI_polyfill2d_beautify.h"
+
+#include "DNA_modifier_types.h"
+}
+
+#include "bmesh.h"
+#include "bmesh_tools.h"
+
+#define STAR_POINTS 8
+
+/* Grid of (concave) star shaped ngons, not connected to each other. */
+static BMesh *bmesh_stars_create(const int size)
+{
+	BMeshCreateParams bm_params = {0};
+	BMesh *bm;
+	int x, y, i;
+
+	bm = BM_mesh_create(&bm_mesh_allocsize_default, &bm_params);
+
+	for (y = 0; y < size; y++) {
+		for (x = 0; x < size; x++) {
+			BMVert *verts[STAR_POINTS * 2];
+			BMFace *f;
+
+			for (i = 0; i < STAR_POINTS * 2; i++) {
+				const float angle = (float)i * (float)M_PI / (float)STAR_POINTS;
+				const float radius = (i % 2) ? 0.2f : 0.5f;
+				const float co[3] = {
+				    (float)x + cosf(angle) * radius,
+				    (float)y + sinf(angle) * radius,
+				    0.0f};
+				verts[i] = BM_vert_create(bm, co, NULL, BM_CREATE_NOP);
+			}
+
+			f = BM_face_create_verts(bm, verts, STAR_POINTS * 2, NULL, BM_CREATE_NOP, true);
+			BM_face_normal_update(f);
+		}
+	}
+
+	return bm;
+}
+
+static float bmesh_area_calc(BMesh *bm)
+{
+	BMIter iter;
+	BMFace *f;
+	float area = 0.0f;
+
+	BM_ITER_MESH (f, &iter, bm, BM_FACES_OF_MESH) {
+		area += BM_face_calc_area(f);
+	}
+	return area;
+}
+
+/* Single threaded reference, triangulates one face at a time. */
+static void bmesh_triangulate_serial(BMesh *bm, const int ngon_method)
+{
+	MemArena *pf_arena = BLI_memarena_new(BLI_POLYFILL_ARENA_SIZE, __func__);
+	Heap *pf_heap = BLI_heap_new_ex(BLI_POLYFILL_ALLOC_NGON_RESERVE);
+	EdgeHash *pf_ehash = BLI_edgehash_new_ex(__func__, BLI_POLYFILL_ALLOC_NGON_RESERVE);
+	BMFace **faces = (BMFace **)MEM_mallocN(sizeof(*faces) * (size_t)bm->totface, __func__);
+	LinkNode *faces_double = NULL;
+	BMIter iter;
+	BMFace *f;
+	int faces_len = 0, i;
+
+	/* collect first, triangulating adds faces while iterating */
+	BM_ITER_MESH (f, &iter, bm, BM_FACES_OF_MESH) {
+		if (f->len > 3) {
+			faces[faces_len++] = f;
+		}
+	}
+
+	for (i = 0; i < faces_len; i++) {
+		BM_face_triangulate(
+		        bm, faces[i],
+		        NULL, NULL,
+		        NULL, NULL,
+		        &faces_double,
+		        MOD_TRIANGULATE_QUAD_BEAUTY, ngon_method, false,
+		        pf_arena, pf_heap, pf_ehash);
+	}
+
+	while (faces_double) {
+		LinkNode *next = faces_double->next;
+		BM_face_kill(bm, (BMFace *)faces_double->link);
+		MEM_freeN(faces_double);
+		faces_double = next;
+	}
+
+	MEM_freeN(faces);
+	BLI_memarena_free(pf_arena);
+	BLI_heap_free(pf_heap, NULL);
+	BLI_edgehash_free(pf_ehash, NULL);
+}
+
+static void bmesh_triangulate_stars(const int size, const int ngon_method)
+{
+	BMesh *bm = bmesh_stars_create(size);
+	BMesh *bm_serial = bmesh_stars_create(size);
+	const int totface_orig = bm->totface;
+	const float area_orig = bmesh_area_calc(bm);
+	BMIter iter, iter_serial;
+	BMFace *f, *f_serial;
+
+	BM_mesh_triangulate(bm, MOD_TRIANGULATE_QUAD_BEAUTY, ngon_method, false, NULL, NULL, NULL);
+	bmesh_triangulate_serial(bm_serial, ngon_method);
+
+	EXPECT_EQ(bm->totface, totface_orig * (STAR_POINTS * 2 - 2));
+	BM_ITER_MESH (f, &iter, bm, BM_FACES_OF_MESH) {
+		EXPECT_EQ(f->len, 3);
+	}
+	/* concave faces must be filled without overlapping triangles */
+	EXPECT_NEAR(bmesh_area_calc(bm) / area_orig, 1.0f, 1e-4f);
+
+	/* the triangles must match the serial result, in the same order */
+	ASSERT_EQ(bm->totface, bm_serial->totface);
+	BM_mesh_elem_index_ensure(bm, BM_VERT);
+	BM_mesh_elem_index_ensure(bm_serial, BM_VERT);
+	f_serial = (BMFace *)BM_iter_new(&iter_serial, bm_serial, BM_FACES_OF_MESH, NULL);
+	BM_ITER_MESH (f, &iter, bm, BM_FACES_OF_MESH) {
+		BMLoop *l_first = BM_FACE_FIRST_LOOP(f);
+		BMLoop *l_first_serial = BM_FACE_FIRST_LOOP(f_serial);
+		int i;
+
+		ASSERT_EQ(f->len, f_serial->len);
+		for (i = 0; i < f->len; i++) {
+			EXPECT_EQ(BM_elem_index_get(l_first->v), BM_elem_index_get(l_first_serial->v));
+			l_first = l_first->next;
+			l_first_serial = l_first_serial->next;
+		}
+		f_serial = (BMFace *)BM_iter_step(&iter_serial);
+	}
+
+	BM_mesh_free(bm);
+	BM_mesh_free(bm_serial);
+}
+
+TEST(bmesh_triangulate, StarsClip)
+{
+	bmesh_triangulate_stars(4, MOD_TRIANGULATE_NGON_EARCLIP);
+}
+
+TEST(bmesh_triangulate, StarsBeauty)
+{
+	bmesh_triangulate_stars(4, MOD_TRIANGULATE_NGON_BEAUTY);
+}
+
+/* Large enough to calculate the triangles in parallel. */
+TEST(bmesh_triangulate, StarsBeautyLarge)
+{
+	bmesh_triangulate_stars(256, MOD_TRIANGULATE_NGON_BEAUTY);
+}